@@ -0,0 +1,150 @@
+#include <condition_variable>
+using std::condition_variable;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <random>
+using std::minstd_rand0;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "image_tools/image_set_interface.hxx"
+
+#include "batch_pipeline.hxx"
+#include "cnn_node.hxx"
+
+void prepare_input_batch(const ImagesInterface &images, const vector<int> &batch, int32_t batch_size, int32_t number_channels, bool perform_dropout, bool accumulate_test_statistics, float input_dropout_probability, minstd_rand0 &generator, InputBatch &input_batch) {
+    input_batch.batch = batch;
+    input_batch.image_height = images.get_image_height();
+    input_batch.image_width = images.get_image_width();
+
+    int32_t image_size = input_batch.image_height * input_batch.image_width;
+
+    input_batch.channel_values.resize(number_channels);
+    for (int32_t channel = 0; channel < number_channels; channel++) {
+        vector<float> &values = input_batch.channel_values[channel];
+        values.assign(batch_size * image_size, 0.0);
+
+        //the batch may have less images than the batch size, if the total number
+        //of images is not divisible by the batch size, so this only fills its own
+        if ((int32_t)batch.size() <= batch_size) images.gather_batch(batch, channel, values.data());
+
+        if (input_dropout_probability > 0) apply_dropout(values.data(), NULL, batch_size, image_size, perform_dropout, accumulate_test_statistics, input_dropout_probability, generator);
+    }
+}
+
+static int32_t number_prefetch_batches = 1;
+
+void set_prefetch_batches(int32_t _prefetch_batches) {
+    if (_prefetch_batches < 0) {
+        cerr << "ERROR: the number of prefetched batches cannot be negative: " << _prefetch_batches << endl;
+        exit(1);
+    }
+
+    number_prefetch_batches = _prefetch_batches;
+}
+
+void set_prefetch_batches(const vector<string> &arguments) {
+    int32_t _prefetch_batches = 1;
+    get_argument(arguments, "--prefetch_batches", false, _prefetch_batches);
+
+    set_prefetch_batches(_prefetch_batches);
+}
+
+int32_t get_prefetch_batches() {
+    return number_prefetch_batches;
+}
+
+BatchPipeline::BatchPipeline(const ImagesInterface &_images, const vector<long> &_order, int32_t _batch_size, int32_t _number_channels, bool _perform_dropout, bool _accumulate_test_statistics, float _input_dropout_probability, uint32_t seed) : images(_images), order(_order), batch_size(_batch_size), number_channels(_number_channels), perform_dropout(_perform_dropout), accumulate_test_statistics(_accumulate_test_statistics), input_dropout_probability(_input_dropout_probability), generator(seed), batches_prepared(0), batches_used(0), stopping(false) {
+
+    number_batches = (order.size() + batch_size - 1) / batch_size;
+
+    prefetch_batches = get_prefetch_batches();
+    if (prefetch_batches > number_batches) prefetch_batches = number_batches;
+
+    input_batches.resize(prefetch_batches + 1);
+
+    if (prefetch_batches > 0) prefetch_thread = thread(&BatchPipeline::prefetch, this);
+}
+
+BatchPipeline::~BatchPipeline() {
+    {
+        lock_guard<mutex> lock(pipeline_mutex);
+        stopping = true;
+    }
+    batch_released.notify_one();
+
+    if (prefetch_thread.joinable()) prefetch_thread.join();
+}
+
+int32_t BatchPipeline::get_number_batches() const {
+    return number_batches;
+}
+
+void BatchPipeline::prepare_batch(int32_t batch_number, InputBatch &input_batch) {
+    vector<int> batch;
+    for (uint32_t current = batch_number * batch_size; current < (uint32_t)(batch_number + 1) * batch_size && current < order.size(); current++) {
+        batch.push_back( order[current] );
+    }
+
+    prepare_input_batch(images, batch, batch_size, number_channels, perform_dropout, accumulate_test_statistics, input_dropout_probability, generator, input_batch);
+}
+
+void BatchPipeline::prefetch() {
+    for (int32_t batch_number = 0; batch_number < number_batches; batch_number++) {
+        {
+            //the batch being trained on is batches_used - 1, so this can work
+            //until it is prefetch_batches ahead of it
+            unique_lock<mutex> lock(pipeline_mutex);
+            batch_released.wait(lock, [&] { return stopping || batch_number < batches_used + prefetch_batches; });
+            if (stopping) return;
+        }
+
+        prepare_batch(batch_number, input_batches[batch_number % input_batches.size()]);
+
+        {
+            lock_guard<mutex> lock(pipeline_mutex);
+            batches_prepared = batch_number + 1;
+        }
+        batch_prepared.notify_one();
+    }
+}
+
+const InputBatch& BatchPipeline::next() {
+    int32_t batch_number = batches_used;
+
+    if (batch_number >= number_batches) {
+        cerr << "ERROR: requested batch " << batch_number << " from a batch pipeline with only " << number_batches << " batches" << endl;
+        exit(1);
+    }
+
+    if (prefetch_batches == 0) {
+        batches_used++;
+        prepare_batch(batch_number, input_batches[0]);
+        return input_batches[0];
+    }
+
+    {
+        unique_lock<mutex> lock(pipeline_mutex);
+        batch_prepared.wait(lock, [&] { return batches_prepared > batch_number; });
+        batches_used++;
+    }
+    batch_released.notify_one();
+
+    return input_batches[batch_number % input_batches.size()];
+}
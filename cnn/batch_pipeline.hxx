@@ -0,0 +1,108 @@
+#ifndef CNN_BATCH_PIPELINE_HXX
+#define CNN_BATCH_PIPELINE_HXX
+
+#include "stdint.h"
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <mutex>
+using std::mutex;
+
+#include <random>
+using std::minstd_rand0;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "image_tools/image_set_interface.hxx"
+
+/**
+ * The values of a CNN_Genome's input nodes for a batch: for each channel, the
+ * gathered and normalized images with the input dropout applied, exactly as
+ * the node's values_out would be after it is reset and its values are set.
+ */
+class InputBatch {
+    public:
+        vector<int> batch;
+
+        int32_t image_height, image_width;
+        vector< vector<float> > channel_values; /**< batch_size x image_height x image_width for each channel. */
+};
+
+/**
+ * Gathers the images of batch into input_batch (with room for batch_size
+ * images, any after the batch's being 0) and applies the input dropout, which
+ * only uses the generator if it drops out values.
+ */
+void prepare_input_batch(const ImagesInterface &images, const vector<int> &batch, int32_t batch_size, int32_t number_channels, bool perform_dropout, bool accumulate_test_statistics, float input_dropout_probability, minstd_rand0 &generator, InputBatch &input_batch);
+
+/**
+ * Sets how many batches a BatchPipeline prepares ahead on its own thread, 0
+ * preparing each batch on the training thread when it is needed.
+ */
+void set_prefetch_batches(int32_t prefetch_batches);
+
+/**
+ * Sets the number of prefetched batches from --prefetch_batches, if it is
+ * given (the default is 1, double buffering the input).
+ */
+void set_prefetch_batches(const vector<string> &arguments);
+
+int32_t get_prefetch_batches();
+
+/**
+ * Prepares the input batches of one pass over the images in order, in a
+ * background thread which works up to get_prefetch_batches() batches ahead of
+ * the batch being trained on.  The batches are prepared in order with the
+ * pipeline's own generator, so they are the same however many are prefetched
+ * (or if none are).
+ */
+class BatchPipeline {
+    private:
+        const ImagesInterface &images;
+        const vector<long> &order;
+
+        int32_t batch_size;
+        int32_t number_channels;
+        bool perform_dropout;
+        bool accumulate_test_statistics;
+        float input_dropout_probability;
+        minstd_rand0 generator;
+
+        int32_t number_batches;
+        int32_t prefetch_batches;
+        vector<InputBatch> input_batches; /**< a ring of prefetch_batches + 1 batches, the one being trained on and those prepared ahead. */
+
+        mutex pipeline_mutex;
+        condition_variable batch_prepared;
+        condition_variable batch_released;
+        int32_t batches_prepared;
+        int32_t batches_used;
+        bool stopping;
+
+        thread prefetch_thread;
+
+        void prepare_batch(int32_t batch_number, InputBatch &input_batch);
+        void prefetch();
+
+    public:
+        BatchPipeline(const ImagesInterface &_images, const vector<long> &_order, int32_t _batch_size, int32_t _number_channels, bool _perform_dropout, bool _accumulate_test_statistics, float _input_dropout_probability, uint32_t seed);
+        ~BatchPipeline();
+
+        int32_t get_number_batches() const;
+
+        /**
+         * Returns the next batch, waiting for it to be prepared if it has not
+         * been.  It is valid until next is called again.
+         */
+        const InputBatch& next();
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include <condition_variable>
+using std::condition_variable;
+
+#include <functional>
+using std::function;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+
+#include "batch_threads.hxx"
+
+/**
+ * The batch threads, which wait for a new generation of work and each run
+ * one of its chunks.
+ */
+class BatchThreadPool {
+    private:
+        vector<thread> threads;
+
+        mutex pool_mutex; /**< held by the thread using the pool for the whole parallel_for_batch. */
+
+        mutex work_mutex;
+        condition_variable work_ready;
+        condition_variable work_done;
+
+        const function<void (int32_t, int32_t, int32_t)> *work;
+        int32_t batch_size;
+        int32_t number_chunks;
+        int64_t generation;
+        int32_t chunks_remaining;
+        bool stopping;
+
+        void run(int32_t chunk) {
+            int64_t last_generation = 0;
+
+            while (true) {
+                const function<void (int32_t, int32_t, int32_t)> *current_work;
+                int32_t current_batch_size, current_number_chunks;
+
+                {
+                    unique_lock<mutex> lock(work_mutex);
+                    work_ready.wait(lock, [&] { return stopping || generation != last_generation; });
+                    if (stopping) return;
+
+                    last_generation = generation;
+                    current_work = work;
+                    current_batch_size = batch_size;
+                    current_number_chunks = number_chunks;
+                }
+
+                if (chunk < current_number_chunks) {
+                    run_chunk(*current_work, chunk, current_batch_size, current_number_chunks);
+
+                    lock_guard<mutex> lock(work_mutex);
+                    chunks_remaining--;
+                    if (chunks_remaining == 0) work_done.notify_one();
+                }
+            }
+        }
+
+    public:
+        BatchThreadPool() : work(NULL), batch_size(0), number_chunks(0), generation(0), chunks_remaining(0), stopping(false) {
+        }
+
+        ~BatchThreadPool() {
+            resize(1);
+        }
+
+        int32_t size() const {
+            return threads.size() + 1;
+        }
+
+        void resize(int32_t number_threads) {
+            lock_guard<mutex> pool_lock(pool_mutex);
+
+            {
+                lock_guard<mutex> lock(work_mutex);
+                stopping = true;
+            }
+            work_ready.notify_all();
+            for (uint32_t i = 0; i < threads.size(); i++) {
+                threads[i].join();
+            }
+            threads.clear();
+
+            stopping = false;
+            generation = 0;
+            for (int32_t chunk = 1; chunk < number_threads; chunk++) {
+                threads.push_back( thread(&BatchThreadPool::run, this, chunk) );
+            }
+        }
+
+        static void run_chunk(const function<void (int32_t, int32_t, int32_t)> &chunk_work, int32_t chunk, int32_t chunk_batch_size, int32_t chunks) {
+            int32_t batch_begin = (int64_t)chunk_batch_size * chunk / chunks;
+            int32_t batch_end = (int64_t)chunk_batch_size * (chunk + 1) / chunks;
+            chunk_work(chunk, batch_begin, batch_end);
+        }
+
+        void parallel_for(int32_t _batch_size, int32_t _number_chunks, const function<void (int32_t, int32_t, int32_t)> &_work) {
+            unique_lock<mutex> pool_lock(pool_mutex, std::try_to_lock);
+
+            if (!pool_lock.owns_lock() || _number_chunks == 1) {
+                for (int32_t chunk = 0; chunk < _number_chunks; chunk++) {
+                    run_chunk(_work, chunk, _batch_size, _number_chunks);
+                }
+                return;
+            }
+
+            {
+                lock_guard<mutex> lock(work_mutex);
+                work = &_work;
+                batch_size = _batch_size;
+                number_chunks = _number_chunks;
+                chunks_remaining = _number_chunks - 1;
+                generation++;
+            }
+            work_ready.notify_all();
+
+            run_chunk(_work, 0, _batch_size, _number_chunks);
+
+            unique_lock<mutex> lock(work_mutex);
+            work_done.wait(lock, [&] { return chunks_remaining == 0; });
+        }
+};
+
+static BatchThreadPool batch_thread_pool;
+
+void set_batch_threads(int32_t number_threads) {
+    if (number_threads < 1) {
+        cerr << "ERROR: the number of batch threads must be at least 1, not " << number_threads << endl;
+        exit(1);
+    }
+
+    batch_thread_pool.resize(number_threads);
+}
+
+void set_batch_threads(const vector<string> &arguments) {
+    int32_t number_threads = 1;
+    get_argument(arguments, "--batch_threads", false, number_threads);
+
+    set_batch_threads(number_threads);
+}
+
+int32_t get_batch_threads() {
+    return batch_thread_pool.size();
+}
+
+int32_t get_number_batch_chunks(int32_t batch_size) {
+    int32_t number_threads = batch_thread_pool.size();
+    return batch_size < number_threads ? batch_size : number_threads;
+}
+
+void parallel_for_batch(int32_t batch_size, const function<void (int32_t, int32_t, int32_t)> &work) {
+    int32_t number_chunks = get_number_batch_chunks(batch_size);
+    if (number_chunks < 1) number_chunks = 1;
+
+    batch_thread_pool.parallel_for(batch_size, number_chunks, work);
+}
@@ -0,0 +1,47 @@
+#ifndef CNN_BATCH_THREADS_HXX
+#define CNN_BATCH_THREADS_HXX
+
+#include "stdint.h"
+
+#include <functional>
+using std::function;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+/**
+ * Sets how many threads the images of a batch are split over when
+ * propagating a CNN_Genome (1, the default, propagates on the calling thread
+ * only).  The extra threads are started once and kept waiting between batches.
+ */
+void set_batch_threads(int32_t number_threads);
+
+/**
+ * Sets the number of batch threads from --batch_threads, if it is given.  This
+ * should be called before any threads are started.
+ */
+void set_batch_threads(const vector<string> &arguments);
+
+int32_t get_batch_threads();
+
+/**
+ * The number of chunks parallel_for_batch splits a batch of batch_size images
+ * into.
+ */
+int32_t get_number_batch_chunks(int32_t batch_size);
+
+/**
+ * Splits the batch_size images of a batch into contiguous chunks, and calls
+ * work(chunk, batch_begin, batch_end) for each chunk, one chunk per batch
+ * thread (the first on the calling thread), returning when all of them are
+ * done.  Chunks are the same for the same batch size, so reductions over them
+ * are too.  If the batch threads are already in use (e.g., by another genome
+ * being trained on another thread) the chunks are all run on the calling
+ * thread instead.
+ */
+void parallel_for_batch(int32_t batch_size, const function<void (int32_t, int32_t, int32_t)> &work);
+
+#endif
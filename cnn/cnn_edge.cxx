@@ -45,6 +45,7 @@ using std::vector;
 #include "comparison.hxx"
 #include "cnn_edge.hxx"
 #include "cnn_node.hxx"
+#include "kernels.hxx"
 #include "pooling.hxx"
 #include "propagation.hxx"
 
@@ -959,15 +960,8 @@ void CNN_Edge::propagate_forward(bool training, bool accumulate_test_statistics,
     int input_size_y = input_node->get_size_y();
 
     if (type == CONVOLUTIONAL) {
-        if (reverse_filter_y && reverse_filter_x) {
-            prop_forward_ry_rx(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
-        } else if (reverse_filter_y) {
-            prop_forward_ry(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
-        } else if (reverse_filter_x) {
-            prop_forward_rx(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
-        } else {
-            prop_forward(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
-        }
+        int method = get_convolution_method(batch_size, input_size_y, input_size_x, output_size_y, output_size_x);
+        prop_forward_convolution(method, input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
 
     } else if (type == POOLING) {
 #ifdef NAN_CHECKS
@@ -993,68 +987,7 @@ void CNN_Edge::propagate_forward(bool training, bool accumulate_test_statistics,
         */
 
 
-        bool max_pooling = true;
-        if (reverse_filter_y && reverse_filter_x) {
-            if (input_size_y % output_size_y == 0) {
-                fisher_yates_shuffle(generator, y_pools);
-                update_offset(y_pools, y_pool_offset);
-                max_pooling = false;
-            }
-
-            if (input_size_x % output_size_x == 0) {
-                fisher_yates_shuffle(generator, x_pools);
-                update_offset(x_pools, x_pool_offset);
-                max_pooling = false;
-            }
-
-            pool_forward_ry_rx(input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling);
-
-        } else if (reverse_filter_y) {
-            if (output_size_y % input_size_y == 0) {
-                fisher_yates_shuffle(generator, y_pools);
-                update_offset(y_pools, y_pool_offset);
-                max_pooling = false;
-            }
-
-            if (input_size_x % output_size_x == 0) {
-                fisher_yates_shuffle(generator, x_pools);
-                update_offset(x_pools, x_pool_offset);
-                max_pooling = false;
-            }
-
-            pool_forward_ry(input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling);
-
-        } else if (reverse_filter_x) {
-            if (input_size_y % output_size_y == 0) {
-                fisher_yates_shuffle(generator, y_pools);
-                update_offset(y_pools, y_pool_offset);
-                max_pooling = false;
-            }
-
-            if (output_size_x % input_size_x == 0) {
-                fisher_yates_shuffle(generator, x_pools);
-                update_offset(x_pools, x_pool_offset);
-                max_pooling = false;
-            }
-
-            pool_forward_rx(input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling);
-
-        } else {
-            if (output_size_y % input_size_y == 0) {
-                fisher_yates_shuffle(generator, y_pools);
-                update_offset(y_pools, y_pool_offset);
-                max_pooling = false;
-            }
-
-            if (output_size_x % input_size_x == 0) {
-                fisher_yates_shuffle(generator, x_pools);
-                update_offset(x_pools, x_pool_offset);
-                max_pooling = false;
-            }
-
-            pool_forward(input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling);
-        }
-
+        pool_forward_edge(input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training);
     } else {
         cerr << "ERROR: unknown edge type in propagate_forward: " << type << endl;
         exit(1);
@@ -1068,90 +1001,42 @@ void CNN_Edge::propagate_forward(bool training, bool accumulate_test_statistics,
 	output_node->input_fired(training, accumulate_test_statistics, epsilon, alpha, perform_dropout, hidden_dropout_probability, generator);
 }
 
-void CNN_Edge::update_weights(float mu, float learning_rate, float weight_decay) {
-    if (!is_reachable()) return;
-    if (type == POOLING) return;
+bool CNN_Edge::is_sliding_window_equivalent() const {
+    return type == CONVOLUTIONAL && !reverse_filter_y && !reverse_filter_x;
+}
 
+void CNN_Edge::propagate_forward_tile(const float* input, float* output, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x) {
     using namespace std::chrono;
-    high_resolution_clock::time_point weight_update_start_time = high_resolution_clock::now();
-
-    float dx, pv, velocity, weight;
-#ifdef NAN_CHECKS
-    float previous_weight;
-#endif
-
-    for (int32_t current = 0; current < filter_size; current++) {
-        dx = weight_updates[current];
-
-        //try clipping the weight
-        //dx = dx * (0.5 / fmax(0.5, fabs(dx)));
+    high_resolution_clock::time_point propagate_forward_start_time = high_resolution_clock::now();
 
-        pv = previous_velocity[current];
+    int method = get_convolution_method(1, input_size_y, input_size_x, output_size_y, output_size_x);
+    prop_forward_convolution(method, input, weights, output, 1, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
 
-        velocity = (mu * pv) - learning_rate * dx;
+    high_resolution_clock::time_point propagate_forward_end_time = high_resolution_clock::now();
+    duration<float, std::milli> time_span = propagate_forward_end_time - propagate_forward_start_time;
 
-        weight = weights[current];
-#ifdef NAN_CHECKS
-        previous_weight = weight;
-#endif
-        weight += velocity + mu * (velocity - pv);
-        //weight += (-mu * pv + (1 + mu) * velocity);
-        //weight += velocity;
+    propagate_forward_time += time_span.count() / 1000.0;
+}
 
-        weight -= (weight * weight_decay);
+void CNN_Edge::update_weights(float mu, float learning_rate, float weight_decay) {
+    if (!is_reachable()) return;
+    if (type == POOLING) return;
 
-        weights[current] = weight;
+    using namespace std::chrono;
+    high_resolution_clock::time_point weight_update_start_time = high_resolution_clock::now();
 
-        previous_velocity[current] = velocity;
+    get_kernels().update_weights(weights, weight_updates, previous_velocity, filter_size, mu, learning_rate, weight_decay);
 
 #ifdef NAN_CHECKS
-        if (isnan(weights[current]) || isinf(weights[current])) {
+    for (int32_t current = 0; current < filter_size; current++) {
+        if (isnan(weights[current]) || isinf(weights[current]) || isnan(previous_velocity[current]) || isinf(previous_velocity[current])) {
             cerr << "ERROR! weight became " << weights[current] << " in edge: " << innovation_number << " (" << input_node_innovation_number << " to " << output_node_innovation_number << ")" << endl;
-            cerr << "\tdx: " << dx << endl;
-            cerr << "\tpv: " << pv << endl;
-            cerr << "\tvelocity: " << velocity << endl;
-            cerr << "\tprevious_weight: " << previous_weight << endl;
+            cerr << "\tdx: " << weight_updates[current] << endl;
+            cerr << "\tvelocity: " << previous_velocity[current] << endl;
             exit(1);
         }
-#endif
-
-        if (weights[current] > 50.0) {
-            /*
-               cout << "weight > 2!" << endl;
-               cout << "updating weight from " << input_node_innovation_number << " to " << output_node_innovation_number
-               << ": fy: " << fy << ", fx: " << fx 
-               << ", weight: " << weights[current] 
-               << ", weight_update: " << weight_updates[current] 
-               << ", learning_rate * dx: " << (learning_rate * dx) << endl;
-
-               this->print(cout);
-               input_node->print(cout);
-               output_node->print(cout);
-
-               exit(1);
-               */
-
-            weights[current] = 50.0;
-            previous_velocity[current] = 0.0;
-        } else if (weights[current] < -50.0) {
-            /*
-               cout << "weight < -2!" << endl;
-               cout << "updating weight from " << input_node_innovation_number << " to " << output_node_innovation_number
-               << ": fy: " << fy << ", fx: " << fx 
-               << ", weight: " << weights[current] 
-               << ", weight_update: " << weight_updates[current] 
-               << ", learning_rate * dx: " << (learning_rate * dx) << endl;
-               this->print(cout);
-               input_node->print(cout);
-               output_node->print(cout);
-
-               exit(1);
-               */
-
-            weights[current] = -50.0;
-            previous_velocity[current] = 0.0;
-        }
     }
+#endif
 
     high_resolution_clock::time_point weight_update_end_time = high_resolution_clock::now();
     duration<float, std::milli> time_span = weight_update_end_time - weight_update_start_time;
@@ -1180,15 +1065,8 @@ void CNN_Edge::propagate_backward(bool training, float mu, float learning_rate,
     }
 
     if (type == CONVOLUTIONAL) {
-        if (reverse_filter_x && reverse_filter_y) {
-            prop_backward_ry_rx(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
-        } else if (reverse_filter_y) {
-            prop_backward_ry(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
-        } else if (reverse_filter_x) {
-            prop_backward_rx(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
-        } else {
-            prop_backward(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
-        }
+        int method = get_convolution_method(batch_size, input_size_y, input_size_x, output_size_y, output_size_x);
+        prop_backward_convolution(method, output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
 
     } else if (type == POOLING) {
         float *pool_gradients = input_node->get_pool_gradients();
@@ -23,6 +23,7 @@ using std::string;
 using std::vector;
 
 #include "cnn_node.hxx"
+#include "propagation.hxx"
 #include "image_tools/image_set.hxx"
 #include "common/random.hxx"
 
@@ -73,6 +74,8 @@ class CNN_Edge {
         bool reverse_filter_y;
         bool needs_initialization;
 
+        FilterSpectrum filter_spectrum; /**< the FFT of the filter, if it is propagated with FFTs. */
+
         float propagate_backward_time;
         float propagate_forward_time;
         float weight_update_time;
@@ -170,6 +173,20 @@ class CNN_Edge {
 
         void propagate_forward(bool training, bool accumulate_test_statistics, float epsilon, float alpha, bool perform_dropout, float hidden_dropout_probability, minstd_rand0 &generator);
 
+        /**
+         * Whether propagating this edge over a whole large image gives the same
+         * values as propagating it over each window of it, i.e., it is a
+         * convolution which does not need to zero pad its input.
+         */
+        bool is_sliding_window_equivalent() const;
+
+        /**
+         * Propagates a single tile (of the given sizes, which are the sizes of
+         * the edge's nodes grown by the same amount) through this edge, adding
+         * it to the output.  It is only valid if is_sliding_window_equivalent().
+         */
+        void propagate_forward_tile(const float* input, float* output, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x);
+
         void propagate_backward(bool training, float mu, float learning_rate, float epsilon);
         void update_weights(float mu, float learning_rate, float weight_decay);
 
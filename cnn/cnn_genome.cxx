@@ -54,6 +54,7 @@ using std::vector;
 #include "common/db_conn.hxx"
 #endif
 
+#include "common/arguments.hxx"
 #include "comparison.hxx"
 #include "common/exp.hxx"
 #include "common/random.hxx"
@@ -64,6 +65,7 @@ using std::vector;
 #include "image_tools/large_image_set.hxx"
 #include "cnn_node.hxx"
 #include "cnn_edge.hxx"
+#include "batch_pipeline.hxx"
 #include "cnn_genome.hxx"
 
 #include "stdint.h"
@@ -173,6 +175,10 @@ float CNN_Genome::get_alpha() const {
     return alpha;
 }
 
+float CNN_Genome::get_epsilon() const {
+    return epsilon;
+}
+
 int CNN_Genome::get_velocity_reset() const {
     return velocity_reset;
 }
@@ -821,6 +827,14 @@ const vector<CNN_Edge*> CNN_Genome::get_edges() const {
     return edges;
 }
 
+const vector<CNN_Node*> CNN_Genome::get_input_nodes() const {
+    return input_nodes;
+}
+
+const vector<CNN_Node*> CNN_Genome::get_softmax_nodes() const {
+    return softmax_nodes;
+}
+
 void CNN_Genome::get_node_copies(vector<CNN_Node*> &node_copies) const {
     node_copies.clear();
 
@@ -1258,12 +1272,15 @@ void CNN_Genome::evaluate_images(const ImagesInterface &images, const vector<int
     bool training = false;
     bool accumulate_test_statistics = false;
 
+    InputBatch input_batch;
+    prepare_input_batch(images, batch, batch_size, input_nodes.size(), training, accumulate_test_statistics, input_dropout_probability, generator, input_batch);
+
     for (uint32_t i = 0; i < nodes.size(); i++) {
         nodes[i]->reset();
     }
 
     for (uint32_t channel = 0; channel < input_nodes.size(); channel++) {
-        input_nodes[channel]->set_values(images, batch, channel, training, accumulate_test_statistics, input_dropout_probability, generator);
+        input_nodes[channel]->set_values(input_batch, channel);
     }
 
     for (uint32_t i = 0; i < edges.size(); i++) {
@@ -1559,12 +1576,21 @@ void CNN_Genome::check_gradients(const ImagesInterface &images) {
 }
 
 void CNN_Genome::evaluate_images(const ImagesInterface &images, const vector<int> &batch, bool training, float &total_error, int &correct_predictions, bool accumulate_test_statistics) {
+    InputBatch input_batch;
+    prepare_input_batch(images, batch, batch_size, input_nodes.size(), training, accumulate_test_statistics, input_dropout_probability, generator, input_batch);
+
+    evaluate_images(images, input_batch, training, total_error, correct_predictions, accumulate_test_statistics);
+}
+
+void CNN_Genome::evaluate_images(const ImagesInterface &images, const InputBatch &input_batch, bool training, float &total_error, int &correct_predictions, bool accumulate_test_statistics) {
+    const vector<int> &batch = input_batch.batch;
+
     for (uint32_t i = 0; i < nodes.size(); i++) {
         nodes[i]->reset();
     }
 
     for (uint32_t channel = 0; channel < input_nodes.size(); channel++) {
-        input_nodes[channel]->set_values(images, batch, channel, training, accumulate_test_statistics, input_dropout_probability, generator);
+        input_nodes[channel]->set_values(input_batch, channel);
     }
 
     for (uint32_t i = 0; i < edges.size(); i++) {
@@ -1762,6 +1788,157 @@ void CNN_Genome::print_progress(ostream &out, string progress_name, float total_
     out << setw(10) << progress_name << "[" << setw(10) << name << ", genome " << setw(5) << generation_id << "] predictions: " << setw(7) << correct_predictions << "/" << setw(7) << number_images << " (" << setw(5) << fixed << setprecision(2) << (100.0 * (float)correct_predictions/(float)number_images) << "%), best: " << setw(7) << best_validation_predictions << "/" << number_validation_images << " (" << setw(5) << fixed << setprecision(2) << (100 * (float)best_validation_predictions/(float)number_validation_images) << "%), error: " << setw(15) << setprecision(5) << fixed << total_error << ", best error: " << setw(15) << best_validation_error << " on epoch: " << setw(5) << best_epoch << ", epoch: " << setw(4) << epoch << "/" << max_epochs << ", mu: " << setw(12) << fixed << setprecision(10) << mu << ", learning_rate: " << setw(12) << fixed << setprecision(10) << learning_rate << ", weight_decay: " << setw(12) << fixed << setprecision(10) << weight_decay << endl;
 }
 
+static bool sliding_window_inference = true;
+
+void set_sliding_window_inference(const vector<string> &arguments) {
+    sliding_window_inference = !argument_exists(arguments, "--per_window_inference");
+}
+
+bool CNN_Genome::is_fully_convolutional(const MultiImagesInterface &images) const {
+    if (images.get_padding() != 0) return false;
+    if (images.get_image_channels() != (int32_t)input_nodes.size()) return false;
+
+    //windows of a different size are left for set_values to report
+    for (uint32_t i = 0; i < input_nodes.size(); i++) {
+        if (input_nodes[i]->get_size_y() != images.get_image_height() || input_nodes[i]->get_size_x() != images.get_image_width()) return false;
+    }
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (edges[i]->is_reachable() && !edges[i]->is_sliding_window_equivalent()) return false;
+    }
+
+    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+        if (softmax_nodes[i]->get_size_y() != 1 || softmax_nodes[i]->get_size_x() != 1) return false;
+    }
+
+    return true;
+}
+
+void CNN_Genome::evaluate_fully_convolutional(const MultiImagesInterface &images, int image_number, vector< vector<float> > &predictions) {
+    int32_t image_height = images.get_image_height();
+    int32_t image_width = images.get_image_width();
+
+    //the subimages are ordered by row then column of the window's offset in the
+    //large image, as in MultiImagesInterface::get_pixel
+    int32_t windows_y = images.get_large_image_height(image_number) - image_height + 1;
+    int32_t windows_x = images.get_large_image_width(image_number) - image_width + 1;
+
+    //every node of a tile of tile_y by tile_x windows is tile_y - 1 larger along
+    //y and tile_x - 1 larger along x than it is for a single window, and each
+    //value of a softmax node is the prediction for one window
+    map<const CNN_Node*, int32_t> node_positions;
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        node_positions[nodes[i]] = i;
+    }
+
+    vector< vector<float> > tile_values_in(nodes.size());
+    vector< vector<float> > tile_values_out(nodes.size());
+    vector<int32_t> tile_inputs_fired(nodes.size());
+
+    vector<float> softmax_values(softmax_nodes.size());
+
+    for (int32_t tile_start_y = 0; tile_start_y < windows_y; tile_start_y += SLIDING_WINDOW_TILE_SIZE) {
+        int32_t tile_y = windows_y - tile_start_y;
+        if (tile_y > SLIDING_WINDOW_TILE_SIZE) tile_y = SLIDING_WINDOW_TILE_SIZE;
+
+        for (int32_t tile_start_x = 0; tile_start_x < windows_x; tile_start_x += SLIDING_WINDOW_TILE_SIZE) {
+            int32_t tile_x = windows_x - tile_start_x;
+            if (tile_x > SLIDING_WINDOW_TILE_SIZE) tile_x = SLIDING_WINDOW_TILE_SIZE;
+
+            for (uint32_t i = 0; i < nodes.size(); i++) {
+                int32_t tile_size = (nodes[i]->get_size_y() + tile_y - 1) * (nodes[i]->get_size_x() + tile_x - 1);
+                tile_values_in[i].assign(tile_size, 0.0);
+                tile_values_out[i].assign(tile_size, 0.0);
+                tile_inputs_fired[i] = 0;
+            }
+
+            for (uint32_t channel = 0; channel < input_nodes.size(); channel++) {
+                vector<float> &values = tile_values_out[node_positions[input_nodes[channel]]];
+
+                int32_t current = 0;
+                for (int32_t y = 0; y < image_height + tile_y - 1; y++) {
+                    for (int32_t x = 0; x < image_width + tile_x - 1; x++) {
+                        values[current] = ((images.get_raw_pixel(image_number, channel, tile_start_y + y, tile_start_x + x) / 255.0) - images.get_channel_avg(channel)) / images.get_channel_std_dev(channel);
+                        current++;
+                    }
+                }
+
+                //scales the values the same as when evaluating a batch (this does not use the generator)
+                if (input_dropout_probability > 0) apply_dropout(values.data(), NULL, 1, values.size(), false, false, input_dropout_probability, generator);
+            }
+
+            for (uint32_t i = 0; i < edges.size(); i++) {
+                if (!edges[i]->is_reachable()) continue;
+
+                CNN_Node *input_node = edges[i]->get_input_node();
+                CNN_Node *output_node = edges[i]->get_output_node();
+                int32_t input_position = node_positions[input_node];
+                int32_t output_position = node_positions[output_node];
+
+                edges[i]->propagate_forward_tile(tile_values_out[input_position].data(), tile_values_in[output_position].data(), input_node->get_size_y() + tile_y - 1, input_node->get_size_x() + tile_x - 1, output_node->get_size_y() + tile_y - 1, output_node->get_size_x() + tile_x - 1);
+
+                tile_inputs_fired[output_position]++;
+                if (tile_inputs_fired[output_position] == output_node->get_number_inputs() && !output_node->is_softmax()) {
+                    output_node->input_fired_tile(tile_values_in[output_position].data(), tile_values_out[output_position].data(), tile_values_in[output_position].size(), epsilon, hidden_dropout_probability);
+                }
+            }
+
+            for (int32_t y = 0; y < tile_y; y++) {
+                for (int32_t x = 0; x < tile_x; x++) {
+                    int32_t current = (y * tile_x) + x;
+
+                    float softmax_max = tile_values_in[node_positions[softmax_nodes[0]]][current];
+                    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+                        softmax_values[i] = tile_values_in[node_positions[softmax_nodes[i]]][current];
+                        if (softmax_values[i] > softmax_max) softmax_max = softmax_values[i];
+                    }
+
+                    float softmax_sum = 0.0;
+                    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+                        softmax_values[i] = exact_exp(softmax_values[i] - softmax_max);
+                        softmax_sum += softmax_values[i];
+                    }
+
+                    if (softmax_sum == 0) {
+                        cout << "ERROR! softmax sum == 0" << endl;
+                        exit(1);
+                    }
+
+                    int32_t subimage = ((tile_start_y + y) * windows_x) + tile_start_x + x;
+                    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+                        predictions[subimage][i] = softmax_values[i] / softmax_sum;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void CNN_Genome::evaluate_subimages(const MultiImagesInterface &images, int image_number, vector< vector<float> > &predictions) {
+    if (sliding_window_inference && is_fully_convolutional(images)) {
+        evaluate_fully_convolutional(images, image_number, predictions);
+        return;
+    }
+
+    int number_subimages = images.get_number_subimages(image_number);
+
+    int initial_offset = 0;
+    for (uint32_t i = 0; i < image_number; i++) {
+        initial_offset += images.get_number_subimages(i);
+    }
+
+    for (uint32_t j = 0; j < number_subimages; j += batch_size) {
+        if (j % 10000 == 0) cout << "subimage: " << j << "/" << number_subimages << endl;
+
+        vector<int> batch;
+        for (uint32_t k = 0; k < batch_size && (j + k) < number_subimages; k++) {
+            batch.push_back( initial_offset + j + k );
+        }
+
+        evaluate_images(images, batch, predictions, initial_offset);
+    }
+}
+
 void CNN_Genome::evaluate_large_images(const LargeImages &images, string output_directory) {
     int current_subimage = 0;
 
@@ -1778,22 +1955,7 @@ void CNN_Genome::evaluate_large_images(const LargeImages &images, string output_
         vector< vector<float> > predictions(number_subimages, vector<float>(images.get_number_classes(), 0.0));
         //cout << "created vector!" << endl;
 
-        for (uint32_t j = 0; j < number_subimages; j += batch_size) {
-
-            //cout << "image " << image_number << ", number subimages: " << number_subimages << ", batch is: ";
-            vector<int> batch;
-            for (uint32_t k = 0; k < batch_size && (j + k) < number_subimages; k++) {
-                batch.push_back( current_subimage + j + k );
-                //cout << " " << current_subimage + j + k;
-            }
-            //cout << endl;
-
-            //cout << "evaluating images for batch starting at " << j << " with batch size " << batch_size << endl;
-            //float batch_total_error = 0.0;
-            //int batch_correct_predictions = 0;
-            evaluate_images(images, batch, predictions, current_subimage);
-            //cout << "evaluated images!" << endl;
-        }
+        evaluate_subimages(images, image_number, predictions);
         current_subimage += number_subimages;
 
         //cout << "checking predictions!" << endl;
@@ -1847,22 +2009,7 @@ void CNN_Genome::get_prediction_matrix(const MultiImagesInterface &images, int i
     vector< vector<float> > predictions(number_subimages, vector<float>(number_classes, 0.0));
     cout << "created predictions vector for image: " << image_number << ", number subimages: " << number_subimages << ", number_classes: " << number_classes << endl;
 
-    int initial_offset = 0;
-    for (uint32_t i = 0; i < image_number; i++) {
-        initial_offset += images.get_number_subimages(i);
-    }
-    int current_subimage = initial_offset;
-
-    for (uint32_t j = 0; j < number_subimages; j += batch_size) {
-        if (j % 10000 == 0) cout << "subimage: " << j << "/" << number_subimages << endl;
-
-        vector<int> batch;
-        for (uint32_t k = 0; k < batch_size && (j + k) < number_subimages; k++) {
-            batch.push_back( current_subimage + j + k );
-        }
-
-        evaluate_images(images, batch, predictions, initial_offset);
-    }
+    evaluate_subimages(images, image_number, predictions);
 
     //now create the prediction matrix to put these predictions into
     int matrix_height = images.get_large_image_height(image_number) - (images.get_image_height() - (images.get_padding() * 2)) + 1;
@@ -1995,15 +2142,21 @@ void CNN_Genome::evaluate(const ImagesInterface &images, const vector<long> &ord
         edges[i]->reset_times();
     }
 
-    for (uint32_t j = 0; j < order.size(); j += batch_size) {
-        vector<int> batch;
-        for (uint32_t k = 0; k < batch_size && (j + k) < order.size(); k++) {
-            batch.push_back( order[j + k] );
-        }
+    //the input batches are prepared ahead on another thread, with their own
+    //generator so the input dropout is the same however many are prepared
+    //ahead.  it is only seeded from this genome's generator if there is input
+    //dropout, so otherwise the genome's generator is used as it was
+    uint32_t pipeline_seed = 0;
+    if (training && input_dropout_probability > 0) pipeline_seed = generator();
+
+    BatchPipeline pipeline(images, order, batch_size, input_nodes.size(), training, accumulate_test_statistics, input_dropout_probability, pipeline_seed);
+
+    for (int32_t j = 0; j < pipeline.get_number_batches(); j++) {
+        const InputBatch &input_batch = pipeline.next();
 
         float batch_total_error = 0.0;
         int batch_correct_predictions = 0;
-        evaluate_images(images, batch, training, batch_total_error, batch_correct_predictions, accumulate_test_statistics);
+        evaluate_images(images, input_batch, training, batch_total_error, batch_correct_predictions, accumulate_test_statistics);
 
         /*
         cerr << "[" << setw(10) << name << ", genome " << setw(5) << generation_id << "] ";
@@ -2012,7 +2165,7 @@ void CNN_Genome::evaluate(const ImagesInterface &images, const vector<long> &ord
         } else {
             cerr << "test batch: ";
         }
-        cerr << setw(5) << (j / batch_size) << "/" << setw(5) << (order.size() / batch_size) << ", batch total error: " << setw(15) << fixed << setprecision(5) << batch_total_error << ", batch_correct_predictions: " << batch_correct_predictions << endl;
+        cerr << setw(5) << j << "/" << setw(5) << pipeline.get_number_batches() << ", batch total error: " << setw(15) << fixed << setprecision(5) << batch_total_error << ", batch_correct_predictions: " << batch_correct_predictions << endl;
         */
 
         /*
@@ -2070,6 +2223,8 @@ void CNN_Genome::evaluate(const ImagesInterface &images, const vector<long> &ord
          << ", weight_update_time: " << weight_update_time
          << ", other_time: " << other_time
          << endl;
+
+    if (is_profiling()) profile.record(epoch, training, order.size(), batch_size, epoch_time, nodes, edges);
 }
 
 void CNN_Genome::evaluate(string progress_name, const ImagesInterface &images, float &total_error, int &correct_predictions) {
@@ -2231,6 +2386,11 @@ void CNN_Genome::stochastic_backpropagation(const ImagesInterface &training_imag
     set_to_best();
     evaluate(training_images, backprop_order, training_error, training_predictions, false, false);
     print_progress(cerr, "best training", training_error, training_predictions, number_training_images);
+
+    if (is_profiling()) {
+        profile.write_to_directory(get_profile_directory(), generation_id);
+        profile.clear();
+    }
 }
 
 void CNN_Genome::print_results(ostream &out) const {
@@ -14,6 +14,8 @@ using std::vector;
 #include "image_tools/large_image_set.hxx"
 #include "cnn_node.hxx"
 #include "cnn_edge.hxx"
+#include "batch_pipeline.hxx"
+#include "cnn_profile.hxx"
 #include "common/random.hxx"
 
 #define SANITY_CHECK_BEFORE_INSERT 0
@@ -22,6 +24,17 @@ using std::vector;
 //mysql can't handl the max float value for some reason
 #define EXACT_MAX_FLOAT 10000000
 
+//the number of windows along each side of the tiles a large image is split
+//into when it is evaluated fully convolutionally
+#define SLIDING_WINDOW_TILE_SIZE 128
+
+/**
+ * Sets whether the windows of large images are evaluated one at a time as
+ * batch entries (if --per_window_inference is given) instead of fully
+ * convolutionally, whenever the genome allows it (the default).
+ */
+void set_sliding_window_inference(const vector<string> &arguments);
+
 class CNN_Genome {
     private:
         string version_str;
@@ -87,6 +100,8 @@ class CNN_Genome {
 
         map<string, int> generated_by_map;
 
+        CNN_Profile profile; /**< the times of each pass through the images, if profiling (see set_profile_directory). */
+
         int (*progress_function)(float);
 
     public:
@@ -160,6 +175,8 @@ class CNN_Genome {
 
         const vector<CNN_Node*> get_nodes() const;
         const vector<CNN_Edge*> get_edges() const;
+        const vector<CNN_Node*> get_input_nodes() const;
+        const vector<CNN_Node*> get_softmax_nodes() const;
 
         CNN_Node* get_node(int node_position);
         CNN_Edge* get_edge(int edge_position);
@@ -176,6 +193,7 @@ class CNN_Genome {
         int get_batch_size() const;
 
         float get_alpha() const;
+        float get_epsilon() const;
         int get_velocity_reset() const;
 
         float get_input_dropout_probability() const;
@@ -205,6 +223,7 @@ class CNN_Genome {
  
         void evaluate_images(const ImagesInterface &images, const vector<int> &batch, vector< vector<float> > &predictions, int offset);
         void evaluate_images(const ImagesInterface &images, const vector<int> &batch, bool training, float &total_error, int &correct_predictions, bool accumulate_test_statistics);
+        void evaluate_images(const ImagesInterface &images, const InputBatch &input_batch, bool training, float &total_error, int &correct_predictions, bool accumulate_test_statistics);
 
         void set_to_best();
         void save_to_best();
@@ -214,6 +233,30 @@ class CNN_Genome {
 
         void check_gradients(const ImagesInterface &images);
 
+        /**
+         * Whether evaluating this genome over the whole of a large image gives
+         * the same predictions as evaluating each of its windows: the images
+         * are not padded, their windows are the size of the input nodes and
+         * every edge is a convolution which does not pad
+         * its input (pooling edges and reverse filters depend on where the
+         * window is).
+         */
+        bool is_fully_convolutional(const MultiImagesInterface &images) const;
+
+        /**
+         * Calculates the predictions of every window of a large image by
+         * propagating each edge once over tiles of SLIDING_WINDOW_TILE_SIZE by
+         * SLIDING_WINDOW_TILE_SIZE windows, instead of once for each window.
+         */
+        void evaluate_fully_convolutional(const MultiImagesInterface &images, int image_number, vector< vector<float> > &predictions);
+
+        /**
+         * Calculates the predictions of every window (subimage) of a large
+         * image, fully convolutionally if the genome allows it, otherwise a
+         * batch of windows at a time.
+         */
+        void evaluate_subimages(const MultiImagesInterface &images, int image_number, vector< vector<float> > &predictions);
+
         void evaluate_large_images(const LargeImages &images, string output_directory);
 
         void evaluate(const ImagesInterface &images, vector< vector<float> > &predictions);
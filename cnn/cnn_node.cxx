@@ -30,6 +30,7 @@ using std::numeric_limits;
 
 #include <random>
 using std::minstd_rand0;
+using std::seed_seq;
 using std::uniform_real_distribution;
 
 #include <stdexcept>
@@ -48,6 +49,7 @@ using std::vector;
 #include "image_tools/image_set.hxx"
 #include "common/random.hxx"
 #include "common/exp.hxx"
+#include "batch_threads.hxx"
 #include "comparison.hxx"
 #include "cnn_genome.hxx"
 #include "cnn_edge.hxx"
@@ -932,25 +934,42 @@ void CNN_Node::apply_relu(float* values, float* gradients) {
     }
 }
 
-void CNN_Node::apply_dropout(float* values, float* gradients, bool perform_dropout, bool accumulate_test_statistics, float dropout_probability, minstd_rand0 &generator) {
+void apply_dropout(float* values, float* gradients, int32_t batch_size, int32_t image_size, bool perform_dropout, bool accumulate_test_statistics, float dropout_probability, minstd_rand0 &generator) {
     if (perform_dropout && !accumulate_test_statistics) {
-        for (int32_t current = 0; current < total_size; current++) {
-            //cout << "values for node " << innovation_number << " now " << values[batch_number][y][x] << " after adding bias: " << bias[batch_number][y][x] << endl;
-
-            if (random_0_1(generator) < dropout_probability) {
-                values[current] = 0.0;
-                gradients[current] = 0.0;
+        //each image gets its own random number stream, so which values are
+        //dropped out does not depend on how many batch threads there are.  the
+        //streams are seeded by mixing one seed from the generator with the
+        //image's index, as seeding them with consecutive outputs of the
+        //generator would make each image's stream the last one's shifted by a
+        //single value
+        uint32_t batch_seed = generator();
+
+        parallel_for_batch(batch_size, [&](int32_t chunk, int32_t batch_begin, int32_t batch_end) {
+            for (int32_t batch_number = batch_begin; batch_number < batch_end; batch_number++) {
+                seed_seq image_seed{batch_seed, (uint32_t)batch_number};
+                minstd_rand0 image_generator(image_seed);
+
+                for (int32_t current = batch_number * image_size; current < (batch_number + 1) * image_size; current++) {
+                    if (random_0_1(image_generator) < dropout_probability) {
+                        values[current] = 0.0;
+                        if (gradients != NULL) gradients[current] = 0.0;
+                    }
+                }
             }
-        }
+        });
 
     } else {
         float dropout_scale = 1.0 - dropout_probability;
-        for (int32_t current = 0; current < total_size; current++) {
+        for (int32_t current = 0; current < batch_size * image_size; current++) {
             values[current] *= dropout_scale;
         }
     }
 }
 
+void CNN_Node::apply_dropout(float* values, float* gradients, bool perform_dropout, bool accumulate_test_statistics, float dropout_probability, minstd_rand0 &generator) {
+    ::apply_dropout(values, gradients, batch_size, size_y * size_x, perform_dropout, accumulate_test_statistics, dropout_probability, generator);
+}
+
 void CNN_Node::backpropagate_relu(float* errors, float* gradients) {
     for (int32_t current = 0; current < total_size; current++) {
         errors[current] *= gradients[current];
@@ -1089,41 +1108,35 @@ void CNN_Node::backpropagate_batch_normalization(bool training, float mu, float
 }
 
 
-void CNN_Node::set_values(const ImagesInterface &images, const vector<int> &batch, int channel, bool perform_dropout, bool accumulate_test_statistics, float input_dropout_probability, minstd_rand0 &generator) {
-    //images.size() may be less than batch size, in the case when the total number of images is not divisible by the batch_size
-    if (batch.size() > batch_size) {
+void CNN_Node::set_values(const InputBatch &input_batch, int channel) {
+    //the batch may have less images than the batch size, in the case when the total number of images is not divisible by the batch_size
+    if ((int32_t)input_batch.batch.size() > batch_size) {
         ostringstream error_message;
-        error_message << "ERROR: number of batch images: " << batch.size() << " > batch_size of input node: " << batch_size << endl;
+        error_message << "ERROR: number of batch images: " << input_batch.batch.size() << " > batch_size of input node: " << batch_size << endl;
         throw runtime_error(error_message.str());
     }
 
-    if (images.get_image_height() != size_y) {
+    if (input_batch.image_height != size_y) {
         ostringstream error_message;
-        error_message << "ERROR: height of input image: " << images.get_image_height() << " != size_y of input node: " << size_y << endl;
+        error_message << "ERROR: height of input image: " << input_batch.image_height << " != size_y of input node: " << size_y << endl;
         throw runtime_error(error_message.str());
     }
 
-    if (images.get_image_width() != size_x) {
+    if (input_batch.image_width != size_x) {
         ostringstream error_message;
-        error_message << "ERROR: width of input image: " << images.get_image_width() << " != size_x of input node: " << size_x << endl;
+        error_message << "ERROR: width of input image: " << input_batch.image_width << " != size_x of input node: " << size_x << endl;
         throw runtime_error(error_message.str());
     }
 
-    //images.size() may be less than batch size, in the case when the total number of images is not divisible by the batch_size
-    int current = 0;
-    for (int32_t batch_number = 0; batch_number < batch.size(); batch_number++) {
-        for (int32_t y = 0; y < size_y; y++) {
-            for (int32_t x = 0; x < size_x; x++) {
-                values_out[current] = images.get_pixel(batch[batch_number], channel, y, x);
-                current++;
-            }
-        }
+    //the input dropout has already been applied to the batch, and the
+    //relu_gradients of an input node are 0 after it is reset so they do not
+    //need to be dropped out as well
+    const vector<float> &values = input_batch.channel_values[channel];
+    for (int32_t current = 0; current < batch_size * size_y * size_x; current++) {
+        values_out[current] = values[current];
     }
-
-    if (input_dropout_probability > 0) apply_dropout(values_out, relu_gradients, perform_dropout, accumulate_test_statistics, input_dropout_probability, generator);
 }
 
-
 void CNN_Node::input_fired(bool training, bool accumulate_test_statistics, float epsilon, float alpha, bool perform_dropout, float hidden_dropout_probability, minstd_rand0 &generator) {
 
     using namespace std::chrono;
@@ -1160,6 +1173,32 @@ void CNN_Node::input_fired(bool training, bool accumulate_test_statistics, float
     input_fired_time += time_span.count() / 1000.0;
 }
 
+void CNN_Node::input_fired_tile(float* tile_values_in, float* tile_values_out, int32_t tile_size, float epsilon, float hidden_dropout_probability) const {
+    float dropout_scale = 1.0 - hidden_dropout_probability;
+
+    float term1 =  gamma / exact_sqrt(running_variance + epsilon);
+    float term2 = beta - ((gamma * running_mean) / exact_sqrt(running_variance + epsilon));
+
+    for (int32_t current = 0; current < tile_size; current++) {
+        if (tile_values_in[current] <= RELU_MIN) {
+            tile_values_in[current] = tile_values_in[current] * RELU_MIN_LEAK;
+        } else if (tile_values_in[current] > RELU_MAX) {
+            tile_values_in[current] = RELU_MAX;
+        }
+
+        if (hidden_dropout_probability > 0) tile_values_in[current] *= dropout_scale;
+
+        tile_values_out[current] = (term1 * tile_values_in[current]) + term2;
+    }
+}
+
+void CNN_Node::get_folded_batch_normalization(float epsilon, float hidden_dropout_probability, float &scale, float &shift) const {
+    scale = gamma / exact_sqrt(running_variance + epsilon);
+    shift = beta - ((gamma * running_mean) / exact_sqrt(running_variance + epsilon));
+
+    if (hidden_dropout_probability > 0) scale *= 1.0 - hidden_dropout_probability;
+}
+
 void CNN_Node::output_fired(bool training, float mu, float learning_rate, float epsilon) {
     using namespace std::chrono;
     high_resolution_clock::time_point output_fired_start_time = high_resolution_clock::now();
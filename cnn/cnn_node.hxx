@@ -34,6 +34,8 @@ using std::vector;
 
 #include "common/random.hxx"
 
+#include "batch_pipeline.hxx"
+
 #define RELU_MIN 0
 #define RELU_MIN_LEAK 0.005
 
@@ -45,6 +47,12 @@ using std::vector;
 #define OUTPUT_NODE 2
 #define SOFTMAX_NODE 3
 
+/**
+ * Drops out each value of the batch_size images with the dropout probability
+ * (along with its gradient, if gradients is not NULL) when performing dropout,
+ * otherwise scales the values by 1 - the dropout probability.
+ */
+void apply_dropout(float* values, float* gradients, int32_t batch_size, int32_t image_size, bool perform_dropout, bool accumulate_test_statistics, float dropout_probability, minstd_rand0 &generator);
 
 class CNN_Node {
     private:
@@ -153,7 +161,7 @@ class CNN_Node {
 
         bool has_nan() const;
 
-        void set_values(const ImagesInterface &images, const vector<int> &batch, int channel, bool perform_dropout, bool accumulate_test_statistics, float input_dropout_probability, minstd_rand0 &generator);
+        void set_values(const InputBatch &input_batch, int channel);
 
         float get_value_in(int batch_number, int y, int x);
         void set_value_in(int batch_number, int y, int x, float value);
@@ -199,6 +207,20 @@ class CNN_Node {
         int get_inputs_fired() const;
         void input_fired(bool training, bool accumulate_test_statistics, float epsilon, float alpha, bool perform_dropout, float hidden_dropout_probability, minstd_rand0 &generator);
 
+        /**
+         * Calculates the values out of a tile of this node (when it is not
+         * training) from its values in, as input_fired does for a batch once all
+         * of the node's inputs have fired.
+         */
+        void input_fired_tile(float* tile_values_in, float* tile_values_out, int32_t tile_size, float epsilon, float hidden_dropout_probability) const;
+
+        /**
+         * The scale and shift of the hidden dropout scaling and (test) batch
+         * normalization folded together, so when not training the node's values
+         * out are scale * relu(value in) + shift.
+         */
+        void get_folded_batch_normalization(float epsilon, float hidden_dropout_probability, float &scale, float &shift) const;
+
         void add_output();
         void disable_output();
         int get_number_outputs() const;
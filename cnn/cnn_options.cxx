@@ -0,0 +1,25 @@
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+
+#include "image_tools/image_set.hxx"
+
+#include "batch_pipeline.hxx"
+#include "batch_threads.hxx"
+#include "cnn_options.hxx"
+#include "cnn_profile.hxx"
+#include "kernels.hxx"
+#include "propagation.hxx"
+
+void set_cnn_options(const vector<string> &arguments) {
+    set_kernel_isa(arguments);
+    set_convolution_method(arguments);
+    set_batch_threads(arguments);
+    set_prefetch_batches(arguments);
+    set_profile_directory(arguments);
+    set_memory_map_images(argument_exists(arguments, "--mmap_images"));
+}
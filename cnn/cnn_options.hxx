@@ -0,0 +1,25 @@
+#ifndef CNN_OPTIONS_HXX
+#define CNN_OPTIONS_HXX
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+/**
+ * Sets the options every program training or evaluating CNN_Genomes shares
+ * from its command line arguments:
+ *   --kernel_isa (see set_kernel_isa)
+ *   --convolution (see set_convolution_method)
+ *   --batch_threads (see set_batch_threads)
+ *   --prefetch_batches (see set_prefetch_batches)
+ *   --profile_directory (see set_profile_directory)
+ *   --mmap_images (see set_memory_map_images)
+ *
+ * This should be called at the start of main, before any threads are
+ * started or images are read.
+ */
+void set_cnn_options(const vector<string> &arguments);
+
+#endif
@@ -0,0 +1,429 @@
+#include <algorithm>
+using std::find;
+using std::min;
+
+#include <fstream>
+using std::ofstream;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+using std::ostream;
+
+#include <map>
+using std::map;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <tuple>
+using std::make_tuple;
+using std::tuple;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/files.hxx"
+
+#include "cnn_node.hxx"
+#include "cnn_edge.hxx"
+#include "cnn_profile.hxx"
+
+//estimates of the operations each value of a hidden node takes when it fires
+//forward (relu, dropout and batch normalization) and backward, and of the
+//floats it reads and writes to do so
+#define NODE_FORWARD_FLOPS 10
+#define NODE_BACKWARD_FLOPS 12
+#define NODE_FORWARD_FLOATS 4
+#define NODE_BACKWARD_FLOATS 5
+
+//the operations and floats read and written for each weight by
+//Kernels::update_weights
+#define WEIGHT_UPDATE_FLOPS 9
+#define WEIGHT_UPDATE_FLOATS 5
+
+static string profile_directory = "";
+
+void set_profile_directory(string directory) {
+    profile_directory = directory;
+}
+
+void set_profile_directory(const vector<string> &arguments) {
+    string directory = "";
+    get_argument(arguments, "--profile_directory", false, directory);
+
+    set_profile_directory(directory);
+}
+
+string get_profile_directory() {
+    return profile_directory;
+}
+
+bool is_profiling() {
+    return profile_directory.compare("") != 0;
+}
+
+static string edge_type_name(int type) {
+    if (type == CONVOLUTIONAL) return "convolutional";
+    if (type == POOLING) return "pooling";
+    return "unknown";
+}
+
+static string node_type_name(int type) {
+    if (type == INPUT_NODE) return "input";
+    if (type == HIDDEN_NODE) return "hidden";
+    if (type == OUTPUT_NODE) return "output";
+    if (type == SOFTMAX_NODE) return "softmax";
+    return "unknown";
+}
+
+static string pass_name(bool training) {
+    if (training) return "training";
+    return "evaluation";
+}
+
+static EdgeProfile get_edge_profile(CNN_Edge *edge, bool training, int number_images, int number_batches) {
+    EdgeProfile profile;
+    profile.innovation_number = edge->get_innovation_number();
+    profile.input_innovation_number = edge->get_input_innovation_number();
+    profile.output_innovation_number = edge->get_output_innovation_number();
+
+    profile.type = edge->get_type();
+    profile.input_size_y = edge->get_input_node()->get_size_y();
+    profile.input_size_x = edge->get_input_node()->get_size_x();
+    profile.output_size_y = edge->get_output_node()->get_size_y();
+    profile.output_size_x = edge->get_output_node()->get_size_x();
+    profile.filter_y = edge->get_filter_y();
+    profile.filter_x = edge->get_filter_x();
+    profile.reverse_filter_y = edge->is_reverse_filter_y();
+    profile.reverse_filter_x = edge->is_reverse_filter_x();
+
+    profile.forward_time = 0.0;
+    profile.backward_time = 0.0;
+    profile.weight_update_time = 0.0;
+    edge->accumulate_times(profile.forward_time, profile.backward_time, profile.weight_update_time);
+
+    int64_t input_size = (int64_t)profile.input_size_y * profile.input_size_x;
+    int64_t output_size = (int64_t)profile.output_size_y * profile.output_size_x;
+    int64_t filter_size = (int64_t)profile.filter_y * profile.filter_x;
+
+    int64_t flops = 0;
+    int64_t floats = 0;
+
+    if (profile.type == CONVOLUTIONAL) {
+        //each value of the smaller of the input and output is multiplied by
+        //every weight of the filter
+        int64_t multiply_adds = (int64_t)min(profile.input_size_y, profile.output_size_y) * profile.filter_y * min(profile.input_size_x, profile.output_size_x) * profile.filter_x;
+
+        //the input is read, the output is added to and the weights are read
+        //once a batch
+        flops += number_images * 2 * multiply_adds;
+        floats += number_images * (input_size + 2 * output_size) + number_batches * filter_size;
+
+        if (training) {
+            //the input errors and the weight updates
+            flops += number_images * 4 * multiply_adds;
+            floats += number_images * (output_size + 3 * input_size) + number_batches * 3 * filter_size;
+
+            flops += number_batches * WEIGHT_UPDATE_FLOPS * filter_size;
+            floats += number_batches * WEIGHT_UPDATE_FLOATS * filter_size;
+        }
+
+    } else if (profile.type == POOLING) {
+        //each input is compared once and each output is scaled, and the input
+        //node's pool gradients are written
+        flops += number_images * (input_size + output_size);
+        floats += number_images * (2 * input_size + 2 * output_size);
+
+        if (training) {
+            flops += number_images * (2 * input_size + output_size);
+            floats += number_images * (4 * input_size + output_size);
+        }
+    }
+
+    profile.flops = flops;
+    profile.bytes = floats * sizeof(float);
+
+    return profile;
+}
+
+static NodeProfile get_node_profile(CNN_Node *node, bool training, int number_images) {
+    NodeProfile profile;
+    profile.innovation_number = node->get_innovation_number();
+
+    if (node->is_input()) profile.type = INPUT_NODE;
+    else if (node->is_softmax()) profile.type = SOFTMAX_NODE;
+    else if (node->is_output()) profile.type = OUTPUT_NODE;
+    else profile.type = HIDDEN_NODE;
+
+    profile.size_y = node->get_size_y();
+    profile.size_x = node->get_size_x();
+
+    profile.input_fired_time = 0.0;
+    profile.output_fired_time = 0.0;
+    node->accumulate_times(profile.input_fired_time, profile.output_fired_time);
+
+    int64_t values = (int64_t)number_images * profile.size_y * profile.size_x;
+
+    profile.flops = 0;
+    profile.bytes = 0;
+
+    //only the hidden nodes do anything when they fire
+    if (profile.type == HIDDEN_NODE) {
+        profile.flops = values * NODE_FORWARD_FLOPS;
+        profile.bytes = values * NODE_FORWARD_FLOATS * sizeof(float);
+
+        if (training) {
+            profile.flops += values * NODE_BACKWARD_FLOPS;
+            profile.bytes += values * NODE_BACKWARD_FLOATS * sizeof(float);
+        }
+    }
+
+    return profile;
+}
+
+void CNN_Profile::record(int epoch, bool training, int number_images, int batch_size, float time, const vector<CNN_Node*> &nodes, const vector<CNN_Edge*> &edges) {
+    ProfilePass pass;
+    pass.epoch = epoch;
+    pass.training = training;
+    pass.number_images = number_images;
+    pass.batch_size = batch_size;
+    pass.time = time;
+
+    int number_batches = (number_images + batch_size - 1) / batch_size;
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (!edges[i]->is_reachable()) continue;
+        pass.edges.push_back( get_edge_profile(edges[i], training, number_images, number_batches) );
+    }
+
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (!nodes[i]->is_reachable()) continue;
+        pass.nodes.push_back( get_node_profile(nodes[i], training, number_images) );
+    }
+
+    passes.push_back(pass);
+}
+
+void CNN_Profile::clear() {
+    passes.clear();
+}
+
+int CNN_Profile::get_number_passes() const {
+    return passes.size();
+}
+
+void CNN_Profile::write_csv(ostream &out) const {
+    out << "epoch,pass,number_images,batch_size,kind,innovation_number,input_innovation_number,output_innovation_number,type,input_size_y,input_size_x,output_size_y,output_size_x,filter_y,filter_x,reverse_filter_y,reverse_filter_x,forward_time,backward_time,weight_update_time,flops,bytes" << endl;
+
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        const ProfilePass &pass = passes[i];
+
+        for (uint32_t j = 0; j < pass.edges.size(); j++) {
+            const EdgeProfile &edge = pass.edges[j];
+
+            out << pass.epoch << "," << pass_name(pass.training) << "," << pass.number_images << "," << pass.batch_size
+                << ",edge," << edge.innovation_number << "," << edge.input_innovation_number << "," << edge.output_innovation_number << "," << edge_type_name(edge.type)
+                << "," << edge.input_size_y << "," << edge.input_size_x << "," << edge.output_size_y << "," << edge.output_size_x
+                << "," << edge.filter_y << "," << edge.filter_x << "," << edge.reverse_filter_y << "," << edge.reverse_filter_x
+                << "," << edge.forward_time << "," << edge.backward_time << "," << edge.weight_update_time << "," << edge.flops << "," << edge.bytes << endl;
+        }
+
+        //the nodes' input and output fired times are their forward and
+        //backward times, and their sizes are given as both input and output
+        for (uint32_t j = 0; j < pass.nodes.size(); j++) {
+            const NodeProfile &node = pass.nodes[j];
+
+            out << pass.epoch << "," << pass_name(pass.training) << "," << pass.number_images << "," << pass.batch_size
+                << ",node," << node.innovation_number << ",,," << node_type_name(node.type)
+                << "," << node.size_y << "," << node.size_x << "," << node.size_y << "," << node.size_x
+                << ",,,,," << node.input_fired_time << "," << node.output_fired_time << ",0," << node.flops << "," << node.bytes << endl;
+        }
+    }
+}
+
+/**
+ * The edges of one type and filter size, summed over all the passes of
+ * training or evaluation.
+ */
+class ProfileSummary {
+    public:
+        vector<int> innovation_numbers;
+
+        float forward_time;
+        float backward_time;
+        float weight_update_time;
+
+        int64_t flops;
+        int64_t bytes;
+
+        ProfileSummary() : forward_time(0.0), backward_time(0.0), weight_update_time(0.0), flops(0), bytes(0) {
+        }
+
+        void add(int innovation_number, float _forward_time, float _backward_time, float _weight_update_time, int64_t _flops, int64_t _bytes) {
+            if (find(innovation_numbers.begin(), innovation_numbers.end(), innovation_number) == innovation_numbers.end()) {
+                innovation_numbers.push_back(innovation_number);
+            }
+
+            forward_time += _forward_time;
+            backward_time += _backward_time;
+            weight_update_time += _weight_update_time;
+            flops += _flops;
+            bytes += _bytes;
+        }
+
+        void write(ostream &out, string pass, string type, string filter, float total_time) const {
+            float time = forward_time + backward_time + weight_update_time;
+
+            float percent_time = 0.0;
+            if (total_time > 0) percent_time = 100.0 * time / total_time;
+
+            float gflops_per_second = 0.0;
+            if (time > 0) gflops_per_second = (flops / 1.0e9) / time;
+
+            float flops_per_byte = 0.0;
+            if (bytes > 0) flops_per_byte = (float)flops / bytes;
+
+            out << pass << "," << type << "," << filter << "," << innovation_numbers.size()
+                << "," << forward_time << "," << backward_time << "," << weight_update_time << "," << time << "," << percent_time
+                << "," << flops << "," << bytes << "," << gflops_per_second << "," << flops_per_byte << endl;
+        }
+};
+
+void CNN_Profile::write_summary(ostream &out) const {
+    out << "pass,type,filter_y,filter_x,reverse_filter_y,reverse_filter_x,count,forward_time,backward_time,weight_update_time,time,percent_time,flops,bytes,gflops_per_second,flops_per_byte" << endl;
+
+    for (int training = 1; training >= 0; training--) {
+        //type, filter_y, filter_x, reverse_filter_y, reverse_filter_x
+        map< tuple<int, int, int, bool, bool>, ProfileSummary > edge_summaries;
+        ProfileSummary node_summary;
+        float total_time = 0.0;
+        float other_time = 0.0;
+
+        for (uint32_t i = 0; i < passes.size(); i++) {
+            const ProfilePass &pass = passes[i];
+            if (pass.training != (bool)training) continue;
+
+            total_time += pass.time;
+            other_time += pass.time;
+
+            for (uint32_t j = 0; j < pass.edges.size(); j++) {
+                const EdgeProfile &edge = pass.edges[j];
+
+                edge_summaries[make_tuple(edge.type, edge.filter_y, edge.filter_x, edge.reverse_filter_y, edge.reverse_filter_x)].add(edge.innovation_number, edge.forward_time, edge.backward_time, edge.weight_update_time, edge.flops, edge.bytes);
+                other_time -= edge.forward_time + edge.backward_time + edge.weight_update_time;
+            }
+
+            for (uint32_t j = 0; j < pass.nodes.size(); j++) {
+                const NodeProfile &node = pass.nodes[j];
+
+                node_summary.add(node.innovation_number, node.input_fired_time, node.output_fired_time, 0.0, node.flops, node.bytes);
+                other_time -= node.input_fired_time + node.output_fired_time;
+            }
+        }
+
+        if (total_time == 0.0) continue;
+
+        string name = pass_name(training);
+
+        for (auto summary = edge_summaries.begin(); summary != edge_summaries.end(); summary++) {
+            const tuple<int, int, int, bool, bool> &key = summary->first;
+
+            string filter = to_string(std::get<1>(key)) + "," + to_string(std::get<2>(key)) + "," + to_string(std::get<3>(key)) + "," + to_string(std::get<4>(key));
+            summary->second.write(out, name, edge_type_name(std::get<0>(key)), filter, total_time);
+        }
+
+        node_summary.write(out, name, "nodes", ",,,", total_time);
+
+        //the time spent outside of the edges and nodes, e.g., preparing
+        //batches and the softmax
+        ProfileSummary other_summary;
+        other_summary.forward_time = other_time;
+        other_summary.write(out, name, "other", ",,,", total_time);
+    }
+}
+
+void CNN_Profile::write_json(ostream &out) const {
+    out << "{" << endl;
+    out << "  \"passes\": [" << endl;
+
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        const ProfilePass &pass = passes[i];
+
+        out << "    {" << endl;
+        out << "      \"epoch\": " << pass.epoch << "," << endl;
+        out << "      \"pass\": \"" << pass_name(pass.training) << "\"," << endl;
+        out << "      \"number_images\": " << pass.number_images << "," << endl;
+        out << "      \"batch_size\": " << pass.batch_size << "," << endl;
+        out << "      \"time\": " << pass.time << "," << endl;
+
+        out << "      \"edges\": [" << endl;
+        for (uint32_t j = 0; j < pass.edges.size(); j++) {
+            const EdgeProfile &edge = pass.edges[j];
+
+            out << "        {\"innovation_number\": " << edge.innovation_number
+                << ", \"input_innovation_number\": " << edge.input_innovation_number
+                << ", \"output_innovation_number\": " << edge.output_innovation_number
+                << ", \"type\": \"" << edge_type_name(edge.type) << "\""
+                << ", \"input_size\": [" << edge.input_size_y << ", " << edge.input_size_x << "]"
+                << ", \"output_size\": [" << edge.output_size_y << ", " << edge.output_size_x << "]"
+                << ", \"filter\": [" << edge.filter_y << ", " << edge.filter_x << "]"
+                << ", \"reverse_filter\": [" << (edge.reverse_filter_y ? "true" : "false") << ", " << (edge.reverse_filter_x ? "true" : "false") << "]"
+                << ", \"forward_time\": " << edge.forward_time
+                << ", \"backward_time\": " << edge.backward_time
+                << ", \"weight_update_time\": " << edge.weight_update_time
+                << ", \"flops\": " << edge.flops
+                << ", \"bytes\": " << edge.bytes << "}";
+            if (j + 1 < pass.edges.size()) out << ",";
+            out << endl;
+        }
+        out << "      ]," << endl;
+
+        out << "      \"nodes\": [" << endl;
+        for (uint32_t j = 0; j < pass.nodes.size(); j++) {
+            const NodeProfile &node = pass.nodes[j];
+
+            out << "        {\"innovation_number\": " << node.innovation_number
+                << ", \"type\": \"" << node_type_name(node.type) << "\""
+                << ", \"size\": [" << node.size_y << ", " << node.size_x << "]"
+                << ", \"input_fired_time\": " << node.input_fired_time
+                << ", \"output_fired_time\": " << node.output_fired_time
+                << ", \"flops\": " << node.flops
+                << ", \"bytes\": " << node.bytes << "}";
+            if (j + 1 < pass.nodes.size()) out << ",";
+            out << endl;
+        }
+        out << "      ]" << endl;
+
+        out << "    }";
+        if (i + 1 < passes.size()) out << ",";
+        out << endl;
+    }
+
+    out << "  ]" << endl;
+    out << "}" << endl;
+}
+
+void CNN_Profile::write_to_directory(string directory, int generation_id) const {
+    mkpath(directory.c_str(), 0777);
+
+    string prefix = directory + "/genome_" + to_string(generation_id) + "_profile";
+
+    ofstream csv_file((prefix + ".csv").c_str());
+    write_csv(csv_file);
+    csv_file.close();
+
+    ofstream json_file((prefix + ".json").c_str());
+    write_json(json_file);
+    json_file.close();
+
+    ofstream summary_file((prefix + "_summary.csv").c_str());
+    write_summary(summary_file);
+    summary_file.close();
+
+    if (!csv_file || !json_file || !summary_file) {
+        cerr << "ERROR: could not write the profile of genome " << generation_id << " to '" << directory << "'" << endl;
+    }
+}
@@ -0,0 +1,132 @@
+#ifndef CNN_PROFILE_HXX
+#define CNN_PROFILE_HXX
+
+#include "stdint.h"
+
+#include <iostream>
+using std::ostream;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "cnn_node.hxx"
+#include "cnn_edge.hxx"
+
+/**
+ * Sets the directory the profiles of trained genomes are written to (see
+ * CNN_Profile).  Genomes are only profiled if it is set.
+ */
+void set_profile_directory(string directory);
+
+/**
+ * Sets the profile directory from --profile_directory, if it is given.
+ */
+void set_profile_directory(const vector<string> &arguments);
+
+string get_profile_directory();
+
+bool is_profiling();
+
+/**
+ * The time spent propagating an edge over one pass through a set of images,
+ * with an estimate of the floating point operations it took and the bytes it
+ * read and wrote.
+ */
+class EdgeProfile {
+    public:
+        int innovation_number;
+        int input_innovation_number;
+        int output_innovation_number;
+
+        int type;
+        int input_size_y, input_size_x;
+        int output_size_y, output_size_x;
+        int filter_y, filter_x;
+        bool reverse_filter_y, reverse_filter_x;
+
+        float forward_time;
+        float backward_time;
+        float weight_update_time;
+
+        int64_t flops;
+        int64_t bytes;
+};
+
+/**
+ * The time spent firing a node (i.e., its relu, dropout and batch
+ * normalization) over one pass through a set of images, with an estimate of
+ * the floating point operations it took and the bytes it read and wrote.
+ */
+class NodeProfile {
+    public:
+        int innovation_number;
+        int type;
+        int size_y, size_x;
+
+        float input_fired_time;
+        float output_fired_time;
+
+        int64_t flops;
+        int64_t bytes;
+};
+
+/**
+ * One pass through a set of images, forward only or (if training) forward and
+ * backward with weight updates.
+ */
+class ProfilePass {
+    public:
+        int epoch;
+        bool training;
+        int number_images;
+        int batch_size;
+        float time;
+
+        vector<EdgeProfile> edges;
+        vector<NodeProfile> nodes;
+};
+
+/**
+ * The times a genome's reachable edges and nodes take over each pass through
+ * the images while it is trained, from the timers they already keep (see
+ * CNN_Edge::accumulate_times and CNN_Node::accumulate_times), with estimates
+ * of the operations and memory traffic each does so their cost can be
+ * compared with their time.  The operations are those of a direct convolution
+ * (with 2 for each multiply add) whichever method is used, and the bytes are
+ * those each edge or node must read and write at least once.
+ */
+class CNN_Profile {
+    private:
+        vector<ProfilePass> passes;
+
+    public:
+        void record(int epoch, bool training, int number_images, int batch_size, float time, const vector<CNN_Node*> &nodes, const vector<CNN_Edge*> &edges);
+
+        void clear();
+        int get_number_passes() const;
+
+        /**
+         * Writes a row for each edge and node on each pass.
+         */
+        void write_csv(ostream &out) const;
+
+        /**
+         * Writes the time, operations and bytes of the edges over all the
+         * passes, summed by edge type and filter size, and of the nodes and
+         * everything else.
+         */
+        void write_summary(ostream &out) const;
+
+        void write_json(ostream &out) const;
+
+        /**
+         * Writes genome_<generation_id>_profile.csv, .json and _summary.csv
+         * to the directory.
+         */
+        void write_to_directory(string directory, int generation_id) const;
+};
+
+#endif
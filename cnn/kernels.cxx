@@ -0,0 +1,83 @@
+#include <iostream>
+using std::cerr;
+using std::endl;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+
+#include "kernels.hxx"
+
+KernelIsa detect_kernel_isa() {
+    //this may be called before main (e.g., by a static initializer), before
+    //the CPU features have been initialized
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f")) return KERNEL_AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) return KERNEL_AVX2;
+    return KERNEL_SSE;
+}
+
+bool kernel_isa_supported(KernelIsa isa) {
+    return isa <= detect_kernel_isa();
+}
+
+string kernel_isa_name(KernelIsa isa) {
+    switch (isa) {
+        case KERNEL_SSE: return "sse";
+        case KERNEL_AVX2: return "avx2";
+        case KERNEL_AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+static const Kernels* kernels_for(KernelIsa isa) {
+    switch (isa) {
+        case KERNEL_AVX512: return &avx512_kernels;
+        case KERNEL_AVX2: return &avx2_kernels;
+        default: return &sse_kernels;
+    }
+}
+
+static KernelIsa kernel_isa = detect_kernel_isa();
+static const Kernels *kernels = kernels_for(kernel_isa);
+
+void set_kernel_isa(KernelIsa isa) {
+    if (!kernel_isa_supported(isa)) {
+        cerr << "ERROR: this CPU does not support the '" << kernel_isa_name(isa) << "' kernels, the best it supports is '" << kernel_isa_name(detect_kernel_isa()) << "'" << endl;
+        exit(1);
+    }
+
+    kernel_isa = isa;
+    kernels = kernels_for(isa);
+}
+
+void set_kernel_isa(const vector<string> &arguments) {
+    string isa_name = "auto";
+    get_argument(arguments, "--kernel_isa", false, isa_name);
+
+    if (isa_name.compare("auto") == 0) {
+        set_kernel_isa(detect_kernel_isa());
+    } else if (isa_name.compare("sse") == 0) {
+        set_kernel_isa(KERNEL_SSE);
+    } else if (isa_name.compare("avx2") == 0) {
+        set_kernel_isa(KERNEL_AVX2);
+    } else if (isa_name.compare("avx512") == 0) {
+        set_kernel_isa(KERNEL_AVX512);
+    } else {
+        cerr << "ERROR: unknown --kernel_isa '" << isa_name << "', it should be one of auto, sse, avx2 or avx512" << endl;
+        exit(1);
+    }
+}
+
+KernelIsa get_kernel_isa() {
+    return kernel_isa;
+}
+
+const Kernels& get_kernels() {
+    return *kernels;
+}
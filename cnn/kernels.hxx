@@ -0,0 +1,114 @@
+#ifndef CNN_KERNELS_HXX
+#define CNN_KERNELS_HXX
+
+#include "stdint.h"
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+/**
+ * The instruction sets the CNN kernels are compiled for.  Each set's kernels
+ * are in their own translation unit (kernels_sse.cxx, kernels_avx2.cxx and
+ * kernels_avx512.cxx) compiled with that instruction set enabled, so a single
+ * binary can use whichever the CPU it runs on supports.
+ */
+enum KernelIsa {
+    KERNEL_SSE = 0,
+    KERNEL_AVX2 = 1,
+    KERNEL_AVX512 = 2
+};
+
+/**
+ * The hand vectorized inner loops of the CNN propagation, pooling and weight
+ * updates, for one instruction set.
+ */
+struct Kernels {
+    const char *name;
+
+    /**
+     * output[y][x] += sum over fy, fx of filter[fy][fx] * input[y + fy][x + fx], for each of
+     * the output_size_y by output_size_x outputs, where the input and output rows
+     * are input_stride and output_stride apart.  The input is zero outside of rows
+     * row_begin up to row_end and columns column_begin up to column_end (e.g., if
+     * it is padded), so the taps which only reach the zeros are skipped.
+     */
+    void (*correlate)(const float* input, int32_t input_stride, int32_t row_begin, int32_t row_end, int32_t column_begin, int32_t column_end, const float* filter, int32_t filter_y, int32_t filter_x, float* output, int32_t output_stride, int32_t output_size_y, int32_t output_size_x);
+
+    /**
+     * Sets max_values[x] to the maximum of the x column of the rows by columns
+     * input (with rows input_stride apart) and max_rows[x] to the first row it
+     * is in.  Values which are not greater than -numeric_limits<float>::max()
+     * are never the maximum, the same as in the scalar max pooling.
+     */
+    void (*column_max)(const float* input, int32_t input_stride, int32_t rows, int32_t columns, float* max_values, float* max_rows);
+
+    /**
+     * input_errors[i] += output_errors[i] * pool_gradients[i] for the size
+     * values, returning the sum of inputs[i] * output_errors[i] * pool_gradients[i]
+     * (the row's part of the pooling scale's update).
+     */
+    float (*pool_errors)(const float* output_errors, const float* pool_gradients, const float* inputs, float* input_errors, int32_t size);
+
+    /**
+     * The nesterov momentum update (with weight decay) of size weights, which
+     * are clamped to [-50, 50], resetting their velocity if they are.  This
+     * rounds the same as the scalar update for every instruction set.
+     */
+    void (*update_weights)(float* weights, const float* weight_updates, float* previous_velocity, int32_t size, float mu, float learning_rate, float weight_decay);
+
+    /**
+     * output[y][x] += sum over fy, fx of filter[fy][fx] * input[y + fy][x + fx]
+     * for 8 bit inputs and filters, accumulated exactly in 32 bit ints (so
+     * the result is the same for every instruction set).  Unlike correlate,
+     * the input is never skipped, so it needs to be padded with zeros if it
+     * is padded.
+     */
+    void (*correlate_int8)(const int8_t* input, int32_t input_stride, const int8_t* filter, int32_t filter_y, int32_t filter_x, int32_t* output, int32_t output_stride, int32_t output_size_y, int32_t output_size_x);
+
+    /**
+     * Converts size half precision (IEEE binary16) values to floats, and
+     * floats to half precision rounding to the nearest even.  These give the
+     * same results with or without the F16C instructions.
+     */
+    void (*half_to_float)(const uint16_t* half_values, float* values, int32_t size);
+    void (*float_to_half)(const float* values, uint16_t* half_values, int32_t size);
+};
+
+extern const Kernels sse_kernels;
+extern const Kernels avx2_kernels;
+extern const Kernels avx512_kernels;
+
+/**
+ * Returns the best instruction set the CPU (and operating system) supports.
+ */
+KernelIsa detect_kernel_isa();
+
+bool kernel_isa_supported(KernelIsa isa);
+
+string kernel_isa_name(KernelIsa isa);
+
+/**
+ * Uses the kernels for isa from now on, exiting with an error if the CPU does
+ * not support it.
+ */
+void set_kernel_isa(KernelIsa isa);
+
+/**
+ * Uses the kernels for the instruction set given by --kernel_isa (one of
+ * auto, sse, avx2 or avx512), or the detected one if it is not given or is
+ * auto.  This should be called before any threads are started.
+ */
+void set_kernel_isa(const vector<string> &arguments);
+
+KernelIsa get_kernel_isa();
+
+/**
+ * The kernels for the instruction set in use, which is the detected one
+ * unless set_kernel_isa was called.
+ */
+const Kernels& get_kernels();
+
+#endif
@@ -0,0 +1,12 @@
+#include "kernels_impl.hxx"
+
+const Kernels avx2_kernels = {
+    "avx2",
+    correlate<AVX2>,
+    column_max<AVX2>,
+    pool_errors<AVX2>,
+    update_weights<AVX2>,
+    correlate_int8<AVX2_INT8>,
+    half_to_float<AVX2>,
+    float_to_half<AVX2>
+};
@@ -0,0 +1,12 @@
+#include "kernels_impl.hxx"
+
+const Kernels avx512_kernels = {
+    "avx512",
+    correlate<AVX512>,
+    column_max<AVX512>,
+    pool_errors<AVX512>,
+    update_weights<AVX512>,
+    correlate_int8<AVX2_INT8>,
+    half_to_float<AVX512>,
+    float_to_half<AVX512>
+};
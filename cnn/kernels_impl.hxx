@@ -0,0 +1,616 @@
+#ifndef CNN_KERNELS_IMPL_HXX
+#define CNN_KERNELS_IMPL_HXX
+
+/**
+ * The kernels, written once over the vector types of an instruction set.
+ * This is only included by the kernels_<isa>.cxx files, each of which is
+ * compiled with its instruction set enabled.  Everything here is in an
+ * anonymous namespace, so the (differently compiled) instantiations in those
+ * files are never merged by the linker.
+ */
+
+#include "stdint.h"
+#include <cstring>
+
+#include <immintrin.h>
+
+#include <limits>
+using std::numeric_limits;
+
+#include "kernels.hxx"
+
+namespace {
+
+/**
+ * Four floats in an SSE register, which every x86-64 CPU has (the build
+ * already requires SSE3).
+ */
+struct SSE {
+    typedef __m128 vec;
+    typedef __m128 mask;
+    static const int32_t WIDTH = 4;
+    typedef SSE Half;
+
+    static inline vec zero() { return _mm_setzero_ps(); }
+    static inline vec set1(float value) { return _mm_set1_ps(value); }
+    static inline vec load(const float* values) { return _mm_loadu_ps(values); }
+    static inline void store(float* values, vec v) { _mm_storeu_ps(values, v); }
+
+    static inline vec add(vec a, vec b) { return _mm_add_ps(a, b); }
+    static inline vec sub(vec a, vec b) { return _mm_sub_ps(a, b); }
+    static inline vec mul(vec a, vec b) { return _mm_mul_ps(a, b); }
+    static inline vec fmadd(vec a, vec b, vec c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+    static inline mask greater(vec a, vec b) { return _mm_cmpgt_ps(a, b); }
+    //a where the mask is set, otherwise b
+    static inline vec select(mask m, vec a, vec b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+    static inline float sum(vec v) {
+        v = _mm_hadd_ps(v, v);
+        v = _mm_hadd_ps(v, v);
+        return _mm_cvtss_f32(v);
+    }
+
+    //there are no half precision conversions before F16C
+    static const bool HALF_CONVERSIONS = false;
+    static inline vec load_half(const uint16_t* values) { return zero(); }
+    static inline void store_half(uint16_t* values, vec v) {}
+};
+
+#ifdef __AVX2__
+/**
+ * Eight floats in an AVX register, with fused multiply adds.
+ */
+struct AVX2 {
+    typedef __m256 vec;
+    typedef __m256 mask;
+    static const int32_t WIDTH = 8;
+    typedef SSE Half;
+
+    static inline vec zero() { return _mm256_setzero_ps(); }
+    static inline vec set1(float value) { return _mm256_set1_ps(value); }
+    static inline vec load(const float* values) { return _mm256_loadu_ps(values); }
+    static inline void store(float* values, vec v) { _mm256_storeu_ps(values, v); }
+
+    static inline vec add(vec a, vec b) { return _mm256_add_ps(a, b); }
+    static inline vec sub(vec a, vec b) { return _mm256_sub_ps(a, b); }
+    static inline vec mul(vec a, vec b) { return _mm256_mul_ps(a, b); }
+    static inline vec fmadd(vec a, vec b, vec c) { return _mm256_fmadd_ps(a, b, c); }
+
+    static inline mask greater(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static inline vec select(mask m, vec a, vec b) { return _mm256_blendv_ps(b, a, m); }
+
+    static inline float sum(vec v) {
+        return SSE::sum(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+    }
+
+    static const bool HALF_CONVERSIONS = true;
+    static inline vec load_half(const uint16_t* values) { return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)values)); }
+    static inline void store_half(uint16_t* values, vec v) { _mm_storeu_si128((__m128i*)values, _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT)); }
+};
+#endif
+
+#ifdef __AVX512F__
+/**
+ * Sixteen floats in an AVX-512 register, with the comparisons in mask registers.
+ */
+struct AVX512 {
+    typedef __m512 vec;
+    typedef __mmask16 mask;
+    static const int32_t WIDTH = 16;
+    typedef AVX2 Half;
+
+    static inline vec zero() { return _mm512_setzero_ps(); }
+    static inline vec set1(float value) { return _mm512_set1_ps(value); }
+    static inline vec load(const float* values) { return _mm512_loadu_ps(values); }
+    static inline void store(float* values, vec v) { _mm512_storeu_ps(values, v); }
+
+    static inline vec add(vec a, vec b) { return _mm512_add_ps(a, b); }
+    static inline vec sub(vec a, vec b) { return _mm512_sub_ps(a, b); }
+    static inline vec mul(vec a, vec b) { return _mm512_mul_ps(a, b); }
+    static inline vec fmadd(vec a, vec b, vec c) { return _mm512_fmadd_ps(a, b, c); }
+
+    static inline mask greater(vec a, vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static inline vec select(mask m, vec a, vec b) { return _mm512_mask_blend_ps(m, b, a); }
+
+    static inline float sum(vec v) {
+        //splitting the halves with the cast and extract intrinsics trips
+        //gcc's uninitialized warnings, this compiles to the same
+        __m256 halves[2];
+        memcpy(halves, &v, sizeof(vec));
+        return AVX2::sum(_mm256_add_ps(halves[0], halves[1]));
+    }
+
+    //the 512 bit conversions trip the same warnings, so these convert each
+    //half with F16C
+    static const bool HALF_CONVERSIONS = true;
+    static inline vec load_half(const uint16_t* values) {
+        __m256 halves[2] = { AVX2::load_half(values), AVX2::load_half(values + AVX2::WIDTH) };
+        vec v;
+        memcpy(&v, halves, sizeof(vec));
+        return v;
+    }
+
+    static inline void store_half(uint16_t* values, vec v) {
+        __m256 halves[2];
+        memcpy(halves, &v, sizeof(vec));
+        AVX2::store_half(values, halves[0]);
+        AVX2::store_half(values + AVX2::WIDTH, halves[1]);
+    }
+};
+#endif
+
+/**
+ * Four 32 bit ints in an SSE register, each the sum of the products of a pair
+ * of 8 bit values with a pair of 8 bit weights, which is a single multiply
+ * add of the pairs widened to 16 bits (needing only SSE2).
+ */
+struct SSE_INT8 {
+    typedef __m128i vec;
+    static const int32_t WIDTH = 4;
+    typedef SSE_INT8 Half;
+
+    static inline vec zero() { return _mm_setzero_si128(); }
+    static inline vec load(const int32_t* values) { return _mm_loadu_si128((const __m128i*)values); }
+    static inline void store(int32_t* values, vec v) { _mm_storeu_si128((__m128i*)values, v); }
+    static inline vec add(vec a, vec b) { return _mm_add_epi32(a, b); }
+
+    static inline vec set_pair(int8_t first, int8_t second) { return _mm_set1_epi32((uint16_t)first | ((uint32_t)(uint16_t)second << 16)); }
+
+    //first_weight * first[i] + second_weight * second[i], with the weights
+    //paired by set_pair
+    static inline vec multiply_pairs(const int8_t* first, const int8_t* second, vec weights) {
+        int32_t first_values, second_values;
+        memcpy(&first_values, first, sizeof(int32_t));
+        memcpy(&second_values, second, sizeof(int32_t));
+
+        vec pairs = _mm_unpacklo_epi8(_mm_cvtsi32_si128(first_values), _mm_cvtsi32_si128(second_values));
+        //puts each byte in the high half of a 16 bit value, then shifts it back down with its sign
+        pairs = _mm_srai_epi16(_mm_unpacklo_epi8(pairs, pairs), 8);
+        return _mm_madd_epi16(pairs, weights);
+    }
+};
+
+#ifdef __AVX2__
+/**
+ * Eight 32 bit ints in an AVX register, as in SSE_INT8.  The AVX-512 kernels
+ * use these too, as multiply adds of 16 bit values in its registers need
+ * AVX512BW.
+ */
+struct AVX2_INT8 {
+    typedef __m256i vec;
+    static const int32_t WIDTH = 8;
+    typedef SSE_INT8 Half;
+
+    static inline vec zero() { return _mm256_setzero_si256(); }
+    static inline vec load(const int32_t* values) { return _mm256_loadu_si256((const __m256i*)values); }
+    static inline void store(int32_t* values, vec v) { _mm256_storeu_si256((__m256i*)values, v); }
+    static inline vec add(vec a, vec b) { return _mm256_add_epi32(a, b); }
+
+    static inline vec set_pair(int8_t first, int8_t second) { return _mm256_set1_epi32((uint16_t)first | ((uint32_t)(uint16_t)second << 16)); }
+
+    static inline vec multiply_pairs(const int8_t* first, const int8_t* second, vec weights) {
+        __m128i pairs = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)first), _mm_loadl_epi64((const __m128i*)second));
+        return _mm256_madd_epi16(_mm256_cvtepi8_epi16(pairs), weights);
+    }
+};
+#endif
+
+
+/********************************************
+ * CONVOLUTION
+ ********************************************/
+
+//output rows are processed in tiles of this many columns so the filter_y
+//input rows a tile reads stay in cache while every row of the tile is done
+#define COLUMN_TILE 256
+
+//the number of vectors of output pixels accumulated at once by the micro kernel
+#define BLOCK_VECTORS 4
+
+/**
+ * Accumulates VECTORS * V::WIDTH adjacent output pixels over rows by columns
+ * taps, where input and filter point to the first of those taps.
+ */
+template <class V, int32_t VECTORS>
+static inline void correlate_block(const float* input, int32_t input_stride, const float* filter, int32_t filter_stride, int32_t rows, int32_t columns, float* output) {
+    typename V::vec sums[VECTORS];
+    for (int32_t i = 0; i < VECTORS; i++) sums[i] = V::zero();
+
+    for (int32_t fy = 0; fy < rows; fy++) {
+        const float* input_row = input + (fy * input_stride);
+        const float* filter_row = filter + (fy * filter_stride);
+
+        for (int32_t fx = 0; fx < columns; fx++) {
+            typename V::vec weight = V::set1(filter_row[fx]);
+            for (int32_t i = 0; i < VECTORS; i++) {
+                sums[i] = V::fmadd(weight, V::load(input_row + fx + (i * V::WIDTH)), sums[i]);
+            }
+        }
+    }
+
+    for (int32_t i = 0; i < VECTORS; i++) {
+        V::store(output + (i * V::WIDTH), V::add(V::load(output + (i * V::WIDTH)), sums[i]));
+    }
+}
+
+/**
+ * Accumulates a single output pixel, which is vectorized along the filter's
+ * rows instead (for outputs narrower than a vector, e.g., the weight updates).
+ */
+template <class V>
+static inline void correlate_pixel(const float* input, int32_t input_stride, const float* filter, int32_t filter_stride, int32_t rows, int32_t columns, float* output) {
+    typename V::vec sums = V::zero();
+    SSE::vec short_sums = SSE::zero();
+    float sum = 0.0;
+
+    for (int32_t fy = 0; fy < rows; fy++) {
+        const float* input_row = input + (fy * input_stride);
+        const float* filter_row = filter + (fy * filter_stride);
+
+        int32_t fx = 0;
+        for (; fx + V::WIDTH <= columns; fx += V::WIDTH) {
+            sums = V::fmadd(V::load(filter_row + fx), V::load(input_row + fx), sums);
+        }
+
+        for (; fx + SSE::WIDTH <= columns; fx += SSE::WIDTH) {
+            short_sums = SSE::fmadd(SSE::load(filter_row + fx), SSE::load(input_row + fx), short_sums);
+        }
+
+        for (; fx < columns; fx++) {
+            sum += filter_row[fx] * input_row[fx];
+        }
+    }
+
+    *output += sum + V::sum(sums) + SSE::sum(short_sums);
+}
+
+/**
+ * Finds the taps (from tap_begin up to tap_end) of a filter of filter_size
+ * which reach the nonzero part (from begin up to end) of the input for any of
+ * the width outputs starting at start.  Returns false if there are none.
+ */
+static inline bool nonzero_taps(int32_t start, int32_t width, int32_t filter_size, int32_t begin, int32_t end, int32_t &tap_begin, int32_t &tap_end) {
+    tap_begin = begin - (start + width - 1);
+    if (tap_begin < 0) tap_begin = 0;
+
+    tap_end = end - start;
+    if (tap_end > filter_size) tap_end = filter_size;
+
+    return tap_begin < tap_end;
+}
+
+/**
+ * Accumulates the outputs of a row from x up to end in blocks of vectors, then
+ * single vectors, then narrower vectors, returning where it stopped (less
+ * than the narrowest vector from end).
+ */
+template <class V>
+static inline int32_t correlate_vectors(const float* input_row, int32_t input_stride, int32_t column_begin, int32_t column_end, const float* filter_rows, int32_t filter_x, int32_t rows, float* output_row, int32_t x, int32_t end) {
+    int32_t fx_begin, fx_end;
+
+    for (; x + (BLOCK_VECTORS * V::WIDTH) <= end; x += BLOCK_VECTORS * V::WIDTH) {
+        if (!nonzero_taps(x, BLOCK_VECTORS * V::WIDTH, filter_x, column_begin, column_end, fx_begin, fx_end)) continue;
+        correlate_block<V, BLOCK_VECTORS>(input_row + x + fx_begin, input_stride, filter_rows + fx_begin, filter_x, rows, fx_end - fx_begin, output_row + x);
+    }
+
+    for (; x + V::WIDTH <= end; x += V::WIDTH) {
+        if (!nonzero_taps(x, V::WIDTH, filter_x, column_begin, column_end, fx_begin, fx_end)) continue;
+        correlate_block<V, 1>(input_row + x + fx_begin, input_stride, filter_rows + fx_begin, filter_x, rows, fx_end - fx_begin, output_row + x);
+    }
+
+    //the rest of the row may still fill narrower vectors
+    if (V::WIDTH > V::Half::WIDTH) {
+        x = correlate_vectors<typename V::Half>(input_row, input_stride, column_begin, column_end, filter_rows, filter_x, rows, output_row, x, end);
+    }
+
+    return x;
+}
+
+template <class V>
+void correlate(const float* input, int32_t input_stride, int32_t row_begin, int32_t row_end, int32_t column_begin, int32_t column_end, const float* filter, int32_t filter_y, int32_t filter_x, float* output, int32_t output_stride, int32_t output_size_y, int32_t output_size_x) {
+    int32_t fy_begin, fy_end, fx_begin, fx_end;
+
+    for (int32_t tile_start = 0; tile_start < output_size_x; tile_start += COLUMN_TILE) {
+        int32_t tile_end = tile_start + COLUMN_TILE;
+        if (tile_end > output_size_x) tile_end = output_size_x;
+
+        for (int32_t y = 0; y < output_size_y; y++) {
+            if (!nonzero_taps(y, 1, filter_y, row_begin, row_end, fy_begin, fy_end)) continue;
+
+            int32_t rows = fy_end - fy_begin;
+            const float* input_row = input + ((y + fy_begin) * input_stride);
+            const float* filter_rows = filter + (fy_begin * filter_x);
+            float* output_row = output + (y * output_stride);
+
+            int32_t x = correlate_vectors<V>(input_row, input_stride, column_begin, column_end, filter_rows, filter_x, rows, output_row, tile_start, tile_end);
+
+            for (; x < tile_end; x++) {
+                if (!nonzero_taps(x, 1, filter_x, column_begin, column_end, fx_begin, fx_end)) continue;
+                correlate_pixel<V>(input_row + x + fx_begin, input_stride, filter_rows + fx_begin, filter_x, rows, fx_end - fx_begin, output_row + x);
+            }
+        }
+    }
+}
+
+
+/********************************************
+ * 8 BIT CONVOLUTION
+ ********************************************/
+
+/**
+ * Accumulates VECTORS * I::WIDTH adjacent output pixels over the whole filter,
+ * two taps of each filter row at a time.  The last tap of an odd width filter
+ * is paired with itself and a zero weight, so nothing past it is read.
+ */
+template <class I, int32_t VECTORS>
+static inline void correlate_int8_block(const int8_t* input, int32_t input_stride, const int8_t* filter, int32_t filter_y, int32_t filter_x, int32_t* output) {
+    typename I::vec sums[VECTORS];
+    for (int32_t i = 0; i < VECTORS; i++) sums[i] = I::zero();
+
+    for (int32_t fy = 0; fy < filter_y; fy++) {
+        const int8_t* input_row = input + (fy * input_stride);
+        const int8_t* filter_row = filter + (fy * filter_x);
+
+        for (int32_t fx = 0; fx < filter_x; fx += 2) {
+            int32_t next = (fx + 1 < filter_x) ? 1 : 0;
+            typename I::vec weights = I::set_pair(filter_row[fx], next ? filter_row[fx + 1] : 0);
+
+            for (int32_t i = 0; i < VECTORS; i++) {
+                const int8_t* first = input_row + fx + (i * I::WIDTH);
+                sums[i] = I::add(sums[i], I::multiply_pairs(first, first + next, weights));
+            }
+        }
+    }
+
+    for (int32_t i = 0; i < VECTORS; i++) {
+        I::store(output + (i * I::WIDTH), I::add(I::load(output + (i * I::WIDTH)), sums[i]));
+    }
+}
+
+template <class I>
+static inline int32_t correlate_int8_vectors(const int8_t* input_row, int32_t input_stride, const int8_t* filter, int32_t filter_y, int32_t filter_x, int32_t* output_row, int32_t x, int32_t end) {
+    for (; x + (BLOCK_VECTORS * I::WIDTH) <= end; x += BLOCK_VECTORS * I::WIDTH) {
+        correlate_int8_block<I, BLOCK_VECTORS>(input_row + x, input_stride, filter, filter_y, filter_x, output_row + x);
+    }
+
+    for (; x + I::WIDTH <= end; x += I::WIDTH) {
+        correlate_int8_block<I, 1>(input_row + x, input_stride, filter, filter_y, filter_x, output_row + x);
+    }
+
+    if (I::WIDTH > I::Half::WIDTH) {
+        x = correlate_int8_vectors<typename I::Half>(input_row, input_stride, filter, filter_y, filter_x, output_row, x, end);
+    }
+
+    return x;
+}
+
+template <class I>
+void correlate_int8(const int8_t* input, int32_t input_stride, const int8_t* filter, int32_t filter_y, int32_t filter_x, int32_t* output, int32_t output_stride, int32_t output_size_y, int32_t output_size_x) {
+    for (int32_t y = 0; y < output_size_y; y++) {
+        const int8_t* input_row = input + (y * input_stride);
+        int32_t* output_row = output + (y * output_stride);
+
+        int32_t x = correlate_int8_vectors<I>(input_row, input_stride, filter, filter_y, filter_x, output_row, 0, output_size_x);
+
+        for (; x < output_size_x; x++) {
+            int32_t sum = 0;
+            for (int32_t fy = 0; fy < filter_y; fy++) {
+                for (int32_t fx = 0; fx < filter_x; fx++) {
+                    sum += filter[(fy * filter_x) + fx] * input_row[(fy * input_stride) + x + fx];
+                }
+            }
+            output_row[x] += sum;
+        }
+    }
+}
+
+
+/********************************************
+ * HALF PRECISION CONVERSION
+ ********************************************/
+
+static inline float half_to_float_value(uint16_t half_value) {
+    uint32_t sign = (uint32_t)(half_value & 0x8000) << 16;
+    uint32_t exponent = (half_value >> 10) & 0x1f;
+    uint32_t mantissa = half_value & 0x3ff;
+
+    uint32_t bits;
+    if (exponent == 0) {
+        //zero or subnormal, which is exactly mantissa * 2^-24
+        float magnitude = mantissa * (1.0f / 16777216.0f);
+        memcpy(&bits, &magnitude, sizeof(uint32_t));
+        bits |= sign;
+    } else if (exponent == 0x1f) {
+        //infinity, or NaN (which is made quiet, as F16C does)
+        bits = sign | 0x7f800000 | (mantissa << 13) | (mantissa != 0 ? 0x400000 : 0);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+static inline uint16_t float_to_half_value(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(uint32_t));
+
+    uint32_t sign = bits & 0x80000000;
+    bits ^= sign;
+
+    uint32_t half_bits;
+    if (bits >= (143u << 23)) {
+        //2^16 or more is infinity whichever way it rounds, and NaN keeps the
+        //top of its payload and is made quiet, as F16C does
+        half_bits = (bits > 0x7f800000) ? (0x7e00 | ((bits >> 13) & 0x3ff)) : 0x7c00;
+    } else if (bits < (113u << 23)) {
+        //subnormal (or zero), adding 0.5 leaves the value rounded to the
+        //nearest even multiple of 2^-24 in the low bits of the float
+        float magnitude;
+        memcpy(&magnitude, &bits, sizeof(float));
+        magnitude += 0.5f;
+        memcpy(&half_bits, &magnitude, sizeof(uint32_t));
+        half_bits -= (126u << 23);
+    } else {
+        //rebiases the exponent and rounds off the low 13 bits of the mantissa
+        //to the nearest even, carrying into the exponent (up to infinity)
+        uint32_t mantissa_odd = (bits >> 13) & 1;
+        bits += ((uint32_t)(15 - 127) << 23) + 0xfff + mantissa_odd;
+        half_bits = bits >> 13;
+    }
+
+    return (uint16_t)(half_bits | (sign >> 16));
+}
+
+template <class V>
+void half_to_float(const uint16_t* half_values, float* values, int32_t size) {
+    int32_t i = 0;
+    if (V::HALF_CONVERSIONS) {
+        for (; i + V::WIDTH <= size; i += V::WIDTH) {
+            V::store(values + i, V::load_half(half_values + i));
+        }
+    }
+
+    for (; i < size; i++) {
+        values[i] = half_to_float_value(half_values[i]);
+    }
+}
+
+template <class V>
+void float_to_half(const float* values, uint16_t* half_values, int32_t size) {
+    int32_t i = 0;
+    if (V::HALF_CONVERSIONS) {
+        for (; i + V::WIDTH <= size; i += V::WIDTH) {
+            V::store_half(half_values + i, V::load(values + i));
+        }
+    }
+
+    for (; i < size; i++) {
+        half_values[i] = float_to_half_value(values[i]);
+    }
+}
+
+
+/********************************************
+ * POOLING
+ ********************************************/
+
+template <class V>
+void column_max(const float* input, int32_t input_stride, int32_t rows, int32_t columns, float* max_values, float* max_rows) {
+    int32_t x = 0;
+    for (; x + V::WIDTH <= columns; x += V::WIDTH) {
+        typename V::vec best = V::set1(-numeric_limits<float>::max());
+        typename V::vec best_row = V::zero();
+
+        for (int32_t y = 0; y < rows; y++) {
+            typename V::vec current = V::load(input + (y * input_stride) + x);
+            typename V::mask greater = V::greater(current, best);
+
+            best = V::select(greater, current, best);
+            best_row = V::select(greater, V::set1(y), best_row);
+        }
+
+        V::store(max_values + x, best);
+        V::store(max_rows + x, best_row);
+    }
+
+    for (; x < columns; x++) {
+        float best = -numeric_limits<float>::max();
+        int32_t best_row = 0;
+
+        for (int32_t y = 0; y < rows; y++) {
+            float current = input[(y * input_stride) + x];
+            if (current > best) {
+                best = current;
+                best_row = y;
+            }
+        }
+
+        max_values[x] = best;
+        max_rows[x] = best_row;
+    }
+}
+
+template <class V>
+float pool_errors(const float* output_errors, const float* pool_gradients, const float* inputs, float* input_errors, int32_t size) {
+    typename V::vec scale_sums = V::zero();
+    float scale_sum = 0.0;
+
+    int32_t i = 0;
+    for (; i + V::WIDTH <= size; i += V::WIDTH) {
+        typename V::vec delta = V::mul(V::load(output_errors + i), V::load(pool_gradients + i));
+        V::store(input_errors + i, V::add(V::load(input_errors + i), delta));
+        scale_sums = V::fmadd(V::load(inputs + i), delta, scale_sums);
+    }
+
+    for (; i < size; i++) {
+        float delta = output_errors[i] * pool_gradients[i];
+        input_errors[i] += delta;
+        scale_sum += inputs[i] * delta;
+    }
+
+    return scale_sum + V::sum(scale_sums);
+}
+
+
+/********************************************
+ * WEIGHT UPDATES
+ ********************************************/
+
+template <class V>
+void update_weights(float* weights, const float* weight_updates, float* previous_velocity, int32_t size, float mu, float learning_rate, float weight_decay) {
+    //no fused multiply adds, so the weights are the same whichever
+    //instruction set updated them
+    typename V::vec mu_v = V::set1(mu);
+    typename V::vec learning_rate_v = V::set1(learning_rate);
+    typename V::vec weight_decay_v = V::set1(weight_decay);
+    typename V::vec max_weight = V::set1(50.0);
+    typename V::vec min_weight = V::set1(-50.0);
+
+    int32_t i = 0;
+    for (; i + V::WIDTH <= size; i += V::WIDTH) {
+        typename V::vec pv = V::load(previous_velocity + i);
+        typename V::vec velocity = V::sub(V::mul(mu_v, pv), V::mul(learning_rate_v, V::load(weight_updates + i)));
+
+        typename V::vec weight = V::load(weights + i);
+        weight = V::add(weight, V::add(velocity, V::mul(mu_v, V::sub(velocity, pv))));
+        weight = V::sub(weight, V::mul(weight, weight_decay_v));
+
+        typename V::mask too_large = V::greater(weight, max_weight);
+        weight = V::select(too_large, max_weight, weight);
+        velocity = V::select(too_large, V::zero(), velocity);
+
+        typename V::mask too_small = V::greater(min_weight, weight);
+        weight = V::select(too_small, min_weight, weight);
+        velocity = V::select(too_small, V::zero(), velocity);
+
+        V::store(weights + i, weight);
+        V::store(previous_velocity + i, velocity);
+    }
+
+    for (; i < size; i++) {
+        float pv = previous_velocity[i];
+        float velocity = (mu * pv) - learning_rate * weight_updates[i];
+
+        float weight = weights[i];
+        weight += velocity + mu * (velocity - pv);
+        weight -= (weight * weight_decay);
+
+        if (weight > 50.0) {
+            weight = 50.0;
+            velocity = 0.0;
+        } else if (weight < -50.0) {
+            weight = -50.0;
+            velocity = 0.0;
+        }
+
+        weights[i] = weight;
+        previous_velocity[i] = velocity;
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,12 @@
+#include "kernels_impl.hxx"
+
+const Kernels sse_kernels = {
+    "sse",
+    correlate<SSE>,
+    column_max<SSE>,
+    pool_errors<SSE>,
+    update_weights<SSE>,
+    correlate_int8<SSE_INT8>,
+    half_to_float<SSE>,
+    float_to_half<SSE>
+};
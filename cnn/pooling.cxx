@@ -26,6 +26,8 @@ using std::vector;
 
 #include "common/random.hxx"
 
+#include "kernels.hxx"
+
 #define REPEATS 16
 
 #ifdef POOL_TEST
@@ -109,6 +111,13 @@ void initialize_pools(vector<int> &pools, vector<int> &offset, int input_size, i
 //pool forward when the y dimension of the output is less than the y dimension of the input and
 //the x dimension of the output is less than the the x dimension of the input
 void pool_forward(const float* input, float scale, float *pool_gradients, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset) {
+    static thread_local vector<float> max_values;
+    static thread_local vector<float> max_rows;
+    max_values.resize(input_size_x);
+    max_rows.resize(input_size_x);
+
+    const Kernels &kernels = get_kernels();
+
     int32_t input_batch_offset = 0;
     int32_t output_batch_offset = 0;
 
@@ -117,39 +126,28 @@ void pool_forward(const float* input, float scale, float *pool_gradients, float*
 
     for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
         for (int32_t out_y = 0; out_y < y_pools.size(); out_y++) {
-            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
-                int32_t max_y = 0;
-                int32_t max_x = 0;
+            int32_t in_y = y_pool_offset[out_y];
+            const float* input_rows = input + input_batch_offset + (in_y * input_size_x);
+            float* gradient_rows = pool_gradients + input_batch_offset + (in_y * input_size_x);
+
+            //the pools in this row cover every column of its rows, so the max of each
+            //pool is the max of the column maxes in it, taking the first row and then
+            //the first column of any ties (the first in row major order)
+            kernels.column_max(input_rows, input_size_x, y_pools[out_y], input_size_x, max_values.data(), max_rows.data());
+            std::fill_n(gradient_rows, y_pools[out_y] * input_size_x, 0);
 
-                int32_t in_y = y_pool_offset[out_y];
+            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
                 int32_t in_x = x_pool_offset[out_x];
 
-                //cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float max_value = -numeric_limits<float>::max();
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                        float current_value = input[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x + pool_x];
-                        //cout << " " << current_value;
-                        if (current_value > max_value) {
-                            max_value = current_value;
-                            max_y = pool_y;
-                            max_x = pool_x;
-                        }
+                int32_t max_x = in_x;
+                for (int32_t x = in_x + 1; x < in_x + x_pools[out_x]; x++) {
+                    if (max_values[x] > max_values[max_x] || (max_values[x] == max_values[max_x] && max_rows[x] < max_rows[max_x])) {
+                        max_x = x;
                     }
                 }
-                //cout << " -- max value: " << max_value << endl;
 
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                        if (pool_y == max_y && pool_x == max_x) {
-                            output[output_batch_offset + (out_y * output_size_x) + out_x] += max_value * scale;
-
-                            pool_gradients[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x + pool_x] = scale;
-                        } else {
-                            pool_gradients[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x + pool_x] = 0;
-                        }
-                    }
-                }
+                output[output_batch_offset + (out_y * output_size_x) + out_x] += max_values[max_x] * scale;
+                gradient_rows[((int32_t)max_rows[max_x] * input_size_x) + max_x] = scale;
             }
         }
         input_batch_offset += input_image_size;
@@ -264,6 +262,13 @@ void pool_forward_ry(const float* input, float scale, float *pool_gradients, flo
 //pool forward when the y dimension of the output is less than the y dimension of the input and
 //the x dimension of the output is greater than the the x dimension of the input
 void pool_forward_rx(const float* input, float scale, float *pool_gradients, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset) {
+    static thread_local vector<float> max_values;
+    static thread_local vector<float> max_rows;
+    max_values.resize(input_size_x);
+    max_rows.resize(input_size_x);
+
+    const Kernels &kernels = get_kernels();
+
     int32_t input_batch_offset = 0;
     int32_t output_batch_offset = 0;
 
@@ -272,38 +277,22 @@ void pool_forward_rx(const float* input, float scale, float *pool_gradients, flo
 
     for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
         for (int32_t out_y = 0; out_y < y_pools.size(); out_y++) {
-            for (int32_t in_x = 0; in_x < input_size_x; in_x++) {
-                int32_t max_y = 0;
+            int32_t in_y = y_pool_offset[out_y];
+            const float* input_rows = input + input_batch_offset + (in_y * input_size_x);
+            float* gradient_rows = pool_gradients + input_batch_offset + (in_y * input_size_x);
 
-                int32_t in_y = y_pool_offset[out_y];
+            //each pool is a single column of this row's rows
+            kernels.column_max(input_rows, input_size_x, y_pools[out_y], input_size_x, max_values.data(), max_rows.data());
+            std::fill_n(gradient_rows, y_pools[out_y] * input_size_x, 0);
+
+            for (int32_t in_x = 0; in_x < input_size_x; in_x++) {
                 int32_t out_x = x_pool_offset[in_x];
 
-                //cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
-                float max_value = -numeric_limits<float>::max();
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    float current_value = input[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x];
-                    //cout << " " << current_value;
-                    if (current_value > max_value) {
-                        max_value = current_value;
-                        max_y = pool_y;
-                    }
+                for (int32_t pool_x = 0; pool_x < x_pools[in_x]; pool_x++) {
+                    output[output_batch_offset + (out_y * output_size_x) + out_x + pool_x] += max_values[in_x] * scale;
                 }
-                //cout << " -- max value: " << max_value << endl;
-
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    if (pool_y == max_y) {
-                        for (int32_t pool_x = 0; pool_x < x_pools[in_x]; pool_x++) {
-                            //cout << "setting output[" << out_y << "][" << out_x + pool_x << "] to: " << max_value << endl;
-                            output[output_batch_offset + (out_y * output_size_x) + out_x + pool_x] += max_value * scale;
-                        }
 
-                        //cout << "setting pool_gradient[" << in_y + pool_y << "][" << in_x << "]: to 1" << endl;
-                        pool_gradients[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x] = scale;
-                    } else {
-                        //cout << "setting pool_gradient[" << in_y + pool_y << "][" << in_x << "]: to 0" << endl;
-                        pool_gradients[input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x] = 0;
-                    }
-                }
+                gradient_rows[((int32_t)max_rows[in_x] * input_size_x) + in_x] = scale;
             }
         }
         input_batch_offset += input_image_size;
@@ -400,6 +389,72 @@ void pool_forward_ry_rx(const float* input, float scale, float *pool_gradients,
 
 
 
+void pool_forward_edge(const float* input, float scale, float *pool_gradients, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset, minstd_rand0 &generator, bool training) {
+    bool max_pooling = true;
+    if (reverse_filter_y && reverse_filter_x) {
+        if (input_size_y % output_size_y == 0) {
+            fisher_yates_shuffle(generator, y_pools);
+            update_offset(y_pools, y_pool_offset);
+            max_pooling = false;
+        }
+
+        if (input_size_x % output_size_x == 0) {
+            fisher_yates_shuffle(generator, x_pools);
+            update_offset(x_pools, x_pool_offset);
+            max_pooling = false;
+        }
+
+        pool_forward_ry_rx(input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling);
+
+    } else if (reverse_filter_y) {
+        if (output_size_y % input_size_y == 0) {
+            fisher_yates_shuffle(generator, y_pools);
+            update_offset(y_pools, y_pool_offset);
+            max_pooling = false;
+        }
+
+        if (input_size_x % output_size_x == 0) {
+            fisher_yates_shuffle(generator, x_pools);
+            update_offset(x_pools, x_pool_offset);
+            max_pooling = false;
+        }
+
+        pool_forward_ry(input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling);
+
+    } else if (reverse_filter_x) {
+        if (input_size_y % output_size_y == 0) {
+            fisher_yates_shuffle(generator, y_pools);
+            update_offset(y_pools, y_pool_offset);
+            max_pooling = false;
+        }
+
+        if (output_size_x % input_size_x == 0) {
+            fisher_yates_shuffle(generator, x_pools);
+            update_offset(x_pools, x_pool_offset);
+            max_pooling = false;
+        }
+
+        pool_forward_rx(input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling);
+
+    } else {
+        if (output_size_y % input_size_y == 0) {
+            fisher_yates_shuffle(generator, y_pools);
+            update_offset(y_pools, y_pool_offset);
+            max_pooling = false;
+        }
+
+        if (output_size_x % input_size_x == 0) {
+            fisher_yates_shuffle(generator, x_pools);
+            update_offset(x_pools, x_pool_offset);
+            max_pooling = false;
+        }
+
+        pool_forward(input, scale, pool_gradients, output, batch_size, input_size_y, input_size_x, output_size_y, output_size_x, y_pools, x_pools, y_pool_offset, x_pool_offset, generator, training, max_pooling);
+    }
+
+}
+
+
 /********************************************
  * BACK PROPAGATION
  ********************************************/
@@ -408,6 +463,11 @@ void pool_forward_ry_rx(const float* input, float scale, float *pool_gradients,
 //pool backward when the y dimension of the output is less than the y dimension of the input and
 //the x dimension of the output is less than the the x dimension of the input
 void pool_backward(float* input_errors, float &scale_update, const float *inputs, const float *pool_gradients, const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset) {
+    static thread_local vector<float> row_errors;
+    row_errors.resize(input_size_x);
+
+    const Kernels &kernels = get_kernels();
+
     int32_t input_batch_offset = 0;
     int32_t output_batch_offset = 0;
 
@@ -417,21 +477,18 @@ void pool_backward(float* input_errors, float &scale_update, const float *inputs
     scale_update = 0.0;
     for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
         for (int32_t out_y = 0; out_y < y_pools.size(); out_y++) {
-            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
-                int32_t in_y = y_pool_offset[out_y];
-                int32_t in_x = x_pool_offset[out_x];
+            int32_t in_y = y_pool_offset[out_y];
 
-                //cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
+            //every input in a pool gets its output error (pool gradients includes
+            //scale, and is only nonzero for the max of each pool)
+            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
                 float output_error = output_errors[output_batch_offset + (out_y * output_size_x) + out_x];
+                std::fill_n(row_errors.data() + x_pool_offset[out_x], x_pools[out_x], output_error);
+            }
 
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                        int position = input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x + pool_x;
-                        float delta = output_error * pool_gradients[position]; //pool gradients includes scale
-                        input_errors[position] += delta;
-                        scale_update += inputs[position] * delta;
-                    }
-                }
+            for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
+                int32_t position = input_batch_offset + ((in_y + pool_y) * input_size_x);
+                scale_update += kernels.pool_errors(row_errors.data(), pool_gradients + position, inputs + position, input_errors + position, input_size_x);
             }
         }
         input_batch_offset += input_image_size;
@@ -443,6 +500,11 @@ void pool_backward(float* input_errors, float &scale_update, const float *inputs
 //pool backward when the y dimension of the output is greater than the y dimension of the input and
 //the x dimension of the output is less than the the x dimension of the input
 void pool_backward_ry(float* input_errors, float &scale_update, const float *inputs, const float *pool_gradients, const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset) {
+    static thread_local vector<float> row_errors;
+    row_errors.resize(input_size_x);
+
+    const Kernels &kernels = get_kernels();
+
     int32_t input_batch_offset = 0;
     int32_t output_batch_offset = 0;
 
@@ -452,23 +514,19 @@ void pool_backward_ry(float* input_errors, float &scale_update, const float *inp
     scale_update = 0.0;
     for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
         for (int32_t in_y = 0; in_y < input_size_y; in_y++) {
-            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
-                int32_t out_y = y_pool_offset[in_y];
-                int32_t in_x = x_pool_offset[out_x];
+            int32_t out_y = y_pool_offset[in_y];
 
-                //cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
+            for (int32_t out_x = 0; out_x < x_pools.size(); out_x++) {
                 float output_error = 0.0;
                 for (int32_t pool_y = 0; pool_y < y_pools[in_y]; pool_y++) {
                     output_error += output_errors[output_batch_offset + ((out_y + pool_y) * output_size_x) + out_x];
                 }
 
-                for (int32_t pool_x = 0; pool_x < x_pools[out_x]; pool_x++) {
-                    int position = input_batch_offset + (in_y * input_size_x) + in_x + pool_x;
-                    float delta = output_error * pool_gradients[position];
-                    input_errors[position] += delta;
-                    scale_update += inputs[position] * delta;
-                }
+                std::fill_n(row_errors.data() + x_pool_offset[out_x], x_pools[out_x], output_error);
             }
+
+            int32_t position = input_batch_offset + (in_y * input_size_x);
+            scale_update += kernels.pool_errors(row_errors.data(), pool_gradients + position, inputs + position, input_errors + position, input_size_x);
         }
         input_batch_offset += input_image_size;
         output_batch_offset += output_image_size;
@@ -479,6 +537,11 @@ void pool_backward_ry(float* input_errors, float &scale_update, const float *inp
 //pool backward when the y dimension of the output is less than the y dimension of the input and
 //the x dimension of the output is greater than the the x dimension of the input
 void pool_backward_rx(float* input_errors, float &scale_update, const float *inputs, const float *pool_gradients, const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset) {
+    static thread_local vector<float> row_errors;
+    row_errors.resize(input_size_x);
+
+    const Kernels &kernels = get_kernels();
+
     int32_t input_batch_offset = 0;
     int32_t output_batch_offset = 0;
 
@@ -488,22 +551,21 @@ void pool_backward_rx(float* input_errors, float &scale_update, const float *inp
     scale_update = 0.0;
     for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
         for (int32_t out_y = 0; out_y < y_pools.size(); out_y++) {
+            int32_t in_y = y_pool_offset[out_y];
+
             for (int32_t in_x = 0; in_x < input_size_x; in_x++) {
-                int32_t in_y = y_pool_offset[out_y];
                 int32_t out_x = x_pool_offset[in_x];
 
-                //cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
                 float output_error = 0.0;
                 for (int32_t pool_x = 0; pool_x < x_pools[in_x]; pool_x++) {
                     output_error += output_errors[output_batch_offset + (out_y * output_size_x) + out_x + pool_x];
                 }
+                row_errors[in_x] = output_error;
+            }
 
-                for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
-                    int position = input_batch_offset + ((in_y + pool_y) * input_size_x) + in_x;
-                    float delta = output_error * pool_gradients[position];
-                    input_errors[position] += delta;
-                    scale_update += inputs[position] * delta;
-                }
+            for (int32_t pool_y = 0; pool_y < y_pools[out_y]; pool_y++) {
+                int32_t position = input_batch_offset + ((in_y + pool_y) * input_size_x);
+                scale_update += kernels.pool_errors(row_errors.data(), pool_gradients + position, inputs + position, input_errors + position, input_size_x);
             }
         }
         input_batch_offset += input_image_size;
@@ -515,6 +577,11 @@ void pool_backward_rx(float* input_errors, float &scale_update, const float *inp
 //pool backward when the y dimension of the output is greater than the y dimension of the input and
 //the x dimension of the output is greater than the the x dimension of the input
 void pool_backward_ry_rx(float* input_errors, float &scale_update, const float *inputs, const float *pool_gradients, const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset) {
+    static thread_local vector<float> row_errors;
+    row_errors.resize(input_size_x);
+
+    const Kernels &kernels = get_kernels();
+
     int32_t input_batch_offset = 0;
     int32_t output_batch_offset = 0;
 
@@ -524,25 +591,22 @@ void pool_backward_ry_rx(float* input_errors, float &scale_update, const float *
     scale_update = 0.0;
     for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
         for (int32_t in_y = 0; in_y < input_size_y; in_y++) {
+            int32_t out_y = y_pool_offset[in_y];
+
             for (int32_t in_x = 0; in_x < input_size_x; in_x++) {
-                int32_t out_y = y_pool_offset[in_y];
                 int32_t out_x = x_pool_offset[in_x];
 
-                //cout << "getting max value for pool starting at " << in_y  << " x " << in_x << " from:" << endl;
                 float output_error = 0.0;
                 for (int32_t pool_x = 0; pool_x < x_pools[in_x]; pool_x++) {
                     for (int32_t pool_y = 0; pool_y < y_pools[in_y]; pool_y++) {
                         output_error += output_errors[output_batch_offset + ((out_y + pool_y) * output_size_x) + out_x + pool_x];
                     }
                 }
-
-                //cout << "setting input error[" << in_y << "][" << in_x << "] to: " << output_error << endl;
-
-                int position = input_batch_offset + (in_y * input_size_x) + in_x;
-                float delta = output_error * pool_gradients[position];
-                input_errors[position] += delta;
-                scale_update += inputs[position] * delta;
+                row_errors[in_x] = output_error;
             }
+
+            int32_t position = input_batch_offset + (in_y * input_size_x);
+            scale_update += kernels.pool_errors(row_errors.data(), pool_gradients + position, inputs + position, input_errors + position, input_size_x);
         }
         input_batch_offset += input_image_size;
         output_batch_offset += output_image_size;
@@ -16,6 +16,14 @@ void pool_forward_rx(const float* input, float scale, float *pool_gradients, flo
 
 void pool_forward_ry_rx(const float* input, float scale, float *pool_gradients, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset, minstd_rand0 &generator, bool training, bool max_pooling);
 
+/**
+ * Pools the input of a pooling edge into its output, with whichever of the
+ * above the edge's reverse filters select, first shuffling the pools along
+ * any dimension which evenly divides the other (which then averages several
+ * fractional poolings when not training).
+ */
+void pool_forward_edge(const float* input, float scale, float *pool_gradients, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset, minstd_rand0 &generator, bool training);
+
 
 void pool_backward(float* input_errors, float &scale_update, const float* inputs, const float *pool_gradients, const float* output_errors, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, vector<int> &y_pools, vector<int> &x_pools, vector<int> &y_pool_offset, vector<int> &x_pool_offset);
 
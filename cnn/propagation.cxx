@@ -1,13 +1,49 @@
 #include "stdint.h"
 #include <cmath>
+#include <cstring>
+
+#include <algorithm>
+
+#include <complex>
+using std::complex;
+
+#include <chrono>
 
 #include <iostream>
+using std::cout;
 using std::cerr;
 using std::endl;
 
+#include <iomanip>
+using std::fixed;
+using std::setprecision;
+using std::setw;
+
+#include <limits>
+using std::numeric_limits;
+
+#include <map>
+using std::map;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+
+#include <random>
+using std::minstd_rand0;
+using std::uniform_int_distribution;
+using std::uniform_real_distribution;
+
+#include <string>
+using std::string;
+
 #include <vector>
 using std::vector;
 
+#include "common/arguments.hxx"
+
+#include "batch_threads.hxx"
+#include "kernels.hxx"
 #include "propagation.hxx"
 
 void prop_forward(const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x) {
@@ -276,9 +312,1083 @@ void prop_backward_ry_rx(float* output_errors, float* input, float* input_errors
     }
 }
 
+/********************************************
+ * LOWERED (GEMM) PROPAGATION
+ ********************************************/
+
+/**
+ * Copies an image into the middle of a zeroed padded_y by padded_x image, with
+ * pad_y rows above it and pad_x columns to the left of it.
+ */
+static void pad_image(const float* image, int32_t size_y, int32_t size_x, int32_t pad_y, int32_t pad_x, int32_t padded_y, int32_t padded_x, vector<float> &padded) {
+    padded.assign(padded_y * padded_x, 0.0);
+
+    for (int32_t y = 0; y < size_y; y++) {
+        const float* image_row = image + (y * size_x);
+        float* padded_row = padded.data() + ((y + pad_y) * padded_x) + pad_x;
+
+        for (int32_t x = 0; x < size_x; x++) {
+            padded_row[x] = image_row[x];
+        }
+    }
+}
+
+/**
+ * Copies the weights, reversing the order of the rows if flip_y and of the
+ * columns if flip_x.
+ */
+static void flip_filter(const float* weights, int32_t filter_y, int32_t filter_x, bool flip_y, bool flip_x, vector<float> &flipped) {
+    flipped.resize(filter_y * filter_x);
+
+    for (int32_t fy = 0; fy < filter_y; fy++) {
+        int32_t weight_y = flip_y ? (filter_y - 1 - fy) : fy;
+
+        for (int32_t fx = 0; fx < filter_x; fx++) {
+            int32_t weight_x = flip_x ? (filter_x - 1 - fx) : fx;
+
+            flipped[(fy * filter_x) + fx] = weights[(weight_y * filter_x) + weight_x];
+        }
+    }
+}
+
+//the reverse filter variants are a valid correlation of the input padded by
+//filter - 1 on both sides with the flipped filter, e.g. for reverse_filter_y:
+//  output[fy + y][x] += weight[fy][fx] * input[y][x + fx]
+//is
+//  output[y][x] += weight[filter_y - 1 - fy][fx] * padded_input[y + fy][x + fx]
+
+void prop_forward_gemm(const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x) {
+    //these are reused so each call does not need to allocate them
+    static thread_local vector<float> lowered_filter;
+    static thread_local vector<float> lowered_input;
+
+    const Kernels &kernels = get_kernels();
+
+    int32_t pad_y = reverse_filter_y ? (filter_y - 1) : 0;
+    int32_t pad_x = reverse_filter_x ? (filter_x - 1) : 0;
+    int32_t lowered_size_y = output_size_y + filter_y - 1;
+    int32_t lowered_size_x = output_size_x + filter_x - 1;
+
+    int32_t output_image_size = output_size_y * output_size_x;
+    int32_t input_image_size = input_size_y * input_size_x;
+
+    flip_filter(weights, filter_y, filter_x, reverse_filter_y, reverse_filter_x, lowered_filter);
+
+    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+        const float* image = input + (batch_number * input_image_size);
+        int32_t image_stride = input_size_x;
+
+        if (pad_y > 0 || pad_x > 0) {
+            pad_image(image, input_size_y, input_size_x, pad_y, pad_x, lowered_size_y, lowered_size_x, lowered_input);
+            image = lowered_input.data();
+            image_stride = lowered_size_x;
+        }
+
+        kernels.correlate(image, image_stride, pad_y, pad_y + input_size_y, pad_x, pad_x + input_size_x, lowered_filter.data(), filter_y, filter_x, output + (batch_number * output_image_size), output_size_x, output_size_y, output_size_x);
+    }
+
+#ifdef NAN_CHECKS
+    for (int32_t i = 0; i < batch_size * output_image_size; i++) {
+        if (isnan(output[i]) || isinf(output[i])) {
+            cerr << "ERROR! NAN or INF in propagate forward, output[" << i << "]: " << output[i] << endl;
+            exit(1);
+        }
+    }
+#endif
+}
+
+void prop_backward_gemm(const float* output_errors, const float* input, float* input_errors, float* weight_updates, const float* weights, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x) {
+    static thread_local vector<float> error_filter;
+    static thread_local vector<float> lowered_input;
+    static thread_local vector<float> lowered_errors;
+    static thread_local vector<float> lowered_updates;
+
+    const Kernels &kernels = get_kernels();
+
+    int32_t pad_y = reverse_filter_y ? (filter_y - 1) : 0;
+    int32_t pad_x = reverse_filter_x ? (filter_x - 1) : 0;
+    int32_t lowered_size_y = output_size_y + filter_y - 1;
+    int32_t lowered_size_x = output_size_x + filter_x - 1;
+
+    //the output errors padded by filter - 1 on every side, so the input
+    //errors (the full convolution of the output errors with the lowered
+    //filter) are a valid correlation with the lowered filter flipped
+    int32_t padded_errors_y = output_size_y + 2 * (filter_y - 1);
+    int32_t padded_errors_x = output_size_x + 2 * (filter_x - 1);
+
+    int32_t output_image_size = output_size_y * output_size_x;
+    int32_t input_image_size = input_size_y * input_size_x;
+
+    //flipping the lowered filter in both directions undoes any flip for the reverse filters
+    flip_filter(weights, filter_y, filter_x, !reverse_filter_y, !reverse_filter_x, error_filter);
+    lowered_updates.assign(filter_y * filter_x, 0.0);
+
+    for (int32_t batch_number = 0; batch_number < batch_size; batch_number++) {
+        const float* image = input + (batch_number * input_image_size);
+        int32_t image_stride = input_size_x;
+
+        if (pad_y > 0 || pad_x > 0) {
+            pad_image(image, input_size_y, input_size_x, pad_y, pad_x, lowered_size_y, lowered_size_x, lowered_input);
+            image = lowered_input.data();
+            image_stride = lowered_size_x;
+        }
+
+        const float* errors = output_errors + (batch_number * output_image_size);
+
+        //the updates of the lowered filter are the correlation of the lowered input with the output errors
+        kernels.correlate(image, image_stride, pad_y, pad_y + input_size_y, pad_x, pad_x + input_size_x, errors, output_size_y, output_size_x, lowered_updates.data(), filter_x, filter_y, filter_x);
+
+        //relative to where the input errors start reading the padded errors
+        int32_t errors_y = filter_y - 1 - pad_y;
+        int32_t errors_x = filter_x - 1 - pad_x;
+
+        pad_image(errors, output_size_y, output_size_x, filter_y - 1, filter_x - 1, padded_errors_y, padded_errors_x, lowered_errors);
+        kernels.correlate(lowered_errors.data() + (pad_y * padded_errors_x) + pad_x, padded_errors_x, errors_y, errors_y + output_size_y, errors_x, errors_x + output_size_x, error_filter.data(), filter_y, filter_x, input_errors + (batch_number * input_image_size), input_size_x, input_size_y, input_size_x);
+    }
+
+    for (int32_t fy = 0; fy < filter_y; fy++) {
+        int32_t weight_y = reverse_filter_y ? (filter_y - 1 - fy) : fy;
+
+        for (int32_t fx = 0; fx < filter_x; fx++) {
+            int32_t weight_x = reverse_filter_x ? (filter_x - 1 - fx) : fx;
+
+            weight_updates[(weight_y * filter_x) + weight_x] += lowered_updates[(fy * filter_x) + fx] / batch_size;
+        }
+    }
+}
+
+/********************************************
+ * FFT PROPAGATION
+ ********************************************/
+
+static int32_t next_power_of_two(int32_t value) {
+    int32_t power = 1;
+    while (power < value) power *= 2;
+    return power;
+}
+
+/**
+ * The twiddle factors (e^(-2 pi i k / size) for k up to size / 2) and the bit
+ * reversal permutation of a transform of size, which are calculated once
+ * for each size (and thread).
+ */
+class FFTTables {
+    public:
+        vector< complex<float> > twiddles;
+        vector<int32_t> bit_reversal;
+
+        FFTTables(int32_t size) {
+            twiddles.resize(size / 2);
+            for (int32_t k = 0; k < size / 2; k++) {
+                complex<double> twiddle = std::polar(1.0, -2.0 * M_PI * k / size);
+                twiddles[k] = complex<float>(twiddle.real(), twiddle.imag());
+            }
+
+            bit_reversal.resize(size);
+            for (int32_t i = 1, j = 0; i < size; i++) {
+                int32_t bit = size >> 1;
+                for (; j & bit; bit >>= 1) {
+                    j ^= bit;
+                }
+                j ^= bit;
+                bit_reversal[i] = j;
+            }
+        }
+};
+
+static const FFTTables& get_fft_tables(int32_t size) {
+    static thread_local vector<FFTTables*> tables;
+
+    int32_t log_size = 0;
+    while ((1 << log_size) < size) log_size++;
+
+    if ((int32_t)tables.size() <= log_size) tables.resize(log_size + 1, NULL);
+    if (tables[log_size] == NULL) tables[log_size] = new FFTTables(size);
+
+    return *tables[log_size];
+}
+
+/**
+ * An in place 2D FFT of a size_y by size_x (both powers of two) array, which is
+ * not scaled if it is the inverse.  The rows are each transformed with an
+ * iterative radix-2 FFT, and then the columns are too, a row of butterflies at
+ * a time so every access is sequential.  The complex multiplications are
+ * written out, as std::complex's check for infinities is much slower.
+ */
+static void fft_2d(complex<float>* values, int32_t size_y, int32_t size_x, bool inverse) {
+    const FFTTables &x_tables = get_fft_tables(size_x);
+    const FFTTables &y_tables = get_fft_tables(size_y);
+    float direction = inverse ? -1.0 : 1.0;
+
+    for (int32_t y = 0; y < size_y; y++) {
+        complex<float>* row = values + (y * size_x);
+
+        for (int32_t i = 1; i < size_x; i++) {
+            int32_t j = x_tables.bit_reversal[i];
+            if (i < j) std::swap(row[i], row[j]);
+        }
+
+        for (int32_t span = 2; span <= size_x; span <<= 1) {
+            int32_t half = span / 2;
+            int32_t stride = size_x / span;
+
+            for (int32_t start = 0; start < size_x; start += span) {
+                for (int32_t k = 0; k < half; k++) {
+                    float twiddle_re = x_tables.twiddles[k * stride].real();
+                    float twiddle_im = direction * x_tables.twiddles[k * stride].imag();
+
+                    complex<float> &even = row[start + k];
+                    complex<float> &odd = row[start + k + half];
+
+                    float odd_re = (odd.real() * twiddle_re) - (odd.imag() * twiddle_im);
+                    float odd_im = (odd.real() * twiddle_im) + (odd.imag() * twiddle_re);
+
+                    odd = complex<float>(even.real() - odd_re, even.imag() - odd_im);
+                    even = complex<float>(even.real() + odd_re, even.imag() + odd_im);
+                }
+            }
+        }
+    }
+
+    for (int32_t i = 1; i < size_y; i++) {
+        int32_t j = y_tables.bit_reversal[i];
+        if (i < j) std::swap_ranges(values + (i * size_x), values + ((i + 1) * size_x), values + (j * size_x));
+    }
+
+    for (int32_t span = 2; span <= size_y; span <<= 1) {
+        int32_t half = span / 2;
+        int32_t stride = size_y / span;
+
+        for (int32_t start = 0; start < size_y; start += span) {
+            for (int32_t k = 0; k < half; k++) {
+                float twiddle_re = y_tables.twiddles[k * stride].real();
+                float twiddle_im = direction * y_tables.twiddles[k * stride].imag();
+
+                float* even = reinterpret_cast<float*>(values + ((start + k) * size_x));
+                float* odd = reinterpret_cast<float*>(values + ((start + k + half) * size_x));
+
+                for (int32_t x = 0; x < 2 * size_x; x += 2) {
+                    float odd_re = (odd[x] * twiddle_re) - (odd[x + 1] * twiddle_im);
+                    float odd_im = (odd[x] * twiddle_im) + (odd[x + 1] * twiddle_re);
+
+                    odd[x] = even[x] - odd_re;
+                    odd[x + 1] = even[x + 1] - odd_im;
+                    even[x] += odd_re;
+                    even[x + 1] += odd_im;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Zeroes the transform and copies the first image into the real part and the
+ * second (if there is one) into the imaginary part, pad_y rows down and pad_x
+ * columns right.
+ */
+static void pack_images(const float* first, const float* second, int32_t size_y, int32_t size_x, int32_t pad_y, int32_t pad_x, int32_t fft_size_x, vector< complex<float> > &transform) {
+    std::fill(transform.begin(), transform.end(), complex<float>(0.0, 0.0));
+
+    for (int32_t y = 0; y < size_y; y++) {
+        complex<float>* row = transform.data() + ((y + pad_y) * fft_size_x) + pad_x;
+        const float* first_row = first + (y * size_x);
+
+        if (second == NULL) {
+            for (int32_t x = 0; x < size_x; x++) row[x] = complex<float>(first_row[x], 0.0);
+        } else {
+            const float* second_row = second + (y * size_x);
+            for (int32_t x = 0; x < size_x; x++) row[x] = complex<float>(first_row[x], second_row[x]);
+        }
+    }
+}
+
+/**
+ * Adds the real part (times scale) of the size_y by size_x values of the
+ * transform starting at row offset_y and column offset_x to the first image,
+ * and the imaginary part to the second (if there is one).
+ */
+static void unpack_images(const vector< complex<float> > &transform, int32_t offset_y, int32_t offset_x, int32_t fft_size_x, float scale, int32_t size_y, int32_t size_x, float* first, float* second) {
+    for (int32_t y = 0; y < size_y; y++) {
+        const complex<float>* row = transform.data() + ((y + offset_y) * fft_size_x) + offset_x;
+        float* first_row = first + (y * size_x);
+
+        for (int32_t x = 0; x < size_x; x++) first_row[x] += row[x].real() * scale;
+
+        if (second != NULL) {
+            float* second_row = second + (y * size_x);
+            for (int32_t x = 0; x < size_x; x++) second_row[x] += row[x].imag() * scale;
+        }
+    }
+}
+
+/**
+ * transform[i] *= spectrum[i], or conj(spectrum[i]) if conjugate.
+ */
+static void multiply_spectrum(vector< complex<float> > &transform, const vector< complex<float> > &spectrum, bool conjugate) {
+    float* values = reinterpret_cast<float*>(transform.data());
+    const float* spectrum_values = reinterpret_cast<const float*>(spectrum.data());
+    float sign = conjugate ? -1.0 : 1.0;
+
+    for (int32_t i = 0; i < 2 * (int32_t)transform.size(); i += 2) {
+        float re = values[i];
+        float im = values[i + 1];
+        float spectrum_re = spectrum_values[i];
+        float spectrum_im = sign * spectrum_values[i + 1];
+
+        values[i] = (re * spectrum_re) - (im * spectrum_im);
+        values[i + 1] = (re * spectrum_im) + (im * spectrum_re);
+    }
+}
+
+FilterSpectrum::FilterSpectrum() : filter_y(0), filter_x(0), reverse_filter_y(false), reverse_filter_x(false), fft_size_y(0), fft_size_x(0) {
+}
+
+void FilterSpectrum::update(const float* _weights, int32_t _filter_y, int32_t _filter_x, bool _reverse_filter_y, bool _reverse_filter_x, int32_t _fft_size_y, int32_t _fft_size_x) {
+    if (_filter_y == filter_y && _filter_x == filter_x && _reverse_filter_y == reverse_filter_y && _reverse_filter_x == reverse_filter_x
+            && _fft_size_y == fft_size_y && _fft_size_x == fft_size_x && std::equal(weights.begin(), weights.end(), _weights)) {
+        return;
+    }
+
+    filter_y = _filter_y;
+    filter_x = _filter_x;
+    reverse_filter_y = _reverse_filter_y;
+    reverse_filter_x = _reverse_filter_x;
+    fft_size_y = _fft_size_y;
+    fft_size_x = _fft_size_x;
+    weights.assign(_weights, _weights + (filter_y * filter_x));
+
+    vector<float> lowered_filter;
+    flip_filter(_weights, filter_y, filter_x, reverse_filter_y, reverse_filter_x, lowered_filter);
+
+    spectrum.resize(fft_size_y * fft_size_x);
+    pack_images(lowered_filter.data(), NULL, filter_y, filter_x, 0, 0, fft_size_x, spectrum);
+    fft_2d(spectrum.data(), fft_size_y, fft_size_x, false);
+}
+
+//the correlation of the lowered input with the lowered filter is the inverse
+//FFT of the input's spectrum times the conjugate of the filter's, and as the
+//filter is real, transforming input_a + i * input_b gives the outputs of both
+//images as the real and imaginary parts
+
+void prop_forward_fft(const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum) {
+    static thread_local vector< complex<float> > transform;
+
+    int32_t pad_y = reverse_filter_y ? (filter_y - 1) : 0;
+    int32_t pad_x = reverse_filter_x ? (filter_x - 1) : 0;
+    int32_t fft_size_y = next_power_of_two(output_size_y + filter_y - 1);
+    int32_t fft_size_x = next_power_of_two(output_size_x + filter_x - 1);
+    float scale = 1.0 / (fft_size_y * fft_size_x);
+
+    int32_t output_image_size = output_size_y * output_size_x;
+    int32_t input_image_size = input_size_y * input_size_x;
+
+    filter_spectrum.update(weights, filter_y, filter_x, reverse_filter_y, reverse_filter_x, fft_size_y, fft_size_x);
+    transform.resize(fft_size_y * fft_size_x);
+
+    for (int32_t batch_number = 0; batch_number < batch_size; batch_number += 2) {
+        bool pair = batch_number + 1 < batch_size;
+        const float* first = input + (batch_number * input_image_size);
+        const float* second = pair ? first + input_image_size : NULL;
+
+        pack_images(first, second, input_size_y, input_size_x, pad_y, pad_x, fft_size_x, transform);
+        fft_2d(transform.data(), fft_size_y, fft_size_x, false);
+        multiply_spectrum(transform, filter_spectrum.spectrum, true);
+        fft_2d(transform.data(), fft_size_y, fft_size_x, true);
+
+        float* first_output = output + (batch_number * output_image_size);
+        unpack_images(transform, 0, 0, fft_size_x, scale, output_size_y, output_size_x, first_output, pair ? first_output + output_image_size : NULL);
+    }
+
+#ifdef NAN_CHECKS
+    for (int32_t i = 0; i < batch_size * output_image_size; i++) {
+        if (isnan(output[i]) || isinf(output[i])) {
+            cerr << "ERROR! NAN or INF in propagate forward, output[" << i << "]: " << output[i] << endl;
+            exit(1);
+        }
+    }
+#endif
+}
+
+//the input errors are the full convolution of the output errors with the
+//lowered filter (the spectra times each other), and the updates of the
+//lowered filter are the correlation of the lowered input with the output
+//errors.  For the updates, (input_a + i * input_b) times the conjugate of
+//(errors_a + i * errors_b) has input_a * errors_a + input_b * errors_b as its
+//real part, so the products of every pair are summed and only the total is
+//transformed back
+
+void prop_backward_fft(const float* output_errors, const float* input, float* input_errors, float* weight_updates, const float* weights, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum) {
+    static thread_local vector< complex<float> > input_transform;
+    static thread_local vector< complex<float> > error_transform;
+    static thread_local vector< complex<float> > update_transform;
+
+    int32_t pad_y = reverse_filter_y ? (filter_y - 1) : 0;
+    int32_t pad_x = reverse_filter_x ? (filter_x - 1) : 0;
+    int32_t fft_size_y = next_power_of_two(output_size_y + filter_y - 1);
+    int32_t fft_size_x = next_power_of_two(output_size_x + filter_x - 1);
+    int32_t fft_size = fft_size_y * fft_size_x;
+    float scale = 1.0 / fft_size;
+
+    int32_t output_image_size = output_size_y * output_size_x;
+    int32_t input_image_size = input_size_y * input_size_x;
+
+    filter_spectrum.update(weights, filter_y, filter_x, reverse_filter_y, reverse_filter_x, fft_size_y, fft_size_x);
+    input_transform.resize(fft_size);
+    error_transform.resize(fft_size);
+    update_transform.assign(fft_size, complex<float>(0.0, 0.0));
+
+    float* updates = reinterpret_cast<float*>(update_transform.data());
+    const float* inputs = reinterpret_cast<const float*>(input_transform.data());
+    const float* errors = reinterpret_cast<const float*>(error_transform.data());
+
+    for (int32_t batch_number = 0; batch_number < batch_size; batch_number += 2) {
+        bool pair = batch_number + 1 < batch_size;
+
+        const float* first_input = input + (batch_number * input_image_size);
+        pack_images(first_input, pair ? first_input + input_image_size : NULL, input_size_y, input_size_x, pad_y, pad_x, fft_size_x, input_transform);
+        fft_2d(input_transform.data(), fft_size_y, fft_size_x, false);
+
+        const float* first_errors = output_errors + (batch_number * output_image_size);
+        pack_images(first_errors, pair ? first_errors + output_image_size : NULL, output_size_y, output_size_x, 0, 0, fft_size_x, error_transform);
+        fft_2d(error_transform.data(), fft_size_y, fft_size_x, false);
+
+        for (int32_t i = 0; i < 2 * fft_size; i += 2) {
+            updates[i] += (inputs[i] * errors[i]) + (inputs[i + 1] * errors[i + 1]);
+            updates[i + 1] += (inputs[i + 1] * errors[i]) - (inputs[i] * errors[i + 1]);
+        }
+
+        multiply_spectrum(error_transform, filter_spectrum.spectrum, false);
+        fft_2d(error_transform.data(), fft_size_y, fft_size_x, true);
+
+        float* first_input_errors = input_errors + (batch_number * input_image_size);
+        unpack_images(error_transform, pad_y, pad_x, fft_size_x, scale, input_size_y, input_size_x, first_input_errors, pair ? first_input_errors + input_image_size : NULL);
+    }
+
+    fft_2d(update_transform.data(), fft_size_y, fft_size_x, true);
+
+    for (int32_t fy = 0; fy < filter_y; fy++) {
+        int32_t weight_y = reverse_filter_y ? (filter_y - 1 - fy) : fy;
+
+        for (int32_t fx = 0; fx < filter_x; fx++) {
+            int32_t weight_x = reverse_filter_x ? (filter_x - 1 - fx) : fx;
+
+            weight_updates[(weight_y * filter_x) + weight_x] += (update_transform[(fy * fft_size_x) + fx].real() * scale) / batch_size;
+        }
+    }
+}
+
+
+/********************************************
+ * CONVOLUTION METHOD SELECTION
+ ********************************************/
+
+static void prop_forward_direct(const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x) {
+    if (reverse_filter_y && reverse_filter_x) {
+        prop_forward_ry_rx(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
+    } else if (reverse_filter_y) {
+        prop_forward_ry(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
+    } else if (reverse_filter_x) {
+        prop_forward_rx(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
+    } else {
+        prop_forward(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
+    }
+}
+
+static void prop_backward_direct(float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x) {
+    if (reverse_filter_y && reverse_filter_x) {
+        prop_backward_ry_rx(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
+    } else if (reverse_filter_y) {
+        prop_backward_ry(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
+    } else if (reverse_filter_x) {
+        prop_backward_rx(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
+    } else {
+        prop_backward(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x);
+    }
+}
+
+//the relative costs of a multiply add of the lowered (GEMM) propagation and of
+//a butterfly of the FFT propagation, per image for a forward and backward
+//pass, measured with propagation_test
+#define GEMM_MULTIPLY_ADD_COST 1.0
+#define FFT_BUTTERFLY_COST 12.0
+
+static int convolution_method = -1;
+static bool autotune_convolution = false;
+
+static mutex autotune_mutex;
+static map< vector<int32_t>, int > autotuned_methods;
+
+string convolution_method_name(int method) {
+    switch (method) {
+        case DIRECT_CONVOLUTION: return "direct";
+        case GEMM_CONVOLUTION: return "gemm";
+        case FFT_CONVOLUTION: return "fft";
+    }
+    return "unknown";
+}
+
+void set_convolution_method(const vector<string> &arguments) {
+    string method_name = "auto";
+    get_argument(arguments, "--convolution", false, method_name);
+
+    convolution_method = -1;
+    autotune_convolution = false;
+
+    if (method_name.compare("auto") == 0) {
+    } else if (method_name.compare("autotune") == 0) {
+        autotune_convolution = true;
+    } else if (method_name.compare("direct") == 0) {
+        convolution_method = DIRECT_CONVOLUTION;
+    } else if (method_name.compare("gemm") == 0) {
+        convolution_method = GEMM_CONVOLUTION;
+    } else if (method_name.compare("fft") == 0) {
+        convolution_method = FFT_CONVOLUTION;
+    } else {
+        cerr << "ERROR: unknown --convolution '" << method_name << "', it should be one of auto, autotune, direct, gemm or fft" << endl;
+        exit(1);
+    }
+}
+
+/**
+ * Estimates which method is fastest from the number of multiply adds of the
+ * lowered propagation (which skips the taps that only reach the padding) and
+ * the number of butterflies of the FFTs (two and a half transforms per image
+ * for a forward and backward pass).
+ */
+static int estimate_convolution_method(int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x) {
+    int32_t filter_y = abs(input_size_y - output_size_y) + 1;
+    int32_t filter_x = abs(input_size_x - output_size_x) + 1;
+
+    //a 1x1 filter just scales the image, which the direct propagation does
+    //without any copies
+    if (filter_y == 1 && filter_x == 1) return DIRECT_CONVOLUTION;
+
+    int32_t lowered_y = output_size_y + filter_y - 1;
+    int32_t lowered_x = output_size_x + filter_x - 1;
+
+    //the taps which reach the input, as the lowered input is only nonzero in
+    //its middle input_size_y by input_size_x
+    double taps = fmin(filter_y, input_size_y) * fmin(filter_x, input_size_x);
+    double gemm_cost = 3.0 * output_size_y * output_size_x * taps * GEMM_MULTIPLY_ADD_COST;
+
+    int32_t fft_size_y = next_power_of_two(lowered_y);
+    int32_t fft_size_x = next_power_of_two(lowered_x);
+    double fft_size = (double)fft_size_y * fft_size_x;
+    double fft_cost = 2.5 * (fft_size / 2.0) * log2(fft_size) * FFT_BUTTERFLY_COST;
+
+    return fft_cost < gemm_cost ? FFT_CONVOLUTION : GEMM_CONVOLUTION;
+}
+
+/**
+ * Times a forward and backward pass of each method on random data (after a
+ * pass to warm up the caches and scratch buffers), returning the fastest.
+ */
+static int time_convolution_methods(int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x) {
+    bool reverse_filter_y = output_size_y > input_size_y;
+    bool reverse_filter_x = output_size_x > input_size_x;
+    int32_t filter_y = abs(input_size_y - output_size_y) + 1;
+    int32_t filter_x = abs(input_size_x - output_size_x) + 1;
+
+    minstd_rand0 generator(batch_size + input_size_y + input_size_x + output_size_y + output_size_x);
+    uniform_real_distribution<float> distribution(-1.0, 1.0);
+
+    vector<float> input(batch_size * input_size_y * input_size_x);
+    vector<float> output_errors(batch_size * output_size_y * output_size_x);
+    vector<float> weights(filter_y * filter_x);
+    for (int32_t i = 0; i < (int32_t)input.size(); i++) input[i] = distribution(generator);
+    for (int32_t i = 0; i < (int32_t)output_errors.size(); i++) output_errors[i] = distribution(generator);
+    for (int32_t i = 0; i < (int32_t)weights.size(); i++) weights[i] = distribution(generator);
+
+    vector<float> output(output_errors.size());
+    vector<float> input_errors(input.size());
+    vector<float> weight_updates(weights.size());
+    FilterSpectrum filter_spectrum;
+
+    using namespace std::chrono;
+
+    int fastest_method = GEMM_CONVOLUTION;
+    double fastest_time = 0.0;
+    for (int method = DIRECT_CONVOLUTION; method <= FFT_CONVOLUTION; method++) {
+        high_resolution_clock::time_point start;
+
+        for (int32_t pass = 0; pass < 2; pass++) {
+            start = high_resolution_clock::now();
+            prop_forward_convolution(method, input.data(), weights.data(), output.data(), batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+            prop_backward_convolution(method, output_errors.data(), input.data(), input_errors.data(), weight_updates.data(), weights.data(), batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+        }
+        double time = duration<double>(high_resolution_clock::now() - start).count();
+
+        if (method == DIRECT_CONVOLUTION || time < fastest_time) {
+            fastest_method = method;
+            fastest_time = time;
+        }
+    }
+
+    return fastest_method;
+}
+
+int get_convolution_method(int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x) {
+    if (convolution_method >= 0) return convolution_method;
+    if (!autotune_convolution) return estimate_convolution_method(input_size_y, input_size_x, output_size_y, output_size_x);
+
+    vector<int32_t> key = {batch_size, input_size_y, input_size_x, output_size_y, output_size_x};
+
+    //the lock is held while timing so each size is only timed once, and so
+    //other threads do not slow down the timing
+    lock_guard<mutex> lock(autotune_mutex);
+    map< vector<int32_t>, int >::iterator tuned = autotuned_methods.find(key);
+    if (tuned != autotuned_methods.end()) return tuned->second;
+
+    int method = time_convolution_methods(batch_size, input_size_y, input_size_x, output_size_y, output_size_x);
+    autotuned_methods[key] = method;
+
+    cout << "autotuned convolution for " << input_size_y << "x" << input_size_x << " -> " << output_size_y << "x" << output_size_x
+        << " with batch size " << batch_size << ": " << convolution_method_name(method) << endl;
+
+    return method;
+}
+
+static void prop_forward_method(int method, const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum) {
+    if (method == FFT_CONVOLUTION) {
+        prop_forward_fft(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+    } else if (method == GEMM_CONVOLUTION) {
+        prop_forward_gemm(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x);
+    } else {
+        prop_forward_direct(input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x);
+    }
+}
+
+static void prop_backward_method(int method, const float* output_errors, const float* input, float* input_errors, float* weight_updates, const float* weights, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum) {
+    if (method == FFT_CONVOLUTION) {
+        prop_backward_fft(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+    } else if (method == GEMM_CONVOLUTION) {
+        prop_backward_gemm(output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x);
+    } else {
+        //the direct propagation does not modify its inputs, it just predates const
+        prop_backward_direct(const_cast<float*>(output_errors), const_cast<float*>(input), input_errors, weight_updates, const_cast<float*>(weights), batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x);
+    }
+}
+
+/**
+ * The batch threads all use the edge's filter spectrum, so it is brought up to
+ * date before they start and they only ever read it.
+ */
+static void update_filter_spectrum(int method, const float* weights, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum) {
+    if (method != FFT_CONVOLUTION) return;
+
+    int32_t fft_size_y = next_power_of_two(output_size_y + filter_y - 1);
+    int32_t fft_size_x = next_power_of_two(output_size_x + filter_x - 1);
+    filter_spectrum.update(weights, filter_y, filter_x, reverse_filter_y, reverse_filter_x, fft_size_y, fft_size_x);
+}
+
+//each batch thread propagates its own images, which only touch their own
+//outputs and input errors
+
+void prop_forward_convolution(int method, const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum) {
+    if (get_number_batch_chunks(batch_size) <= 1) {
+        prop_forward_method(method, input, weights, output, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+        return;
+    }
+
+    update_filter_spectrum(method, weights, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+
+    int32_t input_image_size = input_size_y * input_size_x;
+    int32_t output_image_size = output_size_y * output_size_x;
+
+    parallel_for_batch(batch_size, [&](int32_t chunk, int32_t batch_begin, int32_t batch_end) {
+        prop_forward_method(method, input + (batch_begin * input_image_size), weights, output + (batch_begin * output_image_size), batch_end - batch_begin, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+    });
+}
+
+//the weight updates of each batch thread's images are averaged over just
+//those images, so they are summed weighted by the number of images in each
+
+void prop_backward_convolution(int method, const float* output_errors, const float* input, float* input_errors, float* weight_updates, const float* weights, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum) {
+    int32_t number_chunks = get_number_batch_chunks(batch_size);
+    if (number_chunks <= 1) {
+        prop_backward_method(method, output_errors, input, input_errors, weight_updates, weights, batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+        return;
+    }
+
+    update_filter_spectrum(method, weights, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+
+    int32_t input_image_size = input_size_y * input_size_x;
+    int32_t output_image_size = output_size_y * output_size_x;
+    int32_t filter_size = filter_y * filter_x;
+
+    vector<float> chunk_updates(number_chunks * filter_size, 0.0);
+    vector<int32_t> chunk_images(number_chunks, 0);
+
+    parallel_for_batch(batch_size, [&](int32_t chunk, int32_t batch_begin, int32_t batch_end) {
+        chunk_images[chunk] = batch_end - batch_begin;
+        prop_backward_method(method, output_errors + (batch_begin * output_image_size), input + (batch_begin * input_image_size), input_errors + (batch_begin * input_image_size), chunk_updates.data() + (chunk * filter_size), weights, batch_end - batch_begin, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+    });
+
+    for (int32_t chunk = 0; chunk < number_chunks; chunk++) {
+        float chunk_weight = (float)chunk_images[chunk] / batch_size;
+        const float* updates = chunk_updates.data() + (chunk * filter_size);
+
+        for (int32_t current = 0; current < filter_size; current++) {
+            weight_updates[current] += updates[current] * chunk_weight;
+        }
+    }
+}
+
 #ifdef PROPAGATE_TEST
+
+#define REPEATS 10
+
+void fill_random(vector<float> &values, minstd_rand0 &generator) {
+    uniform_real_distribution<float> distribution(-1.0, 1.0);
+    for (int32_t i = 0; i < (int32_t)values.size(); i++) {
+        values[i] = distribution(generator);
+    }
+}
+
+float max_difference(const vector<float> &expected, const vector<float> &actual) {
+    float max_expected = 1e-6;
+    float difference = 0.0;
+
+    for (int32_t i = 0; i < (int32_t)expected.size(); i++) {
+        max_expected = fmax(max_expected, fabs(expected[i]));
+        difference = fmax(difference, fabs(expected[i] - actual[i]));
+    }
+
+    //relative to the largest value, as the values are sums of many products
+    return difference / max_expected;
+}
+
+/**
+ * Compares the outputs, input errors and weight updates of the direct, lowered
+ * (GEMM) and FFT propagation for an edge between nodes of the given sizes, and
+ * how long each takes.  Returns false if they differ.
+ */
+bool test_propagation(int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x, int32_t batch_size, minstd_rand0 &generator) {
+    bool reverse_filter_y = output_size_y > input_size_y;
+    bool reverse_filter_x = output_size_x > input_size_x;
+    int32_t filter_y = reverse_filter_y ? (output_size_y - input_size_y + 1) : (input_size_y - output_size_y + 1);
+    int32_t filter_x = reverse_filter_x ? (output_size_x - input_size_x + 1) : (input_size_x - output_size_x + 1);
+
+    vector<float> input(batch_size * input_size_y * input_size_x);
+    vector<float> output_errors(batch_size * output_size_y * output_size_x);
+    vector<float> weights(filter_y * filter_x);
+    fill_random(input, generator);
+    fill_random(output_errors, generator);
+    fill_random(weights, generator);
+
+    vector<float> outputs[3];
+    vector<float> input_errors[3];
+    vector<float> weight_updates[3];
+    FilterSpectrum filter_spectrum;
+
+    using namespace std::chrono;
+    duration<double, std::milli> forward_times[3], backward_times[3];
+    for (int method = DIRECT_CONVOLUTION; method <= FFT_CONVOLUTION; method++) {
+        forward_times[method] = duration<double, std::milli>(0);
+        backward_times[method] = duration<double, std::milli>(0);
+    }
+
+    for (int32_t repeat = 0; repeat < REPEATS; repeat++) {
+        for (int method = DIRECT_CONVOLUTION; method <= FFT_CONVOLUTION; method++) {
+            outputs[method].assign(output_errors.size(), 0.0);
+            input_errors[method].assign(input.size(), 0.0);
+            weight_updates[method].assign(weights.size(), 0.0);
+
+            //the direct propagation is the reference, so it is never split
+            //over the batch threads
+            high_resolution_clock::time_point start = high_resolution_clock::now();
+            if (method == DIRECT_CONVOLUTION) {
+                prop_forward_direct(input.data(), weights.data(), outputs[method].data(), batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x);
+            } else {
+                prop_forward_convolution(method, input.data(), weights.data(), outputs[method].data(), batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+            }
+            high_resolution_clock::time_point end = high_resolution_clock::now();
+            forward_times[method] += end - start;
+
+            start = high_resolution_clock::now();
+            if (method == DIRECT_CONVOLUTION) {
+                prop_backward_direct(output_errors.data(), input.data(), input_errors[method].data(), weight_updates[method].data(), weights.data(), batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x);
+            } else {
+                prop_backward_convolution(method, output_errors.data(), input.data(), input_errors[method].data(), weight_updates[method].data(), weights.data(), batch_size, input_size_y, input_size_x, filter_y, filter_x, output_size_y, output_size_x, reverse_filter_y, reverse_filter_x, filter_spectrum);
+            }
+            end = high_resolution_clock::now();
+            backward_times[method] += end - start;
+        }
+    }
+
+    bool passed = true;
+
+    cout << setw(3) << input_size_y << "x" << setw(3) << input_size_x << " -> " << setw(3) << output_size_y << "x" << setw(3) << output_size_x
+        << ", filter " << setw(2) << filter_y << "x" << setw(2) << filter_x
+        << (reverse_filter_y ? " ry" : "   ") << (reverse_filter_x ? " rx" : "   ");
+
+    for (int method = GEMM_CONVOLUTION; method <= FFT_CONVOLUTION; method++) {
+        float output_difference = max_difference(outputs[DIRECT_CONVOLUTION], outputs[method]);
+        float input_error_difference = max_difference(input_errors[DIRECT_CONVOLUTION], input_errors[method]);
+        float weight_update_difference = max_difference(weight_updates[DIRECT_CONVOLUTION], weight_updates[method]);
+        passed = passed && output_difference < 1e-4 && input_error_difference < 1e-4 && weight_update_difference < 1e-4;
+
+        cout << ", " << convolution_method_name(method) << " differences: " << std::scientific << setprecision(2) << output_difference << " " << input_error_difference << " " << weight_update_difference;
+    }
+
+    cout << fixed << setprecision(3) << ", forward/backward ms";
+    for (int method = DIRECT_CONVOLUTION; method <= FFT_CONVOLUTION; method++) {
+        cout << " " << convolution_method_name(method) << ": " << setw(8) << forward_times[method].count() / REPEATS << "/" << setw(8) << backward_times[method].count() / REPEATS;
+    }
+
+    cout << ", estimated: " << convolution_method_name(get_convolution_method(batch_size, input_size_y, input_size_x, output_size_y, output_size_x))
+        << (passed ? "" : " FAILED") << endl;
+
+    return passed;
+}
+
+/**
+ * Compares the kernels' 8 bit correlation with a scalar loop, for inputs and
+ * outputs whose rows are further apart than they are wide, over outputs which
+ * already hold values.  Returns false if they differ.
+ */
+bool test_correlate_int8(const Kernels &kernels, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, minstd_rand0 &generator) {
+    int32_t input_stride = output_size_x + filter_x - 1 + 3;
+    int32_t output_stride = output_size_x + 2;
+
+    uniform_int_distribution<int32_t> value_distribution(-128, 127);
+
+    vector<int8_t> input((output_size_y + filter_y - 1) * input_stride);
+    vector<int8_t> filter(filter_y * filter_x);
+    vector<int32_t> output(output_size_y * output_stride);
+    for (int32_t i = 0; i < (int32_t)input.size(); i++) input[i] = value_distribution(generator);
+    for (int32_t i = 0; i < (int32_t)filter.size(); i++) filter[i] = value_distribution(generator);
+    for (int32_t i = 0; i < (int32_t)output.size(); i++) output[i] = value_distribution(generator);
+
+    vector<int32_t> expected = output;
+    for (int32_t y = 0; y < output_size_y; y++) {
+        for (int32_t x = 0; x < output_size_x; x++) {
+            for (int32_t fy = 0; fy < filter_y; fy++) {
+                for (int32_t fx = 0; fx < filter_x; fx++) {
+                    expected[(y * output_stride) + x] += filter[(fy * filter_x) + fx] * input[((y + fy) * input_stride) + x + fx];
+                }
+            }
+        }
+    }
+
+    kernels.correlate_int8(input.data(), input_stride, filter.data(), filter_y, filter_x, output.data(), output_stride, output_size_y, output_size_x);
+
+    //the padding between the output rows should not be written either
+    for (int32_t i = 0; i < (int32_t)output.size(); i++) {
+        if (output[i] != expected[i]) {
+            cout << "int8 correlation with filter " << filter_y << "x" << filter_x << " and output " << output_size_y << "x" << output_size_x
+                << " FAILED, output " << (i / output_stride) << ", " << (i % output_stride) << " was " << output[i] << " instead of " << expected[i] << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t float_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(uint32_t));
+    return bits;
+}
+
+float bits_float(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+/**
+ * Compares the kernels' half precision conversions of one value at a time
+ * (which are scalar) with their conversions of whole vectors (which use F16C
+ * if the kernels have it) and with the F16C conversions of f16c_kernels (NULL
+ * if the CPU has no F16C), over every half precision value and floats which
+ * are subnormal or exactly between two half precision values, overflow to
+ * infinity or are NaN.  The results need to have the same bits, including
+ * the payloads of NaN.  Returns false if any differ.
+ */
+bool test_half_conversions(const Kernels &kernels, const Kernels *f16c_kernels, minstd_rand0 &generator) {
+    //padded to a multiple of the largest vector width so the F16C
+    //conversions convert every value
+    const int32_t PADDING = 16;
+
+    vector<uint16_t> half_values;
+    for (uint32_t i = 0; i <= 0xffff; i++) half_values.push_back(i);
+
+    vector<float> float_values;
+    //subnormal halves, and the values exactly between them (and the smallest
+    //normal half), which round to the even one
+    for (int32_t i = 0; i <= 1024; i++) {
+        float_values.push_back(i * (1.0f / 16777216.0f));
+        float_values.push_back((i + 0.5f) * (1.0f / 16777216.0f));
+        float_values.push_back(-(i + 0.5f) * (1.0f / 16777216.0f));
+        float_values.push_back(bits_float(float_bits((i + 0.5f) * (1.0f / 16777216.0f)) + 1));
+        float_values.push_back(bits_float(float_bits((i + 0.5f) * (1.0f / 16777216.0f)) - 1));
+    }
+    //subnormal floats
+    float_values.push_back(bits_float(0x00000001));
+    float_values.push_back(bits_float(0x007fffff));
+    float_values.push_back(bits_float(0x80400000));
+    //the values exactly between normal halves, and just either side of them
+    for (uint32_t half = 0x0400; half < 0x7c00; half += 0x00c1) {
+        //the half's float, with half of its last bit added
+        uint32_t between = ((((half >> 10) + 112) << 23) | ((half & 0x3ff) << 13)) + 0x1000;
+        float_values.push_back(bits_float(between));
+        float_values.push_back(bits_float(between + 1));
+        float_values.push_back(bits_float(between - 1));
+        float_values.push_back(-bits_float(between));
+    }
+    //the largest half is 65504, and 65520 is exactly between it and 65536,
+    //which is infinity
+    float values_near_infinity[] = { 65504.0f, 65519.0f, 65519.996f, 65520.0f, 65536.0f, 1e10f, numeric_limits<float>::max(), numeric_limits<float>::infinity() };
+    for (uint32_t i = 0; i < sizeof(values_near_infinity) / sizeof(values_near_infinity[0]); i++) {
+        float_values.push_back(values_near_infinity[i]);
+        float_values.push_back(-values_near_infinity[i]);
+    }
+    //quiet and signaling NaN, with and without payloads
+    uint32_t nan_bits[] = { 0x7fc00000, 0xffc00000, 0x7fc02000, 0x7fe00000, 0x7f802000, 0x7f800001, 0xff801fff, 0x7fffffff, 0xffffe000 };
+    for (uint32_t i = 0; i < sizeof(nan_bits) / sizeof(nan_bits[0]); i++) {
+        float_values.push_back(bits_float(nan_bits[i]));
+    }
+    uniform_int_distribution<uint32_t> bits_distribution;
+    for (int32_t i = 0; i < 10000; i++) {
+        float_values.push_back(bits_float(bits_distribution(generator)));
+    }
+
+    while (half_values.size() % PADDING != 0) half_values.push_back(0);
+    while (float_values.size() % PADDING != 0) float_values.push_back(0.0f);
+
+    vector<float> expected_floats(half_values.size());
+    vector<float> vector_floats(half_values.size());
+    vector<float> scalar_floats(half_values.size());
+    if (f16c_kernels != NULL) f16c_kernels->half_to_float(half_values.data(), expected_floats.data(), half_values.size());
+    kernels.half_to_float(half_values.data(), vector_floats.data(), half_values.size());
+    for (int32_t i = 0; i < (int32_t)half_values.size(); i++) {
+        kernels.half_to_float(&half_values[i], &scalar_floats[i], 1);
+    }
+
+    vector<uint16_t> expected_halves(float_values.size());
+    vector<uint16_t> vector_halves(float_values.size());
+    vector<uint16_t> scalar_halves(float_values.size());
+    if (f16c_kernels != NULL) f16c_kernels->float_to_half(float_values.data(), expected_halves.data(), float_values.size());
+    kernels.float_to_half(float_values.data(), vector_halves.data(), float_values.size());
+    for (int32_t i = 0; i < (int32_t)float_values.size(); i++) {
+        kernels.float_to_half(&float_values[i], &scalar_halves[i], 1);
+    }
+
+    bool passed = true;
+    int32_t failures = 0;
+    for (int32_t i = 0; i < (int32_t)half_values.size(); i++) {
+        uint32_t scalar = float_bits(scalar_floats[i]);
+        uint32_t vector_result = float_bits(vector_floats[i]);
+        uint32_t expected = (f16c_kernels != NULL) ? float_bits(expected_floats[i]) : scalar;
+
+        if (scalar != expected || vector_result != expected) {
+            if (failures++ < 10) {
+                cout << "half to float of 0x" << std::hex << half_values[i] << " FAILED, scalar: 0x" << scalar << ", vector: 0x" << vector_result << ", F16C: 0x" << expected << std::dec << endl;
+            }
+            passed = false;
+        }
+    }
+
+    for (int32_t i = 0; i < (int32_t)float_values.size(); i++) {
+        uint16_t expected = (f16c_kernels != NULL) ? expected_halves[i] : scalar_halves[i];
+
+        if (scalar_halves[i] != expected || vector_halves[i] != expected) {
+            if (failures++ < 10) {
+                cout << "float to half of 0x" << std::hex << float_bits(float_values[i]) << " FAILED, scalar: 0x" << scalar_halves[i] << ", vector: 0x" << vector_halves[i] << ", F16C: 0x" << expected << std::dec << endl;
+            }
+            passed = false;
+        }
+    }
+
+    cout << "converted " << half_values.size() << " half precision values and " << float_values.size() << " floats"
+        << (f16c_kernels != NULL ? "" : " (without F16C to compare with)") << (passed ? "" : " FAILED") << endl;
+
+    return passed;
+}
+
 int main(int argc, char **argv) {
-    //make tests for the 8 convolve operations
+    int32_t batch_size = 50;
+
+    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    minstd_rand0 generator(seed);
+
+    //{input_size_y, input_size_x, output_size_y, output_size_x}, covering the
+    //regular and reverse filters and the small and large filters EXACT evolves
+    int32_t sizes[][4] = {
+        {28, 28, 24, 24},
+        {28, 28, 26, 26},
+        {28, 28, 14, 14},
+        {28, 28,  2,  2},
+        {28, 28, 28, 28},
+        {32, 32, 28, 28},
+        {13, 15,  6,  4},
+        { 6, 15, 13,  4},
+        {13,  4,  6, 15},
+        { 6,  4, 13, 15},
+        {14, 14, 28, 28},
+        { 2,  2, 28, 28},
+        {24, 28, 28, 24},
+        {100, 100, 90, 90},
+        {64, 64, 32, 32},
+        {100, 100, 50, 50},
+        {50, 50, 100, 100}
+    };
+
+    bool passed = true;
+    for (int32_t isa = KERNEL_SSE; isa <= KERNEL_AVX512; isa++) {
+        if (!kernel_isa_supported((KernelIsa)isa)) {
+            cout << "skipping the " << kernel_isa_name((KernelIsa)isa) << " kernels, which this CPU does not support" << endl;
+            continue;
+        }
+
+        set_kernel_isa((KernelIsa)isa);
+        cout << "testing the " << kernel_isa_name((KernelIsa)isa) << " kernels:" << endl;
+
+        for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            passed = test_propagation(sizes[i][0], sizes[i][1], sizes[i][2], sizes[i][3], batch_size, generator) && passed;
+        }
+    }
+
+    //the 8 bit correlation and half precision conversion kernels, with odd
+    //filter widths and output widths which are not multiples of the vector
+    //widths, the avx2 kernels' vector conversions being F16C's
+    int32_t int8_filter_sizes[][2] = { {1, 1}, {1, 2}, {3, 3}, {2, 5}, {5, 5}, {4, 7}, {3, 8} };
+    int32_t int8_output_widths[] = { 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 100 };
+    const Kernels *f16c_kernels = kernel_isa_supported(KERNEL_AVX2) ? &avx2_kernels : NULL;
 
+    const Kernels *all_kernels[] = { &sse_kernels, &avx2_kernels, &avx512_kernels };
+    for (int32_t isa = KERNEL_SSE; isa <= KERNEL_AVX512; isa++) {
+        if (!kernel_isa_supported((KernelIsa)isa)) continue;
+        cout << "testing the " << kernel_isa_name((KernelIsa)isa) << " int8 correlation and half precision conversion:" << endl;
+
+        bool int8_passed = true;
+        for (uint32_t i = 0; i < sizeof(int8_filter_sizes) / sizeof(int8_filter_sizes[0]); i++) {
+            for (uint32_t j = 0; j < sizeof(int8_output_widths) / sizeof(int8_output_widths[0]); j++) {
+                int8_passed = test_correlate_int8(*all_kernels[isa], int8_filter_sizes[i][0], int8_filter_sizes[i][1], 3, int8_output_widths[j], generator) && int8_passed;
+            }
+        }
+        cout << "correlated " << sizeof(int8_filter_sizes) / sizeof(int8_filter_sizes[0]) << " filter sizes over " << sizeof(int8_output_widths) / sizeof(int8_output_widths[0]) << " output widths" << (int8_passed ? "" : " FAILED") << endl;
+
+        passed = int8_passed && passed;
+        passed = test_half_conversions(*all_kernels[isa], f16c_kernels, generator) && passed;
+    }
+
+    //the gemm and fft propagation split over the batch threads, with a batch
+    //size that does not divide evenly between them
+    set_kernel_isa(detect_kernel_isa());
+    set_batch_threads(3);
+    cout << "testing the " << kernel_isa_name(get_kernel_isa()) << " kernels with " << get_batch_threads() << " batch threads:" << endl;
+
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        passed = test_propagation(sizes[i][0], sizes[i][1], sizes[i][2], sizes[i][3], batch_size - 1, generator) && passed;
+    }
+    set_batch_threads(1);
+
+    if (!passed) {
+        cerr << "ERROR: the direct, gemm and fft propagation (or the int8 and half precision kernels) differ" << endl;
+        return 1;
+    }
+    return 0;
 }
 #endif
@@ -3,6 +3,12 @@
 
 #include "stdint.h"
 
+#include <complex>
+using std::complex;
+
+#include <string>
+using std::string;
+
 #include <vector>
 using std::vector;
 
@@ -23,4 +29,79 @@ void prop_backward_rx(float* output_errors, float* input, float* input_errors, f
 
 void prop_backward_ry_rx(float* output_errors, float* input, float* input_errors, float* weight_updates, float* weights, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x);
 
+
+/**
+ * These calculate the same as the prop_forward and prop_backward variants
+ * above (selected by reverse_filter_y and reverse_filter_x), but lower every
+ * variant to a single valid correlation of a zero padded input with a
+ * (possibly flipped) filter, which is computed by a register blocked micro
+ * kernel that accumulates blocks of output pixels over the whole filter and
+ * writes each of them once (see kernels.hxx, which selects the instruction
+ * set it is vectorized with).  The input errors and weight updates are the
+ * same kind of correlation (of the padded output errors with the flipped
+ * filter, and of the input with the output errors), so they use the same
+ * kernel.
+ */
+void prop_forward_gemm(const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x);
+
+void prop_backward_gemm(const float* output_errors, const float* input, float* input_errors, float* weight_updates, const float* weights, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x);
+
+
+/**
+ * The FFT of an edge's lowered filter (see prop_forward_fft), which is kept
+ * between calls and only recalculated when the weights (or sizes) it was
+ * calculated from change.
+ */
+class FilterSpectrum {
+    private:
+        vector<float> weights; /**< the weights the spectrum was calculated from. */
+        int32_t filter_y, filter_x;
+        bool reverse_filter_y, reverse_filter_x;
+        int32_t fft_size_y, fft_size_x;
+
+    public:
+        vector< complex<float> > spectrum;
+
+        FilterSpectrum();
+
+        void update(const float* _weights, int32_t _filter_y, int32_t _filter_x, bool _reverse_filter_y, bool _reverse_filter_x, int32_t _fft_size_y, int32_t _fft_size_x);
+};
+
+/**
+ * These calculate the same as the gemm variants, with the correlations done
+ * as products of 2D FFTs (zero padded to powers of two large enough that
+ * they do not wrap around).  Two images of the batch are transformed at once,
+ * one as the real and one as the imaginary part, as the filter is real.  The
+ * transforms cost about the same for any filter size, so this is faster than
+ * the other two when both the filter and the output are large.
+ */
+void prop_forward_fft(const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum);
+
+void prop_backward_fft(const float* output_errors, const float* input, float* input_errors, float* weight_updates, const float* weights, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum);
+
+
+#define DIRECT_CONVOLUTION 0
+#define GEMM_CONVOLUTION 1
+#define FFT_CONVOLUTION 2
+
+string convolution_method_name(int method);
+
+/**
+ * Sets how the convolution method of each edge is picked from --convolution,
+ * which is one of:
+ *   auto: by the estimated cost of each method for the edge's sizes (the default)
+ *   autotune: by timing each method, once for each size of edge
+ *   direct, gemm or fft: always that method
+ */
+void set_convolution_method(const vector<string> &arguments);
+
+/**
+ * The convolution method for an edge between nodes of these sizes.
+ */
+int get_convolution_method(int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t output_size_y, int32_t output_size_x);
+
+void prop_forward_convolution(int method, const float* input, const float* weights, float* output, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum);
+
+void prop_backward_convolution(int method, const float* output_errors, const float* input, float* input_errors, float* weight_updates, const float* weights, int32_t batch_size, int32_t input_size_y, int32_t input_size_x, int32_t filter_y, int32_t filter_x, int32_t output_size_y, int32_t output_size_x, bool reverse_filter_y, bool reverse_filter_x, FilterSpectrum &filter_spectrum);
+
 #endif
@@ -0,0 +1,639 @@
+#include <cmath>
+
+#include <fstream>
+using std::ifstream;
+using std::ios;
+using std::ofstream;
+
+#include <iostream>
+using std::cerr;
+using std::endl;
+using std::istream;
+using std::ostream;
+
+#include <map>
+using std::map;
+
+#include <string>
+using std::getline;
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "common/exp.hxx"
+
+#include "cnn_edge.hxx"
+#include "cnn_genome.hxx"
+#include "cnn_node.hxx"
+#include "kernels.hxx"
+#include "pooling.hxx"
+#include "quantized_genome.hxx"
+
+#include "stdint.h"
+
+//the first line of an exported quantized genome
+#define QUANTIZED_GENOME_HEADER "EXACT QUANTIZED GENOME 1"
+
+string inference_precision_name(int precision) {
+    switch (precision) {
+        case FP32_INFERENCE: return "fp32";
+        case FP16_INFERENCE: return "fp16";
+        case INT8_INFERENCE: return "int8";
+    }
+    return "unknown";
+}
+
+int get_inference_precision(string name) {
+    if (name.compare("fp32") == 0) {
+        return FP32_INFERENCE;
+    } else if (name.compare("fp16") == 0) {
+        return FP16_INFERENCE;
+    } else if (name.compare("int8") == 0) {
+        return INT8_INFERENCE;
+    } else {
+        cerr << "ERROR: unknown inference precision '" << name << "', it should be one of fp32, fp16 or int8" << endl;
+        exit(1);
+    }
+}
+
+QuantizedNode::QuantizedNode() : innovation_number(-1), type(HIDDEN_NODE), size_y(0), size_x(0), number_inputs(0), scale(1.0), shift(0.0), activation_scale(1.0) {
+}
+
+QuantizedEdge::QuantizedEdge() : type(CONVOLUTIONAL), input_node(-1), output_node(-1), filter_y(0), filter_x(0), reverse_filter_y(false), reverse_filter_x(false), pool_scale(1.0), weight_scale(1.0) {
+}
+
+QuantizedGenome::QuantizedGenome(CNN_Genome *genome, int _precision, const ImagesInterface &calibration_images, int number_calibration_images) {
+    float epsilon = genome->get_epsilon();
+    float input_dropout_probability = genome->get_input_dropout_probability();
+    float hidden_dropout_probability = genome->get_hidden_dropout_probability();
+
+    //only the nodes an image can reach the softmax nodes through are needed
+    vector<CNN_Node*> genome_nodes = genome->get_nodes();
+    vector<CNN_Node*> genome_input_nodes = genome->get_input_nodes();
+    vector<CNN_Node*> genome_softmax_nodes = genome->get_softmax_nodes();
+
+    map<const CNN_Node*, int> node_positions;
+    for (uint32_t i = 0; i < genome_nodes.size(); i++) {
+        CNN_Node *genome_node = genome_nodes[i];
+        if (!genome_node->is_reachable() && !genome_node->is_input() && !genome_node->is_softmax()) continue;
+
+        QuantizedNode node;
+        node.innovation_number = genome_node->get_innovation_number();
+        node.size_y = genome_node->get_size_y();
+        node.size_x = genome_node->get_size_x();
+        node.number_inputs = genome_node->get_number_inputs();
+
+        if (genome_node->is_input()) {
+            node.type = INPUT_NODE;
+            //the input dropout only scales the pixels when not training
+            if (input_dropout_probability > 0) node.scale = 1.0 - input_dropout_probability;
+        } else if (genome_node->is_softmax()) {
+            node.type = SOFTMAX_NODE;
+        } else {
+            node.type = genome_node->is_output() ? OUTPUT_NODE : HIDDEN_NODE;
+            genome_node->get_folded_batch_normalization(epsilon, hidden_dropout_probability, node.scale, node.shift);
+        }
+
+        node_positions[genome_node] = nodes.size();
+        nodes.push_back(node);
+    }
+
+    for (uint32_t i = 0; i < genome_input_nodes.size(); i++) {
+        input_nodes.push_back(node_positions[genome_input_nodes[i]]);
+    }
+
+    for (uint32_t i = 0; i < genome_softmax_nodes.size(); i++) {
+        softmax_nodes.push_back(node_positions[genome_softmax_nodes[i]]);
+    }
+    number_classes = softmax_nodes.size();
+
+    //the genome's edges are in the order they are propagated
+    vector<CNN_Edge*> genome_edges = genome->get_edges();
+    for (uint32_t i = 0; i < genome_edges.size(); i++) {
+        CNN_Edge *genome_edge = genome_edges[i];
+        if (!genome_edge->is_reachable()) continue;
+
+        QuantizedEdge edge;
+        edge.type = genome_edge->get_type();
+        edge.input_node = node_positions[genome_edge->get_input_node()];
+        edge.output_node = node_positions[genome_edge->get_output_node()];
+        edge.filter_y = genome_edge->get_filter_y();
+        edge.filter_x = genome_edge->get_filter_x();
+        edge.reverse_filter_y = genome_edge->is_reverse_filter_y();
+        edge.reverse_filter_x = genome_edge->is_reverse_filter_x();
+
+        const QuantizedNode &input_node = nodes[edge.input_node];
+        const QuantizedNode &output_node = nodes[edge.output_node];
+
+        if (edge.type == CONVOLUTIONAL) {
+            edge.weights.resize(edge.filter_y * edge.filter_x);
+
+            for (int32_t fy = 0; fy < edge.filter_y; fy++) {
+                int32_t weight_y = edge.reverse_filter_y ? (edge.filter_y - 1 - fy) : fy;
+
+                for (int32_t fx = 0; fx < edge.filter_x; fx++) {
+                    int32_t weight_x = edge.reverse_filter_x ? (edge.filter_x - 1 - fx) : fx;
+
+                    edge.weights[(fy * edge.filter_x) + fx] = genome_edge->get_weight((weight_y * edge.filter_x) + weight_x);
+                }
+            }
+        } else {
+            edge.pool_scale = genome_edge->get_scale();
+            initialize_pools(edge.y_pools, edge.y_pool_offset, input_node.size_y, output_node.size_y);
+            initialize_pools(edge.x_pools, edge.x_pool_offset, input_node.size_x, output_node.size_x);
+        }
+
+        edges.push_back(edge);
+    }
+
+    precision = FP32_INFERENCE;
+    initialize_values();
+
+    if (_precision == INT8_INFERENCE) calibrate(calibration_images, number_calibration_images);
+
+    set_precision(_precision);
+}
+
+QuantizedGenome::QuantizedGenome(string filename) {
+    ifstream infile(filename.c_str(), ios::in | ios::binary);
+
+    if (!infile.is_open()) {
+        cerr << "ERROR: could not open quantized genome file '" << filename << "'" << endl;
+        exit(1);
+    }
+
+    read(infile);
+    infile.close();
+}
+
+QuantizedGenome::QuantizedGenome(istream &in) {
+    read(in);
+}
+
+int QuantizedGenome::get_precision() const {
+    return precision;
+}
+
+int QuantizedGenome::get_number_classes() const {
+    return number_classes;
+}
+
+int64_t QuantizedGenome::get_weight_bytes() const {
+    int64_t weight_bytes = 0;
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        const QuantizedEdge &edge = edges[i];
+
+        if (edge.type == CONVOLUTIONAL) {
+            weight_bytes += (edge.weights.size() * sizeof(float)) + (edge.half_weights.size() * sizeof(uint16_t)) + (edge.quantized_weights.size() * sizeof(int8_t));
+            if (precision == INT8_INFERENCE) weight_bytes += sizeof(float);
+        } else {
+            weight_bytes += sizeof(float);
+        }
+    }
+
+    return weight_bytes;
+}
+
+void QuantizedGenome::initialize_values() {
+    values_in.resize(nodes.size());
+    values_out.resize(nodes.size());
+    half_values_out.resize(nodes.size());
+    quantized_values_out.resize(nodes.size());
+    inputs_fired.resize(nodes.size());
+
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        int32_t size = nodes[i].size_y * nodes[i].size_x;
+
+        values_in[i].resize(size);
+
+        //the values out are only kept in the genome's precision
+        if (precision == FP32_INFERENCE) {
+            values_out[i].resize(size);
+        } else {
+            vector<float>().swap(values_out[i]);
+        }
+
+        if (precision == FP16_INFERENCE) {
+            half_values_out[i].resize(size);
+        } else {
+            vector<uint16_t>().swap(half_values_out[i]);
+        }
+
+        if (precision == INT8_INFERENCE) {
+            quantized_values_out[i].resize(size);
+        } else {
+            vector<int8_t>().swap(quantized_values_out[i]);
+        }
+    }
+}
+
+void QuantizedGenome::set_precision(int _precision) {
+    const Kernels &kernels = get_kernels();
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        QuantizedEdge &edge = edges[i];
+        if (edge.type != CONVOLUTIONAL) continue;
+
+        int32_t filter_size = edge.weights.size();
+
+        if (_precision == FP16_INFERENCE) {
+            edge.half_weights.resize(filter_size);
+            kernels.float_to_half(edge.weights.data(), edge.half_weights.data(), filter_size);
+
+        } else if (_precision == INT8_INFERENCE) {
+            //symmetric, so the zeros the reverse filters pad the input with
+            //stay zeros
+            float max_weight = 0.0;
+            for (int32_t current = 0; current < filter_size; current++) {
+                if (fabs(edge.weights[current]) > max_weight) max_weight = fabs(edge.weights[current]);
+            }
+
+            edge.weight_scale = (max_weight > 0) ? (max_weight / 127.0) : 1.0;
+
+            edge.quantized_weights.resize(filter_size);
+            for (int32_t current = 0; current < filter_size; current++) {
+                long quantized_weight = lrintf(edge.weights[current] / edge.weight_scale);
+                if (quantized_weight > 127) quantized_weight = 127;
+                if (quantized_weight < -127) quantized_weight = -127;
+                edge.quantized_weights[current] = quantized_weight;
+            }
+        }
+
+        if (_precision != FP32_INFERENCE) vector<float>().swap(edge.weights);
+    }
+
+    precision = _precision;
+    initialize_values();
+}
+
+void QuantizedGenome::calibrate(const ImagesInterface &images, int number_calibration_images) {
+    if (number_calibration_images > images.get_number_images()) number_calibration_images = images.get_number_images();
+
+    if (number_calibration_images <= 0) {
+        cerr << "ERROR: quantizing a genome to 8 bits needs at least one calibration image" << endl;
+        exit(1);
+    }
+
+    vector<float> max_values(nodes.size(), 0.0);
+    vector<float> predictions;
+
+    for (int32_t i = 0; i < number_calibration_images; i++) {
+        int image = ((int64_t)i * images.get_number_images()) / number_calibration_images;
+        predict(images, image, predictions);
+
+        for (uint32_t node = 0; node < nodes.size(); node++) {
+            if (nodes[node].type == SOFTMAX_NODE) continue;
+
+            for (uint32_t current = 0; current < values_out[node].size(); current++) {
+                if (fabs(values_out[node][current]) > max_values[node]) max_values[node] = fabs(values_out[node][current]);
+            }
+        }
+    }
+
+    for (uint32_t node = 0; node < nodes.size(); node++) {
+        nodes[node].activation_scale = (max_values[node] > 0) ? (max_values[node] / 127.0) : 1.0;
+    }
+}
+
+void QuantizedGenome::set_values_out(int node, const float* values) {
+    int32_t size = nodes[node].size_y * nodes[node].size_x;
+
+    if (precision == FP32_INFERENCE) {
+        std::copy(values, values + size, values_out[node].begin());
+
+    } else if (precision == FP16_INFERENCE) {
+        get_kernels().float_to_half(values, half_values_out[node].data(), size);
+
+    } else {
+        //values past the largest calibrated one saturate
+        float inverse_scale = 1.0 / nodes[node].activation_scale;
+        int8_t *quantized_values = quantized_values_out[node].data();
+
+        for (int32_t current = 0; current < size; current++) {
+            long quantized_value = lrintf(values[current] * inverse_scale);
+            if (quantized_value > 127) quantized_value = 127;
+            if (quantized_value < -127) quantized_value = -127;
+            quantized_values[current] = quantized_value;
+        }
+    }
+}
+
+void QuantizedGenome::get_values_out(int node, int32_t pad_y, int32_t pad_x, int32_t padded_y, int32_t padded_x, vector<float> &values) {
+    int32_t size_y = nodes[node].size_y;
+    int32_t size_x = nodes[node].size_x;
+
+    values.assign(padded_y * padded_x, 0.0);
+
+    for (int32_t y = 0; y < size_y; y++) {
+        float *row = values.data() + ((y + pad_y) * padded_x) + pad_x;
+
+        if (precision == FP32_INFERENCE) {
+            std::copy(values_out[node].begin() + (y * size_x), values_out[node].begin() + ((y + 1) * size_x), row);
+
+        } else if (precision == FP16_INFERENCE) {
+            get_kernels().half_to_float(half_values_out[node].data() + (y * size_x), row, size_x);
+
+        } else {
+            const int8_t *quantized_row = quantized_values_out[node].data() + (y * size_x);
+            for (int32_t x = 0; x < size_x; x++) {
+                row[x] = quantized_row[x] * nodes[node].activation_scale;
+            }
+        }
+    }
+}
+
+void QuantizedGenome::propagate_forward(int edge_position) {
+    const Kernels &kernels = get_kernels();
+
+    QuantizedEdge &edge = edges[edge_position];
+    const QuantizedNode &input_node = nodes[edge.input_node];
+    const QuantizedNode &output_node = nodes[edge.output_node];
+
+    float *output = values_in[edge.output_node].data();
+    int32_t output_size = output_node.size_y * output_node.size_x;
+
+    if (edge.type == CONVOLUTIONAL) {
+        //the reverse filters are a valid correlation of the input padded by
+        //filter - 1 (see prop_forward_gemm)
+        int32_t pad_y = edge.reverse_filter_y ? (edge.filter_y - 1) : 0;
+        int32_t pad_x = edge.reverse_filter_x ? (edge.filter_x - 1) : 0;
+        int32_t padded_y = output_node.size_y + edge.filter_y - 1;
+        int32_t padded_x = output_node.size_x + edge.filter_x - 1;
+        bool padded = pad_y > 0 || pad_x > 0;
+
+        if (precision == INT8_INFERENCE) {
+            const int8_t *input = quantized_values_out[edge.input_node].data();
+            int32_t input_stride = input_node.size_x;
+
+            if (padded) {
+                quantized_input.assign(padded_y * padded_x, 0);
+                for (int32_t y = 0; y < input_node.size_y; y++) {
+                    std::copy(input + (y * input_node.size_x), input + ((y + 1) * input_node.size_x), quantized_input.begin() + ((y + pad_y) * padded_x) + pad_x);
+                }
+
+                input = quantized_input.data();
+                input_stride = padded_x;
+            }
+
+            accumulators.assign(output_size, 0);
+            kernels.correlate_int8(input, input_stride, edge.quantized_weights.data(), edge.filter_y, edge.filter_x, accumulators.data(), output_node.size_x, output_node.size_y, output_node.size_x);
+
+            float scale = edge.weight_scale * input_node.activation_scale;
+            for (int32_t current = 0; current < output_size; current++) {
+                output[current] += accumulators[current] * scale;
+            }
+
+        } else {
+            const float *input = NULL;
+            int32_t input_stride = 0;
+
+            if (precision == FP32_INFERENCE && !padded) {
+                input = values_out[edge.input_node].data();
+                input_stride = input_node.size_x;
+            } else {
+                get_values_out(edge.input_node, pad_y, pad_x, padded_y, padded_x, float_input);
+                input = float_input.data();
+                input_stride = padded_x;
+            }
+
+            const float *weights = edge.weights.data();
+            if (precision == FP16_INFERENCE) {
+                float_weights.resize(edge.half_weights.size());
+                kernels.half_to_float(edge.half_weights.data(), float_weights.data(), edge.half_weights.size());
+                weights = float_weights.data();
+            }
+
+            kernels.correlate(input, input_stride, pad_y, pad_y + input_node.size_y, pad_x, pad_x + input_node.size_x, weights, edge.filter_y, edge.filter_x, output, output_node.size_x, output_node.size_y, output_node.size_x);
+        }
+
+    } else {
+        const float *input = NULL;
+        if (precision == FP32_INFERENCE) {
+            input = values_out[edge.input_node].data();
+        } else {
+            get_values_out(edge.input_node, 0, 0, input_node.size_y, input_node.size_x, float_input);
+            input = float_input.data();
+        }
+
+        pool_gradients.resize(input_node.size_y * input_node.size_x);
+        pool_forward_edge(input, edge.pool_scale, pool_gradients.data(), output, 1, input_node.size_y, input_node.size_x, output_node.size_y, output_node.size_x, edge.reverse_filter_y, edge.reverse_filter_x, edge.y_pools, edge.x_pools, edge.y_pool_offset, edge.x_pool_offset, generator, false);
+    }
+
+    inputs_fired[edge.output_node]++;
+
+    if (inputs_fired[edge.output_node] == output_node.number_inputs && output_node.type != SOFTMAX_NODE) {
+        for (int32_t current = 0; current < output_size; current++) {
+            float value = output[current];
+
+            if (value <= RELU_MIN) {
+                value *= RELU_MIN_LEAK;
+            } else if (value > RELU_MAX) {
+                value = RELU_MAX;
+            }
+
+            output[current] = (output_node.scale * value) + output_node.shift;
+        }
+
+        set_values_out(edge.output_node, output);
+    }
+}
+
+void QuantizedGenome::predict(const ImagesInterface &images, int image, vector<float> &predictions) {
+    if (images.get_image_channels() != (int)input_nodes.size()) {
+        cerr << "ERROR: the images have " << images.get_image_channels() << " channels but the quantized genome has " << input_nodes.size() << " input nodes" << endl;
+        exit(1);
+    }
+
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        std::fill(values_in[i].begin(), values_in[i].end(), 0.0);
+        inputs_fired[i] = 0;
+    }
+
+    vector<int> batch(1, image);
+    for (uint32_t channel = 0; channel < input_nodes.size(); channel++) {
+        const QuantizedNode &input_node = nodes[input_nodes[channel]];
+
+        if (images.get_image_height() != input_node.size_y || images.get_image_width() != input_node.size_x) {
+            cerr << "ERROR: the images are " << images.get_image_height() << " by " << images.get_image_width() << " but the quantized genome's input nodes are " << input_node.size_y << " by " << input_node.size_x << endl;
+            exit(1);
+        }
+
+        vector<float> &pixels = values_in[input_nodes[channel]];
+        images.gather_batch(batch, channel, pixels.data());
+
+        if (input_node.scale != 1.0) {
+            for (uint32_t current = 0; current < pixels.size(); current++) {
+                pixels[current] *= input_node.scale;
+            }
+        }
+
+        set_values_out(input_nodes[channel], pixels.data());
+    }
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        propagate_forward(i);
+    }
+
+    predictions.resize(softmax_nodes.size());
+
+    float softmax_max = values_in[softmax_nodes[0]][0];
+    for (uint32_t i = 1; i < softmax_nodes.size(); i++) {
+        if (values_in[softmax_nodes[i]][0] > softmax_max) softmax_max = values_in[softmax_nodes[i]][0];
+    }
+
+    float softmax_sum = 0.0;
+    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+        predictions[i] = exact_exp(values_in[softmax_nodes[i]][0] - softmax_max);
+        softmax_sum += predictions[i];
+    }
+
+    for (uint32_t i = 0; i < softmax_nodes.size(); i++) {
+        predictions[i] /= softmax_sum;
+    }
+}
+
+void QuantizedGenome::evaluate(const ImagesInterface &images, vector< vector<float> > &predictions) {
+    predictions.resize(images.get_number_images());
+
+    for (int32_t image = 0; image < images.get_number_images(); image++) {
+        predict(images, image, predictions[image]);
+    }
+}
+
+template <class T>
+static void write_binary(ostream &out, const T &value) {
+    out.write((const char*)&value, sizeof(T));
+}
+
+template <class T>
+static void write_binary(ostream &out, const vector<T> &values) {
+    write_binary(out, (int32_t)values.size());
+    if (values.size() > 0) out.write((const char*)values.data(), values.size() * sizeof(T));
+}
+
+template <class T>
+static void read_binary(istream &in, T &value) {
+    in.read((char*)&value, sizeof(T));
+}
+
+template <class T>
+static void read_binary(istream &in, vector<T> &values) {
+    int32_t size;
+    read_binary(in, size);
+    values.resize(size);
+    if (size > 0) in.read((char*)values.data(), size * sizeof(T));
+}
+
+void QuantizedGenome::write(ostream &out) const {
+    out << QUANTIZED_GENOME_HEADER << endl;
+
+    write_binary(out, (int32_t)precision);
+
+    write_binary(out, (int32_t)nodes.size());
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        const QuantizedNode &node = nodes[i];
+        write_binary(out, (int32_t)node.innovation_number);
+        write_binary(out, (int32_t)node.type);
+        write_binary(out, (int32_t)node.size_y);
+        write_binary(out, (int32_t)node.size_x);
+        write_binary(out, (int32_t)node.number_inputs);
+        write_binary(out, node.scale);
+        write_binary(out, node.shift);
+        write_binary(out, node.activation_scale);
+    }
+
+    write_binary(out, input_nodes);
+    write_binary(out, softmax_nodes);
+
+    write_binary(out, (int32_t)edges.size());
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        const QuantizedEdge &edge = edges[i];
+        write_binary(out, (int32_t)edge.type);
+        write_binary(out, (int32_t)edge.input_node);
+        write_binary(out, (int32_t)edge.output_node);
+        write_binary(out, (int32_t)edge.filter_y);
+        write_binary(out, (int32_t)edge.filter_x);
+        write_binary(out, (int32_t)edge.reverse_filter_y);
+        write_binary(out, (int32_t)edge.reverse_filter_x);
+        write_binary(out, edge.pool_scale);
+        write_binary(out, edge.weight_scale);
+
+        //only the weights in the genome's precision are kept
+        write_binary(out, edge.weights);
+        write_binary(out, edge.half_weights);
+        write_binary(out, edge.quantized_weights);
+    }
+}
+
+void QuantizedGenome::write_to_file(string filename) const {
+    ofstream outfile(filename.c_str(), ios::out | ios::binary);
+    write(outfile);
+    outfile.close();
+}
+
+void QuantizedGenome::read(istream &in) {
+    string header;
+    getline(in, header);
+
+    if (header.compare(QUANTIZED_GENOME_HEADER) != 0) {
+        cerr << "ERROR: not a quantized genome, the first line was '" << header << "' instead of '" << QUANTIZED_GENOME_HEADER << "'" << endl;
+        exit(1);
+    }
+
+    int32_t value;
+    read_binary(in, value);
+    precision = value;
+
+    int32_t number_nodes;
+    read_binary(in, number_nodes);
+    nodes.resize(number_nodes);
+    for (int32_t i = 0; i < number_nodes; i++) {
+        QuantizedNode &node = nodes[i];
+        read_binary(in, value); node.innovation_number = value;
+        read_binary(in, value); node.type = value;
+        read_binary(in, value); node.size_y = value;
+        read_binary(in, value); node.size_x = value;
+        read_binary(in, value); node.number_inputs = value;
+        read_binary(in, node.scale);
+        read_binary(in, node.shift);
+        read_binary(in, node.activation_scale);
+    }
+
+    read_binary(in, input_nodes);
+    read_binary(in, softmax_nodes);
+    number_classes = softmax_nodes.size();
+
+    int32_t number_edges;
+    read_binary(in, number_edges);
+    edges.resize(number_edges);
+    for (int32_t i = 0; i < number_edges; i++) {
+        QuantizedEdge &edge = edges[i];
+        read_binary(in, value); edge.type = value;
+        read_binary(in, value); edge.input_node = value;
+        read_binary(in, value); edge.output_node = value;
+        read_binary(in, value); edge.filter_y = value;
+        read_binary(in, value); edge.filter_x = value;
+        read_binary(in, value); edge.reverse_filter_y = value;
+        read_binary(in, value); edge.reverse_filter_x = value;
+        read_binary(in, edge.pool_scale);
+        read_binary(in, edge.weight_scale);
+
+        read_binary(in, edge.weights);
+        read_binary(in, edge.half_weights);
+        read_binary(in, edge.quantized_weights);
+
+        if (edge.type == POOLING) {
+            initialize_pools(edge.y_pools, edge.y_pool_offset, nodes[edge.input_node].size_y, nodes[edge.output_node].size_y);
+            initialize_pools(edge.x_pools, edge.x_pool_offset, nodes[edge.input_node].size_x, nodes[edge.output_node].size_x);
+        }
+    }
+
+    if (!in) {
+        cerr << "ERROR: the quantized genome ended before all of its nodes and edges were read" << endl;
+        exit(1);
+    }
+
+    initialize_values();
+}
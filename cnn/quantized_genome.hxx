@@ -0,0 +1,159 @@
+#ifndef CNN_QUANTIZED_GENOME_HXX
+#define CNN_QUANTIZED_GENOME_HXX
+
+#include "stdint.h"
+
+#include <iostream>
+using std::istream;
+using std::ostream;
+
+#include <random>
+using std::minstd_rand0;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "image_tools/image_set_interface.hxx"
+#include "cnn_genome.hxx"
+
+#define FP32_INFERENCE 0
+#define FP16_INFERENCE 1
+#define INT8_INFERENCE 2
+
+string inference_precision_name(int precision);
+
+/**
+ * The precision named fp32, fp16 or int8, exiting with an error for any other
+ * name.
+ */
+int get_inference_precision(string name);
+
+/**
+ * A node of a QuantizedGenome, with its batch normalization (and dropout
+ * scaling) folded into a single scale and shift.
+ */
+class QuantizedNode {
+    public:
+        int innovation_number;
+        int type;
+        int size_y, size_x;
+        int number_inputs;
+
+        float scale; /**< the values out are scale * relu(value in) + shift, or scale * the pixel for input nodes. */
+        float shift;
+
+        float activation_scale; /**< each 8 bit value out stands for activation_scale times its value. */
+
+        QuantizedNode();
+};
+
+/**
+ * An edge of a QuantizedGenome, which only keeps its weights in the genome's
+ * precision.  Convolutional edges keep them lowered as in prop_forward_gemm,
+ * i.e., flipped along the reverse filters, so every edge is a valid
+ * correlation of its (zero padded) input.
+ */
+class QuantizedEdge {
+    public:
+        int type;
+        int input_node; /**< the position of the edge's input node in the genome's nodes. */
+        int output_node;
+
+        int filter_y, filter_x;
+        bool reverse_filter_y, reverse_filter_x;
+
+        float pool_scale;
+        float weight_scale; /**< each 8 bit weight stands for weight_scale times its value. */
+
+        vector<float> weights;
+        vector<uint16_t> half_weights;
+        vector<int8_t> quantized_weights;
+
+        vector<int> y_pools;
+        vector<int> y_pool_offset;
+        vector<int> x_pools;
+        vector<int> x_pool_offset;
+
+        QuantizedEdge();
+};
+
+/**
+ * An inference only copy of a trained CNN_Genome, without any of its
+ * training state, with its weights and the values of its nodes kept as 32 bit
+ * floats, half precision floats, or 8 bit ints with a scale for each edge and
+ * node.  The 8 bit edges are correlated with 32 bit int accumulators (see
+ * Kernels::correlate_int8), and the scales of the values of each node are
+ * calibrated from the largest value it has over a set of images.  Images are
+ * evaluated one at a time, with buffers kept between them, so a
+ * QuantizedGenome should only be used by one thread at a time.
+ */
+class QuantizedGenome {
+    private:
+        int precision;
+        int number_classes;
+
+        vector<QuantizedNode> nodes;
+        vector<QuantizedEdge> edges;
+
+        vector<int> input_nodes;
+        vector<int> softmax_nodes;
+
+        minstd_rand0 generator; /**< for the pooling edges which shuffle their pools. */
+
+        vector< vector<float> > values_in;
+        vector< vector<float> > values_out;
+        vector< vector<uint16_t> > half_values_out;
+        vector< vector<int8_t> > quantized_values_out;
+        vector<int32_t> inputs_fired;
+
+        vector<float> float_input;
+        vector<float> float_weights;
+        vector<float> pool_gradients;
+        vector<int8_t> quantized_input;
+        vector<int32_t> accumulators;
+
+        void initialize_values();
+
+        void set_values_out(int node, const float* values);
+        void get_values_out(int node, int32_t pad_y, int32_t pad_x, int32_t padded_y, int32_t padded_x, vector<float> &values);
+
+        void propagate_forward(int edge);
+        void calibrate(const ImagesInterface &images, int number_calibration_images);
+        void set_precision(int _precision);
+
+    public:
+        /**
+         * Copies the genome (with its current weights) at the given precision,
+         * calibrating the scales of 8 bit values from number_calibration_images
+         * images spread evenly over calibration_images (which are only used for
+         * INT8_INFERENCE).
+         */
+        QuantizedGenome(CNN_Genome *genome, int _precision, const ImagesInterface &calibration_images, int number_calibration_images);
+
+        QuantizedGenome(string filename);
+        QuantizedGenome(istream &in);
+
+        int get_precision() const;
+        int get_number_classes() const;
+
+        /**
+         * The number of bytes the weights (and their scales) take up.
+         */
+        int64_t get_weight_bytes() const;
+
+        /**
+         * Sets predictions to the softmax of the softmax nodes for an image.
+         */
+        void predict(const ImagesInterface &images, int image, vector<float> &predictions);
+
+        void evaluate(const ImagesInterface &images, vector< vector<float> > &predictions);
+
+        void write(ostream &out) const;
+        void write_to_file(string filename) const;
+        void read(istream &in);
+};
+
+#endif
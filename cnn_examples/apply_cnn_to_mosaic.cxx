@@ -1,3 +1,7 @@
+#include <fstream>
+using std::ofstream;
+using std::ios;
+
 #include <iomanip>
 using std::setw;
 
@@ -26,11 +30,30 @@ using std::vector;
 #include "cnn/cnn_genome.hxx"
 #include "cnn/cnn_edge.hxx"
 #include "cnn/cnn_node.hxx"
+#include "cnn/cnn_options.hxx"
 
 #include "image_tools/large_image_set.hxx"
+#include "image_tools/tiled_image_set.hxx"
+
+/**
+ * Exits if the padded windows would not be the size of the genome's input
+ * nodes, rather than evaluating them with the wrong size.
+ */
+void check_window_size(const CNN_Genome *genome, int32_t padding, int32_t subimage_y, int32_t subimage_x) {
+    const vector<CNN_Node*> input_nodes = genome->get_input_nodes();
+
+    for (uint32_t i = 0; i < input_nodes.size(); i++) {
+        if (input_nodes[i]->get_size_y() != subimage_y + (2 * padding) || input_nodes[i]->get_size_x() != subimage_x + (2 * padding)) {
+            cerr << "ERROR: windows of " << subimage_y << "x" << subimage_x << " with padding " << padding << " do not match the genome's input node size of " << input_nodes[i]->get_size_y() << "x" << input_nodes[i]->get_size_x() << endl;
+            exit(1);
+        }
+    }
+}
 
 int main(int argc, char **argv) {
     vector<string> arguments = vector<string>(argv, argv + argc);
+    set_cnn_options(arguments);
+    set_sliding_window_inference(arguments);
 
     string genome_filename;
     get_argument(arguments, "--genome_file", true, genome_filename);
@@ -52,10 +75,70 @@ int main(int argc, char **argv) {
     string output_directory;
     get_argument(arguments, "--output_directory", true, output_directory);
 
-    if (label_type.compare("POINT") == 0) {
-        int32_t padding = 2;
+    if (label_type.compare("POINT") == 0 && argument_exists(arguments, "--tiled")) {
+        //the mosaic is read a tile at a time and evaluated a region at a time,
+        //so neither it nor its predictions are ever all in memory
+        int32_t padding = genome->get_padding();
+        int32_t subimage_y = 32;
+        int32_t subimage_x = 32;
+        check_window_size(genome, padding, subimage_y, subimage_x);
+
+        int32_t region_size = 1024;
+        get_argument(arguments, "--region_size", false, region_size);
+
+        int32_t cached_tiles = DEFAULT_CACHED_TILES;
+        get_argument(arguments, "--cached_tiles", false, cached_tiles);
+
+        TiledImage mosaic(mosaic_filename, cached_tiles);
+        TiledImages mosaic_regions(&mosaic, 2, padding, subimage_y, subimage_x, region_size, region_size);
+
+        //the class 0 prediction of every window, as the height and width of
+        //the prediction matrix followed by its rows of floats
+        int32_t matrix_height = mosaic.get_height() - subimage_y + 1;
+        int32_t matrix_width = mosaic.get_width() - subimage_x + 1;
+
+        ofstream prediction_file((output_directory + "/predictions.bin").c_str(), ios::out | ios::binary);
+        prediction_file.write( (char*)&matrix_height, sizeof(int32_t) );
+        prediction_file.write( (char*)&matrix_width, sizeof(int32_t) );
+
+        float max_prediction = 0.0;
+        int32_t max_y = 0, max_x = 0;
+
+        int stride = 1;
+        for (int32_t i = 0; i < mosaic_regions.get_number_large_images(); i++) {
+            const ImageRegion &region = mosaic_regions.get_region_bounds(i);
+
+            vector< vector< vector<float> > > prediction_matrix;
+            genome->get_prediction_matrix(mosaic_regions, i, stride, prediction_matrix);
+
+            vector<float> row;
+            for (uint32_t y = 0; y < prediction_matrix.size(); y++) {
+                row.resize(prediction_matrix[y].size());
+                for (uint32_t x = 0; x < prediction_matrix[y].size(); x++) {
+                    row[x] = prediction_matrix[y][x][0];
+
+                    if (row[x] > max_prediction) {
+                        max_prediction = row[x];
+                        max_y = region.y + y;
+                        max_x = region.x + x;
+                    }
+                }
+
+                prediction_file.seekp((2 * sizeof(int32_t)) + ((((int64_t)(region.y + y) * matrix_width) + region.x) * sizeof(float)));
+                prediction_file.write( (char*)row.data(), row.size() * sizeof(float) );
+            }
+
+            cout << "evaluated region " << setw(5) << i << " of " << setw(5) << mosaic_regions.get_number_large_images() << ", tiles read: " << mosaic.get_tiles_read() << endl;
+        }
+        prediction_file.close();
+
+        cout << "prediction: " << max_prediction << " at y: " << max_y << ", x: " << max_x << endl;
+
+    } else if (label_type.compare("POINT") == 0) {
+        int32_t padding = genome->get_padding();
         int32_t subimage_y = 32;
         int32_t subimage_x = 32;
+        check_window_size(genome, padding, subimage_y, subimage_x);
 
         LargeImages mosaic_image(mosaic_filename, padding, subimage_y, subimage_x);
 
@@ -26,11 +26,14 @@ using std::vector;
 #include "cnn/cnn_genome.hxx"
 #include "cnn/cnn_edge.hxx"
 #include "cnn/cnn_node.hxx"
+#include "cnn/cnn_options.hxx"
 
 #include "image_tools/mosaic_image_set.hxx"
 
 int main(int argc, char **argv) {
     vector<string> arguments = vector<string>(argv, argv + argc);
+    set_cnn_options(arguments);
+    set_sliding_window_inference(arguments);
 
     string genome_filename;
     get_argument(arguments, "--genome_file", true, genome_filename);
@@ -22,9 +22,11 @@ using std::vector;
 #include "cnn/cnn_genome.hxx"
 #include "cnn/cnn_edge.hxx"
 #include "cnn/cnn_node.hxx"
+#include "cnn/cnn_options.hxx"
 
 int main(int argc, char **argv) {
     vector<string> arguments = vector<string>(argv, argv + argc);
+    set_cnn_options(arguments);
 
     string training_data;
     get_argument(arguments, "--training_data", true, training_data);
@@ -21,11 +21,14 @@ using std::vector;
 #include "cnn/cnn_genome.hxx"
 #include "cnn/cnn_edge.hxx"
 #include "cnn/cnn_node.hxx"
+#include "cnn/cnn_options.hxx"
 
 #include "image_tools/large_image_set.hxx"
 
 int main(int argc, char **argv) {
     vector<string> arguments = vector<string>(argv, argv + argc);
+    set_cnn_options(arguments);
+    set_sliding_window_inference(arguments);
 
     string training_filename;
     get_argument(arguments, "--training_file", true, training_filename);
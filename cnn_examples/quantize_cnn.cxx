@@ -0,0 +1,206 @@
+#include <chrono>
+
+#include <cmath>
+
+#include <fstream>
+using std::ofstream;
+
+#include <iomanip>
+using std::fixed;
+using std::setprecision;
+using std::setw;
+
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::ostream;
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/files.hxx"
+
+#include "image_tools/image_set.hxx"
+
+#include "cnn/cnn_genome.hxx"
+#include "cnn/cnn_edge.hxx"
+#include "cnn/cnn_node.hxx"
+#include "cnn/cnn_options.hxx"
+#include "cnn/kernels.hxx"
+#include "cnn/quantized_genome.hxx"
+
+/**
+ * The accuracy and speed of one way of evaluating the validation images,
+ * compared to evaluating them with the genome itself.
+ */
+class PrecisionResult {
+    public:
+        string name;
+        int64_t weight_bytes;
+
+        int correct_predictions;
+        float total_error;
+
+        int agreeing_predictions; /**< images given the same class as the genome gives them. */
+        float max_difference; /**< the largest difference from any of the genome's predictions. */
+
+        float seconds;
+};
+
+static int predicted_class(const vector<float> &predictions) {
+    int predicted = 0;
+    for (uint32_t i = 1; i < predictions.size(); i++) {
+        if (predictions[i] > predictions[predicted]) predicted = i;
+    }
+    return predicted;
+}
+
+static PrecisionResult compare_predictions(string name, int64_t weight_bytes, float seconds, const ImagesInterface &images, const vector< vector<float> > &predictions, const vector< vector<float> > &genome_predictions) {
+    PrecisionResult result;
+    result.name = name;
+    result.weight_bytes = weight_bytes;
+    result.correct_predictions = 0;
+    result.total_error = 0.0;
+    result.agreeing_predictions = 0;
+    result.max_difference = 0.0;
+    result.seconds = seconds;
+
+    for (int32_t image = 0; image < images.get_number_images(); image++) {
+        int expected_class = images.get_classification(image);
+        int predicted = predicted_class(predictions[image]);
+
+        if (predicted == expected_class) result.correct_predictions++;
+        if (predicted == predicted_class(genome_predictions[image])) result.agreeing_predictions++;
+
+        //the same error as CNN_Genome::evaluate_images
+        float error = predictions[image][expected_class];
+        if (error == 0) error = 1.0 / EXACT_MAX_FLOAT;
+        result.total_error -= log(error);
+
+        for (uint32_t i = 0; i < predictions[image].size(); i++) {
+            float difference = fabs(predictions[image][i] - genome_predictions[image][i]);
+            if (difference > result.max_difference) result.max_difference = difference;
+        }
+    }
+
+    return result;
+}
+
+static void print_report(ostream &out, const vector<PrecisionResult> &results, int number_images, bool csv) {
+    if (csv) {
+        out << "precision,weight_bytes,correct_predictions,accuracy,total_error,agreement,max_difference,seconds,images_per_second,speedup" << endl;
+    } else {
+        out << setw(10) << "precision" << setw(14) << "weight bytes" << setw(10) << "correct" << setw(11) << "accuracy" << setw(14) << "total error" << setw(12) << "agreement" << setw(12) << "max diff" << setw(12) << "seconds" << setw(14) << "images/sec" << setw(10) << "speedup" << endl;
+    }
+
+    for (uint32_t i = 0; i < results.size(); i++) {
+        const PrecisionResult &result = results[i];
+
+        float accuracy = (100.0 * result.correct_predictions) / number_images;
+        float agreement = (100.0 * result.agreeing_predictions) / number_images;
+        float images_per_second = number_images / result.seconds;
+        float speedup = results[0].seconds / result.seconds;
+
+        if (csv) {
+            out << result.name << "," << result.weight_bytes << "," << result.correct_predictions << "," << accuracy << "," << result.total_error << "," << agreement << "," << result.max_difference << "," << result.seconds << "," << images_per_second << "," << speedup << endl;
+        } else {
+            out << setw(10) << result.name << setw(14) << result.weight_bytes << setw(10) << result.correct_predictions
+                << setw(10) << fixed << setprecision(2) << accuracy << "%" << setw(14) << setprecision(4) << result.total_error
+                << setw(11) << setprecision(2) << agreement << "%" << setw(12) << setprecision(6) << result.max_difference
+                << setw(12) << setprecision(4) << result.seconds << setw(14) << setprecision(1) << images_per_second << setw(9) << setprecision(2) << speedup << "x" << endl;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+    set_cnn_options(arguments);
+
+    string genome_filename;
+    get_argument(arguments, "--genome_file", true, genome_filename);
+
+    string training_data;
+    get_argument(arguments, "--training_data", true, training_data);
+
+    string validation_data;
+    get_argument(arguments, "--validation_data", true, validation_data);
+
+    //all, or one of fp32, fp16 or int8
+    string precision_name = "all";
+    get_argument(arguments, "--precision", false, precision_name);
+
+    vector<int> precisions;
+    if (precision_name.compare("all") == 0) {
+        precisions.push_back(FP32_INFERENCE);
+        precisions.push_back(FP16_INFERENCE);
+        precisions.push_back(INT8_INFERENCE);
+    } else {
+        precisions.push_back(get_inference_precision(precision_name));
+    }
+
+    int number_calibration_images = 1000;
+    get_argument(arguments, "--calibration_images", false, number_calibration_images);
+
+    string output_directory = "";
+    get_argument(arguments, "--output_directory", false, output_directory);
+
+    CNN_Genome *genome = new CNN_Genome(genome_filename, false);
+
+    Images training_images(training_data, genome->get_padding());
+    Images validation_images(validation_data, genome->get_padding(), training_images.get_average(), training_images.get_std_dev());
+
+    if (!genome->sanity_check(SANITY_CHECK_AFTER_GENERATION)) {
+        cerr << "ERROR! genome failed sanity check! This should never happen!" << endl;
+        exit(1);
+    }
+
+    genome->initialize();
+    genome->set_to_best();
+
+    using namespace std::chrono;
+
+    vector<PrecisionResult> results;
+
+    vector< vector<float> > genome_predictions;
+    high_resolution_clock::time_point start_time = high_resolution_clock::now();
+    genome->evaluate(validation_images, genome_predictions);
+    duration<float> genome_time = high_resolution_clock::now() - start_time;
+
+    results.push_back(compare_predictions("genome", genome->get_number_weights() * sizeof(float), genome_time.count(), validation_images, genome_predictions, genome_predictions));
+
+    for (uint32_t i = 0; i < precisions.size(); i++) {
+        //the activation scales are calibrated on the training images, so the
+        //validation images are not used to quantize the genome
+        QuantizedGenome quantized_genome(genome, precisions[i], training_images, number_calibration_images);
+
+        vector< vector<float> > predictions;
+        start_time = high_resolution_clock::now();
+        quantized_genome.evaluate(validation_images, predictions);
+        duration<float> quantized_time = high_resolution_clock::now() - start_time;
+
+        string name = inference_precision_name(precisions[i]);
+        results.push_back(compare_predictions(name, quantized_genome.get_weight_bytes(), quantized_time.count(), validation_images, predictions, genome_predictions));
+
+        if (output_directory.compare("") != 0) {
+            mkpath(output_directory.c_str(), 0777);
+            quantized_genome.write_to_file(output_directory + "/quantized_genome_" + name + ".bin");
+        }
+    }
+
+    cout << "evaluated " << validation_images.get_number_images() << " validation images with the '" << kernel_isa_name(get_kernel_isa()) << "' kernels" << endl;
+    print_report(cout, results, validation_images.get_number_images(), false);
+
+    if (output_directory.compare("") != 0) {
+        ofstream report_file((output_directory + "/quantization_report.csv").c_str());
+        print_report(report_file, results, validation_images.get_number_images(), true);
+        report_file.close();
+    }
+
+    delete genome;
+}
@@ -1,4 +1,5 @@
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 using std::fprintf;
 using std::printf;
@@ -8,12 +9,26 @@ using std::vsnprintf;
 //for va_list, va_start
 #include <stdarg.h>
 
+#include <chrono>
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
 #include <iostream>
 using std::ofstream;
 
+#include <memory>
+using std::make_shared;
+
+#include <mutex>
+using std::lock_guard;
+using std::unique_lock;
+
 #include <thread>
 using std::thread;
 
+#include <utility>
+using std::move;
+
 #include "arguments.hxx"
 #include "files.hxx"
 #include "log.hxx"
@@ -31,15 +46,71 @@ int32_t Log::restricted_rank = -1;
 
 string Log::output_directory = "./logs";
 
-map<thread::id, string> Log::log_ids;
+thread_local string Log::thread_log_id;
 map<string, LogFile*> Log::output_files;
 
-shared_mutex Log::log_ids_mutex;
+int32_t Log::buffer_size = 4096;
+int32_t Log::flush_interval = 100;
+
+vector< shared_ptr<LogBuffer> > Log::buffers;
+mutex Log::buffers_mutex;
+
+thread Log::writer_thread;
+mutex Log::writer_mutex;
+condition_variable Log::writer_cv;
+bool Log::writer_started = false;
+atomic<bool> Log::writer_running(false);
+bool Log::writer_stopping = false;
+
+atomic<int64_t> Log::flush_requested(0);
+int64_t Log::flush_completed = 0;
+condition_variable Log::flush_cv;
 
 LogFile::LogFile(FILE* _file) {
     file = _file;
+    written = false;
+}
+
+LogBuffer::LogBuffer(int32_t capacity) : messages(capacity), head(0), tail(0), retired(false) {
+}
+
+bool LogBuffer::push(LogMessage &message) {
+    int64_t current_tail = tail.load(std::memory_order_relaxed);
+    if (current_tail - head.load(std::memory_order_acquire) >= (int64_t)messages.size()) return false;
+
+    messages[current_tail % messages.size()] = move(message);
+    tail.store(current_tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogBuffer::pop(LogMessage &message) {
+    int64_t current_head = head.load(std::memory_order_relaxed);
+    if (current_head == tail.load(std::memory_order_acquire)) return false;
+
+    message = move(messages[current_head % messages.size()]);
+    head.store(current_head + 1, std::memory_order_release);
+    return true;
 }
 
+bool LogBuffer::empty() {
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+}
+
+/**
+ * Holds a thread's log buffer, marking it as retired when the thread exits
+ * so the writer can remove it after writing out its remaining messages.
+ */
+class LogBufferHandle {
+    public:
+        shared_ptr<LogBuffer> buffer;
+
+        ~LogBufferHandle() {
+            if (buffer) buffer->retired = true;
+        }
+};
+
+static thread_local LogBufferHandle thread_buffer;
+
 void Log::register_command_line_arguments() {
     //CommandLine::create_group("Log", "");
     //CommandLine::
@@ -116,6 +187,14 @@ void Log::initialize(const vector<string> &arguments) {
 
     get_argument(arguments, "--max_header_length", false, max_header_length);
     get_argument(arguments, "--max_message_length", false, max_message_length);
+    get_argument(arguments, "--log_buffer_size", false, buffer_size);
+    get_argument(arguments, "--log_flush_interval", false, flush_interval);
+
+    //a thread could never push a message into an empty buffer
+    if (buffer_size < 1) {
+        cerr << "ERROR: specified an incorrect log buffer size: " << buffer_size << ", it must be at least 1" << endl;
+        exit(1);
+    }
 
 
     mkpath(output_directory.c_str(), 0777);
@@ -134,39 +213,198 @@ void Log::clear_rank_restriction() {
 }
 
 void Log::set_id(string human_readable_id) {
-    thread::id id = std::this_thread::get_id();
+    //cerr << "setting thread id " << std::this_thread::get_id() << " to human readable id: '" << human_readable_id << "'" << endl;
 
-    //cerr << "setting thread id " << id << " to human readable id: '" << human_readable_id << "'" << endl;
+    thread_log_id = human_readable_id;
+}
 
-    log_ids_mutex.lock();
+string Log::get_id() {
+    return thread_log_id;
+}
 
-    log_ids[id] = human_readable_id;
+void Log::release_id(string human_readable_id) {
+    //cerr << "releasing thread from human readable id: '" << human_readable_id << "'" << endl;
 
-    log_ids_mutex.unlock();
+    //the file is closed by the writer, after it has written the messages
+    //this thread logged before releasing the id
+    LogMessage message;
+    message.human_readable_id = human_readable_id;
+    message.close = true;
+    enqueue(message);
 }
 
-void Log::release_id(string human_readable_id) {
+LogBuffer* Log::get_thread_buffer() {
+    if (!thread_buffer.buffer) {
+        thread_buffer.buffer = make_shared<LogBuffer>(buffer_size);
 
-    //cerr << "locking thread from human readable id: '" << human_readable_id << "'" << endl;
-    log_ids_mutex.lock();
-    //cerr << "releasing thread from human readable id: '" << human_readable_id << "'" << endl;
+        lock_guard<mutex> lock(buffers_mutex);
+        buffers.push_back(thread_buffer.buffer);
+    }
+
+    return thread_buffer.buffer.get();
+}
+
+void Log::enqueue(LogMessage &message) {
+    if (!writer_running) {
+        lock_guard<mutex> lock(writer_mutex);
+
+        if (!writer_started) {
+            //no messages have been written to a file yet, so there is nothing to close
+            if (message.close) return;
+
+            writer_started = true;
+            writer_running = true;
+            writer_thread = thread(Log::writer);
+            atexit(Log::shutdown);
+
+        } else if (!writer_running) {
+            //the writer has already shut down (i.e., the program is exiting),
+            //so write the message directly
+            write_message(message);
+            for (auto it = output_files.begin(); it != output_files.end(); it++) {
+                fflush(it->second->file);
+            }
+            return;
+        }
+    }
+
+    LogBuffer *buffer = get_thread_buffer();
+    while (!buffer->push(message)) {
+        //the buffer is full, so wake up the writer and wait for it to make room
+        flush_requested++;
+        writer_cv.notify_one();
+        std::this_thread::yield();
+
+        if (!writer_running) {
+            lock_guard<mutex> lock(writer_mutex);
+            write_message(message);
+            return;
+        }
+    }
+}
 
-    if (output_files.count(human_readable_id) == 0) {
-        //this file was never created and written to
+void Log::writer() {
+    unique_lock<mutex> lock(writer_mutex);
 
-        //cerr << "ERROR: log id '" << human_readable_id << "' was either already released or not previously set!" << endl;
-        //exit(1);
+    while (true) {
+        writer_cv.wait_for(lock, milliseconds(flush_interval), []{ return writer_stopping || flush_requested > flush_completed; });
+
+        bool stopping = writer_stopping;
+        int64_t requested = flush_requested;
+
+        lock.unlock();
+        write_buffers();
+        lock.lock();
+
+        flush_completed = requested;
+        flush_cv.notify_all();
+
+        if (stopping) break;
+    }
+
+    writer_running = false;
+}
+
+void Log::write_buffers() {
+    vector< shared_ptr<LogBuffer> > current_buffers;
+    {
+        lock_guard<mutex> lock(buffers_mutex);
+        current_buffers = buffers;
+    }
+
+    //files are closed after all the buffers have been written, as other threads
+    //may have logged to the same id before it was released
+    vector<LogMessage> closes;
+
+    LogMessage message;
+    for (int32_t i = 0; i < (int32_t)current_buffers.size(); i++) {
+        while (current_buffers[i]->pop(message)) {
+            if (message.close) {
+                closes.push_back(message);
+            } else {
+                write_message(message);
+            }
+        }
+    }
+
+    //flush once per pass instead of once per message
+    for (auto it = output_files.begin(); it != output_files.end(); it++) {
+        if (it->second->written) {
+            fflush(it->second->file);
+            it->second->written = false;
+        }
+    }
+
+    for (int32_t i = 0; i < (int32_t)closes.size(); i++) {
+        write_message(closes[i]);
+    }
+
+    //remove the buffers of threads which have exited once they have been emptied,
+    //checking retired first as a retired thread will not add any more messages
+    lock_guard<mutex> lock(buffers_mutex);
+    for (auto it = buffers.begin(); it != buffers.end(); ) {
+        if ((*it)->retired && (*it)->empty()) {
+            it = buffers.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+void Log::write_message(LogMessage &message) {
+    if (message.close) {
+        if (output_files.count(message.human_readable_id) > 0) {
+            LogFile *log_file = output_files[message.human_readable_id];
+            fflush(log_file->file);
+            fclose(log_file->file);
+
+            delete log_file;
+            output_files.erase(message.human_readable_id);
+        }
+        return;
+    }
+
+    LogFile* log_file = NULL;
+
+    //check and see if we've already opened a file for this human readable id, if we haven't
+    //open a new one for it
+    if (output_files.count(message.human_readable_id) == 0) {
+        string output_filename = output_directory + "/" + message.human_readable_id;
+        FILE *outfile = fopen(output_filename.c_str(), "w");
+        log_file = new LogFile(outfile);
+        output_files[message.human_readable_id] = log_file;
     } else {
+        log_file = output_files[message.human_readable_id];
+    }
+
+    fputs(message.text.c_str(), log_file->file);
+    log_file->written = true;
+}
+
+void Log::flush() {
+    if (!writer_running) return;
 
-        LogFile *log_file = output_files[human_readable_id];
-        fflush(log_file->file);
-        fclose(log_file->file);
+    int64_t request = ++flush_requested;
 
-        delete log_file;
-        output_files.erase(human_readable_id);
+    unique_lock<mutex> lock(writer_mutex);
+    writer_cv.notify_one();
+    flush_cv.wait_for(lock, seconds(1), [request]{ return flush_completed >= request || !writer_running; });
+}
+
+void Log::shutdown() {
+    {
+        lock_guard<mutex> lock(writer_mutex);
+        writer_stopping = true;
     }
+    writer_cv.notify_one();
+    writer_thread.join();
 
-    log_ids_mutex.unlock();
+    for (auto it = output_files.begin(); it != output_files.end(); it++) {
+        fflush(it->second->file);
+        fclose(it->second->file);
+        delete it->second;
+    }
+    output_files.clear();
 }
 
 void Log::log(const char *file, size_t filelen, const char *func, size_t funclen, long line, log_level_t level, const char *format, ...) {
@@ -174,9 +412,8 @@ void Log::log(const char *file, size_t filelen, const char *func, size_t funclen
     va_list arguments;
     va_start(arguments, format);
     
-    thread::id id = std::this_thread::get_id();
-    if (log_ids.count(id) == 0) {
-        cerr << "ERROR: could not write message from thread '" << id << "' because it did not have a human readable id assigned (please use the Log::set_id(string) function before writing to the Log on any thread)." << endl;
+    if (thread_log_id.size() == 0) {
+        cerr << "ERROR: could not write message from thread '" << std::this_thread::get_id() << "' because it did not have a human readable id assigned (please use the Log::set_id(string) function before writing to the Log on any thread)." << endl;
         cerr << "message:" << endl;
         vprintf(format, arguments);
         cerr << endl;
@@ -198,7 +435,7 @@ void Log::log(const char *file, size_t filelen, const char *func, size_t funclen
     char message_buffer[max_message_length];
     vsnprintf(message_buffer, max_message_length, format, arguments);
 
-    string human_readable_id = log_ids[id];
+    const string &human_readable_id = thread_log_id;
     string level_str = Log::get_level_str(level);
 
     string log_str = "";
@@ -209,26 +446,19 @@ void Log::log(const char *file, size_t filelen, const char *func, size_t funclen
     }
 
     if (file_message_level >= level) {
-        LogFile* log_file = NULL;
-
-        //check and see if we've already opened a file for this human readable id, if we haven't
-        //open a new one for it
-
-        if (output_files.count(human_readable_id) == 0) {
-            string output_filename = output_directory + "/" + human_readable_id;
-            FILE *outfile = fopen(output_filename.c_str(), "w");
-            log_file = new LogFile(outfile);
-            output_files[human_readable_id] = log_file;
-        } else {
-            log_file = output_files[human_readable_id];
-        }
+        //the message is written to the file by the log writer thread
+        LogMessage message;
+        message.human_readable_id = human_readable_id;
+        message.text = move(log_str);
+        message.close = false;
+        enqueue(message);
+    }
 
-        //lock this log_file in case multiple threads are trying to write
-        //to the same file
-        log_file->file_mutex.lock();
-        fprintf(log_file->file, "%s", log_str.c_str());
-        fflush(log_file->file);
-        log_file->file_mutex.unlock();
+    //fatal messages are usually followed by exiting (or aborting MPI) so
+    //make sure they make it to the log file
+    if (level == LOG_LEVEL_FATAL) {
+        fflush(stdout);
+        flush();
     }
 }
 
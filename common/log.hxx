@@ -3,24 +3,33 @@
 
 #include <cstdio>  
 
+#include <atomic>
+using std::atomic;
+
+#include <condition_variable>
+using std::condition_variable;
+
 #include <iostream>
 using std::ofstream;
 
 #include <map>
 using std::map;
 
+#include <memory>
+using std::shared_ptr;
+
 #include <mutex>
 using std::mutex;
 
-#include <shared_mutex>
-using std::shared_mutex;
-
 #include <string>
 using std::string;
 
 #include <thread>
 using std::thread;
 
+#include <vector>
+using std::vector;
+
 #include "string_format.hxx"
 
 typedef enum log_level {
@@ -55,7 +64,7 @@ typedef enum log_level {
 class LogFile {
     private:
         FILE* file;
-        mutex file_mutex;
+        bool written; /**< if the file has been written to since it was last flushed. */
 
     public:
         LogFile(FILE* file);
@@ -63,6 +72,52 @@ class LogFile {
     friend class Log;
 };
 
+/**
+ * A message waiting to be written to a log file by the log writer thread.
+ * If close is true, the file for the human readable id is instead closed.
+ */
+class LogMessage {
+    public:
+        string human_readable_id;
+        string text;
+        bool close;
+};
+
+/**
+ * A fixed size single producer, single consumer ring buffer of log messages.
+ * Each thread writing to the log gets its own buffer, which only it adds
+ * messages to and only the log writer thread removes messages from, so
+ * neither needs to take a lock.
+ */
+class LogBuffer {
+    private:
+        vector<LogMessage> messages;
+        atomic<int64_t> head; /**< the index of the next message to be removed, only modified by the writer thread. */
+        atomic<int64_t> tail; /**< the index of the next message to be added, only modified by the owning thread. */
+
+        atomic<bool> retired; /**< set when the owning thread exits, so the buffer can be removed once it is empty. */
+
+    public:
+        LogBuffer(int32_t capacity);
+
+        /**
+         * Adds a message to the buffer.
+         * \return false if the buffer was full and the message was not added.
+         */
+        bool push(LogMessage &message);
+
+        /**
+         * Removes the oldest message in the buffer.
+         * \return false if the buffer was empty.
+         */
+        bool pop(LogMessage &message);
+
+        bool empty();
+
+    friend class Log;
+    friend class LogBufferHandle;
+};
+
 class Log {
     private:
         /**
@@ -100,12 +155,10 @@ class Log {
         static string output_directory;
 
         /**
-         * A map of C++ thread ids (which are not human readable) to human
-         * readable integer ids.
-         * Thread ids are specified with the Log::set_id(string) 
-         * method. 
+         * The human readable id of the calling thread, specified with the
+         * Log::set_id(string) method.  Empty if it has not been set.
          */
-        static map<thread::id, string> log_ids;
+        static thread_local string thread_log_id;
 
         /**
          *  The MPI process rank for this Log instance. Set to -1 if not specified or not using MPI.
@@ -119,15 +172,56 @@ class Log {
 
         /**
          * A map of human readable ids to output files which the log messages
-         * will be written to.
+         * will be written to.  Only used by the log writer thread.
          */
         static map<string, LogFile*> output_files;
 
         /**
-         * A std::shared_mutex protecting the Log::thread_ids map.
-         * The Log::set_thread_id(int32_t) mehod needs write access so it will use the std::shared_mutex::lock()x and std::shared_mutex()::unlock() mechanism, while the Log::get_thread_id() only needs read access and can used the std::shared_mutex::lock_shared() and std::shared_mutex::unlock_shared() methods.
+         * The number of messages each thread's buffer can hold before the thread
+         * has to wait for the log writer to catch up.
+         */
+        static int32_t buffer_size;
+
+        /**
+         * The maximum number of milliseconds between the log writer flushing the
+         * log files.
          */
-        static shared_mutex log_ids_mutex;
+        static int32_t flush_interval;
+
+        /**
+         * The message buffers of all threads which have written to a log file,
+         * protected by buffers_mutex (which is only needed when a thread writes
+         * its first message and when the writer looks for buffers).
+         */
+        static vector< shared_ptr<LogBuffer> > buffers;
+        static mutex buffers_mutex;
+
+        /**
+         * The background thread which writes messages from the thread buffers to
+         * the log files.  It is started when the first message is written to a
+         * file and stopped (after writing any remaining messages) at exit.
+         */
+        static thread writer_thread;
+        static mutex writer_mutex;
+        static condition_variable writer_cv;
+        static bool writer_started;
+        static atomic<bool> writer_running;
+        static bool writer_stopping;
+
+        /**
+         * Threads waiting on Log::flush() wait until the writer has completed a pass
+         * started after their request.
+         */
+        static atomic<int64_t> flush_requested;
+        static int64_t flush_completed;
+        static condition_variable flush_cv;
+
+        static LogBuffer* get_thread_buffer();
+        static void writer();
+        static void write_buffers();
+        static void write_message(LogMessage &message);
+        static void shutdown();
+        static void enqueue(LogMessage &message);
 
 
     public:
@@ -176,9 +270,8 @@ class Log {
         /**
          * Sets a human readable thread id for this thread.
          * 
-         * This will use std::this_thread::get_id() to get c++'s automatically
-         * generated thread id, and then put it in the Log::thread_ids map, so 
-         * it can be used to write cleaner logs.
+         * The id is stored in the thread local Log::thread_log_id, so
+         * it can be used to write cleaner logs without any lookups.
          *
          * This will report an error and exit if another thread has already
          * reserved this human readable id.
@@ -187,9 +280,18 @@ class Log {
          */
         static void set_id(string human_readable_id);
 
+        /**
+         * Returns the human readable id of the calling thread, so helper threads
+         * can write to the same log as the thread that started them.
+         *
+         * \return the id previously set with Log::set_id(string), or an empty string if it has not been set
+         */
+        static string get_id();
+
         /**
          * Releases a the human readable thread id previously set
-         * by by the provided human readable id;
+         * by by the provided human readable id; its log file is closed once
+         * the log writer has written this thread's messages to it.
          *
          * This will report an error and exit if this human readable id
          * has not already been set, or if it has been relased by another
@@ -235,6 +337,13 @@ class Log {
          */
         static void log(const char *file, size_t filelen, const char *func, size_t funclen, long line, log_level_t level, const char *format, ...);
 
+        /**
+         * Waits (for at most a second) for the log writer thread to write all
+         * messages logged before this call to the log files and flush them.  This
+         * is done automatically for FATAL messages and when the program exits.
+         */
+        static void flush();
+
 };
 
 #endif
@@ -1,5 +1,12 @@
 #include <cmath>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
 #include <fstream>
 using std::ifstream;
 
@@ -23,38 +30,21 @@ using std::vector;
 
 #include "stdint.h"
 
-Image::Image(ifstream &infile, int _channels, int _width, int _height, int _padding, int _classification, const Images *_images) {
+Image::Image(const uint8_t *_pixels, int _channels, int _width, int _height, int _padding, int _classification, const Images *_images) {
     channels = _channels;
     width = _width;
     height = _height;
     padding = _padding;
     classification = _classification;
     images = _images;
-
-    pixels = vector< vector< vector<uint8_t> > >(channels, vector< vector<uint8_t> >(height, vector<uint8_t>(width, 0)));
-
-    char* c_pixels = new char[channels * width * height];
-
-    infile.read( c_pixels, sizeof(char) * channels * width * height);
-
-    int current = 0;
-    for (int32_t z = 0; z < channels; z++) {
-        for (int32_t y = 0; y < height; y++) {
-            for (int32_t x = 0; x < width; x++) {
-                pixels[z][y][x] = (uint8_t)c_pixels[current];
-                current++;
-            }
-        }
-    }
-
-    delete [] c_pixels;
+    pixels = _pixels;
 }
 
 float Image::get_pixel(int z, int y, int x) const {
     if (y < padding || x < padding) return 0;
-    else if (y >= width + padding || x >= height + padding) return 0;
+    else if (y >= height + padding || x >= width + padding) return 0;
     else {
-        return ((pixels[z][y - padding][x - padding] / 255.0) - images->get_channel_avg(z)) / images->get_channel_std_dev(z);
+        return ((pixels[(((z * height) + y - padding) * width) + x - padding] / 255.0) - images->get_channel_avg(z)) / images->get_channel_std_dev(z);
     }
 }
 
@@ -69,7 +59,7 @@ void Image::get_pixel_avg(vector<float> &channel_avgs) const {
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                channel_avgs[z] += pixels[z][y][x] / 255.0;
+                channel_avgs[z] += pixels[(((z * height) + y) * width) + x] / 255.0;
             }
         }
         channel_avgs[z] /= (height * width);
@@ -84,7 +74,7 @@ void Image::get_pixel_variance(const vector<float> &channel_avgs, vector<float>
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                tmp = channel_avgs[z] - (pixels[z][y][x] / 255.0);
+                tmp = channel_avgs[z] - (pixels[(((z * height) + y) * width) + x] / 255.0);
                 channel_variances[z] += tmp * tmp;
             }
         }
@@ -98,7 +88,7 @@ void Image::print(ostream &out) {
     for (int32_t z = 0; z < channels; z++) {
         for (int32_t y = 0; y < height; y++) {
             for (int32_t x = 0; x < width; x++) {
-                out << setw(7) << pixels[z][y][x];
+                out << setw(7) << (int)pixels[(((z * height) + y) * width) + x];
             }
             out << endl;
         }
@@ -109,6 +99,12 @@ string Images::get_filename() const {
     return filename;
 }
 
+static bool memory_map_images = false;
+
+void set_memory_map_images(bool memory_map) {
+    memory_map_images = memory_map;
+}
+
 int Images::read_images(string _filename) {
     filename = _filename;
 
@@ -137,20 +133,60 @@ int Images::read_images(string _filename) {
 
     int image_size = channels * width * height;
 
+    number_images = 0;
     for (int i = 0; i < number_classes; i++) {
         cerr << "reading image set with " << class_sizes[i] << " images." << endl;
+        number_images += class_sizes[i];
+    }
 
-        for (int32_t j = 0; j < class_sizes[i]; j++) {
-            images.push_back(Image(infile, channels, width, height, padding, i, this));
+    //the pixels are the rest of the file, so they are either mapped or read
+    //straight into one buffer
+    size_t header_size = sizeof(initial_vals) + (sizeof(int) * number_classes);
+    size_t pixels_size = (size_t)number_images * image_size;
+
+    pixels = NULL;
+    if (memory_map_images) {
+        int fd = open(filename.c_str(), O_RDONLY);
+
+        struct stat file_stat;
+        if (fd >= 0 && fstat(fd, &file_stat) == 0 && (size_t)file_stat.st_size >= header_size + pixels_size) {
+            void *result = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (result != MAP_FAILED) {
+                mapping = result;
+                mapping_size = file_stat.st_size;
+                pixels = (const uint8_t*)mapping + header_size;
+            }
         }
+        if (fd >= 0) close(fd);
+
+        if (pixels == NULL) cerr << "could not memory map '" << filename << "', reading it instead." << endl;
+    }
+
+    if (pixels == NULL) {
+        pixel_buffer.resize(pixels_size);
+        infile.read( (char*)pixel_buffer.data(), pixels_size );
+
+        if ((size_t)infile.gcount() != pixels_size) {
+            cerr << "'" << filename << "' only had " << infile.gcount() << " of the " << pixels_size << " bytes of pixels." << endl;
+            return 1;
+        }
+        pixels = pixel_buffer.data();
     }
-    number_images = images.size();
 
     infile.close();
 
+    images.clear();
+    const uint8_t *current_pixels = pixels;
+    for (int i = 0; i < number_classes; i++) {
+        for (int32_t j = 0; j < class_sizes[i]; j++) {
+            images.push_back(Image(current_pixels, channels, width, height, padding, i, this));
+            current_pixels += image_size;
+        }
+    }
+
     cerr << "image_size: " << channels << "x" << width << "x" << height << " = " << image_size << endl;
 
-    cerr << "read " << images.size() << " images." << endl;
+    cerr << "read " << images.size() << " images" << (mapping != NULL ? " (memory mapped)." : ".") << endl;
     for (int i = 0; i < (int32_t)class_sizes.size(); i++) {
         cerr << "    class " << setw(4) << i << ": " << class_sizes[i] << endl;
     }
@@ -166,7 +202,7 @@ int Images::read_images(string _filename) {
 
 
 
-Images::Images(string _filename, int _padding, const vector<float> &_channel_avg, const vector<float> &_channel_std_dev) {
+Images::Images(string _filename, int _padding, const vector<float> &_channel_avg, const vector<float> &_channel_std_dev) : pixels(NULL), mapping(NULL), mapping_size(0) {
     padding = _padding;
 
     filename = _filename;
@@ -174,9 +210,10 @@ Images::Images(string _filename, int _padding, const vector<float> &_channel_avg
 
     channel_avg = _channel_avg;
     channel_std_dev = _channel_std_dev;
+    calculate_normalized_values();
 }
 
-Images::Images(string _filename, int _padding) {
+Images::Images(string _filename, int _padding) : pixels(NULL), mapping(NULL), mapping_size(0) {
     padding = _padding;
 
     filename = _filename;
@@ -185,6 +222,10 @@ Images::Images(string _filename, int _padding) {
     calculate_avg_std_dev();
 }
 
+Images::~Images() {
+    if (mapping != NULL) munmap(mapping, mapping_size);
+}
+
 bool Images::loaded_correctly() const {
     return !had_error;
 }
@@ -222,6 +263,45 @@ float Images::get_pixel(int image, int z, int y, int x) const {
     return images[image].get_pixel(z, y, x);
 }
 
+void Images::calculate_normalized_values() {
+    if (had_error) return;
+
+    normalized_values.assign(channels, vector<float>(256, 0.0));
+
+    //the same calculation as Image::get_pixel, so both give the same values
+    for (int32_t z = 0; z < channels; z++) {
+        for (int32_t value = 0; value < 256; value++) {
+            normalized_values[z][value] = ((value / 255.0) - channel_avg[z]) / channel_std_dev[z];
+        }
+    }
+}
+
+void Images::gather_batch(const vector<int> &batch, int channel, float *out) const {
+    int32_t padded_height = height + (2 * padding);
+    int32_t padded_width = width + (2 * padding);
+    const float *normalized = normalized_values[channel].data();
+
+    for (uint32_t batch_number = 0; batch_number < batch.size(); batch_number++) {
+        const uint8_t *image_pixels = pixels + (((size_t)batch[batch_number] * channels) + channel) * height * width;
+        float *image_out = out + ((size_t)batch_number * padded_height * padded_width);
+
+        std::fill(image_out, image_out + (padding * padded_width), 0.0);
+
+        for (int32_t y = 0; y < height; y++) {
+            const uint8_t *row = image_pixels + (y * width);
+            float *row_out = image_out + ((y + padding) * padded_width);
+
+            std::fill(row_out, row_out + padding, 0.0);
+            for (int32_t x = 0; x < width; x++) {
+                row_out[padding + x] = normalized[row[x]];
+            }
+            std::fill(row_out + padding + width, row_out + padded_width, 0.0);
+        }
+
+        std::fill(image_out + ((height + padding) * padded_width), image_out + (padded_height * padded_width), 0.0);
+    }
+}
+
 
 const vector<float>& Images::get_average() const {
     return channel_avg;
@@ -277,4 +357,6 @@ void Images::calculate_avg_std_dev() {
         channel_std_dev[j] = sqrt(channel_std_dev[j]);
         cerr << "pixel standard deviation for channel " << j << ": " << channel_std_dev[j] << endl;
     }
+
+    calculate_normalized_values();
 }
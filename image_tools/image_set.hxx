@@ -13,10 +13,15 @@ using std::string;
 #include <vector>
 using std::vector;
 
+#include "stdint.h"
+
 #include "image_set_interface.hxx"
 
 typedef class Images Images;
 
+/**
+ * One image of an Images, which is a view of its pixels in the Images' buffer.
+ */
 class Image : public ImageInterface {
     friend class Images;
 
@@ -26,14 +31,14 @@ class Image : public ImageInterface {
         int height;
         int width;
         int classification;
-        vector< vector< vector<uint8_t> > > pixels;
+        const uint8_t *pixels; /**< channels x height x width, in the Images' buffer. */
 
         //reference to images to get channel avgs and std_Devs
         const Images *images;
 
     public:
 
-        Image(ifstream &infile, int _channels, int _width, int _height, int _padding, int _classification, const Images *_images);
+        Image(const uint8_t *_pixels, int _channels, int _width, int _height, int _padding, int _classification, const Images *_images);
 
         int get_classification() const;
 
@@ -48,6 +53,13 @@ class Image : public ImageInterface {
         void print(ostream &out);
 };
 
+/**
+ * Memory maps the pixels of the Images read from now on, instead of reading
+ * them into memory, so large image sets are paged in as they are used (and
+ * shared by every process using the same file).
+ */
+void set_memory_map_images(bool memory_map);
+
 class Images : public ImagesInterface {
     private:
         string filename;
@@ -60,17 +72,34 @@ class Images : public ImagesInterface {
         int padding;
         int channels, width, height;
 
+        //every image's pixels, one after another in NCHW order (as they are in
+        //the file), which are either in pixel_buffer or memory mapped
+        const uint8_t *pixels;
+        vector<uint8_t> pixel_buffer;
+        void *mapping;
+        size_t mapping_size;
+
         vector<Image> images;
 
         vector<float> channel_avg;
         vector<float> channel_std_dev;
 
+        //the normalized value of each of the 256 pixel values, for each channel
+        vector< vector<float> > normalized_values;
+
         bool had_error;
+
+        void calculate_normalized_values();
+
+        Images(const Images &other);
+        Images& operator=(const Images &other);
+
     public:
         int read_images(string binary_filename);
 
         Images(string binary_filename, int _padding);
         Images(string binary_filename, int _padding, const vector<float> &_channeL_avg, const vector<float> &channel_std_dev);
+        ~Images();
 
         string get_filename() const;
 
@@ -87,6 +116,8 @@ class Images : public ImagesInterface {
         int get_classification(int image) const;
         float get_pixel(int image, int z, int y, int x) const;
 
+        void gather_batch(const vector<int> &batch, int channel, float *out) const;
+
         void calculate_avg_std_dev();
 
         float get_channel_avg(int channel) const;
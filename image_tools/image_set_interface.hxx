@@ -13,6 +13,8 @@ using std::string;
 #include <vector>
 using std::vector;
 
+#include "stdint.h"
+
 typedef class Image Image;
 
 class ImageInterface {
@@ -42,6 +44,23 @@ class ImagesInterface {
         virtual int get_classification(int image) const = 0;
         virtual float get_pixel(int image, int z, int y, int x) const = 0;
 
+        /**
+         * Copies the normalized (and padded) channel of each image in the batch
+         * into out, one get_image_height() by get_image_width() image after
+         * another.
+         */
+        virtual void gather_batch(const vector<int> &batch, int channel, float *out) const {
+            int current = 0;
+            for (uint32_t batch_number = 0; batch_number < batch.size(); batch_number++) {
+                for (int32_t y = 0; y < get_image_height(); y++) {
+                    for (int32_t x = 0; x < get_image_width(); x++) {
+                        out[current] = get_pixel(batch[batch_number], channel, y, x);
+                        current++;
+                    }
+                }
+            }
+        }
+
         virtual float get_channel_avg(int channel) const = 0;
         virtual float get_channel_std_dev(int channel) const = 0;
 
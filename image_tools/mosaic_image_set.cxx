@@ -24,6 +24,7 @@ using std::vector;
 
 #include "large_image_set.hxx"
 #include "mosaic_image_set.hxx"
+#include "tiled_image_set.hxx"
 
 #include "stdint.h"
 
@@ -43,46 +44,14 @@ Rectangle::Rectangle(int _y1, int _x1, int _y2, int _x2) : y1(_y1), x1(_x1), y2(
 }
 
 
-void MosaicImages::get_mosaic_pixels(string filename, vector< vector< vector<uint8_t> > > &pixels, uint32_t &height, uint32_t &width) {
-
-    TIFF *tif = TIFFOpen(filename.c_str(), "r");
-    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);        // uint32 height;
-    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);           // uint32 width;
-    TIFFGetField(tif, TIFFTAG_SAMPLESPERPIXEL, &channels);
-
-    cout << filename << ", height: " << height << ", width: " << width << ", channels: " << channels << endl;
-
-    uint32_t *raster = (uint32_t*)_TIFFmalloc(height * width * sizeof(uint32_t));
-    TIFFReadRGBAImage(tif, width, height, raster, 0);
-
-    pixels.resize(channels, vector< vector<uint8_t> >(height, vector<uint8_t>(width, 0)));
-
-    //cout << "pixels: " << endl;
-    int current_y = 0;
-    int current_x = 0;
-    for (uint32_t i = 0; i < height * width; i++) {
-        pixels[0][height - 1 - current_y][current_x] = TIFFGetR(raster[i]);
-        if (channels > 1) pixels[1][height - 1 - current_y][current_x] = TIFFGetG(raster[i]);
-        if (channels > 2) pixels[2][height - 1 - current_y][current_x] = TIFFGetB(raster[i]);
-        if (channels > 3) pixels[3][height - 1 - current_y][current_x] = TIFFGetA(raster[i]);
-
-        current_x++;
-        if (current_x == width) {
-            current_x = 0;
-            current_y++;
-        }
-    }
-    _TIFFfree(raster);
-    TIFFClose(tif);
-}
-
-
 void MosaicImages::read_mosaic(string filename, const vector<Point> &box_centers, int box_radius, const vector<int> &box_classes) {
 
-    uint32_t height;
-    uint32_t width;
-    vector< vector< vector<uint8_t> > > pixels;
-    get_mosaic_pixels(filename, pixels, height, width);
+    //the mosaic is read a tile at a time, so only the tiles around the boxes
+    //are ever in memory
+    TiledImage mosaic(filename, DEFAULT_CACHED_TILES);
+    channels = mosaic.get_channels();
+    int32_t height = mosaic.get_height();
+    int32_t width = mosaic.get_width();
 
     for (uint32_t i = 0; i < box_centers.size(); i++) {
         int32_t start_x = box_centers[i].x - box_radius;
@@ -105,14 +74,8 @@ void MosaicImages::read_mosaic(string filename, const vector<Point> &box_centers
         int subimages_along_height = (box_height - subimage_height) + 1;
         int number_subimages = subimages_along_width * subimages_along_height;
 
-        vector< vector< vector<uint8_t> > > box_pixels(channels, vector< vector<uint8_t> >(box_height, vector<uint8_t>(box_width, 0)));
-        for (uint32_t bz = 0; bz < channels; bz++) {
-            for (uint32_t by = 0; by < box_height; by++) {
-                for (uint32_t bx = 0; bx < box_width; bx++) {
-                    box_pixels[bz][by][bx] = pixels[bz][start_y + by][start_x + bx];
-                }
-            }
-        }
+        vector< vector< vector<uint8_t> > > box_pixels;
+        mosaic.read_region(start_y, start_x, box_height, box_width, box_pixels);
 
         LargeImage mosaic_image(number_subimages, channels, box_width, box_height, padding, box_classes[i], box_pixels);
         images.push_back(mosaic_image);
@@ -128,10 +91,10 @@ void MosaicImages::read_mosaic(string filename, const vector<Point> &box_centers
 
 void MosaicImages::read_mosaic(string filename, const vector<Line> &lines, int line_height, const vector<int> &line_classes) {
 
-    uint32_t height;
-    uint32_t width;
-    vector< vector< vector<uint8_t> > > pixels;
-    get_mosaic_pixels(filename, pixels, height, width);
+    TiledImage mosaic(filename, DEFAULT_CACHED_TILES);
+    channels = mosaic.get_channels();
+    int32_t height = mosaic.get_height();
+    int32_t width = mosaic.get_width();
 
     for (uint32_t i = 0; i < lines.size(); i++) {
         int32_t y1 = lines[i].y1;
@@ -171,6 +134,15 @@ void MosaicImages::read_mosaic(string filename, const vector<Line> &lines, int l
         double cos_angle = cos(rotation_angle);
         double sin_angle = sin(rotation_angle);
 
+        //only read the part of the mosaic the rotated line can be in (the
+        //pixels it is interpolated from are within its half diagonal of its
+        //center)
+        int32_t radius = sqrt((double)(half_length * half_length) + (double)(half_height * half_height)) + 2;
+        int32_t region_y = (int32_t)y_center - radius;
+        int32_t region_x = (int32_t)x_center - radius;
+        vector< vector< vector<uint8_t> > > pixels;
+        mosaic.read_region(region_y, region_x, (2 * radius) + 1, (2 * radius) + 1, pixels);
+
         //helpful links for rotation by area mapping:
         //http://www.leptonica.com/rotation.html#ROTATION-BY-AREA-MAPPING
         //https://computergraphics.stackexchange.com/questions/2074/rotate-image-around-its-center
@@ -194,10 +166,12 @@ void MosaicImages::read_mosaic(string filename, const vector<Line> &lines, int l
 
                     double fy = tmy - (int32_t)tmy;
                     double fx = tmx - (int32_t)tmx;
-                    line_pixels[bz][tly][tlx] = ((1 - fx) * (1 - fy) * pixels[bz][tmy][tmx])
-                        + (fx * (1 - fy) * pixels[bz][tmy][tmx + 1])
-                        + ((1 - fx) * fy * pixels[bz][tmy + 1][tmx])
-                        + (fx * fy * pixels[bz][tmy + 1][tmx + 1]);
+                    int32_t py = (int32_t)tmy - region_y;
+                    int32_t px = (int32_t)tmx - region_x;
+                    line_pixels[bz][tly][tlx] = ((1 - fx) * (1 - fy) * pixels[bz][py][px])
+                        + (fx * (1 - fy) * pixels[bz][py][px + 1])
+                        + ((1 - fx) * fy * pixels[bz][py + 1][px])
+                        + (fx * fy * pixels[bz][py + 1][px + 1]);
                 }
             }
         }
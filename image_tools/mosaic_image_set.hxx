@@ -67,8 +67,6 @@ class MosaicImages : public MultiImagesInterface {
         vector<float> channel_std_dev;
 
     public:
-        void get_mosaic_pixels(string filename, vector< vector< vector<uint8_t> > > &pixels, uint32_t &height, uint32_t &width);
-
         void read_mosaic(string filename, const vector<Point> &box_centers, int box_radius, const vector<int> &box_classes);
         void read_mosaic(string filename, const vector<Line> &lines, int line_height, const vector<int> &line_classes);
 
@@ -0,0 +1,595 @@
+#include <algorithm>
+using std::upper_bound;
+
+#include <cmath>
+
+#include <cstdlib>
+
+#include <fstream>
+using std::ifstream;
+using std::ofstream;
+using std::ios;
+
+#include <iostream>
+using std::cout;
+using std::cerr;
+using std::endl;
+
+#include <list>
+using std::list;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <unordered_map>
+using std::unordered_map;
+
+#include <utility>
+using std::pair;
+
+#include <vector>
+using std::vector;
+
+#include "stdint.h"
+
+#ifdef _HAS_TIFF_
+#include "tiff.h"
+#include "tiffio.h"
+#endif
+
+#include "tiled_image_set.hxx"
+
+TileReader::~TileReader() {
+}
+
+int TileReader::get_channels() const {
+    return channels;
+}
+
+int TileReader::get_height() const {
+    return height;
+}
+
+int TileReader::get_width() const {
+    return width;
+}
+
+int TileReader::get_tile_height() const {
+    return tile_height;
+}
+
+int TileReader::get_tile_width() const {
+    return tile_width;
+}
+
+int TileReader::get_number_tiles_y() const {
+    return (height + tile_height - 1) / tile_height;
+}
+
+int TileReader::get_number_tiles_x() const {
+    return (width + tile_width - 1) / tile_width;
+}
+
+RawTileReader::RawTileReader(string filename) {
+    infile.open(filename.c_str(), ios::in | ios::binary);
+
+    if (!infile.is_open()) {
+        cerr << "ERROR: could not open tiled image file '" << filename << "' for reading." << endl;
+        exit(1);
+    }
+
+    int header[5];
+    infile.read( (char*)&header, sizeof(header) );
+
+    channels = header[0];
+    height = header[1];
+    width = header[2];
+    tile_height = header[3];
+    tile_width = header[4];
+
+    if (!infile || channels <= 0 || height <= 0 || width <= 0 || tile_height <= 0 || tile_width <= 0) {
+        cerr << "ERROR: tiled image file '" << filename << "' had an invalid header, channels: " << channels << ", height: " << height << ", width: " << width << ", tile_height: " << tile_height << ", tile_width: " << tile_width << endl;
+        exit(1);
+    }
+}
+
+void RawTileReader::read_tile(int tile_y, int tile_x, vector<uint8_t> &pixels) {
+    int64_t tile_size = (int64_t)channels * tile_height * tile_width;
+    int64_t tile_number = ((int64_t)tile_y * get_number_tiles_x()) + tile_x;
+
+    pixels.resize(tile_size);
+
+    infile.seekg((5 * sizeof(int)) + (tile_number * tile_size));
+    infile.read( (char*)pixels.data(), tile_size );
+
+    if (!infile) {
+        cerr << "ERROR: could not read tile " << tile_y << ", " << tile_x << " of tiled image file." << endl;
+        exit(1);
+    }
+}
+
+#ifdef _HAS_TIFF_
+TiffTileReader::TiffTileReader(string filename) {
+    tif = TIFFOpen(filename.c_str(), "r");
+
+    if (tif == NULL) {
+        cerr << "ERROR: could not open TIFF '" << filename << "' for reading." << endl;
+        exit(1);
+    }
+
+    uint32_t tiff_height, tiff_width;
+    uint16_t samples_per_pixel = 1;
+    TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &tiff_height);
+    TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &tiff_width);
+    TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+
+    channels = samples_per_pixel;
+    if (channels > 4) channels = 4;
+    height = tiff_height;
+    width = tiff_width;
+
+    tiled = TIFFIsTiled(tif);
+    if (tiled) {
+        uint32_t tiff_tile_height, tiff_tile_width;
+        TIFFGetField(tif, TIFFTAG_TILELENGTH, &tiff_tile_height);
+        TIFFGetField(tif, TIFFTAG_TILEWIDTH, &tiff_tile_width);
+
+        tile_height = tiff_tile_height;
+        tile_width = tiff_tile_width;
+    } else {
+        uint32_t rows_per_strip = height;
+        TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+        if (rows_per_strip > (uint32_t)height) rows_per_strip = height;
+
+        tile_height = rows_per_strip;
+        tile_width = width;
+    }
+
+    cout << filename << ", height: " << height << ", width: " << width << ", channels: " << channels << ", " << (tiled ? "tile" : "strip") << " height: " << tile_height << ", width: " << tile_width << endl;
+
+    raster.resize((size_t)tile_height * tile_width);
+}
+
+TiffTileReader::~TiffTileReader() {
+    TIFFClose(tif);
+}
+
+void TiffTileReader::read_tile(int tile_y, int tile_x, vector<uint8_t> &pixels) {
+    pixels.assign((size_t)channels * tile_height * tile_width, 0);
+
+    int rows = height - (tile_y * tile_height);
+    if (rows > tile_height) rows = tile_height;
+
+    int columns = width - (tile_x * tile_width);
+    if (columns > tile_width) columns = tile_width;
+
+    //the RGBA rasters have their origin in the lower left, a tile's rows are
+    //at the bottom of the whole tile and a strip's at the bottom of its rows
+    int raster_rows;
+    if (tiled) {
+        TIFFReadRGBATile(tif, tile_x * tile_width, tile_y * tile_height, raster.data());
+        raster_rows = tile_height;
+    } else {
+        TIFFReadRGBAStrip(tif, tile_y * tile_height, raster.data());
+        raster_rows = rows;
+    }
+
+    int channel_size = tile_height * tile_width;
+    for (int32_t y = 0; y < rows; y++) {
+        for (int32_t x = 0; x < columns; x++) {
+            uint32_t pixel = raster[((raster_rows - 1 - y) * tile_width) + x];
+            int current = (y * tile_width) + x;
+
+            pixels[current] = TIFFGetR(pixel);
+            if (channels > 1) pixels[channel_size + current] = TIFFGetG(pixel);
+            if (channels > 2) pixels[(2 * channel_size) + current] = TIFFGetB(pixel);
+            if (channels > 3) pixels[(3 * channel_size) + current] = TIFFGetA(pixel);
+        }
+    }
+}
+#endif
+
+static bool has_extension(const string &filename, const string &extension) {
+    return filename.size() >= extension.size() && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+TiledImage::TiledImage(string _filename, int _max_cached_tiles) : filename(_filename), max_cached_tiles(_max_cached_tiles), tiles_read(0) {
+    if (max_cached_tiles < 1) max_cached_tiles = 1;
+
+    if (has_extension(filename, ".tif") || has_extension(filename, ".tiff")) {
+#ifdef _HAS_TIFF_
+        reader = new TiffTileReader(filename);
+#else
+        cerr << "ERROR: cannot read TIFF '" << filename << "', this was compiled without TIFF support." << endl;
+        exit(1);
+#endif
+    } else {
+        reader = new RawTileReader(filename);
+    }
+}
+
+TiledImage::~TiledImage() {
+    delete reader;
+}
+
+string TiledImage::get_filename() const {
+    return filename;
+}
+
+int TiledImage::get_channels() const {
+    return reader->get_channels();
+}
+
+int TiledImage::get_height() const {
+    return reader->get_height();
+}
+
+int TiledImage::get_width() const {
+    return reader->get_width();
+}
+
+int TiledImage::get_tile_height() const {
+    return reader->get_tile_height();
+}
+
+int TiledImage::get_tile_width() const {
+    return reader->get_tile_width();
+}
+
+int64_t TiledImage::get_tiles_read() const {
+    return tiles_read;
+}
+
+const vector<uint8_t>& TiledImage::get_tile(int tile_y, int tile_x) {
+    int64_t tile_number = ((int64_t)tile_y * reader->get_number_tiles_x()) + tile_x;
+
+    auto cached = cached_tiles.find(tile_number);
+    if (cached != cached_tiles.end()) {
+        recently_used.splice(recently_used.begin(), recently_used, cached->second.second);
+        return cached->second.first;
+    }
+
+    if ((int)cached_tiles.size() >= max_cached_tiles) {
+        cached_tiles.erase(recently_used.back());
+        recently_used.pop_back();
+    }
+
+    recently_used.push_front(tile_number);
+
+    pair< vector<uint8_t>, list<int64_t>::iterator > &tile = cached_tiles[tile_number];
+    tile.second = recently_used.begin();
+    reader->read_tile(tile_y, tile_x, tile.first);
+    tiles_read++;
+
+    return tile.first;
+}
+
+uint8_t TiledImage::get_pixel(int z, int y, int x) {
+    if (y < 0 || x < 0 || y >= reader->get_height() || x >= reader->get_width()) return 0;
+
+    int tile_height = reader->get_tile_height();
+    int tile_width = reader->get_tile_width();
+
+    lock_guard<mutex> lock(cache_mutex);
+    const vector<uint8_t> &tile = get_tile(y / tile_height, x / tile_width);
+
+    return tile[(((z * tile_height) + (y % tile_height)) * tile_width) + (x % tile_width)];
+}
+
+void TiledImage::read_region(int y, int x, int region_height, int region_width, vector< vector< vector<uint8_t> > > &pixels) {
+    int channels = reader->get_channels();
+    int tile_height = reader->get_tile_height();
+    int tile_width = reader->get_tile_width();
+
+    pixels.assign(channels, vector< vector<uint8_t> >(region_height, vector<uint8_t>(region_width, 0)));
+
+    //only the part of the region within the image is read, the rest is 0
+    int start_y = y < 0 ? 0 : y;
+    int start_x = x < 0 ? 0 : x;
+    int end_y = y + region_height < reader->get_height() ? y + region_height : reader->get_height();
+    int end_x = x + region_width < reader->get_width() ? x + region_width : reader->get_width();
+    if (start_y >= end_y || start_x >= end_x) return;
+
+    lock_guard<mutex> lock(cache_mutex);
+    for (int32_t tile_y = start_y / tile_height; tile_y <= (end_y - 1) / tile_height; tile_y++) {
+        for (int32_t tile_x = start_x / tile_width; tile_x <= (end_x - 1) / tile_width; tile_x++) {
+            const vector<uint8_t> &tile = get_tile(tile_y, tile_x);
+
+            int tile_start_y = tile_y * tile_height > start_y ? tile_y * tile_height : start_y;
+            int tile_start_x = tile_x * tile_width > start_x ? tile_x * tile_width : start_x;
+            int tile_end_y = (tile_y + 1) * tile_height < end_y ? (tile_y + 1) * tile_height : end_y;
+            int tile_end_x = (tile_x + 1) * tile_width < end_x ? (tile_x + 1) * tile_width : end_x;
+
+            for (int32_t z = 0; z < channels; z++) {
+                for (int32_t image_y = tile_start_y; image_y < tile_end_y; image_y++) {
+                    const uint8_t *row = &tile[((z * tile_height) + (image_y - (tile_y * tile_height))) * tile_width];
+                    for (int32_t image_x = tile_start_x; image_x < tile_end_x; image_x++) {
+                        pixels[z][image_y - y][image_x - x] = row[image_x - (tile_x * tile_width)];
+                    }
+                }
+            }
+        }
+    }
+}
+
+void TiledImage::get_pixel_avg(vector<float> &channel_avgs) {
+    int channels = reader->get_channels();
+    int tile_height = reader->get_tile_height();
+
+    channel_avgs.assign(channels, 0.0);
+
+    //a row of tiles at a time, so each tile is read once
+    vector< vector< vector<uint8_t> > > pixels;
+    for (int32_t y = 0; y < reader->get_height(); y += tile_height) {
+        int rows = reader->get_height() - y < tile_height ? reader->get_height() - y : tile_height;
+        read_region(y, 0, rows, reader->get_width(), pixels);
+
+        for (int32_t z = 0; z < channels; z++) {
+            for (int32_t row = 0; row < rows; row++) {
+                for (int32_t x = 0; x < reader->get_width(); x++) {
+                    channel_avgs[z] += pixels[z][row][x] / 255.0;
+                }
+            }
+        }
+    }
+
+    for (int32_t z = 0; z < channels; z++) {
+        channel_avgs[z] /= ((double)reader->get_height() * reader->get_width());
+    }
+}
+
+void TiledImage::get_pixel_variance(const vector<float> &channel_avgs, vector<float> &channel_variances) {
+    int channels = reader->get_channels();
+    int tile_height = reader->get_tile_height();
+
+    channel_variances.assign(channels, 0.0);
+
+    vector< vector< vector<uint8_t> > > pixels;
+    float tmp;
+    for (int32_t y = 0; y < reader->get_height(); y += tile_height) {
+        int rows = reader->get_height() - y < tile_height ? reader->get_height() - y : tile_height;
+        read_region(y, 0, rows, reader->get_width(), pixels);
+
+        for (int32_t z = 0; z < channels; z++) {
+            for (int32_t row = 0; row < rows; row++) {
+                for (int32_t x = 0; x < reader->get_width(); x++) {
+                    tmp = channel_avgs[z] - (pixels[z][row][x] / 255.0);
+                    channel_variances[z] += tmp * tmp;
+                }
+            }
+        }
+    }
+
+    for (int32_t z = 0; z < channels; z++) {
+        channel_variances[z] /= ((double)reader->get_height() * reader->get_width());
+    }
+}
+
+void write_raw_tiled_image(string filename, TiledImage &image, int tile_height, int tile_width) {
+    ofstream outfile(filename.c_str(), ios::out | ios::binary);
+
+    if (!outfile.is_open()) {
+        cerr << "ERROR: could not open tiled image file '" << filename << "' for writing." << endl;
+        exit(1);
+    }
+
+    int channels = image.get_channels();
+    int height = image.get_height();
+    int width = image.get_width();
+
+    int header[5] = {channels, height, width, tile_height, tile_width};
+    outfile.write( (char*)&header, sizeof(header) );
+
+    int number_tiles_y = (height + tile_height - 1) / tile_height;
+    int number_tiles_x = (width + tile_width - 1) / tile_width;
+
+    //the region is padded with 0s past the edges of the image, so the tiles
+    //along them are written whole
+    vector< vector< vector<uint8_t> > > pixels;
+    for (int32_t tile_y = 0; tile_y < number_tiles_y; tile_y++) {
+        image.read_region(tile_y * tile_height, 0, tile_height, number_tiles_x * tile_width, pixels);
+
+        for (int32_t tile_x = 0; tile_x < number_tiles_x; tile_x++) {
+            for (int32_t z = 0; z < channels; z++) {
+                for (int32_t y = 0; y < tile_height; y++) {
+                    outfile.write( (char*)&pixels[z][y][tile_x * tile_width], tile_width );
+                }
+            }
+        }
+    }
+
+    outfile.close();
+}
+
+ImageRegion::ImageRegion(int _y, int _x, int _height, int _width) : y(_y), x(_x), height(_height), width(_width) {
+}
+
+void get_overlapping_regions(int height, int width, int region_height, int region_width, int overlap_y, int overlap_x, vector<ImageRegion> &regions) {
+    if (region_height <= overlap_y || region_width <= overlap_x) {
+        cerr << "ERROR: regions of " << region_height << " x " << region_width << " are not larger than their overlap of " << overlap_y << " x " << overlap_x << endl;
+        exit(1);
+    }
+
+    regions.clear();
+    for (int32_t y = 0; y + overlap_y < height; y += region_height - overlap_y) {
+        int current_height = height - y < region_height ? height - y : region_height;
+
+        for (int32_t x = 0; x + overlap_x < width; x += region_width - overlap_x) {
+            int current_width = width - x < region_width ? width - x : region_width;
+
+            regions.push_back(ImageRegion(y, x, current_height, current_width));
+        }
+    }
+}
+
+TiledImages::TiledImages(TiledImage *_image, int _number_classes, int _padding, int _subimage_height, int _subimage_width, int region_height, int region_width) : image(_image), number_classes(_number_classes), padding(_padding), subimage_width(_subimage_width), subimage_height(_subimage_height) {
+    initialize_regions(region_height, region_width);
+    calculate_avg_std_dev();
+}
+
+TiledImages::TiledImages(TiledImage *_image, int _number_classes, int _padding, int _subimage_height, int _subimage_width, int region_height, int region_width, const vector<float> &_channel_avg, const vector<float> &_channel_std_dev) : image(_image), number_classes(_number_classes), padding(_padding), subimage_width(_subimage_width), subimage_height(_subimage_height), channel_avg(_channel_avg), channel_std_dev(_channel_std_dev) {
+    initialize_regions(region_height, region_width);
+}
+
+void TiledImages::initialize_regions(int region_height, int region_width) {
+    get_overlapping_regions(image->get_height(), image->get_width(), region_height, region_width, subimage_height - 1, subimage_width - 1, regions);
+
+    number_images = 0;
+    first_subimages.clear();
+    for (uint32_t i = 0; i < regions.size(); i++) {
+        first_subimages.push_back(number_images);
+        number_images += get_number_subimages(i);
+    }
+
+    cout << "split " << image->get_filename() << " into " << regions.size() << " regions with " << number_images << " subimages." << endl;
+}
+
+int TiledImages::get_region(int subimage) const {
+    if (subimage < 0 || subimage >= number_images) {
+        cerr << "Error getting region of subimage: " << subimage << ", there are only " << number_images << " subimages!" << endl;
+        exit(1);
+    }
+
+    return (upper_bound(first_subimages.begin(), first_subimages.end(), subimage) - first_subimages.begin()) - 1;
+}
+
+string TiledImages::get_filename() const {
+    return image->get_filename();
+}
+
+int TiledImages::get_class_size(int i) const {
+    //the windows of a tiled image are not labeled
+    if (i == 0) return number_images;
+    return 0;
+}
+
+int TiledImages::get_number_classes() const {
+    return number_classes;
+}
+
+int TiledImages::get_number_images() const {
+    return number_images;
+}
+
+int TiledImages::get_number_large_images() const {
+    return regions.size();
+}
+
+int TiledImages::get_number_subimages(int i) const {
+    return (regions[i].height - subimage_height + 1) * (regions[i].width - subimage_width + 1);
+}
+
+int TiledImages::get_padding() const {
+    return padding;
+}
+
+int TiledImages::get_image_channels() const {
+    return image->get_channels();
+}
+
+int TiledImages::get_image_width() const {
+    return subimage_width + (2 * padding);
+}
+
+int TiledImages::get_image_height() const {
+    return subimage_height + (2 * padding);
+}
+
+int TiledImages::get_large_image_channels(int image) const {
+    return this->image->get_channels();
+}
+
+int TiledImages::get_large_image_width(int image) const {
+    return regions[image].width;
+}
+
+int TiledImages::get_large_image_height(int image) const {
+    return regions[image].height;
+}
+
+const ImageRegion& TiledImages::get_region_bounds(int image) const {
+    return regions[image];
+}
+
+int TiledImages::get_image_classification(int image) const {
+    return 0;
+}
+
+int TiledImages::get_classification(int subimage) const {
+    return 0;
+}
+
+float TiledImages::get_pixel(int subimage, int z, int y, int x) const {
+    if (y < padding || x < padding) return 0;
+    else if (y >= subimage_height + padding || x >= subimage_width + padding) return 0;
+
+    int region = get_region(subimage);
+    subimage -= first_subimages[region];
+
+    int subimages_along_width = regions[region].width - subimage_width + 1;
+
+    int subimage_y_offset = subimage / subimages_along_width;
+    int subimage_x_offset = subimage % subimages_along_width;
+
+    return ((get_raw_pixel(region, z, subimage_y_offset + y - padding, subimage_x_offset + x - padding) / 255.0) - channel_avg[z]) / channel_std_dev[z];
+}
+
+float TiledImages::get_raw_pixel(int subimage, int z, int y, int x) const {
+    //as with LargeImages, this is actually the pixel of a large image (region)
+    return image->get_pixel(z, regions[subimage].y + y, regions[subimage].x + x);
+}
+
+void TiledImages::calculate_avg_std_dev() {
+    image->get_pixel_avg(channel_avg);
+
+    for (int32_t j = 0; j < image->get_channels(); j++) {
+        cerr << "average pixel value for channel " << j << ": " << channel_avg[j] << endl;
+    }
+
+    image->get_pixel_variance(channel_avg, channel_std_dev);
+
+    for (int32_t j = 0; j < image->get_channels(); j++) {
+        cerr << "pixel variance for channel " << j << ": " << channel_std_dev[j] << endl;
+        channel_std_dev[j] = sqrt(channel_std_dev[j]);
+        cerr << "pixel standard deviation for channel " << j << ": " << channel_std_dev[j] << endl;
+    }
+}
+
+float TiledImages::get_channel_avg(int channel) const {
+    return channel_avg[channel];
+}
+
+float TiledImages::get_channel_std_dev(int channel) const {
+    return channel_std_dev[channel];
+}
+
+const vector<float>& TiledImages::get_average() const {
+    return channel_avg;
+}
+
+const vector<float>& TiledImages::get_std_dev() const {
+    return channel_std_dev;
+}
+
+#ifdef TILED_IMAGES_TEST
+int main(int argc, char **argv) {
+    if (argc < 5) {
+        cerr << "usage: " << argv[0] << " <input image (.tif, .tiff or raw tiled)> <output raw tiled image> <tile height> <tile width> [<cached tiles>]" << endl;
+        exit(1);
+    }
+
+    int tile_height = atoi(argv[3]);
+    int tile_width = atoi(argv[4]);
+    int max_cached_tiles = DEFAULT_CACHED_TILES;
+    if (argc > 5) max_cached_tiles = atoi(argv[5]);
+
+    TiledImage image(argv[1], max_cached_tiles);
+    write_raw_tiled_image(argv[2], image, tile_height, tile_width);
+
+    cout << "wrote " << argv[2] << " (" << image.get_channels() << " x " << image.get_height() << " x " << image.get_width() << ") with " << tile_height << " x " << tile_width << " tiles, read " << image.get_tiles_read() << " tiles." << endl;
+}
+#endif
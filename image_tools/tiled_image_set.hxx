@@ -0,0 +1,239 @@
+#ifndef TILED_IMAGE_SET_HXX
+#define TILED_IMAGE_SET_HXX
+
+#include <fstream>
+using std::ifstream;
+
+#include <list>
+using std::list;
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <unordered_map>
+using std::unordered_map;
+
+#include <utility>
+using std::pair;
+
+#include <vector>
+using std::vector;
+
+#include "stdint.h"
+
+#ifdef _HAS_TIFF_
+#include "tiffio.h"
+#endif
+
+#include "image_set_interface.hxx"
+
+//the number of tiles a TiledImage keeps in memory, unless it is given another
+#define DEFAULT_CACHED_TILES 64
+
+/**
+ * Reads the tiles of an image file one at a time, each as channels x
+ * tile_height x tile_width pixels (the parts of tiles past the edge of the
+ * image are 0).
+ */
+class TileReader {
+    protected:
+        int channels;
+        int height;
+        int width;
+        int tile_height;
+        int tile_width;
+
+    public:
+        virtual ~TileReader();
+
+        int get_channels() const;
+        int get_height() const;
+        int get_width() const;
+        int get_tile_height() const;
+        int get_tile_width() const;
+
+        int get_number_tiles_y() const;
+        int get_number_tiles_x() const;
+
+        virtual void read_tile(int tile_y, int tile_x, vector<uint8_t> &pixels) = 0;
+};
+
+/**
+ * Reads the raw tiled format, which is five 32 bit ints (channels, height,
+ * width, tile_height and tile_width) followed by every tile, a row of tiles at
+ * a time, each as channels x tile_height x tile_width bytes.
+ */
+class RawTileReader : public TileReader {
+    private:
+        ifstream infile;
+
+    public:
+        RawTileReader(string filename);
+
+        void read_tile(int tile_y, int tile_x, vector<uint8_t> &pixels);
+};
+
+#ifdef _HAS_TIFF_
+/**
+ * Reads a tiled TIFF a tile at a time, or a stripped one a strip at a time
+ * (each strip being a tile as wide as the image).
+ */
+class TiffTileReader : public TileReader {
+    private:
+        TIFF *tif;
+        bool tiled;
+        vector<uint32_t> raster;
+
+    public:
+        TiffTileReader(string filename);
+        ~TiffTileReader();
+
+        void read_tile(int tile_y, int tile_x, vector<uint8_t> &pixels);
+};
+#endif
+
+/**
+ * An image which is read a tile at a time when its pixels are needed, keeping
+ * only the max_cached_tiles most recently used tiles in memory.  Files ending
+ * in .tif or .tiff are read as TIFFs, anything else in the raw tiled format.
+ */
+class TiledImage {
+    private:
+        string filename;
+        TileReader *reader;
+
+        int max_cached_tiles;
+        list<int64_t> recently_used; /**< the cached tiles, most recently used first. */
+        unordered_map<int64_t, pair< vector<uint8_t>, list<int64_t>::iterator > > cached_tiles;
+        int64_t tiles_read;
+
+        mutex cache_mutex;
+
+        const vector<uint8_t>& get_tile(int tile_y, int tile_x);
+
+    public:
+        TiledImage(string _filename, int _max_cached_tiles);
+        ~TiledImage();
+
+        string get_filename() const;
+
+        int get_channels() const;
+        int get_height() const;
+        int get_width() const;
+        int get_tile_height() const;
+        int get_tile_width() const;
+
+        /**
+         * The number of tiles which have been read from the file, including
+         * those read again after they were dropped from the cache.
+         */
+        int64_t get_tiles_read() const;
+
+        uint8_t get_pixel(int z, int y, int x);
+
+        /**
+         * Copies the region_height x region_width pixels starting at (y, x)
+         * into pixels, as channels x region_height x region_width, reading each
+         * tile the region overlaps once.
+         */
+        void read_region(int y, int x, int region_height, int region_width, vector< vector< vector<uint8_t> > > &pixels);
+
+        void get_pixel_avg(vector<float> &channel_avgs);
+        void get_pixel_variance(const vector<float> &channel_avgs, vector<float> &channel_variances);
+};
+
+/**
+ * Writes the image in the raw tiled format, a row of tiles at a time.
+ */
+void write_raw_tiled_image(string filename, TiledImage &image, int tile_height, int tile_width);
+
+class ImageRegion {
+    public:
+        int y;
+        int x;
+        int height;
+        int width;
+
+        ImageRegion(int _y, int _x, int _height, int _width);
+};
+
+/**
+ * Splits a height x width image into regions of at most region_height x
+ * region_width, row by row, with each overlapping the previous ones by
+ * overlap_y and overlap_x.  Each window of (overlap_y + 1) x (overlap_x + 1)
+ * pixels of the image is then within exactly one region with its top left
+ * corner in the region's top region_height - overlap_y rows and left
+ * region_width - overlap_x columns, so evaluating the windows of every region
+ * evaluates each window of the image once.
+ */
+void get_overlapping_regions(int height, int width, int region_height, int region_width, int overlap_y, int overlap_x, vector<ImageRegion> &regions);
+
+/**
+ * The windows (subimages) of a TiledImage, with each of its overlapping
+ * regions as one of the large images, so they can be evaluated a region at a
+ * time without the whole image in memory.  The subimages of each region are
+ * ordered as those of LargeImages.
+ */
+class TiledImages : public MultiImagesInterface {
+    private:
+        TiledImage *image;
+
+        int number_classes;
+        int number_images;
+
+        int padding;
+        int subimage_width, subimage_height;
+
+        vector<ImageRegion> regions;
+        vector<int> first_subimages; /**< the number of subimages in the regions before each region. */
+
+        vector<float> channel_avg;
+        vector<float> channel_std_dev;
+
+        void initialize_regions(int region_height, int region_width);
+        int get_region(int subimage) const;
+
+    public:
+        TiledImages(TiledImage *_image, int _number_classes, int _padding, int _subimage_height, int _subimage_width, int region_height, int region_width);
+        TiledImages(TiledImage *_image, int _number_classes, int _padding, int _subimage_height, int _subimage_width, int region_height, int region_width, const vector<float> &_channel_avg, const vector<float> &_channel_std_dev);
+
+        string get_filename() const;
+
+        int get_class_size(int i) const;
+
+        int get_number_classes() const;
+
+        int get_number_images() const;
+        int get_number_large_images() const;
+        int get_number_subimages(int i) const;
+
+        int get_padding() const;
+
+        int get_image_channels() const;
+        int get_image_width() const;
+        int get_image_height() const;
+
+        int get_large_image_channels(int image) const;
+        int get_large_image_width(int image) const;
+        int get_large_image_height(int image) const;
+
+        const ImageRegion& get_region_bounds(int image) const;
+
+        int get_image_classification(int image) const;
+        int get_classification(int subimage) const;
+        float get_pixel(int subimage, int z, int y, int x) const;
+        float get_raw_pixel(int subimage, int z, int y, int x) const;
+
+        void calculate_avg_std_dev();
+
+        float get_channel_avg(int channel) const;
+        float get_channel_std_dev(int channel) const;
+
+        const vector<float>& get_average() const;
+        const vector<float>& get_std_dev() const;
+};
+
+#endif
@@ -29,6 +29,7 @@ using std::vector;
 #include "image_tools/image_set.hxx"
 
 #include "cnn/exact.hxx"
+#include "cnn/cnn_options.hxx"
 
 #define WORK_REQUEST_TAG 1
 #define GENOME_LENGTH_TAG 2
@@ -221,6 +222,7 @@ int main(int argc, char** argv) {
     MPI_Comm_size(MPI_COMM_WORLD, &max_rank);
 
     arguments = vector<string>(argv, argv + argc);
+    set_cnn_options(arguments);
 
     string training_filename;
     get_argument(arguments, "--training_file", true, training_filename);
@@ -1,12 +1,23 @@
 #include <chrono>
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 
 #include <iomanip>
 using std::setw;
 using std::fixed;
 using std::setprecision;
 
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
 #include <mutex>
+using std::lock_guard;
 using std::mutex;
+using std::unique_lock;
 
 #include <string>
 using std::string;
@@ -24,9 +35,13 @@ using std::vector;
 #include "common/weight_initialize.hxx"
 
 #include "rnn/examm.hxx"
+#include "rnn/speculative_generator.hxx"
 
 #include "time_series/time_series.hxx"
 
+#include "genome_scheduler.hxx"
+#include "series_broadcast.hxx"
+
 #define WORK_REQUEST_TAG 1
 #define GENOME_LENGTH_TAG 2
 #define GENOME_TAG 3
@@ -38,6 +53,8 @@ vector<string> arguments;
 
 EXAMM *examm;
 
+SpeculativeGenerator *speculative_generator = NULL;
+
 bool finished = false;
 
 vector< vector< vector<double> > > training_inputs;
@@ -45,58 +62,111 @@ vector< vector< vector<double> > > training_outputs;
 vector< vector< vector<double> > > validation_inputs;
 vector< vector< vector<double> > > validation_outputs;
 
-void send_work_request(int target) {
+//views of the series above, or (with --shared_memory_broadcast) of the copy
+//of them every process on a node shares
+SharedSeries shared_series[4];
+DatasetView training_input_view;
+DatasetView training_output_view;
+DatasetView validation_input_view;
+DatasetView validation_output_view;
+
+void send_work_request(int target, int number_genomes) {
     int work_request_message[1];
-    work_request_message[0] = 0;
+    work_request_message[0] = number_genomes;
     MPI_Send(work_request_message, 1, MPI_INT, target, WORK_REQUEST_TAG, MPI_COMM_WORLD);
 }
 
-void receive_work_request(int source) {
+int receive_work_request(int source) {
     MPI_Status status;
     int work_request_message[1];
     MPI_Recv(work_request_message, 1, MPI_INT, source, WORK_REQUEST_TAG, MPI_COMM_WORLD, &status);
+
+    //older workers sent a 0 to request a single genome
+    if (work_request_message[0] < 1) return 1;
+    return work_request_message[0];
 }
 
-RNN_Genome* receive_genome_from(int source) {
+/**
+ * Genomes are sent in batches: first a length message with the number of
+ * genomes followed by each genome's length and the milliseconds the worker
+ * spent training it (0 for untrained genomes), then a single message with all
+ * the genomes' bytes concatenated.
+ */
+void receive_genomes_from(int source, vector<RNN_Genome*> &genomes, vector<int> &training_times) {
     MPI_Status status;
-    int length_message[1];
-    MPI_Recv(length_message, 1, MPI_INT, source, GENOME_LENGTH_TAG, MPI_COMM_WORLD, &status);
+    MPI_Probe(source, GENOME_LENGTH_TAG, MPI_COMM_WORLD, &status);
 
-    int length = length_message[0];
+    int length_message_size;
+    MPI_Get_count(&status, MPI_INT, &length_message_size);
 
-    LOG_DEBUG("receiving genome of length: %d from: %d\n", length, source);
+    vector<int> length_message(length_message_size);
+    MPI_Recv(length_message.data(), length_message_size, MPI_INT, source, GENOME_LENGTH_TAG, MPI_COMM_WORLD, &status);
 
-    char* genome_str = new char[length + 1];
+    int number_genomes = length_message[0];
+    int total_length = 0;
+    for (int i = 0; i < number_genomes; i++) {
+        total_length += length_message[i + 1];
+    }
 
-    LOG_DEBUG("receiving genome from: %d\n", source);
-    MPI_Recv(genome_str, length, MPI_CHAR, source, GENOME_TAG, MPI_COMM_WORLD, &status);
+    LOG_DEBUG("receiving %d genomes with total length: %d from: %d\n", number_genomes, total_length, source);
 
-    genome_str[length] = '\0';
+    char* genome_str = new char[total_length + 1];
+    MPI_Recv(genome_str, total_length, MPI_CHAR, source, GENOME_TAG, MPI_COMM_WORLD, &status);
 
-    LOG_TRACE("genome_str:\n%s\n", genome_str);
+    genomes.clear();
+    training_times.clear();
+    int offset = 0;
+    for (int i = 0; i < number_genomes; i++) {
+        int length = length_message[i + 1];
+        genomes.push_back(new RNN_Genome(genome_str + offset, length));
+        offset += length;
 
-    RNN_Genome* genome = new RNN_Genome(genome_str, length);
+        //length messages without training times are from older workers
+        if (length_message_size > number_genomes + 1) {
+            training_times.push_back(length_message[number_genomes + i + 1]);
+        } else {
+            training_times.push_back(0);
+        }
+    }
 
     delete [] genome_str;
-    return genome;
 }
 
-void send_genome_to(int target, RNN_Genome* genome) {
-    char *byte_array;
-    int32_t length;
+RNN_Genome* receive_genome_from(int source) {
+    vector<RNN_Genome*> genomes;
+    vector<int> training_times;
+    receive_genomes_from(source, genomes, training_times);
+    return genomes[0];
+}
+
+void send_genomes_to(int target, const vector<RNN_Genome*> &genomes, const vector<int> &training_times) {
+    vector<int> length_message((genomes.size() * 2) + 1);
+    length_message[0] = genomes.size();
+
+    string bytes_str;
+    for (int i = 0; i < (int)genomes.size(); i++) {
+        char *byte_array;
+        int32_t length;
 
-    genome->write_to_array(&byte_array, length);
+        genomes[i]->write_to_array(&byte_array, length);
+        bytes_str.append(byte_array, length);
+        length_message[i + 1] = length;
+        length_message[genomes.size() + i + 1] = training_times[i];
 
-    LOG_DEBUG("sending genome of length: %d to: %d\n", length, target);
+        free(byte_array);
+    }
 
-    int length_message[1];
-    length_message[0] = length;
-    MPI_Send(length_message, 1, MPI_INT, target, GENOME_LENGTH_TAG, MPI_COMM_WORLD);
+    LOG_DEBUG("sending %d genomes with total length: %d to: %d\n", genomes.size(), bytes_str.size(), target);
+    MPI_Send(length_message.data(), length_message.size(), MPI_INT, target, GENOME_LENGTH_TAG, MPI_COMM_WORLD);
+    MPI_Send(&bytes_str[0], bytes_str.size(), MPI_CHAR, target, GENOME_TAG, MPI_COMM_WORLD);
+}
 
-    LOG_DEBUG("sending genome to: %d\n", target);
-    MPI_Send(byte_array, length, MPI_CHAR, target, GENOME_TAG, MPI_COMM_WORLD);
+void send_genomes_to(int target, const vector<RNN_Genome*> &genomes) {
+    send_genomes_to(target, genomes, vector<int>(genomes.size(), 0));
+}
 
-    free(byte_array);
+void send_genome_to(int target, RNN_Genome* genome, int training_time) {
+    send_genomes_to(target, vector<RNN_Genome*>(1, genome), vector<int>(1, training_time));
 }
 
 void send_terminate_message(int target) {
@@ -111,12 +181,33 @@ void receive_terminate_message(int source) {
     MPI_Recv(terminate_message, 1, MPI_INT, source, TERMINATE_TAG, MPI_COMM_WORLD, &status);
 }
 
-void master(int max_rank) {
+/**
+ * Returns the total number of time steps over all the training series, which
+ * the cost of training a genome scales with.
+ */
+int64_t get_total_series_length() {
+    int64_t total_series_length = 0;
+    for (int32_t i = 0; i < (int32_t)training_input_view.size(); i++) {
+        if (training_input_view[i].size() > 0) total_series_length += training_input_view[i][0].size();
+    }
+    return total_series_length;
+}
+
+void master(int max_rank, int32_t ready_queue_size, int32_t threads_per_rank) {
     //the "main" id will have already been set by the main function so we do not need to re-set it here
     LOG_DEBUG("MAX INT: %d\n", numeric_limits<int>::max());
 
     int terminates_sent = 0;
 
+    GenomeScheduler scheduler(get_total_series_length(), ready_queue_size);
+    bool search_completed = false;
+    int total_outstanding = 0;
+
+    //workers running multiple training threads can still have genomes out when
+    //they are terminated, so the master keeps receiving until they have all
+    //come back.  every work request is answered right away (with genomes or a
+    //terminate) so a worker waiting on its answer never has to send results
+
     while (true) {
         //wait for a incoming message
         MPI_Status status;
@@ -130,42 +221,85 @@ void master(int max_rank) {
         //if the message is a work request, send a genome
 
         if (tag == WORK_REQUEST_TAG) {
-            receive_work_request(source);
+            int number_requested = receive_work_request(source);
+
+            vector<RNN_Genome*> genomes;
+            while (!search_completed && scheduler.needs_genomes(number_requested)) {
+                RNN_Genome *genome = NULL;
+                if (speculative_generator != NULL) {
+                    genome = speculative_generator->get_genome();
+                } else {
+                    examm_mutex.lock();
+                    genome = examm->generate_genome();
+                    examm_mutex.unlock();
+                }
+
+                if (genome == NULL) {
+                    //genomes still in the ready queue would only be trained past max_genomes
+                    search_completed = true;
+                    scheduler.clear();
+                    break;
+                }
+                scheduler.add_genome(genome);
+            }
 
+            //once there are only enough genomes left to keep every worker busy
+            //once more, hand out the cheapest ones first so the search does not
+            //wait on a few long running genomes at the end
             examm_mutex.lock();
-            RNN_Genome *genome = examm->generate_genome();
+            int remaining_genomes = examm->get_max_genomes() - examm->get_inserted_genomes() - total_outstanding;
+            bool prefer_small = remaining_genomes <= (max_rank - 1) * threads_per_rank;
             examm_mutex.unlock();
 
-            if (genome == NULL) { //search was completed if it returns NULL for an individual
+            for (int i = 0; i < number_requested; i++) {
+                RNN_Genome *genome = scheduler.next_genome(prefer_small);
+                if (genome == NULL) break;
+                genomes.push_back(genome);
+            }
+
+            if (genomes.size() == 0) { //search was completed if it returns NULL for an individual
                 //send terminate message
                 LOG_INFO("terminating worker: %d\n", source);
                 send_terminate_message(source);
                 terminates_sent++;
 
-                LOG_DEBUG("sent: %d terminates of %d\n", terminates_sent, (max_rank - 1));
-                if (terminates_sent >= max_rank - 1) return;
+                LOG_DEBUG("sent: %d terminates of %d, %d genomes outstanding\n", terminates_sent, (max_rank - 1), total_outstanding);
+                if (terminates_sent >= max_rank - 1 && total_outstanding == 0) return;
 
             } else {
                 //genome->write_to_file( examm->get_output_directory() + "/before_send_gen_" + to_string(genome->get_generation_id()) );
 
                 //send genome
-                LOG_DEBUG("sending genome to: %d\n", source);
-                send_genome_to(source, genome);
-
-                //delete this genome as it will not be used again
-                delete genome;
+                LOG_DEBUG("sending %d genomes to: %d\n", genomes.size(), source);
+                send_genomes_to(source, genomes);
+                total_outstanding += genomes.size();
+
+                //delete these genomes as they will not be used again
+                for (int i = 0; i < (int)genomes.size(); i++) {
+                    delete genomes[i];
+                }
             }
         } else if (tag == GENOME_LENGTH_TAG) {
             LOG_DEBUG("received genome from: %d\n", source);
-            RNN_Genome *genome = receive_genome_from(source);
+            vector<RNN_Genome*> genomes;
+            vector<int> training_times;
+            receive_genomes_from(source, genomes, training_times);
+            total_outstanding -= genomes.size();
 
             examm_mutex.lock();
-            examm->insert_genome(genome);
+            for (int i = 0; i < (int)genomes.size(); i++) {
+                scheduler.genome_trained(genomes[i], training_times[i]);
+                examm->insert_genome(genomes[i]);
+            }
             examm_mutex.unlock();
 
-            //delete the genome as it won't be used again, a copy was inserted
-            delete genome;
+            //delete the genomes as they won't be used again, a copy was inserted
+            for (int i = 0; i < (int)genomes.size(); i++) {
+                delete genomes[i];
+            }
             //this genome will be deleted if/when removed from population
+
+            if (terminates_sent >= max_rank - 1 && total_outstanding == 0) return;
         } else {
             LOG_FATAL("ERROR: received message from %d with unknown tag: %d", source, tag);
             MPI_Abort(MPI_COMM_WORLD, 1);
@@ -178,7 +312,7 @@ void worker(int rank) {
 
     while (true) {
         LOG_DEBUG("sending work request!\n");
-        send_work_request(0);
+        send_work_request(0, 1);
         LOG_DEBUG("sent work request!\n");
 
         MPI_Status status;
@@ -199,13 +333,15 @@ void worker(int rank) {
             //have each worker write the backproagation to a separate log file
             string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank);
             Log::set_id(log_id);
-            genome->backpropagate_stochastic(training_inputs, training_outputs, validation_inputs, validation_outputs);
+            auto start_time = steady_clock::now();
+            genome->backpropagate_stochastic(training_input_view, training_output_view, validation_input_view, validation_output_view);
+            int training_time = duration_cast<milliseconds>(steady_clock::now() - start_time).count();
             Log::release_id(log_id);
 
             //go back to the worker's log for MPI communication
             Log::set_id("worker_" + to_string(rank));
 
-            send_genome_to(0, genome);
+            send_genome_to(0, genome, training_time);
 
             delete genome;
         } else {
@@ -218,6 +354,146 @@ void worker(int rank) {
     Log::release_id("worker_" + to_string(rank));
 }
 
+/**
+ * Genomes waiting to be trained and trained genomes waiting to be sent back
+ * to the master by a hybrid worker.
+ */
+mutex worker_queue_mutex;
+condition_variable worker_queue_cv;
+deque<RNN_Genome*> untrained_genomes;
+vector<RNN_Genome*> trained_genomes;
+vector<int> trained_genome_times;
+bool worker_finished = false;
+
+void training_thread(int rank, int thread_id) {
+    while (true) {
+        unique_lock<mutex> lock(worker_queue_mutex);
+        worker_queue_cv.wait(lock, []{ return worker_finished || untrained_genomes.size() > 0; });
+
+        if (untrained_genomes.size() == 0) break;   //the worker has finished
+
+        RNN_Genome *genome = untrained_genomes.front();
+        untrained_genomes.pop_front();
+        lock.unlock();
+
+        //have each thread write the backproagation to a separate log file
+        string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank) + "_thread_" + to_string(thread_id);
+        Log::set_id(log_id);
+        auto start_time = steady_clock::now();
+        genome->backpropagate_stochastic(training_input_view, training_output_view, validation_input_view, validation_output_view);
+        int training_time = duration_cast<milliseconds>(steady_clock::now() - start_time).count();
+        Log::release_id(log_id);
+
+        lock.lock();
+        trained_genomes.push_back(genome);
+        trained_genome_times.push_back(training_time);
+        lock.unlock();
+        worker_queue_cv.notify_all();
+    }
+}
+
+/**
+ * A worker which trains genomes on multiple threads, all sharing this
+ * process' copy of the training and validation data.  This thread does all
+ * of the MPI communication: it requests as many genomes as there are idle
+ * training threads and sends back trained genomes in batches.
+ */
+void hybrid_worker(int rank, int threads_per_rank) {
+    Log::set_id("worker_" + to_string(rank));
+
+    vector<thread> threads;
+    for (int i = 0; i < threads_per_rank; i++) {
+        threads.push_back( thread(training_thread, rank, i) );
+    }
+
+    int idle_threads = threads_per_rank;
+    bool request_sent = false;
+    bool terminated = false;
+
+    //trained genomes are only sent while no work request is outstanding, and
+    //the master answers requests right away, so the master is never sending
+    //genomes to this worker while it is sending results back
+    while (true) {
+        if (request_sent) {
+            MPI_Status status;
+            MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+
+            int tag = status.MPI_TAG;
+            LOG_DEBUG("probe received message with tag: %d\n", tag);
+
+            if (tag == TERMINATE_TAG) {
+                LOG_DEBUG("received terminate tag!\n");
+                receive_terminate_message(0);
+                terminated = true;
+
+            } else if (tag == GENOME_LENGTH_TAG) {
+                vector<RNN_Genome*> genomes;
+                vector<int> training_times;
+                receive_genomes_from(0, genomes, training_times);
+                LOG_DEBUG("received %d genomes!\n", genomes.size());
+
+                {
+                    lock_guard<mutex> lock(worker_queue_mutex);
+                    untrained_genomes.insert(untrained_genomes.end(), genomes.begin(), genomes.end());
+                }
+                worker_queue_cv.notify_all();
+
+                idle_threads -= genomes.size();
+
+            } else {
+                LOG_FATAL("ERROR: received message with unknown tag: %d\n", tag);
+                MPI_Abort(MPI_COMM_WORLD, 1);
+            }
+            request_sent = false;
+        }
+
+        vector<RNN_Genome*> results;
+        vector<int> result_times;
+
+        {
+            unique_lock<mutex> lock(worker_queue_mutex);
+            //only sleep if there are no idle threads to request genomes for
+            if (terminated || idle_threads == 0) {
+                worker_queue_cv.wait(lock, [&]{ return trained_genomes.size() > 0 || idle_threads == threads_per_rank; });
+            }
+            results.swap(trained_genomes);
+            result_times.swap(trained_genome_times);
+        }
+
+        if (results.size() > 0) {
+            LOG_DEBUG("sending %d trained genomes\n", results.size());
+            send_genomes_to(0, results, result_times);
+
+            for (int i = 0; i < (int)results.size(); i++) {
+                delete results[i];
+            }
+            idle_threads += results.size();
+        }
+
+        if (terminated) {
+            if (idle_threads == threads_per_rank) break;
+
+        } else if (idle_threads > 0) {
+            LOG_DEBUG("sending work request for %d genomes!\n", idle_threads);
+            send_work_request(0, idle_threads);
+            request_sent = true;
+        }
+    }
+
+    {
+        lock_guard<mutex> lock(worker_queue_mutex);
+        worker_finished = true;
+    }
+    worker_queue_cv.notify_all();
+
+    for (int i = 0; i < (int)threads.size(); i++) {
+        threads[i].join();
+    }
+
+    //release the log file for the worker communication
+    Log::release_id("worker_" + to_string(rank));
+}
+
 // void stop(int rank) {
 //     std::cout<<"RANK: " << rank <<" -- AAAA:: XXXXXXXXXXXXXXXXXXXX\n";
 //     MPI_Barrier(MPI_COMM_WORLD);
@@ -226,7 +502,10 @@ void worker(int rank) {
 
 int main(int argc, char** argv) {
     std::cout << "starting up!" << std::endl;
-    MPI_Init(&argc, &argv);
+    //only the thread which calls main makes MPI calls, including in the
+    //hybrid worker which trains genomes on other threads
+    int thread_support;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
     std::cout << "did mpi init!" << std::endl;
 
     int rank, max_rank;
@@ -249,28 +528,48 @@ int main(int argc, char** argv) {
 
     TimeSeriesSets *time_series_sets = NULL;
 
+    int32_t time_offset = 1;
+    get_argument(arguments, "--time_offset", true, time_offset);
+
+    bool shared_memory_broadcast = argument_exists(arguments, "--shared_memory_broadcast");
+
+    vector<string> input_parameter_names;
+    vector<string> output_parameter_names;
+
     if (rank == 0) {
-        //only have the master process print TSS info
+        //only the master process reads and normalizes the time series, the
+        //workers receive the exported series from it
         time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
         if (argument_exists(arguments, "--write_time_series")) {
             string base_filename;
             get_argument(arguments, "--write_time_series", true, base_filename);
             time_series_sets->write_time_series_sets(base_filename);
         }
-    } else {
-        time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    }
 
+        time_series_sets->export_training_series(time_offset, training_inputs, training_outputs);
+        time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
 
+        input_parameter_names = time_series_sets->get_input_parameter_names();
+        output_parameter_names = time_series_sets->get_output_parameter_names();
+    }
 
-    int32_t time_offset = 1;
-    get_argument(arguments, "--time_offset", true, time_offset);
+    broadcast_strings(input_parameter_names, 0, MPI_COMM_WORLD);
+    broadcast_strings(output_parameter_names, 0, MPI_COMM_WORLD);
 
-    time_series_sets->export_training_series(time_offset, training_inputs, training_outputs);
-    time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
+    vector< vector< vector<double> > > *series[4] = { &training_inputs, &training_outputs, &validation_inputs, &validation_outputs };
+    DatasetView *series_views[4] = { &training_input_view, &training_output_view, &validation_input_view, &validation_output_view };
+    for (int32_t i = 0; i < 4; i++) {
+        if (shared_memory_broadcast) {
+            shared_series[i].broadcast(*series[i], 0, MPI_COMM_WORLD);
+            *series_views[i] = shared_series[i].get_view();
+        } else {
+            broadcast_series(*series[i], 0, MPI_COMM_WORLD);
+            *series_views[i] = DatasetView(*series[i]);
+        }
+    }
 
-    int number_inputs = time_series_sets->get_number_inputs();
-    int number_outputs = time_series_sets->get_number_outputs();
+    int number_inputs = input_parameter_names.size();
+    int number_outputs = output_parameter_names.size();
 
     LOG_DEBUG("number_inputs: %d, number_outputs: %d\n", number_inputs, number_outputs);
 
@@ -372,13 +671,25 @@ int main(int argc, char** argv) {
 
         bool epigenetic_weights = argument_exists(arguments, "--epigenetic_weights");
 
-        seed_genome->transfer_to(time_series_sets->get_input_parameter_names(), time_series_sets->get_output_parameter_names(), transfer_learning_version, epigenetic_weights, min_recurrent_depth, max_recurrent_depth);
+        seed_genome->transfer_to(input_parameter_names, output_parameter_names, transfer_learning_version, epigenetic_weights, min_recurrent_depth, max_recurrent_depth);
     }
 
 
     bool start_filled = false;
     get_argument(arguments, "--start_filled", false, start_filled);
 
+    int32_t threads_per_rank = 1;
+    get_argument(arguments, "--threads_per_rank", false, threads_per_rank);
+
+    int32_t ready_queue_size = 0;
+    get_argument(arguments, "--ready_queue_size", false, ready_queue_size);
+
+    int32_t speculative_queue_size = 0;
+    get_argument(arguments, "--speculative_queue_size", false, speculative_queue_size);
+
+    int32_t max_speculative_staleness = -1;
+    get_argument(arguments, "--max_speculative_staleness", false, max_speculative_staleness);
+
     Log::clear_rank_restriction();
 
     if (rank == 0) {
@@ -409,7 +720,18 @@ int main(int argc, char** argv) {
             examm->set_possible_node_types(possible_node_types);
         }
 
-        master(max_rank);
+        if (speculative_queue_size > 0) {
+            speculative_generator = new SpeculativeGenerator(examm, examm_mutex, speculative_queue_size, max_speculative_staleness);
+        }
+
+        master(max_rank, ready_queue_size, threads_per_rank);
+
+        if (speculative_generator != NULL) {
+            speculative_generator->print_statistics();
+            delete speculative_generator;
+        }
+    } else if (threads_per_rank > 1) {
+        hybrid_worker(rank, threads_per_rank);
     } else {
         worker(rank);
     }
@@ -420,6 +742,10 @@ int main(int argc, char** argv) {
     LOG_DEBUG("rank %d completed!\n");
     Log::release_id("main_" + to_string(rank));
 
+    for (int32_t i = 0; i < 4; i++) {
+        shared_series[i].free();
+    }
+
     MPI_Finalize();
     delete time_series_sets;
 
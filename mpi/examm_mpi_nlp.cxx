@@ -26,6 +26,8 @@ using std::vector;
 
 #include "word_series/word_series.hxx"
 
+#include "series_broadcast.hxx"
+
 #define WORK_REQUEST_TAG 1
 #define GENOME_LENGTH_TAG 2
 #define GENOME_TAG 3
@@ -39,10 +41,15 @@ EXAMM *examm;
 
 bool finished = false;
 
-vector< vector< vector<double> > > training_inputs;
-vector< vector< vector<double> > > training_outputs;
-vector< vector< vector<double> > > validation_inputs;
-vector< vector< vector<double> > > validation_outputs;
+//the workers receive genomes without their softmax settings
+int32_t softmax_samples = 0;
+vector<int32_t> word_classes;
+
+//one hot views of the words in the corpus (which is never deleted before the workers finish), not copies
+DatasetView training_inputs;
+DatasetView training_outputs;
+DatasetView validation_inputs;
+DatasetView validation_outputs;
 
 void send_work_request(int target) {
     int work_request_message[1];
@@ -199,6 +206,8 @@ void worker(int rank) {
             string log_id = "genome_" + to_string(genome->get_generation_id()) + "_worker_" + to_string(rank);
             Log::set_id(log_id);
 
+            genome->set_softmax_samples(softmax_samples);
+            genome->set_word_classes(word_classes);
             genome->backpropagate(training_inputs, training_outputs, validation_inputs, validation_outputs);
             //genome->backpropagate_stochastic(training_inputs, training_outputs, validation_inputs, validation_outputs);
 
@@ -244,30 +253,71 @@ int main(int argc, char** argv) {
 
     Corpus* corpus_sets = NULL;
 
+    int32_t word_offset = 1;
+    get_argument(arguments, "--word_offset", true, word_offset);
+
+    get_argument(arguments, "--softmax_samples", false, softmax_samples);
+
+    int32_t softmax_classes = 0;
+    get_argument(arguments, "--softmax_classes", false, softmax_classes);
+
+    if (softmax_samples > 0 && softmax_classes > 0) {
+        LOG_FATAL("ERROR: only one of '--softmax_samples' and '--softmax_classes' can be used.\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    vector<string> input_parameter_names;
+    vector<string> output_parameter_names;
+
+    vector<string> training_filenames;
+    vector<string> test_filenames;
+    vector< vector<int32_t> > training_tokens;
+    vector< vector<int32_t> > test_tokens;
+
     if (rank == 0) {
-        //only have the master process print TSS info
+        //only the master process reads the corpus, the workers receive the
+        //tokens of its files and make their own corpus from them
         corpus_sets = Corpus::generate_from_arguments(arguments);
         if (argument_exists(arguments, "--write_word_series")) {
             string base_filename;
             get_argument(arguments, "--write_word_series", true, base_filename);
             corpus_sets->write_sentence_series_sets(base_filename);
         }
-    } else {
-        corpus_sets = Corpus::generate_from_arguments(arguments);
+
+        input_parameter_names = corpus_sets->get_input_parameter_names();
+        corpus_sets->get_training_tokens(training_filenames, training_tokens);
+        corpus_sets->get_test_tokens(test_filenames, test_tokens);
     }
 
+    broadcast_strings(input_parameter_names, 0, MPI_COMM_WORLD);
+    broadcast_strings(training_filenames, 0, MPI_COMM_WORLD);
+    broadcast_strings(test_filenames, 0, MPI_COMM_WORLD);
 
+    broadcast_tokens(training_tokens, 0, MPI_COMM_WORLD);
+    broadcast_tokens(test_tokens, 0, MPI_COMM_WORLD);
 
-    int32_t word_offset = 1;
-    get_argument(arguments, "--word_offset", true, word_offset);
+    if (rank != 0) {
+        corpus_sets = Corpus::generate_from_tokens(input_parameter_names, training_filenames, training_tokens, test_filenames, test_tokens);
+    }
+
+    //the corpus has its own copy of the tokens
+    vector< vector<int32_t> >().swap(training_tokens);
+    vector< vector<int32_t> >().swap(test_tokens);
+
+    //every process has the same training tokens, so they all get the same
+    //classes, which need to be added before the outputs are exported
+    if (softmax_classes > 0) corpus_sets->set_word_classes(softmax_classes);
+    word_classes = corpus_sets->get_word_classes();
 
-    corpus_sets->export_training_series(word_offset,training_inputs,training_outputs);
-    corpus_sets->export_test_series(word_offset,validation_inputs,validation_outputs);
+    corpus_sets->export_training_series(word_offset, training_inputs, training_outputs);
+    corpus_sets->export_test_series(word_offset, validation_inputs, validation_outputs);
+
+    output_parameter_names = corpus_sets->get_output_parameter_names();
 
     LOG_INFO("exported word series.\n");
 
-    int number_inputs = corpus_sets->get_number_inputs();
-    int number_outputs = corpus_sets->get_number_outputs();
+    int number_inputs = input_parameter_names.size();
+    int number_outputs = output_parameter_names.size();
 
     LOG_INFO("number_inputs: %d, number_outputs: %d\n", number_inputs, number_outputs);
 
@@ -371,7 +421,7 @@ int main(int argc, char** argv) {
 
         bool epigenetic_weights = argument_exists(arguments, "--epigenetic_weights");
 
-        seed_genome->transfer_to(corpus_sets->get_input_parameter_names(), corpus_sets->get_output_parameter_names(), transfer_learning_version, epigenetic_weights, min_recurrent_depth, max_recurrent_depth);
+        seed_genome->transfer_to(input_parameter_names, output_parameter_names, transfer_learning_version, epigenetic_weights, min_recurrent_depth, max_recurrent_depth);
     }
 
 
@@ -408,6 +458,9 @@ int main(int argc, char** argv) {
             examm->set_possible_node_types(possible_node_types);
         }
 
+        examm->set_softmax_samples(softmax_samples);
+        examm->set_word_classes(word_classes);
+
         master(max_rank);
     } else {
         worker(rank);
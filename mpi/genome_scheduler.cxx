@@ -0,0 +1,158 @@
+#include <cmath>
+using std::fabs;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+
+#include "rnn/rnn_genome.hxx"
+#include "rnn/rnn_node_interface.hxx"
+
+#include "genome_scheduler.hxx"
+
+//node types go up to the random DAG node, which is past NUMBER_NODE_TYPES
+#define NUMBER_COST_NODE_TYPES (RANDOM_DAG_NODE + 1)
+
+/**
+ * Prior estimates of the milliseconds spent per node of each type per time
+ * step (forward and backward pass), beyond the cost of their weights.  Gated
+ * nodes do considerably more work per time step than simple ones.
+ */
+static const double NODE_TYPE_COST_PRIORS[NUMBER_COST_NODE_TYPES] = {
+    2e-5,   //simple
+    2e-5,   //jordan
+    2e-5,   //elman
+    5e-5,   //UGRNN
+    5e-5,   //MGU
+    8e-5,   //GRU
+    8e-5,   //delta
+    1e-4,   //LSTM
+    1.5e-4, //ENARC
+    1.5e-4, //ENAS_DAG
+    1.5e-4  //random DAG
+};
+
+static const double WEIGHT_COST_PRIOR = 5e-6;
+
+GenomeCostModel::GenomeCostModel(int64_t _total_series_length) : total_series_length(_total_series_length), calibration_rate(0.5), number_updates(0), total_relative_error(0.0) {
+    coefficients.push_back(WEIGHT_COST_PRIOR);
+    for (int32_t i = 0; i < NUMBER_COST_NODE_TYPES; i++) {
+        coefficients.push_back(NODE_TYPE_COST_PRIORS[i]);
+    }
+}
+
+void GenomeCostModel::get_features(RNN_Genome *genome, vector<double> &features) {
+    double steps = (double)total_series_length * genome->get_bp_iterations();
+
+    features.clear();
+    features.push_back(steps * genome->get_number_weights());
+    for (int32_t i = 0; i < NUMBER_COST_NODE_TYPES; i++) {
+        features.push_back(steps * genome->get_enabled_node_count(i));
+    }
+}
+
+double GenomeCostModel::estimate(RNN_Genome *genome) {
+    vector<double> features;
+    get_features(genome, features);
+
+    double estimate = 0.0;
+    for (int32_t i = 0; i < (int32_t)features.size(); i++) {
+        estimate += coefficients[i] * features[i];
+    }
+
+    return estimate;
+}
+
+void GenomeCostModel::update(RNN_Genome *genome, double measured_milliseconds) {
+    if (measured_milliseconds <= 0) return;
+
+    vector<double> features;
+    get_features(genome, features);
+
+    double estimate = 0.0;
+    double norm = 0.0;
+    for (int32_t i = 0; i < (int32_t)features.size(); i++) {
+        estimate += coefficients[i] * features[i];
+        norm += features[i] * features[i];
+    }
+    if (norm == 0.0) return;
+
+    double error = measured_milliseconds - estimate;
+    for (int32_t i = 0; i < (int32_t)features.size(); i++) {
+        coefficients[i] += calibration_rate * error * features[i] / norm;
+
+        //a component can never make training faster
+        if (coefficients[i] < 0.0) coefficients[i] = 0.0;
+    }
+
+    number_updates++;
+    total_relative_error += fabs(estimate - measured_milliseconds) / measured_milliseconds;
+
+    LOG_DEBUG("genome %d estimated training time: %lf ms, measured: %lf ms, average relative error: %lf\n", genome->get_generation_id(), estimate, measured_milliseconds, get_average_relative_error());
+}
+
+int32_t GenomeCostModel::get_number_updates() const {
+    return number_updates;
+}
+
+double GenomeCostModel::get_average_relative_error() const {
+    if (number_updates == 0) return 0.0;
+    return total_relative_error / number_updates;
+}
+
+GenomeScheduler::GenomeScheduler(int64_t total_series_length, int32_t _ready_queue_size) : cost_model(total_series_length), ready_queue_size(_ready_queue_size) {
+}
+
+GenomeScheduler::~GenomeScheduler() {
+    clear();
+}
+
+bool GenomeScheduler::needs_genomes(int32_t number_requested) const {
+    return (int32_t)ready_genomes.size() < ready_queue_size + number_requested;
+}
+
+void GenomeScheduler::add_genome(RNN_Genome *genome) {
+    ready_genomes.push_back(genome);
+    ready_estimates.push_back(cost_model.estimate(genome));
+}
+
+RNN_Genome* GenomeScheduler::next_genome(bool prefer_small) {
+    if (ready_genomes.size() == 0) return NULL;
+
+    int32_t selected = 0;
+    for (int32_t i = 1; i < (int32_t)ready_genomes.size(); i++) {
+        if (prefer_small ? (ready_estimates[i] < ready_estimates[selected]) : (ready_estimates[i] > ready_estimates[selected])) {
+            selected = i;
+        }
+    }
+
+    RNN_Genome *genome = ready_genomes[selected];
+    LOG_DEBUG("scheduling genome %d with estimated training time: %lf ms (%s first, %d genomes ready)\n", genome->get_generation_id(), ready_estimates[selected], prefer_small ? "smallest" : "largest", ready_genomes.size());
+
+    ready_genomes.erase(ready_genomes.begin() + selected);
+    ready_estimates.erase(ready_estimates.begin() + selected);
+
+    return genome;
+}
+
+void GenomeScheduler::genome_trained(RNN_Genome *genome, double training_milliseconds) {
+    cost_model.update(genome, training_milliseconds);
+
+    //the estimates of the genomes still waiting were made with the old coefficients
+    for (int32_t i = 0; i < (int32_t)ready_genomes.size(); i++) {
+        ready_estimates[i] = cost_model.estimate(ready_genomes[i]);
+    }
+}
+
+void GenomeScheduler::clear() {
+    for (int32_t i = 0; i < (int32_t)ready_genomes.size(); i++) {
+        delete ready_genomes[i];
+    }
+    ready_genomes.clear();
+    ready_estimates.clear();
+}
+
+int32_t GenomeScheduler::size() const {
+    return ready_genomes.size();
+}
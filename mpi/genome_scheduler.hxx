@@ -0,0 +1,92 @@
+#ifndef EXAMM_GENOME_SCHEDULER_HXX
+#define EXAMM_GENOME_SCHEDULER_HXX
+
+#include <vector>
+using std::vector;
+
+#include "rnn/rnn_genome.hxx"
+
+/**
+ * Estimates how many milliseconds a worker will take to train a genome.
+ *
+ * Training time scales with the number of time steps each backpropagation
+ * iteration has to run over, so each genome is described by its number of
+ * weights and its number of enabled hidden nodes of each node type, all
+ * multiplied by the total series length times the genome's number of
+ * backpropagation iterations.  The per-weight and per-node type costs start
+ * from rough priors and are calibrated online (with normalized least mean
+ * squares) from the training times the workers report back.
+ */
+class GenomeCostModel {
+    private:
+        int64_t total_series_length; /**< the total number of time steps over all training series. */
+
+        vector<double> coefficients; /**< estimated milliseconds per weight, followed by milliseconds per node of each node type. */
+        double calibration_rate; /**< how quickly the coefficients move towards the measured training times. */
+
+        int32_t number_updates;
+        double total_relative_error; /**< the sum of |estimate - measured| / measured, used to report how good the estimates are. */
+
+        void get_features(RNN_Genome *genome, vector<double> &features);
+
+    public:
+        GenomeCostModel(int64_t _total_series_length);
+
+        double estimate(RNN_Genome *genome);
+        void update(RNN_Genome *genome, double measured_milliseconds);
+
+        int32_t get_number_updates() const;
+        double get_average_relative_error() const;
+};
+
+/**
+ * Holds a small ready queue of generated genomes for the MPI master.  Normally
+ * the most expensive genome in the queue is handed out first, so long running
+ * genomes are not left to the end of the search; once the search gets close to
+ * max_genomes the cheapest genomes are handed out first instead so that the
+ * last few work requests finish quickly and workers are not left idle waiting
+ * on stragglers.
+ */
+class GenomeScheduler {
+    private:
+        GenomeCostModel cost_model;
+
+        int32_t ready_queue_size; /**< how many genomes to keep generated beyond what has been requested. */
+
+        vector<RNN_Genome*> ready_genomes;
+        vector<double> ready_estimates;
+
+    public:
+        GenomeScheduler(int64_t total_series_length, int32_t _ready_queue_size);
+        ~GenomeScheduler();
+
+        /**
+         * Returns true if more genomes should be generated and added before
+         * handing out number_requested genomes.
+         */
+        bool needs_genomes(int32_t number_requested) const;
+
+        void add_genome(RNN_Genome *genome);
+
+        /**
+         * Removes and returns the most expensive genome in the ready queue, or
+         * the cheapest if prefer_small is true.  Returns NULL if the queue is empty.
+         */
+        RNN_Genome* next_genome(bool prefer_small);
+
+        /**
+         * Updates the cost model with the time a worker reported it took to train
+         * the genome.
+         */
+        void genome_trained(RNN_Genome *genome, double training_milliseconds);
+
+        /**
+         * Deletes any genomes left in the ready queue, used when the search has
+         * completed and they will never be trained.
+         */
+        void clear();
+
+        int32_t size() const;
+};
+
+#endif
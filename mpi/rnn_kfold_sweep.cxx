@@ -50,6 +50,8 @@ typedef struct stat Stat;
 
 #include "time_series/time_series.hxx"
 
+#include "series_broadcast.hxx"
+
 #define WORK_REQUEST_TAG 1
 #define JOB_TAG 2
 #define TERMINATE_TAG 3
@@ -79,6 +81,21 @@ vector<string> rnn_types({
 
 TimeSeriesSets* time_series_sets = NULL;
 
+int32_t number_series = 0;
+vector<string> input_parameter_names;
+vector<string> output_parameter_names;
+
+//every series of the time series sets, exported once by the master and broadcast
+//to the workers which select the training and test folds from them per job
+vector< vector< vector<double> > > series_inputs;
+vector< vector< vector<double> > > series_outputs;
+
+//views of the series above, or (with --shared_memory_broadcast) of the copy
+//of them every process on a node shares
+SharedSeries shared_inputs, shared_outputs;
+DatasetView series_input_view;
+DatasetView series_output_view;
+
 
 struct ResultSet {
     int job;
@@ -229,11 +246,11 @@ void master(int max_rank) {
     }
 
     //initialize the results with -1 as the job so we can determine if a particular rnn type has completed
-    results = vector<ResultSet>(rnn_types.size() * time_series_sets->get_number_series() * repeats, {-1, 0.0, 0.0, 0.0, 0.0, 0});
+    results = vector<ResultSet>(rnn_types.size() * number_series * repeats, {-1, 0.0, 0.0, 0.0, 0.0, 0});
 
     int terminates_sent = 0;
     int current_job = 0;
-    int last_job = rnn_types.size() * (time_series_sets->get_number_series() / fold_size) * repeats;
+    int last_job = rnn_types.size() * (number_series / fold_size) * repeats;
 
     while (true) {
         //wait for a incoming message
@@ -275,7 +292,7 @@ void master(int max_rank) {
             //TODO:
             //check and see if this particular set of jobs for rnn_type has completed,
             //then write the file for that type if it has
-            int32_t jobs_per_rnn = (time_series_sets->get_number_series() / fold_size) * repeats;
+            int32_t jobs_per_rnn = (number_series / fold_size) * repeats;
 
             //get the particular rnn type this job was for, and which results should be there
             int32_t rnn = result.job / jobs_per_rnn;
@@ -303,7 +320,7 @@ void master(int max_rank) {
                 ofstream outfile(output_directory + "/combined_" + rnn_types[rnn] + ".csv");
 
                 int32_t current = rnn_job_start;
-                for (int32_t j = 0; j < (time_series_sets->get_number_series() / fold_size); j++) {
+                for (int32_t j = 0; j < (number_series / fold_size); j++) {
                     for (int32_t k = 0; k < repeats; k++) {
 
                         outfile << j << "," << k << "," << results[current].milliseconds << "," << results[current].training_mse << "," << results[current].training_mae << "," << results[current].test_mse << "," << results[current].test_mae << endl;
@@ -324,7 +341,7 @@ void master(int max_rank) {
 }
 
 ResultSet handle_job(int rank, int current_job) {
-    int32_t jobs_per_rnn = (time_series_sets->get_number_series() / fold_size) * repeats;
+    int32_t jobs_per_rnn = (number_series / fold_size) * repeats;
 
     //get rnn_type
     string rnn_type = rnn_types[ current_job / jobs_per_rnn ] ;
@@ -340,7 +357,7 @@ ResultSet handle_job(int rank, int current_job) {
     vector<int> training_indexes;
     vector<int> test_indexes;
 
-    for (uint32_t k = 0; k < time_series_sets->get_number_series(); k += fold_size) {
+    for (int32_t k = 0; k < number_series; k += fold_size) {
         if (j == (k / fold_size)) {
             for (int l = 0; l < fold_size; l++) {
                 test_indexes.push_back(k + l);
@@ -354,22 +371,23 @@ ResultSet handle_job(int rank, int current_job) {
 
     LOG_DEBUG("test_indexes.size(): %d, training_indexes.size(): %d\n", test_indexes.size(), training_indexes.size());
 
-    time_series_sets->set_training_indexes(training_indexes);
-    time_series_sets->set_test_indexes(test_indexes);
+    DatasetView training_inputs;
+    DatasetView training_outputs;
+    DatasetView validation_inputs;
+    DatasetView validation_outputs;
 
-    vector< vector< vector<double> > > training_inputs;
-    vector< vector< vector<double> > > training_outputs;
-    vector< vector< vector<double> > > validation_inputs;
-    vector< vector< vector<double> > > validation_outputs;
-
-    time_series_sets->export_training_series(time_offset, training_inputs, training_outputs);
-    time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
+    for (int32_t k = 0; k < (int32_t)training_indexes.size(); k++) {
+        training_inputs.push_back(series_input_view[training_indexes[k]]);
+        training_outputs.push_back(series_output_view[training_indexes[k]]);
+    }
 
-    vector<string> input_parameter_names = time_series_sets->get_input_parameter_names();
-    vector<string> output_parameter_names = time_series_sets->get_output_parameter_names();
+    for (int32_t k = 0; k < (int32_t)test_indexes.size(); k++) {
+        validation_inputs.push_back(series_input_view[test_indexes[k]]);
+        validation_outputs.push_back(series_output_view[test_indexes[k]]);
+    }
 
-    int number_inputs = time_series_sets->get_number_inputs();
-    //int number_outputs = time_series_sets->get_number_outputs();
+    int number_inputs = input_parameter_names.size();
+    //int number_outputs = output_parameter_names.size();
 
     RNN_Genome *genome = NULL;
     if (rnn_type == "one_layer_lstm") {
@@ -560,11 +578,38 @@ int main(int argc, char **argv) {
     }
 
 
+    bool shared_memory_broadcast = argument_exists(arguments, "--shared_memory_broadcast");
+
     if (rank == 0) {
-        //only print verbose info from the master process
+        //only the master process reads and normalizes the time series, the
+        //workers receive the exported series from it
         time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+
+        number_series = time_series_sets->get_number_series();
+        input_parameter_names = time_series_sets->get_input_parameter_names();
+        output_parameter_names = time_series_sets->get_output_parameter_names();
+
+        vector<int> series_indexes;
+        for (int32_t i = 0; i < number_series; i++) {
+            series_indexes.push_back(i);
+        }
+        time_series_sets->export_time_series(series_indexes, time_offset, series_inputs, series_outputs);
+    }
+
+    MPI_Bcast(&number_series, 1, MPI_INT32_T, 0, MPI_COMM_WORLD);
+    broadcast_strings(input_parameter_names, 0, MPI_COMM_WORLD);
+    broadcast_strings(output_parameter_names, 0, MPI_COMM_WORLD);
+
+    if (shared_memory_broadcast) {
+        shared_inputs.broadcast(series_inputs, 0, MPI_COMM_WORLD);
+        shared_outputs.broadcast(series_outputs, 0, MPI_COMM_WORLD);
+        series_input_view = shared_inputs.get_view();
+        series_output_view = shared_outputs.get_view();
     } else {
-        time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+        broadcast_series(series_inputs, 0, MPI_COMM_WORLD);
+        broadcast_series(series_outputs, 0, MPI_COMM_WORLD);
+        series_input_view = DatasetView(series_inputs);
+        series_output_view = DatasetView(series_outputs);
     }
 
     //MPI_Barrier(MPI_COMM_WORLD);
@@ -578,5 +623,8 @@ int main(int argc, char **argv) {
     }
 
     Log::release_id("main_" + to_string(rank));
+
+    shared_inputs.free();
+    shared_outputs.free();
     MPI_Finalize();
 }
@@ -0,0 +1,283 @@
+#include <cstring>
+using std::memcpy;
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "mpi.h"
+
+#include "common/log.hxx"
+
+#include "series_broadcast.hxx"
+
+//MPI counts are ints, so large buffers need to be sent in chunks
+#define MAX_BROADCAST_COUNT (1 << 30)
+
+void broadcast_chunked(void *buffer, int64_t count, MPI_Datatype type, int type_size, int root, MPI_Comm comm) {
+    char *bytes = (char*)buffer;
+
+    for (int64_t start = 0; start < count; start += MAX_BROADCAST_COUNT) {
+        int64_t chunk = count - start;
+        if (chunk > MAX_BROADCAST_COUNT) chunk = MAX_BROADCAST_COUNT;
+
+        MPI_Bcast(bytes + (start * type_size), (int)chunk, type, root, comm);
+    }
+}
+
+void broadcast_strings(vector<string> &strings, int root, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    //pack the strings into a single '\0' separated character buffer
+    int64_t length = 0;
+    vector<char> packed;
+    if (rank == root) {
+        for (int32_t i = 0; i < (int32_t)strings.size(); i++) {
+            packed.insert(packed.end(), strings[i].begin(), strings[i].end());
+            packed.push_back('\0');
+        }
+        length = packed.size();
+    }
+
+    MPI_Bcast(&length, 1, MPI_INT64_T, root, comm);
+
+    if (rank != root) packed.resize(length);
+    broadcast_chunked(packed.data(), length, MPI_CHAR, sizeof(char), root, comm);
+
+    if (rank != root) {
+        strings.clear();
+
+        int64_t start = 0;
+        for (int64_t i = 0; i < length; i++) {
+            if (packed[i] == '\0') {
+                strings.push_back(string(packed.begin() + start, packed.begin() + i));
+                start = i + 1;
+            }
+        }
+    }
+}
+
+/**
+ * The shape header is the number of series followed by the number of
+ * parameters and number of time steps of each series.
+ */
+void get_series_shape(const vector< vector< vector<double> > > &series, vector<int64_t> &shape, int64_t &number_values) {
+    shape.clear();
+    shape.push_back(series.size());
+
+    number_values = 0;
+    for (int32_t i = 0; i < (int32_t)series.size(); i++) {
+        int64_t number_parameters = series[i].size();
+        int64_t number_steps = number_parameters > 0 ? series[i][0].size() : 0;
+
+        for (int32_t j = 0; j < number_parameters; j++) {
+            if ((int64_t)series[i][j].size() != number_steps) {
+                LOG_FATAL("ERROR: cannot broadcast series %d, parameter %d had %d time steps but parameter 0 had %d\n", i, j, series[i][j].size(), number_steps);
+                exit(1);
+            }
+        }
+
+        shape.push_back(number_parameters);
+        shape.push_back(number_steps);
+
+        number_values += number_parameters * number_steps;
+    }
+}
+
+void pack_series(const vector< vector< vector<double> > > &series, double *packed) {
+    int64_t current = 0;
+    for (int32_t i = 0; i < (int32_t)series.size(); i++) {
+        for (int32_t j = 0; j < (int32_t)series[i].size(); j++) {
+            memcpy(packed + current, series[i][j].data(), series[i][j].size() * sizeof(double));
+            current += series[i][j].size();
+        }
+    }
+}
+
+void unpack_series(const vector<int64_t> &shape, const double *packed, vector< vector< vector<double> > > &series) {
+    series.clear();
+    series.resize(shape[0]);
+
+    int64_t current = 0;
+    for (int32_t i = 0; i < (int32_t)series.size(); i++) {
+        int64_t number_parameters = shape[1 + (i * 2)];
+        int64_t number_steps = shape[2 + (i * 2)];
+
+        series[i].resize(number_parameters);
+        for (int32_t j = 0; j < number_parameters; j++) {
+            series[i][j].assign(packed + current, packed + current + number_steps);
+            current += number_steps;
+        }
+    }
+}
+
+/**
+ * Broadcasts the shape header of the root's series (see get_series_shape),
+ * and the total number of values in them.
+ */
+void broadcast_series_shape(const vector< vector< vector<double> > > &series, int root, MPI_Comm comm, vector<int64_t> &shape, int64_t &number_values) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    int64_t shape_length = 0;
+    number_values = 0;
+
+    if (rank == root) {
+        get_series_shape(series, shape, number_values);
+        shape_length = shape.size();
+    }
+
+    MPI_Bcast(&shape_length, 1, MPI_INT64_T, root, comm);
+    MPI_Bcast(&number_values, 1, MPI_INT64_T, root, comm);
+    if (rank != root) shape.resize(shape_length);
+    broadcast_chunked(shape.data(), shape_length, MPI_INT64_T, sizeof(int64_t), root, comm);
+
+    LOG_DEBUG("broadcasting %ld series with %ld total values\n", shape[0], number_values);
+}
+
+void broadcast_series(vector< vector< vector<double> > > &series, int root, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    vector<int64_t> shape;
+    int64_t number_values;
+    broadcast_series_shape(series, root, comm, shape, number_values);
+
+    vector<double> packed(number_values);
+    if (rank == root) pack_series(series, packed.data());
+
+    broadcast_chunked(packed.data(), number_values, MPI_DOUBLE, sizeof(double), root, comm);
+
+    if (rank != root) unpack_series(shape, packed.data(), series);
+}
+
+SharedSeries::SharedSeries() : node_comm(MPI_COMM_NULL), window(MPI_WIN_NULL) {
+}
+
+void SharedSeries::broadcast(const vector< vector< vector<double> > > &series, int root, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    vector<int64_t> shape;
+    int64_t number_values;
+    broadcast_series_shape(series, root, comm, shape, number_values);
+
+    //group the processes by node, making sure the root process is rank 0 on
+    //its node and in the communicator of node leaders
+    int key = (rank == root) ? 0 : 1;
+
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, key, MPI_INFO_NULL, &node_comm);
+
+    int node_rank;
+    MPI_Comm_rank(node_comm, &node_rank);
+
+    MPI_Comm leader_comm;
+    MPI_Comm_split(comm, node_rank == 0 ? 0 : MPI_UNDEFINED, key, &leader_comm);
+
+    //only the node leader allocates memory for the window, the other processes
+    //on the node query its address
+    MPI_Aint window_size = (node_rank == 0) ? number_values * sizeof(double) : 0;
+    double *packed = NULL;
+    MPI_Win_allocate_shared(window_size, sizeof(double), MPI_INFO_NULL, node_comm, &packed, &window);
+
+    if (node_rank != 0) {
+        MPI_Aint leader_size;
+        int displacement_unit;
+        MPI_Win_shared_query(window, 0, &leader_size, &displacement_unit, &packed);
+    }
+
+    //the window stays locked for as long as it is read, so MPI_Win_sync can
+    //make the leader's writes visible to the other processes on the node
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+
+    if (node_rank == 0) {
+        if (rank == root) pack_series(series, packed);
+        broadcast_chunked(packed, number_values, MPI_DOUBLE, sizeof(double), 0, leader_comm);
+        MPI_Comm_free(&leader_comm);
+    }
+
+    MPI_Win_sync(window);
+    MPI_Barrier(node_comm);
+    MPI_Win_sync(window);
+
+    view.clear();
+    int64_t current = 0;
+    for (int32_t i = 0; i < (int32_t)shape[0]; i++) {
+        int64_t number_parameters = shape[1 + (i * 2)];
+        int64_t number_steps = shape[2 + (i * 2)];
+
+        SeriesView series_view;
+        for (int32_t j = 0; j < number_parameters; j++) {
+            series_view.add_field(packed + current, number_steps);
+            current += number_steps;
+        }
+        view.push_back(series_view);
+    }
+}
+
+const DatasetView& SharedSeries::get_view() const {
+    return view;
+}
+
+void SharedSeries::free() {
+    if (window == MPI_WIN_NULL) return;
+
+    view.clear();
+
+    //make sure everyone on the node has finished reading before the window is freed
+    MPI_Win_unlock_all(window);
+    MPI_Barrier(node_comm);
+    MPI_Win_free(&window);
+    MPI_Comm_free(&node_comm);
+}
+
+void broadcast_tokens(vector< vector<int32_t> > &tokens, int root, MPI_Comm comm) {
+    int rank;
+    MPI_Comm_rank(comm, &rank);
+
+    //the number of series followed by the number of tokens in each
+    vector<int64_t> shape;
+    int64_t number_tokens = 0;
+    int64_t shape_length = 0;
+
+    if (rank == root) {
+        shape.push_back(tokens.size());
+        for (int32_t i = 0; i < (int32_t)tokens.size(); i++) {
+            shape.push_back(tokens[i].size());
+            number_tokens += tokens[i].size();
+        }
+        shape_length = shape.size();
+    }
+
+    MPI_Bcast(&shape_length, 1, MPI_INT64_T, root, comm);
+    MPI_Bcast(&number_tokens, 1, MPI_INT64_T, root, comm);
+    if (rank != root) shape.resize(shape_length);
+    broadcast_chunked(shape.data(), shape_length, MPI_INT64_T, sizeof(int64_t), root, comm);
+
+    LOG_DEBUG("broadcasting %ld token series with %ld total tokens\n", shape[0], number_tokens);
+
+    vector<int32_t> packed(number_tokens);
+    if (rank == root) {
+        int64_t current = 0;
+        for (int32_t i = 0; i < (int32_t)tokens.size(); i++) {
+            memcpy(packed.data() + current, tokens[i].data(), tokens[i].size() * sizeof(int32_t));
+            current += tokens[i].size();
+        }
+    }
+
+    broadcast_chunked(packed.data(), number_tokens, MPI_INT32_T, sizeof(int32_t), root, comm);
+
+    if (rank != root) {
+        tokens.clear();
+        tokens.resize(shape[0]);
+
+        int64_t current = 0;
+        for (int32_t i = 0; i < (int32_t)tokens.size(); i++) {
+            tokens[i].assign(packed.begin() + current, packed.begin() + current + shape[1 + i]);
+            current += shape[1 + i];
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef EXAMM_SERIES_BROADCAST_HXX
+#define EXAMM_SERIES_BROADCAST_HXX
+
+#include <string>
+using std::string;
+
+#include <vector>
+using std::vector;
+
+#include "mpi.h"
+
+#include "time_series/series_view.hxx"
+
+/**
+ * Broadcasts a vector of strings (e.g., parameter names) from the root process
+ * to all other processes in the communicator.
+ */
+void broadcast_strings(vector<string> &strings, int root, MPI_Comm comm);
+
+/**
+ * Broadcasts a set of series (series x parameter x time step) from the root
+ * process to all other processes in the communicator.
+ *
+ * The root packs the series into a single contiguous buffer (a small shape
+ * header followed by the values) so the data goes out in as few MPI_Bcast
+ * calls as possible; every other rank unpacks it into the series vector.
+ */
+void broadcast_series(vector< vector< vector<double> > > &series, int root, MPI_Comm comm);
+
+/**
+ * A set of series broadcast into an MPI-3 shared memory window, so there is
+ * one copy of it per node instead of one per process.  Only one process per
+ * node receives the series over the network, and every process on the node
+ * reads them in place through its view.
+ */
+class SharedSeries {
+    private:
+        MPI_Comm node_comm;
+        MPI_Win window;
+        DatasetView view;
+
+    public:
+        SharedSeries();
+
+        /**
+         * Broadcasts the root process's series into the shared memory window
+         * of every node, which is collective over the communicator.
+         */
+        void broadcast(const vector< vector< vector<double> > > &series, int root, MPI_Comm comm);
+
+        /**
+         * A view of the series in the window, which is valid until free is
+         * called.
+         */
+        const DatasetView& get_view() const;
+
+        /**
+         * Frees the window, which is collective over the processes on each
+         * node, so it needs to be called by all of them before MPI_Finalize.
+         */
+        void free();
+};
+
+/**
+ * Broadcasts the tokens of a set of word series (series x position) from the
+ * root process to all other processes in the communicator.  These are only
+ * one integer per word (not one double per vocabulary word), so they are
+ * always sent to every process.
+ */
+void broadcast_tokens(vector< vector<int32_t> > &tokens, int root, MPI_Comm comm);
+
+#endif
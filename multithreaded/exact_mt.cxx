@@ -28,6 +28,7 @@ using std::vector;
 #include "image_tools/image_set.hxx"
 
 #include "cnn/exact.hxx"
+#include "cnn/cnn_options.hxx"
 
 mutex exact_mutex;
 
@@ -64,6 +65,7 @@ void exact_thread(const Images &training_images, const Images &validation_images
 
 int main(int argc, char** argv) {
     arguments = vector<string>(argv, argv + argc);
+    set_cnn_options(arguments);
 
     int number_threads;
     get_argument(arguments, "--number_threads", true, number_threads);
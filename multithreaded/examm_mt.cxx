@@ -6,6 +6,9 @@ using std::condition_variable;
 #include <iomanip>
 using std::setw;
 
+#include <map>
+using std::map;
+
 #include <mutex>
 using std::mutex;
 
@@ -22,8 +25,10 @@ using std::vector;
 #include "common/log.hxx"
 
 #include "rnn/examm.hxx"
+#include "rnn/speculative_generator.hxx"
 
 #include "time_series/time_series.hxx"
+#include "time_series/time_series_stream.hxx"
 
 
 mutex examm_mutex;
@@ -32,30 +37,47 @@ vector<string> arguments;
 
 EXAMM *examm;
 
+SpeculativeGenerator *speculative_generator = NULL;
 
 bool finished = false;
 
 
-vector< vector< vector<double> > > training_inputs;
-vector< vector< vector<double> > > training_outputs;
-vector< vector< vector<double> > > validation_inputs;
-vector< vector< vector<double> > > validation_outputs;
+//views of the columns loaded by the time series sets (which are never deleted), not copies
+DatasetView training_inputs;
+DatasetView training_outputs;
+DatasetView validation_inputs;
+DatasetView validation_outputs;
+
+//set instead of the views above when training on windows streamed from files too large to load
+TimeSeriesStream *time_series_stream = NULL;
 
 
 void examm_thread(int id) {
 
     while (true) {
-        examm_mutex.lock();
-        Log::set_id("main");
-        RNN_Genome *genome = examm->generate_genome();
-        examm_mutex.unlock();
+        RNN_Genome *genome = NULL;
+        if (speculative_generator != NULL) {
+            genome = speculative_generator->get_genome();
+        } else {
+            examm_mutex.lock();
+            Log::set_id("main");
+            genome = examm->generate_genome();
+            examm_mutex.unlock();
+        }
 
         if (genome == NULL) break;  //generate_individual returns NULL when the search is done
 
         string log_id = "genome_" + to_string(genome->get_generation_id()) + "_thread_" + to_string(id);
         Log::set_id(log_id);
-        //genome->backpropagate(training_inputs, training_outputs, validation_inputs, validation_outputs);
-        genome->backpropagate_stochastic(training_inputs, training_outputs, validation_inputs, validation_outputs);
+        if (time_series_stream != NULL) {
+            TimeSeriesWindows *training_windows = time_series_stream->next_training_windows();
+            const TimeSeriesWindows *validation_windows = time_series_stream->get_validation_windows();
+            genome->backpropagate_stochastic(training_windows->inputs, training_windows->outputs, validation_windows->inputs, validation_windows->outputs);
+            delete training_windows;
+        } else {
+            //genome->backpropagate(training_inputs, training_outputs, validation_inputs, validation_outputs);
+            genome->backpropagate_stochastic(training_inputs, training_outputs, validation_inputs, validation_outputs);
+        }
         Log::release_id(log_id);
 
         examm_mutex.lock();
@@ -92,17 +114,46 @@ int main(int argc, char** argv) {
     int32_t time_offset = 1;
     get_argument(arguments, "--time_offset", true, time_offset);
 
-    TimeSeriesSets* time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
-    vector<string> inputs_removed_tokens;
-    vector<string> outputs_removed_tokens;
-
-    time_series_sets->export_training_series(time_offset, training_inputs, training_outputs);
-    time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
-
-    LOG_INFO("exported time series.\n");
+    vector<string> input_parameter_names;
+    vector<string> output_parameter_names;
+    string normalize_type;
+    map<string,double> normalize_mins;
+    map<string,double> normalize_maxs;
+    map<string,double> normalize_avgs;
+    map<string,double> normalize_std_devs;
+
+    if (argument_exists(arguments, "--stream_window_length")) {
+        time_series_stream = TimeSeriesStream::generate_from_arguments(arguments);
+
+        input_parameter_names = time_series_stream->get_input_parameter_names();
+        output_parameter_names = time_series_stream->get_output_parameter_names();
+        normalize_type = time_series_stream->get_normalize_type();
+        normalize_mins = time_series_stream->get_normalize_mins();
+        normalize_maxs = time_series_stream->get_normalize_maxs();
+        normalize_avgs = time_series_stream->get_normalize_avgs();
+        normalize_std_devs = time_series_stream->get_normalize_std_devs();
+
+        LOG_INFO("streaming time series.\n");
+
+    } else {
+        TimeSeriesSets* time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
+
+        time_series_sets->export_training_series(time_offset, training_inputs, training_outputs);
+        time_series_sets->export_test_series(time_offset, validation_inputs, validation_outputs);
+
+        input_parameter_names = time_series_sets->get_input_parameter_names();
+        output_parameter_names = time_series_sets->get_output_parameter_names();
+        normalize_type = time_series_sets->get_normalize_type();
+        normalize_mins = time_series_sets->get_normalize_mins();
+        normalize_maxs = time_series_sets->get_normalize_maxs();
+        normalize_avgs = time_series_sets->get_normalize_avgs();
+        normalize_std_devs = time_series_sets->get_normalize_std_devs();
+
+        LOG_INFO("exported time series.\n");
+    }
 
-    int number_inputs = time_series_sets->get_number_inputs();
-    int number_outputs = time_series_sets->get_number_outputs();
+    int number_inputs = input_parameter_names.size();
+    int number_outputs = output_parameter_names.size();
 
     LOG_INFO("number_inputs: %d, number_outputs: %d\n", number_inputs, number_outputs);
 
@@ -205,7 +256,7 @@ int main(int argc, char** argv) {
 
         bool epigenetic_weights = argument_exists(arguments, "--epigenetic_weights");
 
-        seed_genome->transfer_to(time_series_sets->get_input_parameter_names(), time_series_sets->get_output_parameter_names(), transfer_learning_version, epigenetic_weights, min_recurrent_depth, max_recurrent_depth);
+        seed_genome->transfer_to(input_parameter_names, output_parameter_names, transfer_learning_version, epigenetic_weights, min_recurrent_depth, max_recurrent_depth);
     }
 
     bool start_filled = false;
@@ -218,13 +269,13 @@ int main(int argc, char** argv) {
             speciation_method,
             species_threshold, fitness_threshold,
             neat_c1, neat_c2, neat_c3,
-            time_series_sets->get_input_parameter_names(),
-            time_series_sets->get_output_parameter_names(),
-            time_series_sets->get_normalize_type(),
-            time_series_sets->get_normalize_mins(),
-            time_series_sets->get_normalize_maxs(),
-            time_series_sets->get_normalize_avgs(),
-            time_series_sets->get_normalize_std_devs(),
+            input_parameter_names,
+            output_parameter_names,
+            normalize_type,
+            normalize_mins,
+            normalize_maxs,
+            normalize_avgs,
+            normalize_std_devs,
             weight_initialize, weight_inheritance, mutated_component_weight,
             bp_iterations, learning_rate,
             use_high_threshold, high_threshold,
@@ -240,6 +291,16 @@ int main(int argc, char** argv) {
         examm->set_possible_node_types(possible_node_types);
     }
 
+    int32_t speculative_queue_size = 0;
+    get_argument(arguments, "--speculative_queue_size", false, speculative_queue_size);
+
+    int32_t max_speculative_staleness = -1;
+    get_argument(arguments, "--max_speculative_staleness", false, max_speculative_staleness);
+
+    if (speculative_queue_size > 0) {
+        speculative_generator = new SpeculativeGenerator(examm, examm_mutex, speculative_queue_size, max_speculative_staleness);
+    }
+
     vector<thread> threads;
     for (int32_t i = 0; i < number_threads; i++) {
         threads.push_back( thread(examm_thread, i) );
@@ -249,6 +310,16 @@ int main(int argc, char** argv) {
         threads[i].join();
     }
 
+    if (speculative_generator != NULL) {
+        speculative_generator->print_statistics();
+        delete speculative_generator;
+    }
+
+    if (time_series_stream != NULL) {
+        time_series_stream->print_statistics();
+        delete time_series_stream;
+    }
+
     finished = true;
 
     LOG_INFO("completed!\n");
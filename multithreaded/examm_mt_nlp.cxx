@@ -35,10 +35,11 @@ EXAMM *examm;
 bool finished = false;
 
 
-vector< vector< vector<double> > > training_inputs;
-vector< vector< vector<double> > > training_outputs;
-vector< vector< vector<double> > > validation_inputs;
-vector< vector< vector<double> > > validation_outputs;
+//one hot views of the words in the corpus (which is never deleted), not copies
+DatasetView training_inputs;
+DatasetView training_outputs;
+DatasetView validation_inputs;
+DatasetView validation_outputs;
 
 
 void examm_thread(int id) {
@@ -94,9 +95,23 @@ int main(int argc, char  **argv)
     int32_t word_offset = 1;
     get_argument(arguments,"--word_offset",true,word_offset);
 
+    int32_t softmax_samples = 0;
+    get_argument(arguments, "--softmax_samples", false, softmax_samples);
+
+    int32_t softmax_classes = 0;
+    get_argument(arguments, "--softmax_classes", false, softmax_classes);
+
+    if (softmax_samples > 0 && softmax_classes > 0) {
+        LOG_FATAL("ERROR: only one of '--softmax_samples' and '--softmax_classes' can be used.\n");
+        exit(1);
+    }
+
 
 	Corpus* corpus_sets = Corpus::generate_from_arguments(arguments);
 
+    //the class outputs need to be added before the outputs are exported
+    if (softmax_classes > 0) corpus_sets->set_word_classes(softmax_classes);
+
 	corpus_sets->export_training_series(word_offset,training_inputs,training_outputs);
 	corpus_sets->export_test_series(word_offset,validation_inputs,validation_outputs);
 
@@ -244,6 +259,9 @@ int main(int argc, char  **argv)
         examm->set_possible_node_types(possible_node_types);
     }
 
+    examm->set_softmax_samples(softmax_samples);
+    examm->set_word_classes(corpus_sets->get_word_classes());
+
     vector<thread> threads;
     for (int32_t i = 0; i < number_threads; i++) {
         threads.push_back( thread(examm_thread, i) );
@@ -0,0 +1,225 @@
+#include <cstdlib>
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <fstream>
+using std::ofstream;
+using std::ios;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <utility>
+using std::move;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+
+#include "artifact_writer.hxx"
+
+vector<ArtifactWriter*> ArtifactWriter::writers;
+mutex ArtifactWriter::writers_mutex;
+
+ArtifactWriter::ArtifactWriter(string _output_directory, int32_t _max_queue_size) : output_directory(_output_directory), max_queue_size(_max_queue_size), writing(false), stopping(false), stopped(false) {
+    fitness_log_file = new ofstream(output_directory + "/fitness_log.csv");
+    op_log_file = new ofstream(output_directory + "/op_log.csv");
+
+    {
+        lock_guard<mutex> lock(writers_mutex);
+        static bool registered = false;
+        if (!registered) {
+            atexit(ArtifactWriter::shutdown_all);
+            registered = true;
+        }
+        writers.push_back(this);
+    }
+
+    writer_thread = thread(&ArtifactWriter::write_artifacts, this);
+}
+
+ArtifactWriter::~ArtifactWriter() {
+    shutdown();
+
+    {
+        lock_guard<mutex> lock(writers_mutex);
+        for (auto it = writers.begin(); it != writers.end(); it++) {
+            if (*it == this) {
+                writers.erase(it);
+                break;
+            }
+        }
+    }
+
+    fitness_log_file->close();
+    delete fitness_log_file;
+    op_log_file->close();
+    delete op_log_file;
+}
+
+void ArtifactWriter::shutdown_all() {
+    vector<ArtifactWriter*> current_writers;
+    {
+        lock_guard<mutex> lock(writers_mutex);
+        current_writers = writers;
+    }
+
+    for (int32_t i = 0; i < (int32_t)current_writers.size(); i++) {
+        current_writers[i]->shutdown();
+    }
+}
+
+void ArtifactWriter::check_log_file(ofstream *&log_file, string filename) {
+    //make sure the log file is still good
+    if (!log_file->good()) {
+        log_file->close();
+        delete log_file;
+
+        string output_file = output_directory + "/" + filename;
+        log_file = new ofstream(output_file, std::ios_base::app);
+
+        if (!log_file->is_open()) {
+            LOG_ERROR("could not open EXAMM output log: '%s'\n", output_file.c_str());
+            exit(1);
+        }
+    }
+}
+
+void ArtifactWriter::write_batch(deque<Artifact> &batch) {
+    string fitness_log_rows;
+    string op_log_rows;
+
+    for (int32_t i = 0; i < (int32_t)batch.size(); i++) {
+        Artifact &artifact = batch[i];
+
+        if (artifact.type == ARTIFACT_FILE) {
+            ofstream outfile(artifact.filename, ios::out | ios::binary);
+            outfile.write(artifact.contents.c_str(), artifact.contents.size());
+            outfile.close();
+
+        } else if (artifact.type == ARTIFACT_FITNESS_LOG) {
+            fitness_log_rows.append(artifact.contents);
+
+        } else if (artifact.type == ARTIFACT_OP_LOG) {
+            op_log_rows.append(artifact.contents);
+        }
+    }
+
+    //write all the rows queued since the last batch at once
+    if (fitness_log_rows.size() > 0) {
+        check_log_file(fitness_log_file, "fitness_log.csv");
+        fitness_log_file->write(fitness_log_rows.c_str(), fitness_log_rows.size());
+        fitness_log_file->flush();
+    }
+
+    if (op_log_rows.size() > 0) {
+        check_log_file(op_log_file, "op_log.csv");
+        op_log_file->write(op_log_rows.c_str(), op_log_rows.size());
+        op_log_file->flush();
+    }
+}
+
+void ArtifactWriter::write_artifacts() {
+    Log::set_id("artifact_writer");
+
+    unique_lock<mutex> lock(queue_mutex);
+    while (true) {
+        queue_cv.wait(lock, [this]{ return stopping || queue.size() > 0; });
+        if (queue.size() == 0) break;   //stopping and everything has been written
+
+        deque<Artifact> batch;
+        batch.swap(queue);
+        writing = true;
+        lock.unlock();
+        space_cv.notify_all();
+
+        write_batch(batch);
+
+        lock.lock();
+        writing = false;
+        space_cv.notify_all();
+    }
+
+    Log::release_id("artifact_writer");
+}
+
+void ArtifactWriter::enqueue(Artifact &artifact) {
+    unique_lock<mutex> lock(queue_mutex);
+
+    if (stopping) {
+        //the writer thread is shutting down (i.e., the program is exiting) so wait
+        //for it to finish and write the artifact directly
+        space_cv.wait(lock, [this]{ return stopped; });
+
+        deque<Artifact> batch;
+        batch.push_back(move(artifact));
+        write_batch(batch);
+        return;
+    }
+
+    space_cv.wait(lock, [this]{ return (int32_t)queue.size() < max_queue_size; });
+    queue.push_back(move(artifact));
+    lock.unlock();
+
+    queue_cv.notify_one();
+}
+
+void ArtifactWriter::write_file(string filename, string contents) {
+    Artifact artifact;
+    artifact.type = ARTIFACT_FILE;
+    artifact.filename = move(filename);
+    artifact.contents = move(contents);
+    enqueue(artifact);
+}
+
+void ArtifactWriter::append_fitness_log(string row) {
+    Artifact artifact;
+    artifact.type = ARTIFACT_FITNESS_LOG;
+    artifact.contents = move(row);
+    enqueue(artifact);
+}
+
+void ArtifactWriter::append_op_log(string row) {
+    Artifact artifact;
+    artifact.type = ARTIFACT_OP_LOG;
+    artifact.contents = move(row);
+    enqueue(artifact);
+}
+
+void ArtifactWriter::flush() {
+    unique_lock<mutex> lock(queue_mutex);
+    space_cv.wait(lock, [this]{ return stopped || (queue.size() == 0 && !writing); });
+}
+
+void ArtifactWriter::shutdown() {
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        if (stopping) return;
+        stopping = true;
+    }
+    queue_cv.notify_all();
+
+    if (std::this_thread::get_id() == writer_thread.get_id()) {
+        //the writer thread itself is exiting the program (after failing to open a log)
+        writer_thread.detach();
+    } else {
+        writer_thread.join();
+    }
+
+    lock_guard<mutex> lock(queue_mutex);
+    stopped = true;
+    space_cv.notify_all();
+}
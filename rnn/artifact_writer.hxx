@@ -0,0 +1,102 @@
+#ifndef EXAMM_ARTIFACT_WRITER_HXX
+#define EXAMM_ARTIFACT_WRITER_HXX
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <fstream>
+using std::ofstream;
+
+#include <mutex>
+using std::mutex;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#define ARTIFACT_FILE 0
+#define ARTIFACT_FITNESS_LOG 1
+#define ARTIFACT_OP_LOG 2
+
+class Artifact {
+    public:
+        int32_t type;
+        string filename; /**< the file to write for ARTIFACT_FILE artifacts. */
+        string contents;
+};
+
+/**
+ * Writes EXAMM's result files (the fitness and operator logs and the best
+ * genomes' graphviz and binary files) on a dedicated thread, so that inserting
+ * a genome does not have to wait on the filesystem.
+ *
+ * The caller serializes everything in memory and queues it.  Artifacts are
+ * written in the order they were queued; log rows queued while the writer was
+ * busy are written together, with a single flush of each log.  If more than
+ * max_queue_size artifacts are waiting, the caller blocks until the writer
+ * catches up.  Any queued artifacts are written before the writer is destroyed
+ * or the program exits.
+ */
+class ArtifactWriter {
+    private:
+        string output_directory;
+        int32_t max_queue_size;
+
+        ofstream *fitness_log_file;
+        ofstream *op_log_file;
+
+        mutex queue_mutex;
+        condition_variable queue_cv; /**< signals the writer that artifacts were queued (or it is stopping). */
+        condition_variable space_cv; /**< signals callers that the writer has emptied the queue. */
+        deque<Artifact> queue;
+        bool writing; /**< true while the writer is writing a batch taken off the queue. */
+        bool stopping;
+        bool stopped;
+
+        thread writer_thread;
+
+        /**
+         * All the artifact writers which have not been destroyed, so they can be
+         * flushed at exit even if their EXAMM object never is.
+         */
+        static vector<ArtifactWriter*> writers;
+        static mutex writers_mutex;
+        static void shutdown_all();
+
+        void enqueue(Artifact &artifact);
+        void write_batch(deque<Artifact> &batch);
+        void write_artifacts();
+        void check_log_file(ofstream *&log_file, string filename);
+
+    public:
+        /**
+         * Creates the writer and (truncating any previous contents) the fitness_log.csv
+         * and op_log.csv files in the output directory.
+         */
+        ArtifactWriter(string _output_directory, int32_t _max_queue_size = 1024);
+        ~ArtifactWriter();
+
+        void write_file(string filename, string contents);
+        void append_fitness_log(string row);
+        void append_op_log(string row);
+
+        /**
+         * Blocks until everything queued has been written and flushed.
+         */
+        void flush();
+
+        /**
+         * Writes everything queued and stops the writer thread.
+         */
+        void shutdown();
+};
+
+#endif
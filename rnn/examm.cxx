@@ -18,6 +18,9 @@ using std::setprecision;
 #include <iostream>
 using std::endl;
 
+#include <sstream>
+using std::ostringstream;
+
 #include <random>
 using std::minstd_rand0;
 using std::uniform_real_distribution;
@@ -48,6 +51,9 @@ using std::to_string;
 
 
 EXAMM::~EXAMM() {
+    //writes out anything still queued
+    delete artifact_writer;
+
     RNN_Genome *genome;
     for (uint32_t i = 0; i < genomes.size(); i++) {
         while (genomes[i].size() > 0) {
@@ -136,6 +142,8 @@ EXAMM::EXAMM(
     normalize_avgs = _normalize_avgs;
     normalize_std_devs = _normalize_std_devs;
 
+    softmax_samples = 0;
+
     total_bp_epochs = 0;
 
     edge_innovation_count = 0;
@@ -295,17 +303,21 @@ EXAMM::EXAMM(
 
     if (output_directory != "") {
         mkpath(output_directory.c_str(), 0777);
-        log_file = new ofstream(output_directory + "/" + "fitness_log.csv");
-        (*log_file) << "Inserted Genomes, Total BP Epochs, Time, Best Val. MAE, Best Val. MSE, Enabled Nodes, Enabled Edges, Enabled Rec. Edges";
+        artifact_writer = new ArtifactWriter(output_directory);
+
+        ostringstream log_file;
+        log_file << "Inserted Genomes, Total BP Epochs, Time, Best Val. MAE, Best Val. MSE, Enabled Nodes, Enabled Edges, Enabled Rec. Edges";
         //memory_log << "Inserted Genomes, Total BP Epochs, Time, Best Val. MAE, Best Val. MSE, Enabled Nodes, Enabled Edges, Enabled Rec. Edges";
 
-        (*log_file) << speciation_strategy->get_strategy_information_headers();
+        log_file << speciation_strategy->get_strategy_information_headers();
         //(memory_log) << speciation_strategy->get_strategy_information_headers();
 
-        (*log_file) << endl;
+        log_file << endl;
         //memory_log << endl;
 
-        op_log_file = new ofstream(output_directory + "/op_log.csv");
+        artifact_writer->append_fitness_log(log_file.str());
+
+        ostringstream op_log_file;
         
         op_log_ordering = {
             "genomes",
@@ -338,10 +350,10 @@ EXAMM::EXAMM(
 
         for (int i = 0; i < op_log_ordering.size(); i++) {
             string op = op_log_ordering[i];
-            (*op_log_file) << op;
-            (*op_log_file) << " Generated, ";
-            (*op_log_file) << op;
-            (*op_log_file) << " Inserted, ";
+            op_log_file << op;
+            op_log_file << " Generated, ";
+            op_log_file << op;
+            op_log_file << " Inserted, ";
             
             inserted_counts[op] = 0;
             generated_counts[op] = 0;
@@ -349,11 +361,11 @@ EXAMM::EXAMM(
 
         map<string, int>::iterator it;
 
-        (*op_log_file) << endl;
+        op_log_file << endl;
+        artifact_writer->append_op_log(op_log_file.str());
 
     } else {
-        log_file = NULL;
-        op_log_file = NULL;
+        artifact_writer = NULL;
     }
 
     startClock = std::chrono::system_clock::now();
@@ -366,34 +378,10 @@ void EXAMM::print() {
 }
 
 void EXAMM::update_log() {
-    if (log_file != NULL) {
-
-        //make sure the log file is still good
-        if (!log_file->good()) {
-            log_file->close();
-            delete log_file;
-
-            string output_file = output_directory + "/fitness_log.csv";
-            log_file = new ofstream(output_file, std::ios_base::app);
-
-            if (!log_file->is_open()) {
-                LOG_ERROR("could not open EXAMM output log: '%s'\n", output_file.c_str());
-                exit(1);
-            }
-        }
-
-        if (!op_log_file->good()) {
-            op_log_file->close();
-            delete op_log_file;
-
-            string output_file = output_directory + "/op_log.csv";
-            op_log_file = new ofstream(output_file, std::ios_base::app);
-
-            if (!op_log_file->is_open()) {
-                LOG_ERROR("could not open EXAMM output log: '%s'\n", output_file.c_str());
-                exit(1);
-            }
-        }
+    if (artifact_writer != NULL) {
+        //the rows are written (and the log files checked) by the artifact writer's thread
+        ostringstream log_file;
+        ostringstream op_log_file;
 
         RNN_Genome *best_genome = get_best_genome();
         if (best_genome == NULL) {
@@ -403,7 +391,7 @@ void EXAMM::update_log() {
         std::chrono::time_point<std::chrono::system_clock> currentClock = std::chrono::system_clock::now();
         long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(currentClock - startClock).count();
 
-        (*log_file) << speciation_strategy->get_inserted_genomes()
+        log_file << speciation_strategy->get_inserted_genomes()
             << "," << total_bp_epochs
             << "," << milliseconds
             << "," << best_genome->best_validation_mae
@@ -412,7 +400,9 @@ void EXAMM::update_log() {
             << "," << best_genome->get_enabled_edge_count()
             << "," << best_genome->get_enabled_recurrent_edge_count()
             << speciation_strategy->get_strategy_information_values()
-            << endl;
+            << "\n";
+
+        artifact_writer->append_fitness_log(log_file.str());
 
         /*
         memory_log << speciation_strategy->get_inserted_genomes()
@@ -429,10 +419,11 @@ void EXAMM::update_log() {
 
         for (int i = 0; i < op_log_ordering.size(); i++) {
             string op = op_log_ordering[i];
-            (*op_log_file) << generated_counts[op] << ", " << inserted_counts[op]  << ", ";
+            op_log_file << generated_counts[op] << ", " << inserted_counts[op]  << ", ";
         }
 
-        (*op_log_file) << endl;
+        op_log_file << "\n";
+        artifact_writer->append_op_log(op_log_file.str());
 
     }
 }
@@ -443,6 +434,14 @@ void EXAMM::write_memory_log(string filename) {
     log_file.close();
 }
 
+void EXAMM::set_softmax_samples(int32_t _softmax_samples) {
+    softmax_samples = _softmax_samples;
+}
+
+void EXAMM::set_word_classes(const vector<int32_t> &_word_classes) {
+    word_classes = _word_classes;
+}
+
 void EXAMM::set_possible_node_types(vector<string> possible_node_type_strings) {
     possible_node_types.clear();
 
@@ -465,6 +464,18 @@ void EXAMM::set_possible_node_types(vector<string> possible_node_type_strings) {
     }
 }
 
+int32_t EXAMM::get_inserted_genomes() const {
+    return speciation_strategy->get_inserted_genomes();
+}
+
+bool EXAMM::was_erased(RNN_Genome *genome) {
+    return speciation_strategy->was_erased(genome);
+}
+
+int32_t EXAMM::get_max_genomes() const {
+    return max_genomes;
+}
+
 string EXAMM::get_output_directory() const {
     return output_directory;
 }
@@ -503,8 +514,21 @@ bool EXAMM::insert_genome(RNN_Genome* genome) {
     //write this genome to disk if it was a new best found genome
     if (insert_position == 0) {
         genome->normalize_type = normalize_type;
-        genome->write_graphviz(output_directory + "/rnn_genome_" + to_string(genome->get_generation_id()) + ".gv");
-        genome->write_to_file(output_directory + "/rnn_genome_" + to_string(genome->get_generation_id()) + ".bin");
+
+        string genome_filename = output_directory + "/rnn_genome_" + to_string(genome->get_generation_id());
+        if (artifact_writer != NULL) {
+            //serialize the genome now, as the caller deletes it after inserting
+            ostringstream graphviz;
+            genome->write_graphviz(graphviz);
+            artifact_writer->write_file(genome_filename + ".gv", graphviz.str());
+
+            ostringstream binary;
+            genome->write_to_stream(binary);
+            artifact_writer->write_file(genome_filename + ".bin", binary.str());
+        } else {
+            genome->write_graphviz(genome_filename + ".gv");
+            genome->write_to_file(genome_filename + ".bin");
+        }
     }
 
     // Name of the operator
@@ -556,6 +580,8 @@ RNN_Genome* EXAMM::generate_genome() {
     genome->set_bp_iterations(bp_iterations);
     genome->set_learning_rate(learning_rate);
     genome->enable_use_regression(use_regression);
+    genome->set_softmax_samples(softmax_samples);
+    genome->set_word_classes(word_classes);
 
     if (use_high_threshold) genome->enable_high_threshold(high_threshold);
     if (use_low_threshold) genome->enable_low_threshold(low_threshold);
@@ -17,6 +17,7 @@ using std::to_string;
 #include <vector>
 using std::vector;
 
+#include "artifact_writer.hxx"
 #include "rnn_genome.hxx"
 #include "speciation_strategy.hxx"
 #include "common/weight_initialize.hxx"
@@ -65,6 +66,8 @@ class EXAMM {
         double low_threshold;
 
         bool use_regression;
+        int32_t softmax_samples;
+        vector<int32_t> word_classes;
         bool use_dropout;
         double dropout_probability;
 
@@ -102,8 +105,7 @@ class EXAMM {
         map<string, int32_t> generated_counts;
 
         string output_directory;
-        ofstream *log_file;
-        ofstream *op_log_file;
+        ArtifactWriter *artifact_writer; /**< writes the logs and best genomes on a separate thread, NULL if there is no output directory. */
 
         vector<string> input_parameter_names;
         vector<string> output_parameter_names;
@@ -176,6 +178,13 @@ class EXAMM {
 
         void set_possible_node_types(vector<string> possible_node_type_strings);
 
+        /**
+         * These set how the genomes are trained with a softmax (when not using
+         * regression), see RNN::set_softmax_samples and RNN::set_word_classes.
+         */
+        void set_softmax_samples(int32_t _softmax_samples);
+        void set_word_classes(const vector<int32_t> &_word_classes);
+
         uniform_int_distribution<int32_t> get_recurrent_depth_dist();
 
         int get_random_node_type();
@@ -195,6 +204,10 @@ class EXAMM {
         RNN_Genome* get_best_genome();
         RNN_Genome* get_worst_genome();
 
+        int32_t get_inserted_genomes() const;
+        bool was_erased(RNN_Genome *genome);
+        int32_t get_max_genomes() const;
+
         string get_output_directory() const;
         RNN_Genome* generate_for_transfer_learning(string file_name, int extra_inputs, int extra_outputs) ;
 
@@ -331,6 +331,9 @@ void Island::erase_island() {
     // }
     erased_generation_id = latest_generation_id;
     genomes.clear();
+    //the structure map refers to the erased genomes, so it needs to be cleared as well
+    //or duplicates of them would be looked for in an empty island
+    structure_map.clear();
     erased = true;
     erase_again = 5;
     LOG_INFO("Worst island size after erased: %d\n", genomes.size());
@@ -630,6 +630,14 @@ RNN_Genome* IslandSpeciationStrategy::get_global_best_genome(){
     return global_best_genome;
 }
 
+bool IslandSpeciationStrategy::was_erased(RNN_Genome *genome) {
+    int32_t island = genome->get_group_id();
+    if (island < 0 || island >= (int32_t)islands.size()) return false;
+
+    //the same check Island::insert_genome makes before inserting
+    return genome->get_generation_id() <= islands[island]->get_erased_generation_id();
+}
+
 void IslandSpeciationStrategy::set_erased_islands_status() {
     for (int i = 0; i < islands.size(); i++) {
         if (islands[i] -> get_erase_again_num() > 0) {
@@ -192,6 +192,8 @@ class IslandSpeciationStrategy : public SpeciationStrategy {
 
         RNN_Genome* get_global_best_genome();
 
+        bool was_erased(RNN_Genome *genome);
+
         void set_erased_islands_status();
 
 };
@@ -26,7 +26,7 @@ void get_mse(const vector<double> &output_values, const vector<double> &expected
     }
 }
 
-void get_mse(RNN *genome, const vector< vector<double> > &expected, double &mse_sum, vector< vector<double> > &deltas) {
+void get_mse(RNN *genome, const SeriesView &expected, double &mse_sum, vector< vector<double> > &deltas) {
     deltas.assign(genome->output_nodes.size(), vector<double>(expected[0].size(), 0.0));
 
     mse_sum = 0.0;
@@ -79,7 +79,7 @@ void get_mae(const vector<double> &output_values, const vector<double> &expected
     }
 }
 
-void get_mae(RNN *genome, const vector< vector<double> > &expected, double &mae_sum, vector< vector<double> > &deltas) {
+void get_mae(RNN *genome, const SeriesView &expected, double &mae_sum, vector< vector<double> > &deltas) {
     deltas.assign(genome->output_nodes.size(), vector<double>(expected[0].size(), 0.0));
 
     mae_sum = 0.0;
@@ -402,6 +402,11 @@ RNN_Genome* NeatSpeciationStrategy::get_global_best_genome() {
     return global_best_genome;
 }
 
+bool NeatSpeciationStrategy::was_erased(RNN_Genome *genome) {
+    //genomes are assigned to a species when they are inserted, so they can always be inserted
+    return false;
+}
+
 vector<int32_t> NeatSpeciationStrategy::get_random_species_list() {
     vector<int32_t> species_list;
     for (int i = 0; i < Neat_Species.size(); i++) {
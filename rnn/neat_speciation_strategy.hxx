@@ -125,6 +125,8 @@ class NeatSpeciationStrategy : public SpeciationStrategy {
 
         RNN_Genome* get_global_best_genome();
 
+        bool was_erased(RNN_Genome *genome);
+
         vector<int32_t> get_random_species_list();
         
         double get_distance(RNN_Genome* g1, RNN_Genome* g2);
@@ -7,6 +7,9 @@ using std::upper_bound;
 #include <limits>
 using std::numeric_limits;
 
+#include <map>
+using std::map;
+
 #include <iomanip>
 using std::fixed;
 using std::setw;
@@ -20,6 +23,7 @@ using std::ofstream;
 
 #include <random>
 using std::minstd_rand0;
+using std::uniform_int_distribution;
 using std::uniform_real_distribution;
 
 #include <vector>
@@ -173,6 +177,9 @@ RNN::RNN(vector<RNN_Node_Interface*> &_nodes, vector<RNN_Edge*> &_edges, const v
 
     fix_parameter_orders(input_parameter_names, output_parameter_names);
     validate_parameters(input_parameter_names, output_parameter_names);
+
+    initialize_one_hot_inputs();
+    initialize_selectable_outputs();
 }
 
 RNN::RNN(vector<RNN_Node_Interface*> &_nodes, vector<RNN_Edge*> &_edges, vector<RNN_Recurrent_Edge*> &_recurrent_edges, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names) {
@@ -199,9 +206,136 @@ RNN::RNN(vector<RNN_Node_Interface*> &_nodes, vector<RNN_Edge*> &_edges, vector<
     LOG_DEBUG("validating parameters, input_node.size: %d\n", input_nodes.size());
     validate_parameters(input_parameter_names, output_parameter_names);
 
+    initialize_one_hot_inputs();
+    initialize_selectable_outputs();
+
     LOG_TRACE("got RNN with %d nodes, %d edges, %d recurrent edges\n", nodes.size(), edges.size(), recurrent_edges.size());
 }
 
+void RNN::initialize_one_hot_inputs() {
+    one_hot_pass = false;
+    one_hot_inputs_possible = true;
+
+    map<const RNN_Node_Interface*, int32_t> input_indexes;
+    for (int32_t i = 0; i < (int32_t)input_nodes.size(); i++) {
+        input_indexes[input_nodes[i]] = i;
+
+        //the inactive outputs of an input node are all fired at once, so its
+        //only input can be the input value
+        if (input_nodes[i]->is_reachable() && (dynamic_cast<RNN_Node*>(input_nodes[i]) == NULL || input_nodes[i]->total_inputs != 1)) {
+            one_hot_inputs_possible = false;
+        }
+    }
+
+    input_edges.assign(input_nodes.size(), vector<RNN_Edge*>());
+    input_edge_targets.assign(input_nodes.size(), vector<int32_t>());
+    non_input_edges.clear();
+    input_targets.clear();
+    input_target_counts.clear();
+
+    map<const RNN_Node_Interface*, int32_t> target_indexes;
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (!edges[i]->is_reachable()) continue;
+
+        auto input = input_indexes.find(edges[i]->input_node);
+        if (input == input_indexes.end()) {
+            non_input_edges.push_back(edges[i]);
+            continue;
+        }
+
+        auto target = target_indexes.find(edges[i]->output_node);
+        if (target == target_indexes.end()) {
+            target = target_indexes.insert(std::make_pair(edges[i]->output_node, (int32_t)input_targets.size())).first;
+            input_targets.push_back(edges[i]->output_node);
+            input_target_counts.push_back(0);
+        }
+
+        input_edges[input->second].push_back(edges[i]);
+        input_edge_targets[input->second].push_back(target->second);
+        input_target_counts[target->second]++;
+    }
+}
+
+void RNN::initialize_selectable_outputs() {
+    softmax_samples = 0;
+    word_classes.clear();
+    class_words.clear();
+    sampled_pass = false;
+
+    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+    generator = minstd_rand0(seed);
+
+    map<const RNN_Node_Interface*, int32_t> output_indexes;
+    for (int32_t i = 0; i < (int32_t)output_nodes.size(); i++) {
+        output_indexes[output_nodes[i]] = i;
+    }
+
+    //the deltas of an output node with recurrent edges (or edges to other
+    //nodes) are needed at every time step, so it is always calculated
+    output_selectable.assign(output_nodes.size(), true);
+    for (uint32_t i = 0; i < recurrent_edges.size(); i++) {
+        if (!recurrent_edges[i]->is_reachable()) continue;
+
+        auto input = output_indexes.find(recurrent_edges[i]->input_node);
+        if (input != output_indexes.end()) output_selectable[input->second] = false;
+
+        auto output = output_indexes.find(recurrent_edges[i]->output_node);
+        if (output != output_indexes.end()) output_selectable[output->second] = false;
+    }
+
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (!edges[i]->is_reachable()) continue;
+
+        auto input = output_indexes.find(edges[i]->input_node);
+        if (input != output_indexes.end()) output_selectable[input->second] = false;
+    }
+
+    unselectable_outputs.clear();
+    for (int32_t i = 0; i < (int32_t)output_nodes.size(); i++) {
+        if (!output_selectable[i]) unselectable_outputs.push_back(i);
+    }
+
+    output_edges.assign(output_nodes.size(), vector<RNN_Edge*>());
+    non_output_edges.clear();
+    non_input_output_edges.clear();
+    output_edge_sources.clear();
+    output_edge_source_counts.clear();
+
+    map<const RNN_Node_Interface*, int32_t> source_indexes;
+    for (uint32_t i = 0; i < edges.size(); i++) {
+        if (!edges[i]->is_reachable()) continue;
+
+        auto output = output_indexes.find(edges[i]->output_node);
+        if (output == output_indexes.end() || !output_selectable[output->second]) {
+            non_output_edges.push_back(edges[i]);
+            if (edges[i]->input_node->layer_type != INPUT_LAYER) non_input_output_edges.push_back(edges[i]);
+            continue;
+        }
+
+        auto source = source_indexes.find(edges[i]->input_node);
+        if (source == source_indexes.end()) {
+            source = source_indexes.insert(std::make_pair(edges[i]->input_node, (int32_t)output_edge_sources.size())).first;
+            output_edge_sources.push_back(edges[i]->input_node);
+            output_edge_source_counts.push_back(0);
+        }
+
+        output_edges[output->second].push_back(edges[i]);
+        output_edge_source_counts[source->second]++;
+    }
+
+    input_edge_outputs.assign(input_nodes.size(), vector<int32_t>());
+    for (uint32_t i = 0; i < input_nodes.size(); i++) {
+        for (uint32_t j = 0; j < input_edges[i].size(); j++) {
+            auto output = output_indexes.find(input_edges[i][j]->output_node);
+            if (output != output_indexes.end() && output_selectable[output->second]) {
+                input_edge_outputs[i].push_back(output->second);
+            } else {
+                input_edge_outputs[i].push_back(-1);
+            }
+        }
+    }
+}
+
 RNN::~RNN() {
     RNN_Node_Interface *node;
 
@@ -300,6 +434,35 @@ void RNN::enable_use_regression(bool _use_regression) {
     use_regression = _use_regression;
 }
 
+void RNN::set_softmax_samples(int32_t _softmax_samples) {
+    softmax_samples = _softmax_samples;
+}
+
+void RNN::set_word_classes(const vector<int32_t> &_word_classes) {
+    word_classes = _word_classes;
+    class_words.clear();
+    if (word_classes.size() == 0) return;
+
+    int32_t number_classes = (int32_t)output_nodes.size() - (int32_t)word_classes.size();
+    if (number_classes <= 0) {
+        LOG_FATAL("ERROR: there were %d word classes for an RNN with %d output nodes, there needs to be an output node for each class after the words.\n", word_classes.size(), output_nodes.size());
+        exit(1);
+    }
+
+    class_words.assign(number_classes, vector<int32_t>());
+    for (int32_t i = 0; i < (int32_t)word_classes.size(); i++) {
+        if (word_classes[i] < 0 || word_classes[i] >= number_classes) {
+            LOG_FATAL("ERROR: word %d had class %d, but there are only %d classes.\n", i, word_classes[i], number_classes);
+            exit(1);
+        }
+        class_words[word_classes[i]].push_back(i);
+    }
+}
+
+void RNN::set_softmax_seed(unsigned seed) {
+    generator = minstd_rand0(seed);
+}
+
 uint32_t RNN::get_number_weights() {
     uint32_t number_weights = 0;
 
@@ -321,7 +484,16 @@ uint32_t RNN::get_number_weights() {
     return number_weights;
 }
 
-void RNN::forward_pass(const vector< vector<double> > &series_data, bool using_dropout, bool training, double dropout_probability) {
+void RNN::forward_pass(const SeriesView &series_data, bool using_dropout, bool training, double dropout_probability) {
+    forward_pass(series_data, using_dropout, training, dropout_probability, false);
+}
+
+/**
+ * If select_outputs is true, only the output nodes selected (by
+ * select_sampled_outputs or select_class_outputs) at each time step are
+ * calculated.
+ */
+void RNN::forward_pass(const SeriesView &series_data, bool using_dropout, bool training, double dropout_probability, bool select_outputs) {
     series_length = series_data[0].size();
 
     if (input_nodes.size() != series_data.size()) {
@@ -354,6 +526,18 @@ void RNN::forward_pass(const vector< vector<double> > &series_data, bool using_d
         if (recurrent_edges[i]->is_reachable()) recurrent_edges[i]->first_propagate_forward();
     }
 
+    sampled_pass = select_outputs;
+
+    //dropout is applied to every edge at every time step, so it needs the full pass
+    one_hot_pass = !using_dropout && one_hot_inputs_possible && series_data.is_one_hot();
+    if (one_hot_pass) {
+        one_hot_forward_pass(series_data);
+        return;
+    }
+
+    //the edges into the selectable output nodes are propagated after the others
+    const vector<RNN_Edge*> &forward_edges = sampled_pass ? non_output_edges : edges;
+
     for (int32_t time = 0; time < series_length; time++) {
         for (uint32_t i = 0; i < input_nodes.size(); i++) {
             if(input_nodes[i]->is_reachable()) input_nodes[i]->input_fired(time, series_data[i][time]);
@@ -361,12 +545,80 @@ void RNN::forward_pass(const vector< vector<double> > &series_data, bool using_d
 
         //feed forward
         if (using_dropout) {
-            for (uint32_t i = 0; i < edges.size(); i++) {
-                if (edges[i]->is_reachable()) edges[i]->propagate_forward(time, training, dropout_probability);
+            for (uint32_t i = 0; i < forward_edges.size(); i++) {
+                if (forward_edges[i]->is_reachable()) forward_edges[i]->propagate_forward(time, training, dropout_probability);
+            }
+        } else {
+            for (uint32_t i = 0; i < forward_edges.size(); i++) {
+                if (forward_edges[i]->is_reachable()) forward_edges[i]->propagate_forward(time);
+            }
+        }
+
+        if (sampled_pass) selected_outputs_forward(time, using_dropout, training, dropout_probability);
+
+        for (uint32_t i = 0; i < recurrent_edges.size(); i++) {
+            if (recurrent_edges[i]->is_reachable()) recurrent_edges[i]->propagate_forward(time);
+        }
+    }
+}
+
+void RNN::one_hot_forward_pass(const SeriesView &series_data) {
+    one_hot_tokens.resize(series_length);
+    for (int32_t time = 0; time < series_length; time++) {
+        one_hot_tokens[time] = series_data.get_token(time);
+    }
+
+    inactive_outputs.assign(input_nodes.size(), 0.0);
+    inactive_derivatives.assign(input_nodes.size(), 0.0);
+    inactive_target_inputs.assign(input_targets.size(), 0.0);
+
+    for (uint32_t i = 0; i < input_nodes.size(); i++) {
+        if (!input_nodes[i]->is_reachable()) continue;
+
+        RNN_Node *input_node = (RNN_Node*)input_nodes[i];
+        input_node->fire_constant_input(series_data.get_inactive_value(i));
+
+        inactive_outputs[i] = tanh(series_data.get_inactive_value(i) + input_node->bias);
+        inactive_derivatives[i] = tanh_derivative(inactive_outputs[i]);
+
+        for (uint32_t j = 0; j < input_edges[i].size(); j++) {
+            inactive_target_inputs[input_edge_targets[i][j]] += inactive_outputs[i] * input_edges[i][j]->weight;
+        }
+    }
+
+    for (int32_t time = 0; time < series_length; time++) {
+        int32_t token = one_hot_tokens[time];
+
+        if (token >= 0 && input_nodes[token]->is_reachable()) {
+            RNN_Node *input_node = (RNN_Node*)input_nodes[token];
+            input_node->inputs_fired[time] = 0;
+            input_node->input_values[time] = 0.0;
+            input_node->input_fired(time, series_data.get_active_value(token));
+
+            //the active node's edges add the difference from its inactive output
+            for (uint32_t j = 0; j < input_edges[token].size(); j++) {
+                RNN_Edge *edge = input_edges[token][j];
+
+                edge->outputs[time] = input_node->output_values[time] * edge->weight;
+                edge->output_node->input_values[time] += (input_node->output_values[time] - inactive_outputs[token]) * edge->weight;
             }
+        }
+
+        //every input edge into a target fires at once
+        for (uint32_t i = 0; i < input_targets.size(); i++) {
+            input_targets[i]->inputs_fired[time] += input_target_counts[i] - 1;
+            input_targets[i]->input_fired(time, inactive_target_inputs[i]);
+        }
+
+        if (sampled_pass) {
+            for (uint32_t i = 0; i < non_input_output_edges.size(); i++) {
+                non_input_output_edges[i]->propagate_forward(time);
+            }
+
+            selected_outputs_forward(time, false, false, 0.0);
         } else {
-            for (uint32_t i = 0; i < edges.size(); i++) {
-                if (edges[i]->is_reachable()) edges[i]->propagate_forward(time);
+            for (uint32_t i = 0; i < non_input_edges.size(); i++) {
+                non_input_edges[i]->propagate_forward(time);
             }
         }
 
@@ -376,7 +628,229 @@ void RNN::forward_pass(const vector< vector<double> > &series_data, bool using_d
     }
 }
 
+/**
+ * Adds the gradients of the input edges (and input node biases) which were
+ * not propagated backward by a one hot pass: the delta of each input edge's
+ * target summed over every time step times the inactive output, minus that
+ * at the time steps its input node was active (which were propagated).
+ */
+void RNN::one_hot_gradients() {
+    vector<double> target_deltas(input_targets.size(), 0.0);
+    for (uint32_t i = 0; i < input_targets.size(); i++) {
+        for (int32_t time = 0; time < series_length; time++) {
+            target_deltas[i] += input_targets[i]->d_input[time];
+        }
+    }
+
+    for (uint32_t i = 0; i < input_nodes.size(); i++) {
+        if (!input_nodes[i]->is_reachable()) continue;
+
+        RNN_Node *input_node = (RNN_Node*)input_nodes[i];
+        for (uint32_t j = 0; j < input_edges[i].size(); j++) {
+            RNN_Edge *edge = input_edges[i][j];
+            double delta = target_deltas[input_edge_targets[i][j]];
+
+            edge->d_weight += inactive_outputs[i] * delta;
+            input_node->d_bias += inactive_derivatives[i] * edge->weight * delta;
+        }
+    }
+
+    for (int32_t time = 0; time < series_length; time++) {
+        int32_t token = one_hot_tokens[time];
+        if (token < 0 || !input_nodes[token]->is_reachable()) continue;
+
+        RNN_Node *input_node = (RNN_Node*)input_nodes[token];
+        for (uint32_t j = 0; j < input_edges[token].size(); j++) {
+            RNN_Edge *edge = input_edges[token][j];
+            double delta = edge->output_node->d_input[time];
+
+            edge->d_weight -= inactive_outputs[token] * delta;
+            input_node->d_bias -= inactive_derivatives[token] * edge->weight * delta;
+        }
+    }
+}
+
+int32_t RNN::get_expected_output(const SeriesView &expected_outputs, int32_t time, int32_t number_words) const {
+    if (expected_outputs.is_one_hot()) return expected_outputs.get_token(time);
+
+    //otherwise the expected word is the one with the largest value, if it is larger than the others
+    int32_t expected = -1;
+    double max_value = -numeric_limits<double>::max();
+    double min_value = numeric_limits<double>::max();
+    for (int32_t i = 0; i < number_words; i++) {
+        double value = expected_outputs[i][time];
+        if (value > max_value) {
+            max_value = value;
+            expected = i;
+        }
+        if (value < min_value) min_value = value;
+    }
+
+    if (max_value == min_value) return -1;
+    return expected;
+}
+
+/**
+ * Selects the expected word and softmax_samples other words (sampled
+ * uniformly without replacement) at each time step.  Time steps without an
+ * expected word (padding) have no selected output nodes.
+ */
+void RNN::select_sampled_outputs(const SeriesView &expected_outputs) {
+    int32_t length = expected_outputs[0].size();
+    int32_t number_words = output_nodes.size();
+    int32_t number_samples = fmin(softmax_samples, number_words - 1);
+
+    uniform_int_distribution<int32_t> word_distribution(0, number_words - 1);
+
+    selected_outputs.clear();
+    selected_output_starts.assign(1, 0);
+    output_selected_times.assign(output_nodes.size(), -1);
+
+    for (int32_t time = 0; time < length; time++) {
+        int32_t expected = get_expected_output(expected_outputs, time, number_words);
+
+        if (expected >= 0) {
+            selected_outputs.push_back(expected);
+            output_selected_times[expected] = time;
+
+            for (int32_t i = 0; i < number_samples;) {
+                int32_t word = word_distribution(generator);
+                if (output_selected_times[word] == time) continue;
+
+                selected_outputs.push_back(word);
+                output_selected_times[word] = time;
+                i++;
+            }
+        }
+
+        selected_output_starts.push_back(selected_outputs.size());
+    }
+}
+
+/**
+ * Selects every class output node followed by the word output nodes in the
+ * expected word's class at each time step.  Time steps without an expected
+ * word (padding) have no selected output nodes.
+ */
+void RNN::select_class_outputs(const SeriesView &expected_outputs) {
+    int32_t length = expected_outputs[0].size();
+    int32_t number_words = word_classes.size();
+
+    selected_outputs.clear();
+    selected_output_starts.assign(1, 0);
+    output_selected_times.assign(output_nodes.size(), -1);
+
+    for (int32_t time = 0; time < length; time++) {
+        int32_t expected = get_expected_output(expected_outputs, time, number_words);
+
+        if (expected >= 0) {
+            for (int32_t i = number_words; i < (int32_t)output_nodes.size(); i++) {
+                selected_outputs.push_back(i);
+            }
+
+            const vector<int32_t> &words = class_words[word_classes[expected]];
+            selected_outputs.insert(selected_outputs.end(), words.begin(), words.end());
+        }
+
+        selected_output_starts.push_back(selected_outputs.size());
+    }
+}
+
+void RNN::mark_selected_outputs(int32_t time) {
+    for (int32_t i = selected_output_starts[time]; i < selected_output_starts[time + 1]; i++) {
+        output_selected_times[selected_outputs[i]] = time;
+    }
+}
+
+void RNN::selected_outputs_forward(int32_t time, bool using_dropout, bool training, double dropout_probability) {
+    for (int32_t i = selected_output_starts[time]; i < selected_output_starts[time + 1]; i++) {
+        int32_t output = selected_outputs[i];
+        if (!output_selectable[output]) continue;
+
+        for (uint32_t j = 0; j < output_edges[output].size(); j++) {
+            RNN_Edge *edge = output_edges[output][j];
+
+            //a one hot pass has already added the input edges
+            if (one_hot_pass && edge->input_node->layer_type == INPUT_LAYER) continue;
+
+            if (using_dropout) edge->propagate_forward(time, training, dropout_probability);
+            else edge->propagate_forward(time);
+        }
+    }
+}
+
+void RNN::selected_outputs_backward(int32_t time, double error, bool using_dropout, bool training, double dropout_probability) {
+    for (int32_t i = selected_output_starts[time]; i < selected_output_starts[time + 1]; i++) {
+        int32_t output = selected_outputs[i];
+        if (output_selectable[output]) output_nodes[output]->error_fired(time, error);
+    }
+
+    for (int32_t i = selected_output_starts[time]; i < selected_output_starts[time + 1]; i++) {
+        int32_t output = selected_outputs[i];
+        if (!output_selectable[output]) continue;
+
+        for (int32_t j = (int32_t)output_edges[output].size() - 1; j >= 0; j--) {
+            RNN_Edge *edge = output_edges[output][j];
+            if (one_hot_pass && edge->input_node->layer_type == INPUT_LAYER) continue;
+
+            if (using_dropout) edge->propagate_backward(time, training, dropout_probability);
+            else edge->propagate_backward(time);
+        }
+    }
+}
+
 void RNN::backward_pass(double error, bool using_dropout, bool training, double dropout_probability) {
+    if (one_hot_pass) {
+        //only the active input node's edges are propagated backward, so the
+        //others are counted as already fired
+        for (uint32_t i = 0; i < input_nodes.size(); i++) {
+            if (input_nodes[i]->is_reachable()) input_nodes[i]->outputs_fired.assign(series_length, input_edges[i].size());
+        }
+
+        for (int32_t time = 0; time < series_length; time++) {
+            int32_t token = one_hot_tokens[time];
+            if (token < 0 || !input_nodes[token]->is_reachable()) continue;
+
+            if (sampled_pass) {
+                //the active node's edges into output nodes which were not selected are not propagated either
+                mark_selected_outputs(time);
+                for (uint32_t i = 0; i < input_edges[token].size(); i++) {
+                    int32_t output = input_edge_outputs[token][i];
+                    if (output < 0 || output_selected_times[output] == time) input_nodes[token]->outputs_fired[time]--;
+                }
+            } else {
+                input_nodes[token]->outputs_fired[time] -= input_edges[token].size();
+            }
+        }
+    }
+
+    if (sampled_pass) {
+        //only the edges into the selected output nodes are propagated backward,
+        //so the others are counted as already fired (the input edges of a one
+        //hot pass were counted above)
+        for (uint32_t i = 0; i < output_edge_sources.size(); i++) {
+            if (one_hot_pass && output_edge_sources[i]->layer_type == INPUT_LAYER) continue;
+
+            for (int32_t time = 0; time < series_length; time++) {
+                output_edge_sources[i]->outputs_fired[time] += output_edge_source_counts[i];
+            }
+        }
+
+        for (int32_t time = 0; time < series_length; time++) {
+            for (int32_t i = selected_output_starts[time]; i < selected_output_starts[time + 1]; i++) {
+                int32_t output = selected_outputs[i];
+                if (!output_selectable[output]) continue;
+
+                for (uint32_t j = 0; j < output_edges[output].size(); j++) {
+                    RNN_Edge *edge = output_edges[output][j];
+                    if (one_hot_pass && edge->input_node->layer_type == INPUT_LAYER) continue;
+
+                    edge->input_node->outputs_fired[time]--;
+                }
+            }
+        }
+    }
+
     //do a propagate forward for time == (series_length - 1) so that the
     // output fired count on each node will be correct for the first pass
     //through the RNN
@@ -386,17 +860,45 @@ void RNN::backward_pass(double error, bool using_dropout, bool training, double
 
     for (int32_t time = series_length - 1; time >= 0; time--) {
 
-        for (uint32_t i = 0; i < output_nodes.size(); i++) {
-            output_nodes[i]->error_fired(time, error);
+        if (sampled_pass) {
+            for (uint32_t i = 0; i < unselectable_outputs.size(); i++) {
+                output_nodes[unselectable_outputs[i]]->error_fired(time, error);
+            }
+
+            selected_outputs_backward(time, error, using_dropout, training, dropout_probability);
+        } else {
+            for (uint32_t i = 0; i < output_nodes.size(); i++) {
+                output_nodes[i]->error_fired(time, error);
+            }
         }
 
-        if (using_dropout) {
-            for (int32_t i = (int32_t)edges.size() - 1; i >= 0; i--) {
-                if (edges[i]->is_reachable()) edges[i]->propagate_backward(time, training, dropout_probability);
+        if (one_hot_pass) {
+            const vector<RNN_Edge*> &backward_edges = sampled_pass ? non_input_output_edges : non_input_edges;
+            for (int32_t i = (int32_t)backward_edges.size() - 1; i >= 0; i--) {
+                backward_edges[i]->propagate_backward(time);
+            }
+
+            int32_t token = one_hot_tokens[time];
+            if (token >= 0 && input_nodes[token]->is_reachable()) {
+                if (sampled_pass) mark_selected_outputs(time);
+
+                for (int32_t i = (int32_t)input_edges[token].size() - 1; i >= 0; i--) {
+                    int32_t output = input_edge_outputs[token][i];
+                    if (sampled_pass && output >= 0 && output_selected_times[output] != time) continue;
+
+                    input_edges[token][i]->propagate_backward(time);
+                }
             }
         } else {
-            for (int32_t i = (int32_t)edges.size() - 1; i >= 0; i--) {
-                if (edges[i]->is_reachable()) edges[i]->propagate_backward(time);
+            const vector<RNN_Edge*> &backward_edges = sampled_pass ? non_output_edges : edges;
+            if (using_dropout) {
+                for (int32_t i = (int32_t)backward_edges.size() - 1; i >= 0; i--) {
+                    if (backward_edges[i]->is_reachable()) backward_edges[i]->propagate_backward(time, training, dropout_probability);
+                }
+            } else {
+                for (int32_t i = (int32_t)backward_edges.size() - 1; i >= 0; i--) {
+                    if (backward_edges[i]->is_reachable()) backward_edges[i]->propagate_backward(time);
+                }
             }
         }
 
@@ -404,9 +906,11 @@ void RNN::backward_pass(double error, bool using_dropout, bool training, double
             if (recurrent_edges[i]->is_reachable()) recurrent_edges[i]->propagate_backward(time);
         }
     }
+
+    if (one_hot_pass) one_hot_gradients();
 }
 
-double RNN::calculate_error_softmax(const vector< vector<double> > &expected_outputs) {
+double RNN::calculate_error_softmax(const SeriesView &expected_outputs) {
     
     
     double cross_entropy_sum = 0.0;
@@ -445,7 +949,94 @@ double RNN::calculate_error_softmax(const vector< vector<double> > &expected_out
   return cross_entropy_sum;
 }
 
-double RNN::calculate_error_mse(const vector< vector<double> > &expected_outputs) {
+/**
+ * Sets the errors of a softmax over only the given output nodes at a time
+ * step, where the expected output node should be 1 and the others 0.
+ *
+ * \return the cross entropy of the expected output node
+ */
+double RNN::calculate_softmax_error(const int32_t *outputs, int32_t number_outputs, int32_t time, int32_t expected) {
+    //subtracting the largest output keeps the exponents from overflowing
+    double max_output = -numeric_limits<double>::max();
+    for (int32_t i = 0; i < number_outputs; i++) {
+        max_output = fmax(max_output, output_nodes[outputs[i]]->output_values[time]);
+    }
+
+    softmax_values.resize(number_outputs);
+    double softmax_sum = 0.0;
+    for (int32_t i = 0; i < number_outputs; i++) {
+        softmax_values[i] = exp(output_nodes[outputs[i]]->output_values[time] - max_output);
+        softmax_sum += softmax_values[i];
+    }
+
+    double cross_entropy = 0.0;
+    for (int32_t i = 0; i < number_outputs; i++) {
+        double softmax = softmax_values[i] / softmax_sum;
+
+        if (outputs[i] == expected) {
+            output_nodes[outputs[i]]->error_values[time] = softmax - 1.0;
+            cross_entropy = -log(softmax);
+        } else {
+            output_nodes[outputs[i]]->error_values[time] = softmax;
+        }
+    }
+
+    return cross_entropy;
+}
+
+double RNN::calculate_error_sampled_softmax() {
+    for (uint32_t i = 0; i < output_nodes.size(); i++) {
+        output_nodes[i]->error_values.assign(series_length, 0.0);
+    }
+
+    //the expected word is the first selected output node of each time step
+    double cross_entropy_sum = 0.0;
+    for (int32_t time = 0; time < series_length; time++) {
+        int32_t start = selected_output_starts[time];
+        int32_t number_outputs = selected_output_starts[time + 1] - start;
+        if (number_outputs == 0) continue;
+
+        cross_entropy_sum += calculate_softmax_error(&selected_outputs[start], number_outputs, time, selected_outputs[start]);
+    }
+
+    return cross_entropy_sum;
+}
+
+double RNN::calculate_error_class_softmax(const SeriesView &expected_outputs) {
+    for (uint32_t i = 0; i < output_nodes.size(); i++) {
+        output_nodes[i]->error_values.assign(series_length, 0.0);
+    }
+
+    int32_t number_words = word_classes.size();
+    int32_t number_classes = class_words.size();
+
+    //the cross entropy of a word is that of its class plus that of the word within its class
+    double cross_entropy_sum = 0.0;
+    for (int32_t time = 0; time < series_length; time++) {
+        int32_t start = selected_output_starts[time];
+        int32_t number_outputs = selected_output_starts[time + 1] - start;
+        if (number_outputs == 0) continue;
+
+        int32_t expected = get_expected_output(expected_outputs, time, number_words);
+
+        cross_entropy_sum += calculate_softmax_error(&selected_outputs[start], number_classes, time, number_words + word_classes[expected]);
+        cross_entropy_sum += calculate_softmax_error(&selected_outputs[start + number_classes], number_outputs - number_classes, time, expected);
+    }
+
+    return cross_entropy_sum;
+}
+
+/**
+ * \return the cross entropy of the softmax prediction_softmax uses, over the
+ * output nodes already selected if select_outputs is true
+ */
+double RNN::calculate_selected_error_softmax(const SeriesView &expected_outputs, bool select_outputs) {
+    if (!select_outputs) return calculate_error_softmax(expected_outputs);
+    if (word_classes.size() > 0) return calculate_error_class_softmax(expected_outputs);
+    return calculate_error_sampled_softmax();
+}
+
+double RNN::calculate_error_mse(const SeriesView &expected_outputs) {
     double mse_sum = 0.0;
     double mse;
     double error;
@@ -468,7 +1059,7 @@ double RNN::calculate_error_mse(const vector< vector<double> > &expected_outputs
     return mse_sum;
 }
 
-double RNN::calculate_error_mae(const vector< vector<double> > &expected_outputs) {
+double RNN::calculate_error_mae(const SeriesView &expected_outputs) {
     double mae_sum = 0.0;
     double mae;
     double error;
@@ -496,22 +1087,35 @@ double RNN::calculate_error_mae(const vector< vector<double> > &expected_outputs
 }
 
 
-double RNN::prediction_softmax(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, bool training, double dropout_probability) {
+double RNN::prediction_softmax(const SeriesView &series_data, const SeriesView &expected_outputs, bool using_dropout, bool training, double dropout_probability) {
+    //the class based softmax is exact, so it is also used for validation,
+    //while a sampled softmax is only used for training
+    if (word_classes.size() > 0) {
+        select_class_outputs(expected_outputs);
+        forward_pass(series_data, using_dropout, training, dropout_probability, true);
+        return calculate_error_class_softmax(expected_outputs);
+
+    } else if (training && softmax_samples > 0) {
+        select_sampled_outputs(expected_outputs);
+        forward_pass(series_data, using_dropout, training, dropout_probability, true);
+        return calculate_error_sampled_softmax();
+    }
+
     forward_pass(series_data, using_dropout, training, dropout_probability);
     return calculate_error_softmax(expected_outputs);
 }
 
-double RNN::prediction_mse(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, bool training, double dropout_probability) {
+double RNN::prediction_mse(const SeriesView &series_data, const SeriesView &expected_outputs, bool using_dropout, bool training, double dropout_probability) {
     forward_pass(series_data, using_dropout, training, dropout_probability);
     return calculate_error_mse(expected_outputs);
 }
 
-double RNN::prediction_mae(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, bool training, double dropout_probability) {
+double RNN::prediction_mae(const SeriesView &series_data, const SeriesView &expected_outputs, bool using_dropout, bool training, double dropout_probability) {
     forward_pass(series_data, using_dropout, training, dropout_probability);
     return calculate_error_mae(expected_outputs);
 }
 
-vector<double> RNN::get_predictions(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, double dropout_probability) {
+vector<double> RNN::get_predictions(const SeriesView &series_data, const SeriesView &expected_outputs, bool using_dropout, double dropout_probability) {
     forward_pass(series_data, using_dropout, false, dropout_probability);
 
     vector<double> result;
@@ -528,7 +1132,7 @@ vector<double> RNN::get_predictions(const vector< vector<double> > &series_data,
     return result;
 }
 
-void RNN::write_predictions(string output_filename, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names, const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, TimeSeriesSets *time_series_sets, bool using_dropout, double dropout_probability) {
+void RNN::write_predictions(string output_filename, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names, const SeriesView &series_data, const SeriesView &expected_outputs, TimeSeriesSets *time_series_sets, bool using_dropout, double dropout_probability) {
     forward_pass(series_data, using_dropout, false, dropout_probability);
 
     LOG_DEBUG("series_length: %d, series_data.size(): %d, series_data[0].size(): %d\n", series_length, series_data.size(), series_data[0].size());
@@ -559,30 +1163,36 @@ void RNN::write_predictions(string output_filename, const vector<string> &input_
     }
     outfile << endl;
 
+    //look up how each parameter is denormalized once instead of for every value
+    vector<double> input_scales, input_offsets;
+    vector<double> output_scales, output_offsets;
+    time_series_sets->get_denormalize_coefficients(input_parameter_names, input_scales, input_offsets);
+    time_series_sets->get_denormalize_coefficients(output_parameter_names, output_scales, output_offsets);
+
     for (uint32_t j = 0; j < series_length; j++) {
         for (uint32_t i = 0; i < input_nodes.size(); i++) {
             if (i > 0) outfile << ",";
             //outfile << series_data[i][j];
-            outfile << time_series_sets->denormalize(input_parameter_names[i], series_data[i][j]);
+            outfile << (series_data[i][j] * input_scales[i]) + input_offsets[i];
         }
 
         for (uint32_t i = 0; i < output_nodes.size(); i++) {
             outfile << ",";
             //outfile << expected_outputs[i][j];
-            outfile << time_series_sets->denormalize(output_parameter_names[i], expected_outputs[i][j]);
+            outfile << (expected_outputs[i][j] * output_scales[i]) + output_offsets[i];
         }
 
         for (uint32_t i = 0; i < output_nodes.size(); i++) {
             outfile << ",";
             //outfile << output_nodes[i]->output_values[j];
-            outfile << time_series_sets->denormalize(output_parameter_names[i], output_nodes[i]->output_values[j]);
+            outfile << (output_nodes[i]->output_values[j] * output_scales[i]) + output_offsets[i];
         }
         outfile << endl;
     }
     outfile.close();
 }
 
-void RNN::write_predictions(string output_filename, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names, const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, Corpus *word_series_sets, bool using_dropout, double dropout_probability) {
+void RNN::write_predictions(string output_filename, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names, const SeriesView &series_data, const SeriesView &expected_outputs, Corpus *word_series_sets, bool using_dropout, double dropout_probability) {
     forward_pass(series_data, using_dropout, false, dropout_probability);
 
     LOG_DEBUG("series_length: %d, series_data.size(): %d, series_data[0].size(): %d\n", series_length, series_data.size(), series_data[0].size());
@@ -638,18 +1248,18 @@ void RNN::write_predictions(string output_filename, const vector<string> &input_
 
 
 
-void RNN::get_analytic_gradient(const vector<double> &test_parameters, const vector< vector<double> > &inputs, const vector< vector<double> > &outputs, double &mse, vector<double> &analytic_gradient, bool using_dropout, bool training, double dropout_probability) {
+void RNN::get_analytic_gradient(const vector<double> &test_parameters, const SeriesView &inputs, const SeriesView &outputs, double &mse, vector<double> &analytic_gradient, bool using_dropout, bool training, double dropout_probability) {
     analytic_gradient.assign(test_parameters.size(), 0.0);
 
     set_weights(test_parameters);
-    forward_pass(inputs, using_dropout, training, dropout_probability);
 
     if (use_regression) {
+        forward_pass(inputs, using_dropout, training, dropout_probability);
         mse = calculate_error_mse(outputs);
         backward_pass(mse * (1.0 / outputs[0].size())*2.0, using_dropout, training, dropout_probability);
 
     } else {
-        mse = calculate_error_softmax(outputs);
+        mse = prediction_softmax(inputs, outputs, using_dropout, training, dropout_probability);
         backward_pass(mse * (1.0 / outputs[0].size()), using_dropout, training, dropout_probability);
     
     }
@@ -683,15 +1293,31 @@ void RNN::get_analytic_gradient(const vector<double> &test_parameters, const vec
     }
 }
 
-void RNN::get_empirical_gradient(const vector<double> &test_parameters, const vector< vector<double> > &inputs, const vector< vector<double> > &outputs, double &mse, vector<double> &empirical_gradient, bool using_dropout, bool training, double dropout_probability) {
+/**
+ * Without regression the empirical gradient is of the same softmax as the
+ * analytic gradient.  The output nodes of a sampled or class based softmax
+ * are selected once and used for every pass, so a sampled softmax's gradient
+ * is that of the loss over the words sampled first.
+ */
+void RNN::get_empirical_gradient(const vector<double> &test_parameters, const SeriesView &inputs, const SeriesView &outputs, double &mse, vector<double> &empirical_gradient, bool using_dropout, bool training, double dropout_probability) {
     empirical_gradient.assign(test_parameters.size(), 0.0);
 
     vector< vector<double> > deltas;
 
+    bool select_outputs = false;
+    if (!use_regression) {
+        if (word_classes.size() > 0) {
+            select_class_outputs(outputs);
+            select_outputs = true;
+        } else if (training && softmax_samples > 0) {
+            select_sampled_outputs(outputs);
+            select_outputs = true;
+        }
+    }
 
     set_weights(test_parameters);
-    forward_pass(inputs, using_dropout, training, dropout_probability);
-    double original_mse = calculate_error_mse(outputs);
+    forward_pass(inputs, using_dropout, training, dropout_probability, select_outputs);
+    double original_mse = use_regression ? calculate_error_mse(outputs) : calculate_selected_error_softmax(outputs, select_outputs);
 
     double save;
     double diff = 0.00001;
@@ -703,16 +1329,19 @@ void RNN::get_empirical_gradient(const vector<double> &test_parameters, const ve
 
         parameters[i] = save - diff;
         set_weights(parameters);
-        forward_pass(inputs, using_dropout, training, dropout_probability);
-        get_mse(this, outputs, mse1, deltas);
+        forward_pass(inputs, using_dropout, training, dropout_probability, select_outputs);
+        if (use_regression) get_mse(this, outputs, mse1, deltas);
+        else mse1 = calculate_selected_error_softmax(outputs, select_outputs);
 
         parameters[i] = save + diff;
         set_weights(parameters);
-        forward_pass(inputs, using_dropout, training, dropout_probability);
-        get_mse(this, outputs, mse2, deltas);
+        forward_pass(inputs, using_dropout, training, dropout_probability, select_outputs);
+        if (use_regression) get_mse(this, outputs, mse2, deltas);
+        else mse2 = calculate_selected_error_softmax(outputs, select_outputs);
 
         empirical_gradient[i] = (mse2 - mse1) / (2.0 * diff);
-        empirical_gradient[i] *= original_mse;
+        if (use_regression) empirical_gradient[i] *= original_mse;
+        else empirical_gradient[i] *= original_mse * (1.0 / outputs[0].size());
 
         parameters[i] = save;
     }
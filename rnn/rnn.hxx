@@ -1,6 +1,9 @@
 #ifndef EXAMM_RNN_GENOME_HXX
 #define EXAMM_RNN_GENOME_HXX
 
+#include <random>
+using std::minstd_rand0;
+
 #include <string>
 using std::string;
 
@@ -12,6 +15,7 @@ using std::vector;
 #include "rnn_edge.hxx"
 #include "rnn_recurrent_edge.hxx"
 
+#include "time_series/series_view.hxx"
 #include "time_series/time_series.hxx"
 #include "word_series/word_series.hxx"
 
@@ -27,6 +31,71 @@ class RNN {
         vector<RNN_Edge*> edges;
         vector<RNN_Recurrent_Edge*> recurrent_edges;
 
+        /**
+         * With one hot inputs (e.g., the words of a Corpus) only one input
+         * node is active at each time step.  Every inactive input node has
+         * the same output at every time step, so what their edges add to
+         * each node they connect to is calculated once per pass and only the
+         * active input node's edges are propagated.
+         */
+        bool one_hot_inputs_possible; /**< false if an input node is not a simple node with only its input value as input. */
+        vector< vector<RNN_Edge*> > input_edges; /**< the reachable feed forward edges out of each input node. */
+        vector< vector<int32_t> > input_edge_targets; /**< the index (in input_targets) of the output node of each input edge. */
+        vector<RNN_Edge*> non_input_edges; /**< the other reachable feed forward edges, in the same order as edges. */
+        vector<RNN_Node_Interface*> input_targets;
+        vector<int32_t> input_target_counts; /**< the number of input edges into each of the input_targets. */
+
+        bool one_hot_pass; /**< true if the last forward pass only propagated the active input nodes. */
+        vector<int32_t> one_hot_tokens;
+        vector<double> inactive_outputs;
+        vector<double> inactive_derivatives;
+        vector<double> inactive_target_inputs;
+
+        /**
+         * A sampled or class based hierarchical softmax only calculates some
+         * of the output nodes at each time step (e.g., the expected word and
+         * a sample of the other words), so only the feed forward edges into
+         * those output nodes are propagated.  Output nodes with recurrent
+         * edges are always calculated.
+         */
+        int32_t softmax_samples; /**< if > 0, training uses a softmax over the expected word and this many sampled other words. */
+        vector<int32_t> word_classes; /**< if not empty, the class of each word output node, the class output nodes are after the word output nodes. */
+        vector< vector<int32_t> > class_words; /**< the word output nodes in each class. */
+
+        vector<bool> output_selectable; /**< false for the output nodes which are always calculated. */
+        vector<int32_t> unselectable_outputs;
+        vector< vector<RNN_Edge*> > output_edges; /**< the reachable feed forward edges into each selectable output node. */
+        vector<RNN_Edge*> non_output_edges; /**< the other reachable feed forward edges, in the same order as edges. */
+        vector<RNN_Edge*> non_input_output_edges; /**< the non_output_edges which are not input edges. */
+        vector<RNN_Node_Interface*> output_edge_sources;
+        vector<int32_t> output_edge_source_counts; /**< the number of output edges out of each of the output_edge_sources. */
+        vector< vector<int32_t> > input_edge_outputs; /**< the selectable output node of each input edge, or -1. */
+
+        bool sampled_pass; /**< true if the last forward pass only calculated the selected output nodes. */
+        vector<int32_t> selected_outputs; /**< the output nodes used by the softmax at each time step. */
+        vector<int32_t> selected_output_starts; /**< where each time step's output nodes start in selected_outputs. */
+        vector<int32_t> output_selected_times; /**< the last time step each output node was selected at. */
+        vector<double> softmax_values;
+        minstd_rand0 generator;
+
+        void initialize_one_hot_inputs();
+        void one_hot_forward_pass(const SeriesView &series_data);
+        void one_hot_gradients();
+
+        void initialize_selectable_outputs();
+        int32_t get_expected_output(const SeriesView &expected_outputs, int32_t time, int32_t number_words) const;
+        void select_sampled_outputs(const SeriesView &expected_outputs);
+        void select_class_outputs(const SeriesView &expected_outputs);
+        void mark_selected_outputs(int32_t time);
+        void selected_outputs_forward(int32_t time, bool using_dropout, bool training, double dropout_probability);
+        void selected_outputs_backward(int32_t time, double error, bool using_dropout, bool training, double dropout_probability);
+        double calculate_softmax_error(const int32_t *outputs, int32_t number_outputs, int32_t time, int32_t expected);
+        double calculate_error_sampled_softmax();
+        double calculate_error_class_softmax(const SeriesView &expected_outputs);
+        double calculate_selected_error_softmax(const SeriesView &expected_outputs, bool select_outputs);
+
+        void forward_pass(const SeriesView &series_data, bool using_dropout, bool training, double dropout_probability, bool select_outputs);
+
     public:
         RNN(vector<RNN_Node_Interface*> &_nodes, vector<RNN_Edge*> &_edges, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names);
         RNN(vector<RNN_Node_Interface*> &_nodes, vector<RNN_Edge*> &_edges, vector<RNN_Recurrent_Edge*> &_recurrent_edges, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names);
@@ -41,37 +110,61 @@ class RNN {
         RNN_Node_Interface* get_node(int i);
         RNN_Edge* get_edge(int i);
 
-        void forward_pass(const vector< vector<double> > &series_data, bool using_dropout, bool training, double dropout_probability);
+        void forward_pass(const SeriesView &series_data, bool using_dropout, bool training, double dropout_probability);
         void backward_pass(double error, bool using_dropout, bool training, double dropout_probability);
 
-        double calculate_error_softmax(const vector< vector<double> > &expected_outputs);
-        double calculate_error_mse(const vector< vector<double> > &expected_outputs);
-        double calculate_error_mae(const vector< vector<double> > &expected_outputs);
+        double calculate_error_softmax(const SeriesView &expected_outputs);
+        double calculate_error_mse(const SeriesView &expected_outputs);
+        double calculate_error_mae(const SeriesView &expected_outputs);
 
-        double prediction_softmax(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, bool training, double dropout_probability);
-        double prediction_mse(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, bool training, double dropout_probability);
-        double prediction_mae(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool using_dropout, bool training, double dropout_probability);
+        double prediction_softmax(const SeriesView &series_data, const SeriesView &expected_outputs, bool using_dropout, bool training, double dropout_probability);
+        double prediction_mse(const SeriesView &series_data, const SeriesView &expected_outputs, bool using_dropout, bool training, double dropout_probability);
+        double prediction_mae(const SeriesView &series_data, const SeriesView &expected_outputs, bool using_dropout, bool training, double dropout_probability);
 
 
-        vector<double> get_predictions(const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, bool usng_dropout, double dropout_probability);
+        vector<double> get_predictions(const SeriesView &series_data, const SeriesView &expected_outputs, bool usng_dropout, double dropout_probability);
 
-        void write_predictions(string output_filename, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names, const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, TimeSeriesSets *time_series_sets, bool using_dropout, double dropout_probability);
-        void write_predictions(string output_filename, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names, const vector< vector<double> > &series_data, const vector< vector<double> > &expected_outputs, Corpus *word_series_sets, bool using_dropout, double dropout_probability);
+        void write_predictions(string output_filename, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names, const SeriesView &series_data, const SeriesView &expected_outputs, TimeSeriesSets *time_series_sets, bool using_dropout, double dropout_probability);
+        void write_predictions(string output_filename, const vector<string> &input_parameter_names, const vector<string> &output_parameter_names, const SeriesView &series_data, const SeriesView &expected_outputs, Corpus *word_series_sets, bool using_dropout, double dropout_probability);
 
         void initialize_randomly();
         void get_weights(vector<double> &parameters);
         void set_weights(const vector<double> &parameters);
         void enable_use_regression(bool _use_regression);
 
+        /**
+         * Trains with a softmax over the expected word and this many randomly
+         * sampled other words at each time step instead of over every word,
+         * 0 (the default) trains with the full softmax.  Validation is always
+         * done with the full softmax.
+         */
+        void set_softmax_samples(int32_t _softmax_samples);
+
+        /**
+         * Uses a class based hierarchical softmax, where word_classes[i] is the
+         * class of output node i, and the output nodes after the words are the
+         * classes.  The probability of a word is the softmax of its class over
+         * the class output nodes times its softmax over the word output nodes
+         * of its class.
+         */
+        void set_word_classes(const vector<int32_t> &_word_classes);
+
+        /**
+         * Reseeds the generator the words of a sampled softmax are sampled
+         * with, so the same words can be sampled again (e.g., to compare the
+         * analytic and empirical gradients of a sampled softmax).
+         */
+        void set_softmax_seed(unsigned seed);
+
         uint32_t get_number_weights();
 
-        void get_analytic_gradient(const vector<double> &test_parameters, const vector< vector<double> > &inputs, const vector< vector<double> > &outputs, double &mse, vector<double> &analytic_gradient, bool using_dropout, bool training, double dropout_probability);
-        void get_empirical_gradient(const vector<double> &test_parameters, const vector< vector<double> > &inputs, const vector< vector<double> > &outputs, double &mae, vector<double> &empirical_gradient, bool using_dropout, bool training, double dropout_probability);
+        void get_analytic_gradient(const vector<double> &test_parameters, const SeriesView &inputs, const SeriesView &outputs, double &mse, vector<double> &analytic_gradient, bool using_dropout, bool training, double dropout_probability);
+        void get_empirical_gradient(const vector<double> &test_parameters, const SeriesView &inputs, const SeriesView &outputs, double &mae, vector<double> &empirical_gradient, bool using_dropout, bool training, double dropout_probability);
 
         //RNN* copy();
 
-        friend void get_mse(RNN* genome, const vector< vector<double> > &expected, double &mse, vector< vector<double> > &deltas);
-        friend void get_mae(RNN* genome, const vector< vector<double> > &expected, double &mae, vector< vector<double> > &deltas);
+        friend void get_mse(RNN* genome, const SeriesView &expected, double &mse, vector< vector<double> > &deltas);
+        friend void get_mae(RNN* genome, const SeriesView &expected, double &mae, vector< vector<double> > &deltas);
 };
 
 #endif
@@ -121,6 +121,8 @@ RNN_Genome::RNN_Genome(vector<RNN_Node_Interface*> &_nodes,
     use_dropout = false;
     dropout_probability = 0.5;
 
+    softmax_samples = 0;
+
     log_filename = "";
 
     uint16_t seed = std::chrono::system_clock::now().time_since_epoch().count();
@@ -184,6 +186,9 @@ RNN_Genome* RNN_Genome::copy() {
     other->use_dropout = use_dropout;
     other->dropout_probability = dropout_probability;
 
+    other->softmax_samples = softmax_samples;
+    other->word_classes = word_classes;
+
     other->log_filename = log_filename;
 
     other->generated_by_map = generated_by_map;
@@ -508,6 +513,14 @@ void RNN_Genome::enable_use_regression(bool _use_regression) {
     use_regression = _use_regression;
 }
 
+void RNN_Genome::set_softmax_samples(int32_t _softmax_samples) {
+    softmax_samples = _softmax_samples;
+}
+
+void RNN_Genome::set_word_classes(const vector<int32_t> &_word_classes) {
+    word_classes = _word_classes;
+}
+
 void RNN_Genome::set_log_filename(string _log_filename) {
     log_filename = _log_filename;
 }
@@ -822,7 +835,11 @@ RNN* RNN_Genome::get_rnn() {
         //if (recurrent_edges[i]->is_reachable()) recurrent_edge_copies.push_back( recurrent_edges[i]->copy(node_copies) );
     }
 
-    return new RNN(node_copies, edge_copies, recurrent_edge_copies, input_parameter_names, output_parameter_names);
+    RNN *rnn = new RNN(node_copies, edge_copies, recurrent_edge_copies, input_parameter_names, output_parameter_names);
+    rnn->set_softmax_samples(softmax_samples);
+    if (word_classes.size() > 0) rnn->set_word_classes(word_classes);
+
+    return rnn;
 }
 
 vector<double> RNN_Genome::get_best_parameters() const {
@@ -875,7 +892,7 @@ bool RNN_Genome::sanity_check() {
 }
 
 
-void forward_pass_thread_regression(RNN* rnn, const vector<double> &parameters, const vector< vector<double> > &inputs, const vector< vector<double> > &outputs, uint32_t i, double *mses, bool use_dropout, bool training, double dropout_probability) {
+void forward_pass_thread_regression(RNN* rnn, const vector<double> &parameters, const SeriesView &inputs, const SeriesView &outputs, uint32_t i, double *mses, bool use_dropout, bool training, double dropout_probability) {
     rnn->set_weights(parameters);
     rnn->forward_pass(inputs, use_dropout, training, dropout_probability);
     mses[i] = rnn->calculate_error_mse(outputs);
@@ -884,16 +901,15 @@ void forward_pass_thread_regression(RNN* rnn, const vector<double> &parameters,
     LOG_TRACE("mse[%d]: %lf\n", i, mses[i]);
 }
 
-void forward_pass_thread_classification(RNN* rnn, const vector<double> &parameters, const vector< vector<double> > &inputs, const vector< vector<double> > &outputs, uint32_t i, double *mses, bool use_dropout, bool training, double dropout_probability) {
+void forward_pass_thread_classification(RNN* rnn, const vector<double> &parameters, const SeriesView &inputs, const SeriesView &outputs, uint32_t i, double *mses, bool use_dropout, bool training, double dropout_probability) {
     rnn->set_weights(parameters);
-    rnn->forward_pass(inputs, use_dropout, training, dropout_probability);
-    mses[i] = rnn->calculate_error_softmax(outputs);
+    mses[i] = rnn->prediction_softmax(inputs, outputs, use_dropout, training, dropout_probability);
     //mses[i] = rnn->calculate_error_mae(outputs);
 
     LOG_TRACE("mse[%d]: %lf\n", i, mses[i]);
 }
 
-void RNN_Genome::get_analytic_gradient(vector<RNN*> &rnns, const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, double &mse, vector<double> &analytic_gradient, bool training) {
+void RNN_Genome::get_analytic_gradient(vector<RNN*> &rnns, const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs, double &mse, vector<double> &analytic_gradient, bool training) {
 
     double *mses = new double[rnns.size()];
     double mse_sum = 0.0;
@@ -952,7 +968,7 @@ void RNN_Genome::get_analytic_gradient(vector<RNN*> &rnns, const vector<double>
 }
 
 
-void RNN_Genome::backpropagate(const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, const vector< vector< vector<double> > > &validation_inputs, const vector< vector< vector<double> > > &validation_outputs) {
+void RNN_Genome::backpropagate(const DatasetView &inputs, const DatasetView &outputs, const DatasetView &validation_inputs, const DatasetView &validation_outputs) {
 
     double learning_rate = this->learning_rate / inputs.size();
     double low_threshold = sqrt(this->low_threshold * inputs.size());
@@ -1173,7 +1189,7 @@ void RNN_Genome::backpropagate(const vector< vector< vector<double> > > &inputs,
     this->set_weights(best_parameters);
 }
 
-void RNN_Genome::backpropagate_stochastic(const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, const vector< vector< vector<double> > > &validation_inputs, const vector< vector< vector<double> > > &validation_outputs) {
+void RNN_Genome::backpropagate_stochastic(const DatasetView &inputs, const DatasetView &outputs, const DatasetView &validation_inputs, const DatasetView &validation_outputs) {
     vector<double> parameters = initial_parameters;
 
     int n_parameters = this->get_number_weights();
@@ -1471,7 +1487,7 @@ void RNN_Genome::backpropagate_stochastic(const vector< vector< vector<double> >
     get_mu_sigma(best_parameters, _mu, _sigma);
 }
 
-double RNN_Genome::get_softmax(const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs) {
+double RNN_Genome::get_softmax(const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs) {
     RNN *rnn = get_rnn();
     rnn->enable_use_regression(use_regression);
     rnn->set_weights(parameters);
@@ -1494,7 +1510,7 @@ double RNN_Genome::get_softmax(const vector<double> &parameters, const vector< v
     return avg_softmax;
 }
 
-double RNN_Genome::get_mse(const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs) {
+double RNN_Genome::get_mse(const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs) {
     RNN *rnn = get_rnn();
     rnn->enable_use_regression(use_regression);
     rnn->set_weights(parameters);
@@ -1517,7 +1533,7 @@ double RNN_Genome::get_mse(const vector<double> &parameters, const vector< vecto
     return avg_mse;
 }
 
-double RNN_Genome::get_mae(const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs) {
+double RNN_Genome::get_mae(const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs) {
     RNN *rnn = get_rnn();
     rnn->enable_use_regression(use_regression);
     rnn->set_weights(parameters);
@@ -1540,7 +1556,7 @@ double RNN_Genome::get_mae(const vector<double> &parameters, const vector< vecto
     return avg_mae;
 }
 
-vector< vector<double> > RNN_Genome::get_predictions(const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs) {
+vector< vector<double> > RNN_Genome::get_predictions(const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs) {
     RNN *rnn = get_rnn();
     rnn->set_weights(parameters);
 
@@ -1557,7 +1573,7 @@ vector< vector<double> > RNN_Genome::get_predictions(const vector<double> &param
 }
 
 
-void RNN_Genome::write_predictions(string output_directory, const vector<string> &input_filenames, const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, TimeSeriesSets *time_series_sets) {
+void RNN_Genome::write_predictions(string output_directory, const vector<string> &input_filenames, const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs, TimeSeriesSets *time_series_sets) {
     RNN *rnn = get_rnn();
     rnn->set_weights(parameters);
 
@@ -1582,7 +1598,7 @@ void RNN_Genome::write_predictions(string output_directory, const vector<string>
 }
 
 
-void RNN_Genome::write_predictions(string output_directory, const vector<string> &input_filenames, const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, Corpus *word_series_sets) {
+void RNN_Genome::write_predictions(string output_directory, const vector<string> &input_filenames, const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs, Corpus *word_series_sets) {
     RNN *rnn = get_rnn();
     rnn->set_weights(parameters);
 
@@ -3003,7 +3019,11 @@ string RNN_Genome::get_color(double weight, bool is_recurrent) {
 
 void RNN_Genome::write_graphviz(string filename) {
     ofstream outfile(filename);
+    write_graphviz(outfile);
+    outfile.close();
+}
 
+void RNN_Genome::write_graphviz(ostream &outfile) {
     outfile << "digraph RNN {" << endl;
     outfile << "labelloc=\"t\";" << endl;
     outfile << "label=\"Genome Fitness: " << best_validation_mae * 100.0 << "% MAE\";" << endl;
@@ -3122,8 +3142,6 @@ void RNN_Genome::write_graphviz(string filename) {
 
 
     outfile << "}" << endl;
-    outfile.close();
-
 }
 
 void read_map(istream &in, map<string, double> &m) {
@@ -3249,6 +3267,10 @@ void RNN_Genome::read_from_stream(istream &bin_istream) {
     bin_istream.read((char*)&use_dropout, sizeof(bool));
     bin_istream.read((char*)&dropout_probability, sizeof(double));
 
+    //the softmax is set by whatever is training the genome, it is not written with it
+    softmax_samples = 0;
+    word_classes.clear();
+
     bin_istream.read((char*)&weight_initialize, sizeof(int32_t));
     bin_istream.read((char*)&weight_inheritance, sizeof(int32_t));
     bin_istream.read((char*)&mutated_component_weight, sizeof(int32_t));
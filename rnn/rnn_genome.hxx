@@ -26,6 +26,7 @@ using std::vector;
 
 #include "common/random.hxx"
 #include "common/weight_initialize.hxx"
+#include "time_series/series_view.hxx"
 #include "time_series/time_series.hxx"
 #include "word_series/word_series.hxx"
 
@@ -51,6 +52,8 @@ class RNN_Genome {
         double low_threshold;
 
         bool use_regression;
+        int32_t softmax_samples; /**< if > 0, trains with a sampled softmax (see RNN::set_softmax_samples). */
+        vector<int32_t> word_classes; /**< if not empty, uses a class based softmax (see RNN::set_word_classes). */
 
         bool use_dropout;
         double dropout_probability;
@@ -162,6 +165,8 @@ class RNN_Genome {
         void disable_dropout();
         void enable_dropout(double _dropout_probability);
         void enable_use_regression(bool _use_regression);
+        void set_softmax_samples(int32_t _softmax_samples);
+        void set_word_classes(const vector<int32_t> &_word_classes);
         void set_log_filename(string _log_filename);
 
         void get_weights(vector<double> &parameters);
@@ -200,20 +205,20 @@ class RNN_Genome {
         void set_best_parameters( vector<double> parameters);    //INFO: ADDED BY ABDELRAHMAN TO USE FOR TRANSFER LEARNING
         void set_initial_parameters( vector<double> parameters);  //INFO: ADDED BY ABDELRAHMAN TO USE FOR TRANSFER LEARNING
 
-        void get_analytic_gradient(vector<RNN*> &rnns, const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, double &mse, vector<double> &analytic_gradient, bool training);
+        void get_analytic_gradient(vector<RNN*> &rnns, const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs, double &mse, vector<double> &analytic_gradient, bool training);
 
-        void backpropagate(const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, const vector< vector< vector<double> > > &validation_inputs, const vector< vector< vector<double> > > &validation_outputs);
+        void backpropagate(const DatasetView &inputs, const DatasetView &outputs, const DatasetView &validation_inputs, const DatasetView &validation_outputs);
 
-        void backpropagate_stochastic(const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, const vector< vector< vector<double> > > &validation_inputs, const vector< vector< vector<double> > > &validation_outputs);
+        void backpropagate_stochastic(const DatasetView &inputs, const DatasetView &outputs, const DatasetView &validation_inputs, const DatasetView &validation_outputs);
 
-        double get_softmax(const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs);
-        double get_mse(const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs);
-        double get_mae(const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs);
+        double get_softmax(const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs);
+        double get_mse(const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs);
+        double get_mae(const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs);
 
 
-        vector< vector<double> > get_predictions(const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs);
-        void write_predictions(string output_directory, const vector<string> &input_filenames, const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, TimeSeriesSets *time_series_sets);
-        void write_predictions(string output_directory, const vector<string> &input_filenames, const vector<double> &parameters, const vector< vector< vector<double> > > &inputs, const vector< vector< vector<double> > > &outputs, Corpus * word_series_sets);
+        vector< vector<double> > get_predictions(const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs);
+        void write_predictions(string output_directory, const vector<string> &input_filenames, const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs, TimeSeriesSets *time_series_sets);
+        void write_predictions(string output_directory, const vector<string> &input_filenames, const vector<double> &parameters, const DatasetView &inputs, const DatasetView &outputs, Corpus * word_series_sets);
 
         void get_mu_sigma(const vector<double> &p, double &mu, double &sigma);
 
@@ -257,6 +262,7 @@ class RNN_Genome {
 
         string get_color(double weight, bool is_recurrent);
         void write_graphviz(string filename);
+        void write_graphviz(ostream &outfile);
 
         RNN_Genome(string binary_filename);
         RNN_Genome(char* array, int32_t length);
@@ -74,6 +74,15 @@ void RNN_Node::input_fired(int time, double incoming_output) {
 #endif
 }
 
+void RNN_Node::fire_constant_input(double input_value) {
+    double output_value = tanh(input_value + bias);
+
+    inputs_fired.assign(series_length, total_inputs);
+    input_values.assign(series_length, input_value);
+    output_values.assign(series_length, output_value);
+    ld_output.assign(series_length, tanh_derivative(output_value));
+}
+
 void RNN_Node::try_update_deltas(int time) {
     if (outputs_fired[time] < total_outputs) return;
     else if (outputs_fired[time] > total_outputs) {
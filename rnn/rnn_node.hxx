@@ -29,6 +29,12 @@ class RNN_Node : public RNN_Node_Interface {
         
         void input_fired(int time, double incoming_output);
 
+        /**
+         * Fires the same input value at every time step at once, for input
+         * nodes whose (one hot) input is inactive at most time steps.
+         */
+        void fire_constant_input(double input_value);
+
         void try_update_deltas(int time);
         void output_fired(int time, double delta);
         void error_fired(int time, double error);
@@ -48,6 +54,7 @@ class RNN_Node : public RNN_Node_Interface {
         void write_to_stream(ostream &out);
 
         friend class RNN_Edge;
+        friend class RNN;
 };
 
 #endif
@@ -17,6 +17,7 @@ using std::string;
 using std::vector;
 
 #include "common/random.hxx"
+#include "time_series/series_view.hxx"
 
 class RNN;
 
@@ -129,8 +130,8 @@ class RNN_Node_Interface {
         friend class RNN;
         friend class RNN_Genome;
 
-        friend void get_mse(RNN* genome, const vector< vector<double> > &expected, double &mse, vector< vector<double> > &deltas);
-        friend void get_mae(RNN* genome, const vector< vector<double> > &expected, double &mae, vector< vector<double> > &deltas);
+        friend void get_mse(RNN* genome, const SeriesView &expected, double &mse, vector< vector<double> > &deltas);
+        friend void get_mae(RNN* genome, const SeriesView &expected, double &mae, vector< vector<double> > &deltas);
 };
 
 
@@ -90,6 +90,16 @@ class SpeciationStrategy {
         virtual string get_strategy_information_values() const = 0;
 
         virtual RNN_Genome* get_global_best_genome() = 0;
+
+        /**
+         * Checks if a previously generated genome can no longer be inserted
+         * because the island (or species) it was generated for has been erased
+         * since it was generated.
+         *
+         * \param genome is the generated genome to check
+         * \return true if the genome would not be inserted
+         */
+        virtual bool was_erased(RNN_Genome *genome) = 0;
 };
 
 #endif
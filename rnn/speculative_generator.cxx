@@ -0,0 +1,167 @@
+#include <condition_variable>
+using std::condition_variable;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/log.hxx"
+
+#include "examm.hxx"
+#include "rnn_genome.hxx"
+#include "speculative_generator.hxx"
+
+SpeculativeGenerator::SpeculativeGenerator(EXAMM *_examm, mutex &_examm_mutex, int32_t _max_queue_size, int32_t _max_staleness) :
+                        examm(_examm),
+                        examm_mutex(_examm_mutex),
+                        max_queue_size(_max_queue_size),
+                        max_staleness(_max_staleness),
+                        search_completed(false),
+                        stopping(false),
+                        genomes_handed_out(0),
+                        discarded_erased(0),
+                        discarded_stale(0),
+                        requests(0),
+                        queue_empty(0),
+                        total_queue_depth(0) {
+
+    if (max_queue_size < 1) {
+        LOG_FATAL("ERROR: speculative generation queue size must be at least 1, was %d\n", max_queue_size);
+        exit(1);
+    }
+
+    producer = thread(&SpeculativeGenerator::produce, this);
+}
+
+SpeculativeGenerator::~SpeculativeGenerator() {
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_all();
+    producer.join();
+
+    for (int32_t i = 0; i < (int32_t)queue.size(); i++) {
+        delete queue[i];
+    }
+}
+
+void SpeculativeGenerator::produce() {
+    Log::set_id("speculative_generator");
+
+    while (true) {
+        unique_lock<mutex> lock(queue_mutex);
+        queue_cv.wait(lock, [this]{ return stopping || (int32_t)queue.size() < max_queue_size; });
+        if (stopping) break;
+        lock.unlock();
+
+        examm_mutex.lock();
+        RNN_Genome *genome = examm->generate_genome();
+        int32_t inserted_genomes = examm->get_inserted_genomes();
+        examm_mutex.unlock();
+
+        lock.lock();
+        if (genome == NULL) {
+            //generate_genome returns NULL when the search is done
+            search_completed = true;
+            lock.unlock();
+            queue_cv.notify_all();
+            break;
+        }
+
+        queue.push_back(genome);
+        queue_inserted_genomes.push_back(inserted_genomes);
+        LOG_DEBUG("generated genome %d, queue depth: %d\n", genome->get_generation_id(), queue.size());
+
+        lock.unlock();
+        queue_cv.notify_all();
+    }
+
+    Log::release_id("speculative_generator");
+}
+
+RNN_Genome* SpeculativeGenerator::get_genome() {
+    unique_lock<mutex> lock(queue_mutex);
+
+    requests++;
+    total_queue_depth += queue.size();
+    if (queue.size() == 0 && !search_completed) queue_empty++;
+
+    while (true) {
+        queue_cv.wait(lock, [this]{ return search_completed || queue.size() > 0; });
+
+        if (queue.size() == 0) return NULL;
+
+        RNN_Genome *genome = queue.front();
+        int32_t generated_inserted_genomes = queue_inserted_genomes.front();
+        queue.pop_front();
+        queue_inserted_genomes.pop_front();
+
+        //let the producer replace the genome while this one is checked
+        lock.unlock();
+        queue_cv.notify_all();
+
+        examm_mutex.lock();
+        bool completed = examm->get_inserted_genomes() > examm->get_max_genomes();
+        bool erased = examm->was_erased(genome);
+        int32_t inserted_since = examm->get_inserted_genomes() - generated_inserted_genomes;
+        examm_mutex.unlock();
+
+        lock.lock();
+
+        if (completed) {
+            //genomes generated before the search completed do not need to be trained
+            delete genome;
+            continue;
+
+        } else if (erased) {
+            LOG_DEBUG("discarding genome %d, its island was erased after it was generated\n", genome->get_generation_id());
+            discarded_erased++;
+            delete genome;
+
+        } else if (max_staleness >= 0 && inserted_since > max_staleness) {
+            LOG_DEBUG("discarding genome %d, %d genomes were inserted after it was generated\n", genome->get_generation_id(), inserted_since);
+            discarded_stale++;
+            delete genome;
+
+        } else {
+            genomes_handed_out++;
+            return genome;
+        }
+    }
+}
+
+int64_t SpeculativeGenerator::get_genomes_handed_out() {
+    lock_guard<mutex> lock(queue_mutex);
+    return genomes_handed_out;
+}
+
+int64_t SpeculativeGenerator::get_discarded_erased() {
+    lock_guard<mutex> lock(queue_mutex);
+    return discarded_erased;
+}
+
+int64_t SpeculativeGenerator::get_discarded_stale() {
+    lock_guard<mutex> lock(queue_mutex);
+    return discarded_stale;
+}
+
+double SpeculativeGenerator::get_average_queue_depth() {
+    lock_guard<mutex> lock(queue_mutex);
+    if (requests == 0) return 0.0;
+    return (double)total_queue_depth / requests;
+}
+
+void SpeculativeGenerator::print_statistics() {
+    double average_queue_depth = get_average_queue_depth();
+
+    lock_guard<mutex> lock(queue_mutex);
+    LOG_INFO("speculative generation: %ld genomes handed out, average queue depth: %lf, queue empty %ld times, %ld discarded for erased islands, %ld discarded as stale\n", genomes_handed_out, average_queue_depth, queue_empty, discarded_erased, discarded_stale);
+}
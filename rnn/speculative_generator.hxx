@@ -0,0 +1,87 @@
+#ifndef EXAMM_SPECULATIVE_GENERATOR_HXX
+#define EXAMM_SPECULATIVE_GENERATOR_HXX
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <mutex>
+using std::mutex;
+
+#include <thread>
+using std::thread;
+
+#include "examm.hxx"
+#include "rnn_genome.hxx"
+
+/**
+ * Generates genomes ahead of time on a background thread so that workers
+ * asking for a genome do not have to wait for crossover, mutation and
+ * reachability calculations.
+ *
+ * The producer thread keeps a bounded queue of generated genomes.  As the
+ * population changes while genomes wait in the queue, a genome is discarded
+ * instead of handed out if the island it was generated for has been erased
+ * and repopulated since (as it would never be inserted), or if more than
+ * max_staleness genomes have been inserted since it was generated.
+ *
+ * All calls to the EXAMM object are made holding examm_mutex, which must be
+ * the same mutex the caller holds when inserting genomes.  The caller must
+ * not hold examm_mutex when calling get_genome.
+ */
+class SpeculativeGenerator {
+    private:
+        EXAMM *examm;
+        mutex &examm_mutex;
+
+        int32_t max_queue_size; /**< the maximum number of generated genomes waiting to be handed out. */
+        int32_t max_staleness; /**< discard genomes if more than this many genomes were inserted after they were generated, < 0 for no limit. */
+
+        mutex queue_mutex;
+        condition_variable queue_cv;
+        deque<RNN_Genome*> queue;
+        deque<int32_t> queue_inserted_genomes; /**< the number of inserted genomes when each queued genome was generated. */
+
+        bool search_completed;
+        bool stopping;
+
+        thread producer;
+
+        int64_t genomes_handed_out;
+        int64_t discarded_erased; /**< genomes discarded because their island was erased and repopulated. */
+        int64_t discarded_stale; /**< genomes discarded because too many genomes were inserted since they were generated. */
+        int64_t requests; /**< how many times get_genome has been called. */
+        int64_t queue_empty; /**< how many times get_genome had to wait for a genome to be generated. */
+        int64_t total_queue_depth; /**< the sum of the queue depth at each call to get_genome, used to calculate the average. */
+
+        void produce();
+
+    public:
+        SpeculativeGenerator(EXAMM *_examm, mutex &_examm_mutex, int32_t _max_queue_size, int32_t _max_staleness);
+
+        /**
+         * Stops the producer thread and deletes any genomes left in the queue.
+         */
+        ~SpeculativeGenerator();
+
+        /**
+         * Returns the next genome to train, waiting for the producer thread if
+         * none are ready.  Like EXAMM::generate_genome this returns NULL when the
+         * search has completed.
+         */
+        RNN_Genome* get_genome();
+
+        int64_t get_genomes_handed_out();
+        int64_t get_discarded_erased();
+        int64_t get_discarded_stale();
+        double get_average_queue_depth();
+
+        /**
+         * Logs the queue depth and discard statistics.
+         */
+        void print_statistics();
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include <cmath>
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "common/weight_initialize.hxx"
+
+#include "rnn/rnn.hxx"
+#include "rnn/rnn_genome.hxx"
+
+#include "rnn/generate_nn.hxx"
+
+#include "time_series/series_view.hxx"
+
+#include "gradient_test.hxx"
+
+int one_hot_iterations = 10;
+double one_hot_tolerance = 10e-10;
+
+bool values_match(string name, const vector<double> &sparse, const vector<double> &dense) {
+    if (sparse.size() != dense.size()) {
+        LOG_INFO("\t\tFAILED %s: %d one hot values but %d dense values\n", name.c_str(), (int32_t)sparse.size(), (int32_t)dense.size());
+        return false;
+    }
+
+    bool matched = true;
+    for (uint32_t i = 0; i < sparse.size(); i++) {
+        double difference = sparse[i] - dense[i];
+
+        if (fabs(difference) > one_hot_tolerance * fmax(1.0, fabs(dense[i]))) {
+            LOG_INFO("\t\tFAILED %s[%d]: one hot: %lf, dense: %lf, difference: %lf\n", name.c_str(), i, sparse[i], dense[i], difference);
+            matched = false;
+        }
+    }
+
+    return matched;
+}
+
+/**
+ * Runs the genome with random weights on a one hot view of the tokens and on
+ * the equivalent dense inputs (and expected outputs), where the inputs have
+ * inactive and active values other than 0 and 1 like normalized words do.
+ * The outputs and the analytic gradients (with both the mse and the softmax)
+ * should be the same.
+ *
+ * \return true if they were
+ */
+bool one_hot_test(string name, RNN_Genome *genome, int32_t number_words, int32_t input_length, int32_t number_tokens) {
+    LOG_INFO("\ttesting one hot inputs on '%s'...\n", name.c_str());
+
+    vector<int32_t> input_tokens(number_tokens);
+    vector<int32_t> output_tokens(number_tokens);
+    for (int32_t time = 0; time < number_tokens; time++) {
+        vector<double> token;
+        generate_random_vector(2, token);
+        input_tokens[time] = fmin(number_words - 1, (token[0] + 0.5) * number_words);
+        output_tokens[time] = fmin(number_words - 1, (token[1] + 0.5) * number_words);
+    }
+
+    vector<double> input_inactive(number_words), input_active(number_words);
+    vector<double> output_inactive(number_words, 0.0), output_active(number_words, 1.0);
+    for (int32_t i = 0; i < number_words; i++) {
+        input_inactive[i] = -0.1 * (i + 1);
+        input_active[i] = 1.0 + 0.1 * (i + 1);
+    }
+
+    SeriesView sparse_inputs(input_tokens.data(), number_tokens, input_length, number_words, input_inactive.data(), input_active.data());
+    SeriesView sparse_outputs(output_tokens.data(), number_tokens, input_length, number_words, output_inactive.data(), output_active.data());
+
+    //time steps after the tokens (padding) have no active word
+    vector< vector<double> > inputs(number_words, vector<double>(input_length));
+    vector< vector<double> > outputs(number_words, vector<double>(input_length));
+    for (int32_t i = 0; i < number_words; i++) {
+        for (int32_t time = 0; time < input_length; time++) {
+            bool active = time < number_tokens && input_tokens[time] == i;
+            inputs[i][time] = active ? input_active[i] : input_inactive[i];
+
+            active = time < number_tokens && output_tokens[time] == i;
+            outputs[i][time] = active ? output_active[i] : output_inactive[i];
+        }
+    }
+
+    RNN* rnn = genome->get_rnn();
+    bool passed = true;
+
+    vector<double> parameters;
+    vector<double> sparse_gradient, dense_gradient;
+    double sparse_error, dense_error;
+
+    for (int32_t i = 0; i < one_hot_iterations; i++) {
+        generate_random_vector(rnn->get_number_weights(), parameters);
+
+        rnn->set_weights(parameters);
+        vector<double> sparse_predictions = rnn->get_predictions(sparse_inputs, sparse_outputs, false, 0.0);
+        vector<double> dense_predictions = rnn->get_predictions(inputs, outputs, false, 0.0);
+        passed &= values_match("outputs", sparse_predictions, dense_predictions);
+
+        rnn->enable_use_regression(true);
+        rnn->get_analytic_gradient(parameters, sparse_inputs, outputs, sparse_error, sparse_gradient, false, true, 0.0);
+        rnn->get_analytic_gradient(parameters, inputs, outputs, dense_error, dense_gradient, false, true, 0.0);
+        passed &= values_match("mse", vector<double>(1, sparse_error), vector<double>(1, dense_error));
+        passed &= values_match("mse gradient", sparse_gradient, dense_gradient);
+
+        rnn->enable_use_regression(false);
+        rnn->get_analytic_gradient(parameters, sparse_inputs, sparse_outputs, sparse_error, sparse_gradient, false, true, 0.0);
+        rnn->get_analytic_gradient(parameters, inputs, outputs, dense_error, dense_gradient, false, true, 0.0);
+        passed &= values_match("softmax", vector<double>(1, sparse_error), vector<double>(1, dense_error));
+        passed &= values_match("softmax gradient", sparse_gradient, dense_gradient);
+    }
+
+    delete rnn;
+
+    if (passed) {
+        LOG_INFO("\tPASSED!\n");
+    } else {
+        LOG_INFO("\tFAILED!\n");
+    }
+
+    return passed;
+}
+
+int main(int argc, char **argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    initialize_generator();
+
+    LOG_INFO("TESTING ONE HOT INPUTS\n");
+
+    int input_length = 10;
+    get_argument(arguments, "--input_length", true, input_length);
+
+    int number_words = 5;
+    get_argument(arguments, "--number_words", false, number_words);
+
+    string weight_initialize_string = "random";
+    get_argument(arguments, "--weight_initialize", false, weight_initialize_string);
+
+    WeightType weight_initialize;
+    weight_initialize = get_enum_from_string(weight_initialize_string);
+
+    if (weight_initialize < 0 || weight_initialize >= NUM_WEIGHT_TYPES - 1) {
+        LOG_FATAL("weight initialization method %s is set wrong \n", weight_initialize_string.c_str());
+    }
+
+    vector<string> words;
+    for (int32_t i = 0; i < number_words; i++) {
+        words.push_back("word " + to_string(i));
+    }
+
+    bool passed = true;
+    RNN_Genome *genome;
+
+    for (int32_t max_recurrent_depth = 1; max_recurrent_depth <= 3; max_recurrent_depth++) {
+        LOG_INFO("testing with max recurrent depth: %d\n", max_recurrent_depth);
+
+        //the last two time steps are padding
+        int32_t number_tokens = input_length > 2 ? input_length - 2 : input_length;
+
+        genome = create_ff(words, 0, 0, words, max_recurrent_depth, weight_initialize, WeightType::NONE, WeightType::NONE);
+        passed &= one_hot_test("FF: No Hidden", genome, number_words, input_length, number_tokens);
+        delete genome;
+
+        genome = create_ff(words, 2, 3, words, max_recurrent_depth, weight_initialize, WeightType::NONE, WeightType::NONE);
+        passed &= one_hot_test("FF: 2x3 Hidden", genome, number_words, input_length, number_tokens);
+        delete genome;
+
+        genome = create_elman(words, 1, 3, words, max_recurrent_depth, weight_initialize);
+        passed &= one_hot_test("Elman: 1x3 Hidden", genome, number_words, input_length, number_tokens);
+        delete genome;
+
+        genome = create_jordan(words, 1, 3, words, max_recurrent_depth, weight_initialize);
+        passed &= one_hot_test("Jordan: 1x3 Hidden", genome, number_words, input_length, number_tokens);
+        delete genome;
+
+        genome = create_lstm(words, 2, 2, words, max_recurrent_depth, weight_initialize);
+        passed &= one_hot_test("LSTM: 2x2 Hidden", genome, number_words, input_length, number_tokens);
+        delete genome;
+    }
+
+    if (!passed) {
+        LOG_ERROR("SOME FAILED!\n");
+        exit(1);
+    }
+
+    LOG_INFO("ALL PASSED!\n");
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include <chrono>
+
+#include <cmath>
+
+#include <string>
+using std::string;
+using std::to_string;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+#include "common/weight_initialize.hxx"
+
+#include "rnn/rnn.hxx"
+#include "rnn/rnn_genome.hxx"
+
+#include "rnn/generate_nn.hxx"
+
+#include "time_series/series_view.hxx"
+
+#include "gradient_test.hxx"
+
+int softmax_iterations = 10;
+double softmax_tolerance = 10e-8;
+
+int32_t random_word(int32_t number_words) {
+    vector<double> value;
+    generate_random_vector(1, value);
+    return fmin(number_words - 1, (value[0] + 0.5) * number_words);
+}
+
+/**
+ * Compares the analytic and empirical gradients of the genome's softmax (with
+ * whichever sampled or class based softmax it was set to use) with random
+ * weights, on both dense inputs and a one hot view of the same inputs.  The
+ * generator is reseeded before each gradient so a sampled softmax samples
+ * the same words for both.  Time steps after the tokens are padding, without
+ * an expected word.
+ *
+ * \return true if the gradients matched
+ */
+bool softmax_gradient_test(string name, RNN_Genome *genome, int32_t number_words, const vector<int32_t> &word_classes, int32_t number_classes, int32_t input_length, int32_t number_tokens) {
+    LOG_INFO("\ttesting softmax gradient on '%s'...\n", name.c_str());
+
+    vector<int32_t> input_tokens(number_tokens);
+    vector<int32_t> expected_words(number_tokens);
+    for (int32_t time = 0; time < number_tokens; time++) {
+        input_tokens[time] = random_word(number_words);
+        expected_words[time] = random_word(number_words);
+    }
+
+    vector<double> inactive(number_words, 0.0), active(number_words, 1.0);
+    SeriesView sparse_inputs(input_tokens.data(), number_tokens, input_length, number_words, inactive.data(), active.data());
+
+    //the class outputs (if any) follow the words, and are active for the expected word's class
+    int32_t number_outputs = number_words + number_classes;
+    vector< vector<double> > inputs(number_words, vector<double>(input_length, 0.0));
+    vector< vector<double> > outputs(number_outputs, vector<double>(input_length, 0.0));
+    for (int32_t time = 0; time < number_tokens; time++) {
+        inputs[input_tokens[time]][time] = 1.0;
+        outputs[expected_words[time]][time] = 1.0;
+        if (number_classes > 0) outputs[number_words + word_classes[expected_words[time]]][time] = 1.0;
+    }
+
+    RNN* rnn = genome->get_rnn();
+    rnn->enable_use_regression(false);
+
+    bool passed = true;
+
+    vector<double> parameters;
+    vector<double> analytic_gradient, empirical_gradient;
+    double analytic_error, empirical_error;
+
+    for (int32_t i = 0; i < softmax_iterations; i++) {
+        for (int32_t one_hot = 0; one_hot < 2; one_hot++) {
+            SeriesView input_view = one_hot ? sparse_inputs : SeriesView(inputs);
+
+            generate_random_vector(rnn->get_number_weights(), parameters);
+            unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
+
+            rnn->set_softmax_seed(seed);
+            rnn->get_analytic_gradient(parameters, input_view, outputs, analytic_error, analytic_gradient, false, true, 0.0);
+            rnn->set_softmax_seed(seed);
+            rnn->get_empirical_gradient(parameters, input_view, outputs, empirical_error, empirical_gradient, false, true, 0.0);
+
+            if (fabs(analytic_error - empirical_error) > softmax_tolerance * fmax(1.0, fabs(analytic_error))) {
+                LOG_INFO("\t\tFAILED analytic error: %lf, empirical error: %lf, %s inputs\n", analytic_error, empirical_error, one_hot ? "one hot" : "dense");
+                passed = false;
+            }
+
+            for (uint32_t j = 0; j < analytic_gradient.size(); j++) {
+                double difference = analytic_gradient[j] - empirical_gradient[j];
+
+                if (fabs(difference) > softmax_tolerance * fmax(1.0, fabs(analytic_gradient[j]))) {
+                    LOG_INFO("\t\tFAILED analytic gradient[%d]: %lf, empirical gradient[%d]: %lf, difference: %lf, %s inputs\n", j, analytic_gradient[j], j, empirical_gradient[j], difference, one_hot ? "one hot" : "dense");
+                    passed = false;
+                } else {
+                    LOG_DEBUG("\t\tPASSED analytic gradient[%d]: %lf, empirical gradient[%d]: %lf, difference: %lf, %s inputs\n", j, analytic_gradient[j], j, empirical_gradient[j], difference, one_hot ? "one hot" : "dense");
+                }
+            }
+        }
+    }
+
+    delete rnn;
+
+    if (passed) {
+        LOG_INFO("\tPASSED!\n");
+    } else {
+        LOG_INFO("\tFAILED!\n");
+    }
+
+    return passed;
+}
+
+int main(int argc, char **argv) {
+    vector<string> arguments = vector<string>(argv, argv + argc);
+
+    Log::initialize(arguments);
+    Log::set_id("main");
+
+    initialize_generator();
+
+    LOG_INFO("TESTING SAMPLED AND CLASS BASED SOFTMAX GRADIENTS\n");
+
+    int input_length = 10;
+    get_argument(arguments, "--input_length", true, input_length);
+
+    int number_words = 6;
+    get_argument(arguments, "--number_words", false, number_words);
+
+    int softmax_samples = 2;
+    get_argument(arguments, "--softmax_samples", false, softmax_samples);
+
+    int number_classes = 2;
+    get_argument(arguments, "--number_classes", false, number_classes);
+
+    string weight_initialize_string = "random";
+    get_argument(arguments, "--weight_initialize", false, weight_initialize_string);
+
+    WeightType weight_initialize;
+    weight_initialize = get_enum_from_string(weight_initialize_string);
+
+    if (weight_initialize < 0 || weight_initialize >= NUM_WEIGHT_TYPES - 1) {
+        LOG_FATAL("weight initialization method %s is set wrong \n", weight_initialize_string.c_str());
+    }
+
+    vector<string> words;
+    for (int32_t i = 0; i < number_words; i++) {
+        words.push_back("word " + to_string(i));
+    }
+
+    vector<string> word_outputs = words;
+    vector<int32_t> word_classes;
+    for (int32_t i = 0; i < number_words; i++) {
+        word_classes.push_back(i % number_classes);
+    }
+    for (int32_t i = 0; i < number_classes; i++) {
+        word_outputs.push_back("class " + to_string(i));
+    }
+
+    bool passed = true;
+    RNN_Genome *genome;
+
+    for (int32_t max_recurrent_depth = 1; max_recurrent_depth <= 3; max_recurrent_depth++) {
+        LOG_INFO("testing with max recurrent depth: %d\n", max_recurrent_depth);
+
+        //the full softmax still has errors on padding time steps (where its
+        //cross entropy is 0), so it is only tested without padding
+        int32_t number_tokens = input_length > 2 ? input_length - 2 : input_length;
+
+        for (int32_t structure = 0; structure < 4; structure++) {
+            string structure_name;
+            for (int32_t mode = 0; mode < 3; mode++) {
+                vector<string> &outputs = (mode == 2) ? word_outputs : words;
+
+                if (structure == 0) {
+                    structure_name = "FF: 2x3 Hidden";
+                    genome = create_ff(words, 2, 3, outputs, max_recurrent_depth, weight_initialize, WeightType::NONE, WeightType::NONE);
+                } else if (structure == 1) {
+                    //the jordan outputs have recurrent edges, so they are always calculated
+                    structure_name = "Jordan: 1x3 Hidden";
+                    genome = create_jordan(words, 1, 3, outputs, max_recurrent_depth, weight_initialize);
+                } else if (structure == 2) {
+                    structure_name = "Elman: 1x3 Hidden";
+                    genome = create_elman(words, 1, 3, outputs, max_recurrent_depth, weight_initialize);
+                } else {
+                    structure_name = "LSTM: 1x2 Hidden";
+                    genome = create_lstm(words, 1, 2, outputs, max_recurrent_depth, weight_initialize);
+                }
+
+                if (mode == 0) {
+                    passed &= softmax_gradient_test(structure_name + ", Full Softmax", genome, number_words, word_classes, 0, input_length, input_length);
+                } else if (mode == 1) {
+                    genome->set_softmax_samples(softmax_samples);
+                    passed &= softmax_gradient_test(structure_name + ", " + to_string(softmax_samples) + " Softmax Samples", genome, number_words, word_classes, 0, input_length, number_tokens);
+                } else {
+                    genome->set_word_classes(word_classes);
+                    passed &= softmax_gradient_test(structure_name + ", " + to_string(number_classes) + " Word Classes", genome, number_words, word_classes, number_classes, input_length, number_tokens);
+                }
+
+                delete genome;
+            }
+        }
+    }
+
+    if (!passed) {
+        LOG_ERROR("SOME FAILED!\n");
+        exit(1);
+    }
+
+    LOG_INFO("ALL PASSED!\n");
+    return 0;
+}
@@ -8,6 +8,8 @@
 #         --output_directory: output directory for results
 #         --std_message_level: can be INFO, DEBUG, WARNING, TRACE, ERROR, FATAL
 #         --file_message_level: can be INFO, DEBUG, WARNING, TRACE, ERROR, FATAL
+#         --log_buffer_size: number of messages each thread can buffer before waiting on the log writer thread, 4096 if not specified
+#         --log_flush_interval: maximum milliseconds between the log writer flushing the log files, 100 if not specified
         
 #     examm:
 #         --learning_rate: learning rate for back propagation
@@ -38,6 +40,20 @@
 #             --shift_parameter_names: parameters 'time_offset' in the future are used for prediction
 
 #         --normalize: data normalize method, can be "min_max" or "avg_std_dev"
+#         --load_threads: number of threads used to parse the data files in parallel, one per hardware thread if not specified
+#         --no_dataset_cache: always parse the data files instead of reading the binary caches created next to them (e.g., burner_0.csv.cache for burner_0.csv)
+#         --stream_window_length: (examm_mt only) train and validate on windows of this many time steps read from the binary caches, instead of loading the data files into memory
+#         --stream_windows: number of randomly placed training windows each genome is trained on, 10 if not specified
+#         --stream_validation_windows: number of windows of the test files every genome is validated on, 10 if not specified
+#         --stream_prefetch: number of sets of training windows read ahead of time by a background thread, 2 if not specified
+
+#     word series (examm_mt_nlp and examm_mpi_nlp):
+#         --training_filenames
+#         --test_filenames
+#         --word_offset: number of words in the future to predict
+#         --load_threads: number of threads used to read the files in parallel, one per hardware thread if not specified
+#         --softmax_samples: train with a softmax over the expected word and this many uniformly sampled other words instead of every word, validation still uses the full softmax
+#         --softmax_classes: split the words into this many classes by frequency and train and validate with a class based hierarchical softmax, which adds an output for each class
 
 #     island speciation strategy:
 #         --speciation_method: can be "island" or "neat", "island" if not specified
@@ -54,6 +70,15 @@
 #         --start_filled: the islands would start with 'Filled' status if enabled 
 #         --epigenetic_weights: false if not specified
 
+#     speculative generation (examm_mt and examm_mpi):
+#         --speculative_queue_size: number of genomes generated ahead of time on a background thread, 0 (disabled) if not specified
+#         --max_speculative_staleness: discard speculatively generated genomes if more than this many genomes were inserted after they were generated, no limit if not specified
+
+#     mpi:
+#         --threads_per_rank: number of training threads for each worker process, the threads share one copy of the data and one connection to the master, 1 if not specified
+#         --shared_memory_broadcast: processes on the same node read one copy of the training data, broadcast by the master into MPI shared memory
+#         --ready_queue_size: number of genomes the master keeps generated ahead of work requests, so the most expensive are handed out first (and the cheapest near max_genomes), 0 if not specified
+
 # Sample script for examm:
     out_dir="./test_output/"
     mkdir -p $out_dir
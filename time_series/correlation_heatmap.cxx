@@ -1,18 +1,29 @@
+#include <atomic>
+using std::atomic;
+
 #include <fstream>
 using std::ofstream;
 
 #include <iomanip>
 using std::setw;
 
+#include <mutex>
+using std::call_once;
+using std::once_flag;
+
 #include <string>
 using std::string;
 
+#include <thread>
+using std::thread;
+
 #include <vector>
 using std::vector;
 
 #include "common/arguments.hxx"
 #include "common/log.hxx"
 
+#include "time_series/cross_correlation.hxx"
 #include "time_series/time_series.hxx"
 
 
@@ -21,6 +32,76 @@ vector<string> arguments;
 vector< vector< vector<double> > > testing_inputs;
 vector< vector< vector<double> > > testing_outputs;
 
+/**
+ * The correlations of one file's parameters with the target parameter.  Each
+ * (file, parameter) pair is calculated by whichever thread takes it next, and
+ * the thread which finishes the last pair of a file writes its output files.
+ */
+class FileCorrelations {
+    public:
+        TimeSeriesSet *tss;
+        string correlations_csv_filename;
+        string headers_txt_filename;
+
+        vector<string> parameter_names; /**< every parameter but the target. */
+
+        once_flag target_flag;
+        CrossCorrelation *target; /**< created by the first thread to work on this file. */
+
+        vector< vector<double> > correlations;
+        atomic<int32_t> remaining;
+};
+
+string target_parameter_name;
+int32_t max_lag = 0;
+
+vector<FileCorrelations*> files;
+vector< std::pair<int32_t, int32_t> > pairs;
+atomic<int32_t> next_pair(0);
+
+void write_correlations(FileCorrelations *file) {
+    ofstream correlations_csv(file->correlations_csv_filename);
+    ofstream headers_txt(file->headers_txt_filename);
+
+    for (uint32_t j = 0; j < file->parameter_names.size(); j++) {
+        for (int32_t k = 1; k < max_lag; k++) {
+            if (k > 1) correlations_csv << ",";
+            correlations_csv << file->correlations[j][k];
+        }
+        correlations_csv << endl;
+
+        headers_txt << file->parameter_names[j] << endl;
+    }
+
+    correlations_csv.close();
+    headers_txt.close();
+
+    //the file's correlations are no longer needed once they are written
+    vector< vector<double> >().swap(file->correlations);
+    delete file->target;
+    file->target = NULL;
+}
+
+void correlation_thread(string log_id) {
+    Log::set_id(log_id);
+
+    int32_t i;
+    while ((i = next_pair++) < (int32_t)pairs.size()) {
+        FileCorrelations *file = files[pairs[i].first];
+        int32_t parameter = pairs[i].second;
+
+        call_once(file->target_flag, [file]() {
+            file->target = new CrossCorrelation(file->tss->get_time_series(target_parameter_name), max_lag);
+        });
+
+        file->target->correlate(file->tss->get_time_series(file->parameter_names[parameter]), file->correlations[parameter]);
+
+        if (--file->remaining == 0) write_correlations(file);
+    }
+
+    Log::release_id(log_id);
+}
+
 int main(int argc, char** argv) {
     arguments = vector<string>(argv, argv + argc);
 
@@ -33,12 +114,15 @@ int main(int argc, char** argv) {
     TimeSeriesSets *time_series_sets = TimeSeriesSets::generate_from_arguments(arguments);
     LOG_DEBUG("got time series sets.\n");
 
-    int32_t max_lag = 0;
     get_argument(arguments, "--max_lag", true, max_lag);
 
-    string target_parameter_name;
     get_argument(arguments, "--target_parameter_name", true, target_parameter_name);
 
+    int32_t number_threads = 0;
+    get_argument(arguments, "--number_threads", false, number_threads);
+    if (number_threads <= 0) number_threads = thread::hardware_concurrency();
+    if (number_threads <= 0) number_threads = 1;
+
 
     vector<string> parameter_names = time_series_sets->get_input_parameter_names();
 
@@ -56,31 +140,43 @@ int main(int argc, char** argv) {
         cout << "prefix: '" << prefix << "'" << endl;
         cout << "suffix: '" << suffix << "'" << endl;
 
-        string correlations_csv_filename = output_directory + "/" + prefix + "_correlations.csv";
-        string headers_txt_filename = output_directory + "/" + prefix + "_headers.txt";
-
-        cout << "correlations_csv_filename: '" << correlations_csv_filename << "'" << endl;
-        cout << "headers_txt_filename: '" << headers_txt_filename << "'" << endl;
+        FileCorrelations *file = new FileCorrelations();
+        file->tss = tss;
+        file->target = NULL;
+        file->correlations_csv_filename = output_directory + "/" + prefix + "_correlations.csv";
+        file->headers_txt_filename = output_directory + "/" + prefix + "_headers.txt";
 
-        ofstream correlations_csv(correlations_csv_filename);
-        ofstream headers_txt(headers_txt_filename);
+        cout << "correlations_csv_filename: '" << file->correlations_csv_filename << "'" << endl;
+        cout << "headers_txt_filename: '" << file->headers_txt_filename << "'" << endl;
 
         for (uint32_t j = 0; j < parameter_names.size(); j++) {
             if (parameter_names[j].compare(target_parameter_name) == 0) continue;
 
-            for (uint32_t k = 1; k < max_lag; k++) {
-                double correlation = tss->get_correlation(target_parameter_name, parameter_names[j], k);
+            pairs.push_back(std::make_pair((int32_t)files.size(), (int32_t)file->parameter_names.size()));
+            file->parameter_names.push_back(parameter_names[j]);
+        }
+        file->correlations.resize(file->parameter_names.size());
+        file->remaining = file->parameter_names.size();
+
+        files.push_back(file);
+
+        //files without any other parameters still get (empty) output files
+        if (file->parameter_names.size() == 0) write_correlations(file);
+    }
 
-                if (k > 1) correlations_csv << ",";
-                correlations_csv << correlation;
-            }
-            correlations_csv << endl;
+    LOG_INFO("calculating the correlations of %d parameters in %d files with %d threads\n", pairs.size(), files.size(), number_threads);
 
-            headers_txt << parameter_names[j] << endl;
-        }
+    vector<thread> threads;
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads.push_back( thread(correlation_thread, "correlation_thread_" + to_string(i)) );
+    }
+
+    for (int32_t i = 0; i < number_threads; i++) {
+        threads[i].join();
+    }
 
-        correlations_csv.close();
-        headers_txt.close();
+    for (uint32_t i = 0; i < files.size(); i++) {
+        delete files[i];
     }
 
     Log::release_id("main");
@@ -0,0 +1,125 @@
+#include <cmath>
+
+#include <complex>
+using std::complex;
+using std::conj;
+using std::polar;
+
+#include <utility>
+using std::swap;
+
+#include <vector>
+using std::vector;
+
+#include "cross_correlation.hxx"
+#include "time_series.hxx"
+
+CrossCorrelation::CrossCorrelation(const TimeSeries *_target, int32_t _max_lag) : target(_target), max_lag(_max_lag) {
+    length = target->values.size();
+
+    padded_length = 1;
+    while (padded_length < 2 * length) padded_length *= 2;
+
+    //each FFT takes roughly 5 * N log2(N) operations, while calculating the
+    //correlations directly takes 2 * N operations per lag
+    use_fft = (double)max_lag * length > 5.0 * padded_length * log2((double)padded_length);
+
+    if (use_fft) {
+        double average = target->get_average();
+
+        target_spectrum.assign(padded_length, complex<double>(0.0, 0.0));
+        for (int32_t i = 0; i < length; i++) {
+            target_spectrum[i] = complex<double>(target->values[i] - average, 0.0);
+        }
+        fft(target_spectrum, false);
+    }
+}
+
+void CrossCorrelation::fft(vector< complex<double> > &values, bool inverse) {
+    int32_t n = values.size();
+
+    //reorder the values by the bit reversal of their indexes
+    for (int32_t i = 1, j = 0; i < n; i++) {
+        int32_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+
+        if (i < j) swap(values[i], values[j]);
+    }
+
+    for (int32_t span = 2; span <= n; span <<= 1) {
+        double angle = 2.0 * M_PI / span * (inverse ? 1.0 : -1.0);
+        complex<double> step = polar(1.0, angle);
+
+        for (int32_t start = 0; start < n; start += span) {
+            complex<double> twiddle(1.0, 0.0);
+            for (int32_t k = 0; k < span / 2; k++) {
+                complex<double> even = values[start + k];
+                complex<double> odd = values[start + k + span / 2] * twiddle;
+
+                values[start + k] = even + odd;
+                values[start + k + span / 2] = even - odd;
+                twiddle *= step;
+            }
+        }
+    }
+
+    if (inverse) {
+        for (int32_t i = 0; i < n; i++) {
+            values[i] /= n;
+        }
+    }
+}
+
+void CrossCorrelation::correlate(const TimeSeries *other, vector<double> &correlations) const {
+    correlations.assign(max_lag, 0.0);
+
+    double average = target->get_average();
+    double variance = target->get_variance();
+    double other_average = other->get_average();
+    double other_variance = other->get_variance();
+
+    //the correlations are all zero if either series does not change
+    if (variance < 1e-12 || other_variance < 1e-12) return;
+
+    double denominator = sqrt(variance * other_variance);
+
+    if (!use_fft || (int32_t)other->values.size() != length) {
+        //this is only used for series of different lengths (which are not in the same
+        //file) or if there are few enough lags that calculating them directly is faster
+        for (int32_t lag = 0; lag < max_lag; lag++) {
+            int32_t lag_length = fmin(length, other->values.size()) - lag;
+
+            double covariance_sum = 0.0;
+            for (int32_t i = 0; i < lag_length; i++) {
+                covariance_sum += (target->values[i + lag] - average) * (other->values[i] - other_average);
+            }
+
+            correlations[lag] = (covariance_sum / denominator) / lag_length;
+        }
+        return;
+    }
+
+    vector< complex<double> > spectrum(padded_length, complex<double>(0.0, 0.0));
+    for (int32_t i = 0; i < length; i++) {
+        spectrum[i] = complex<double>(other->values[i] - other_average, 0.0);
+    }
+    fft(spectrum, false);
+
+    //the inverse of target * conj(other) is the covariance sum of every lag
+    for (int32_t i = 0; i < padded_length; i++) {
+        spectrum[i] = target_spectrum[i] * conj(spectrum[i]);
+    }
+    fft(spectrum, true);
+
+    for (int32_t lag = 0; lag < max_lag; lag++) {
+        int32_t lag_length = length - lag;
+
+        double covariance_sum = 0.0;
+        if (lag_length > 0) covariance_sum = spectrum[lag].real();
+
+        correlations[lag] = (covariance_sum / denominator) / lag_length;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef EXAMM_CROSS_CORRELATION_HXX
+#define EXAMM_CROSS_CORRELATION_HXX
+
+#include <complex>
+using std::complex;
+
+#include <vector>
+using std::vector;
+
+#include "time_series.hxx"
+
+/**
+ * Calculates the lagged correlations of one (target) time series with other
+ * time series, the same as TimeSeries::get_correlation, but for every lag at
+ * once.
+ *
+ * The centered target series is transformed with an FFT once, when this is
+ * constructed.  The correlations of every lag with another series then only
+ * take the FFT of that series and an inverse FFT of the product of the two,
+ * O(N log N) instead of O(N * max_lag).  When max_lag is small enough that
+ * the correlations are cheaper to calculate directly, they are.
+ *
+ * Once constructed, correlate can be called from multiple threads at once.
+ */
+class CrossCorrelation {
+    private:
+        const TimeSeries *target;
+        int32_t max_lag;
+
+        int32_t length; /**< the number of values in the target series. */
+        int32_t padded_length; /**< a power of two large enough that the FFT's circular correlation does not wrap around. */
+        bool use_fft;
+
+        vector< complex<double> > target_spectrum;
+
+        /**
+         * An in place iterative radix-2 FFT, values.size() must be a power of two.
+         */
+        static void fft(vector< complex<double> > &values, bool inverse);
+
+    public:
+        CrossCorrelation(const TimeSeries *_target, int32_t _max_lag);
+
+        /**
+         * Sets correlations[lag] to target->get_correlation(other, lag), for every lag
+         * from 0 up to (but not including) max_lag.
+         */
+        void correlate(const TimeSeries *other, vector<double> &correlations) const;
+};
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef EXAMM_SERIES_VIEW_HXX
+#define EXAMM_SERIES_VIEW_HXX
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+using std::vector;
+
+/**
+ * A read only view of the values of one field over a window of consecutive
+ * time steps, which does not own (or copy) the values.
+ *
+ * One hot fields (made by a SeriesView of tokens) have no values, they are
+ * the active value wherever the token is the field's and the inactive value
+ * everywhere else.  The class fields of a one hot view are active wherever
+ * the token's class is the field's.
+ */
+class FieldView {
+    private:
+        const double *values;
+        size_t length;
+
+        const int32_t *tokens;
+        size_t number_tokens; /**< time steps after the tokens (padding) are inactive. */
+        int32_t token;
+        double inactive_value;
+        double active_value;
+        const int32_t *token_classes; /**< NULL unless this is a class field, otherwise the class of each token. */
+
+    public:
+        FieldView() : values(NULL), length(0), tokens(NULL), number_tokens(0), token(-1), inactive_value(0.0), active_value(0.0), token_classes(NULL) {
+        }
+
+        FieldView(const double *_values, size_t _length) : values(_values), length(_length), tokens(NULL), number_tokens(0), token(-1), inactive_value(0.0), active_value(0.0), token_classes(NULL) {
+        }
+
+        FieldView(const vector<double> &_values) : values(_values.data()), length(_values.size()), tokens(NULL), number_tokens(0), token(-1), inactive_value(0.0), active_value(0.0), token_classes(NULL) {
+        }
+
+        FieldView(const int32_t *_tokens, size_t _number_tokens, size_t _length, int32_t _token, double _inactive_value, double _active_value, const int32_t *_token_classes) : values(NULL), length(_length), tokens(_tokens), number_tokens(_number_tokens), token(_token), inactive_value(_inactive_value), active_value(_active_value), token_classes(_token_classes) {
+        }
+
+        double operator[](size_t time) const {
+            if (tokens == NULL) return values[time];
+            if (time >= number_tokens) return inactive_value;
+
+            int32_t value_token = (token_classes == NULL) ? tokens[time] : token_classes[tokens[time]];
+            return (value_token == token) ? active_value : inactive_value;
+        }
+
+        size_t size() const {
+            return length;
+        }
+
+        /**
+         * \return the values of the field, or NULL for one hot fields.
+         */
+        const double* data() const {
+            return values;
+        }
+};
+
+/**
+ * A read only view of the fields of one time series (e.g., the inputs or the
+ * expected outputs of a single file), indexed as series[field][time] just
+ * like the vector< vector<double> > it can be made from.
+ *
+ * Views exported from a TimeSeriesSets point directly at its columns, so
+ * the input and output views of an offset series share the same values
+ * instead of each holding a copy.  They are only valid while the
+ * TimeSeriesSets (or the vectors they were made from) exist and are not
+ * modified.
+ *
+ * A one hot view (e.g., of the words of a Corpus) instead holds a single
+ * token per time step, the index of the one field which is active at that
+ * time step, so a vocabulary of fields costs no more than one field.
+ * Indexing it still works the same, but an RNN can use the tokens to only
+ * propagate the active field's input.
+ *
+ * A one hot view can also have class fields after its token fields (e.g.,
+ * for a class based hierarchical softmax), one per class of tokens, which
+ * are active wherever the active token is in their class.
+ */
+class SeriesView {
+    private:
+        vector<FieldView> fields;
+
+        const int32_t *tokens; /**< NULL unless this is a one hot view. */
+        size_t number_tokens;
+        size_t length;
+        size_t number_fields;
+        const double *inactive_values;
+        const double *active_values;
+
+        const int32_t *token_classes;
+        size_t number_classes; /**< the last number_classes fields are class fields. */
+
+    public:
+        SeriesView() : tokens(NULL), number_tokens(0), length(0), number_fields(0), inactive_values(NULL), active_values(NULL), token_classes(NULL), number_classes(0) {
+        }
+
+        /**
+         * Creates a one hot view of length time steps, where field tokens[time]
+         * is active at each time step.  Time steps past number_tokens (padding)
+         * have no active field.
+         */
+        SeriesView(const int32_t *_tokens, size_t _number_tokens, size_t _length, size_t _number_fields, const double *_inactive_values, const double *_active_values) : tokens(_tokens), number_tokens(_number_tokens), length(_length), number_fields(_number_fields), inactive_values(_inactive_values), active_values(_active_values), token_classes(NULL), number_classes(0) {
+        }
+
+        /**
+         * Creates a one hot view with number_fields token fields followed by
+         * number_classes class fields, where token_classes[token] is the class
+         * of each token.  The inactive and active values are of every field,
+         * including the class fields.
+         */
+        SeriesView(const int32_t *_tokens, size_t _number_tokens, size_t _length, size_t _number_fields, const double *_inactive_values, const double *_active_values, const int32_t *_token_classes, size_t _number_classes) : tokens(_tokens), number_tokens(_number_tokens), length(_length), number_fields(_number_fields + _number_classes), inactive_values(_inactive_values), active_values(_active_values), token_classes(_token_classes), number_classes(_number_classes) {
+        }
+
+        SeriesView(const vector< vector<double> > &series) : tokens(NULL), number_tokens(0), length(0), number_fields(0), inactive_values(NULL), active_values(NULL), token_classes(NULL), number_classes(0) {
+            fields.reserve(series.size());
+            for (size_t i = 0; i < series.size(); i++) {
+                fields.push_back(FieldView(series[i]));
+            }
+        }
+
+        void add_field(const double *values, size_t length) {
+            fields.push_back(FieldView(values, length));
+        }
+
+        FieldView operator[](size_t field) const {
+            if (tokens == NULL) return fields[field];
+
+            size_t number_token_fields = number_fields - number_classes;
+            if (field < number_token_fields) return FieldView(tokens, number_tokens, length, field, inactive_values[field], active_values[field], NULL);
+            return FieldView(tokens, number_tokens, length, field - number_token_fields, inactive_values[field], active_values[field], token_classes);
+        }
+
+        size_t size() const {
+            if (tokens == NULL) return fields.size();
+            return number_fields;
+        }
+
+        bool is_one_hot() const {
+            return tokens != NULL;
+        }
+
+        /**
+         * \return the active field of a one hot view at the given time step, or -1 if no field is active.
+         */
+        int32_t get_token(size_t time) const {
+            return time < number_tokens ? tokens[time] : -1;
+        }
+
+        double get_inactive_value(size_t field) const {
+            return inactive_values[field];
+        }
+
+        double get_active_value(size_t field) const {
+            return active_values[field];
+        }
+};
+
+/**
+ * Views of a set of time series, indexed as dataset[series][field][time] just
+ * like the vector< vector< vector<double> > > it can be made from.
+ */
+class DatasetView {
+    private:
+        vector<SeriesView> series;
+
+    public:
+        DatasetView() {
+        }
+
+        DatasetView(const vector< vector< vector<double> > > &_series) {
+            series.reserve(_series.size());
+            for (size_t i = 0; i < _series.size(); i++) {
+                series.push_back(SeriesView(_series[i]));
+            }
+        }
+
+        void push_back(const SeriesView &_series) {
+            series.push_back(_series);
+        }
+
+        void clear() {
+            series.clear();
+        }
+
+        const SeriesView& operator[](size_t i) const {
+            return series[i];
+        }
+
+        size_t size() const {
+            return series.size();
+        }
+};
+
+#endif
@@ -1,10 +1,33 @@
     #include <cmath>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
 using std::find;
 
+#include <atomic>
+using std::atomic;
+
+#include <charconv>
+using std::errc;
+using std::from_chars;
+
+#include <cstdio>
+using std::rename;
+
+#include <cstring>
+using std::memchr;
+using std::memcmp;
+using std::memcpy;
+using std::memset;
+
 #include <fstream>
 using std::ifstream;
+using std::ofstream;
+using std::istreambuf_iterator;
 
 #include <iomanip>
 using std::setw;
@@ -25,6 +48,9 @@ using std::invalid_argument;
 #include <string>
 using std::string;
 
+#include <thread>
+using std::thread;
+
 #include <vector>
 using std::vector;
 
@@ -33,12 +59,79 @@ using std::vector;
 
 #include "time_series.hxx"
 
+RunningStatistics::RunningStatistics() : count(0), mean(0.0), m2(0.0),
+                                         min(numeric_limits<double>::max()), max(-numeric_limits<double>::max()),
+                                         min_change(numeric_limits<double>::max()), max_change(-numeric_limits<double>::max()),
+                                         last(0.0) {
+}
+
+RunningStatistics::RunningStatistics(int64_t _count, double _min, double _mean, double _max, double _variance, double _min_change, double _max_change) :
+                                         count(_count), mean(_mean), m2(_variance * (_count - 1)),
+                                         min(_min), max(_max),
+                                         min_change(_min_change), max_change(_max_change),
+                                         last(0.0) {
+}
+
+void RunningStatistics::merge(const RunningStatistics &other) {
+    if (other.count == 0) return;
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+
+    int64_t combined_count = count + other.count;
+    double delta = other.mean - mean;
+
+    mean += delta * ((double)other.count / combined_count);
+    m2 += other.m2 + (delta * delta) * ((double)count * other.count / combined_count);
+    count = combined_count;
+
+    if (other.min < min) min = other.min;
+    if (other.max > max) max = other.max;
+    if (other.min_change < min_change) min_change = other.min_change;
+    if (other.max_change > max_change) max_change = other.max_change;
+    last = other.last;
+}
+
+int64_t RunningStatistics::get_count() const {
+    return count;
+}
+
+double RunningStatistics::get_min() const {
+    return min;
+}
+
+double RunningStatistics::get_mean() const {
+    return mean;
+}
+
+double RunningStatistics::get_max() const {
+    return max;
+}
+
+double RunningStatistics::get_variance() const {
+    return m2 / (count - 1);
+}
+
+double RunningStatistics::get_min_change() const {
+    return min_change;
+}
+
+double RunningStatistics::get_max_change() const {
+    return max_change;
+}
+
 TimeSeries::TimeSeries(string _name) {
     name = _name;
 }
 
 void TimeSeries::add_value(double value) {
     values.push_back(value);
+    statistics.add(value);
+}
+
+void TimeSeries::reserve(int32_t number_values) {
+    values.reserve(number_values);
 }
 
 double TimeSeries::get_value(int i) {
@@ -46,38 +139,26 @@ double TimeSeries::get_value(int i) {
 }
 
 void TimeSeries::calculate_statistics() {
-    min = numeric_limits<double>::max();
-    min_change = numeric_limits<double>::max();
-    average = 0.0;
-    max = -numeric_limits<double>::max();
-    max_change = -numeric_limits<double>::max();
-
-    std_dev = 0.0;
-    variance = 0.0;
-
-    for (uint32_t i = 0; i < values.size(); i++) {
-        average += values[i];
-
-        if (min > values[i]) min = values[i];
-        if (max < values[i]) max = values[i];
-
-        if (i > 0) {
-            double diff = values[i] - values[i-1];
-
-            if (diff < min_change) min_change = diff;
-            if (diff > max_change) max_change = diff;
+    if (statistics.get_count() != (int64_t)values.size()) {
+        statistics = RunningStatistics();
+        for (uint32_t i = 0; i < values.size(); i++) {
+            statistics.add(values[i]);
         }
     }
 
-    average /= values.size();
+    set_statistics(statistics);
+}
 
-    for (uint32_t i = 0; i < values.size(); i++) {
-        double diff = values[i] - average;
-        variance += diff * diff;
-    }
-    variance /= values.size() - 1;
+void TimeSeries::set_statistics(const RunningStatistics &_statistics) {
+    statistics = _statistics;
 
+    min = statistics.get_min();
+    average = statistics.get_mean();
+    max = statistics.get_max();
+    variance = statistics.get_variance();
     std_dev = sqrt(variance);
+    min_change = statistics.get_min_change();
+    max_change = statistics.get_max_change();
 }
 
 void TimeSeries::print_statistics() {
@@ -116,19 +197,32 @@ double TimeSeries::get_max_change() const {
     return max_change;
 }
 
+const RunningStatistics& TimeSeries::get_statistics() const {
+    return statistics;
+}
+
 void TimeSeries::normalize_min_max(double min, double max) {
     LOG_DEBUG("normalizing time series '%s' with min: %lf and max: %lf, series min: %lf, series max: %lf\n", name.c_str(), min, max, this->min, this->max);
 
-    for (int i = 0; i < values.size(); i++) {
-        if (values[i] < min) {
-            LOG_WARNING("normalizing series %s, value[%d] %lf was less than min for normalization: %lf\n", name.c_str(), i, values[i], min);
-        }
+    //only look for the values out of bounds if the series has any, so the
+    //normalization itself is a tight loop which can be vectorized
+    if (this->min < min || this->max > max) {
+        for (int i = 0; i < (int)values.size(); i++) {
+            if (values[i] < min) {
+                LOG_WARNING("normalizing series %s, value[%d] %lf was less than min for normalization: %lf\n", name.c_str(), i, values[i], min);
+            }
 
-        if (values[i] > max) {
-            LOG_WARNING("normalizing series %s, value[%d] %lf was greater than max for normalization: %lf\n", name.c_str(), i, values[i], max);
+            if (values[i] > max) {
+                LOG_WARNING("normalizing series %s, value[%d] %lf was greater than max for normalization: %lf\n", name.c_str(), i, values[i], max);
+            }
         }
+    }
 
-        values[i] = (values[i] - min) / (max - min);
+    double *data = values.data();
+    int32_t length = values.size();
+    double range = max - min;
+    for (int32_t i = 0; i < length; i++) {
+        data[i] = (data[i] - min) / range;
     }
 }
 
@@ -136,8 +230,10 @@ void TimeSeries::normalize_min_max(double min, double max) {
 void TimeSeries::normalize_avg_std_dev(double avg, double std_dev, double norm_max) {
     LOG_DEBUG("normalizing time series '%s' with avg: %lf, std_dev: %lf and normalized max: %lf, series avg: %lf, series std_dev: %lf\n", name.c_str(), avg, std_dev, norm_max, this->average, this->std_dev);
 
-    for (int i = 0; i < values.size(); i++) {
-        values[i] = ((values[i] - avg) / std_dev) / norm_max;
+    double *data = values.data();
+    int32_t length = values.size();
+    for (int32_t i = 0; i < length; i++) {
+        data[i] = ((data[i] - avg) / std_dev) / norm_max;
     }
 }
 
@@ -147,6 +243,7 @@ void TimeSeries::cut(int32_t start, int32_t stop) {
     values = vector<double>(first, last);
 
     //update the statistics after the cut
+    statistics = RunningStatistics();
     calculate_statistics();
 }
 
@@ -185,6 +282,7 @@ TimeSeries* TimeSeries::copy() {
     ts->variance = variance;
     ts->min_change = min_change;
     ts->max_change = max_change;
+    ts->statistics = statistics;
 
     ts->values = values;
 
@@ -214,32 +312,619 @@ void TimeSeriesSet::add_time_series(string name) {
     }
 }
 
-TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string> &_fields) {
-    filename = _filename;
-    fields = _fields;
-    
-    ifstream ts_file(filename);
+/**
+ * The contents of a file, memory mapped if possible (otherwise read into
+ * memory), so it can be parsed in place without copying each line.
+ */
+class MappedFile {
+    private:
+        void *mapping;
+        size_t mapping_size;
+        string contents;
+
+    public:
+        bool opened;
+        const char *data;
+        size_t size;
+
+        /**
+         * \param advice is passed to madvise, it should be MADV_SEQUENTIAL if the file will be read
+         * from start to end or MADV_RANDOM if only parts of it will be read
+         */
+        MappedFile(const string &filename, int advice = MADV_SEQUENTIAL) : mapping(NULL), mapping_size(0), opened(false), data(NULL), size(0) {
+            int fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            opened = true;
+
+            struct stat file_stat;
+            if (fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+                void *result = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (result != MAP_FAILED) {
+                    madvise(result, file_stat.st_size, advice);
+                    mapping = result;
+                    mapping_size = file_stat.st_size;
+                    data = (const char*)mapping;
+                    size = mapping_size;
+                }
+            }
+            close(fd);
+
+            if (mapping == NULL) {
+                //not a regular file (or it could not be mapped), so fall back to reading it
+                ifstream in_file(filename, std::ios::binary);
+                contents.assign(istreambuf_iterator<char>(in_file), istreambuf_iterator<char>());
+                data = contents.c_str();
+                size = contents.size();
+            }
+        }
 
-    string line;
-    if (!getline(ts_file, line)) {
-        LOG_ERROR("ERROR! Could not get headers from the CSV file. File potentially empty!\n");
-        exit(1);
-    }
+        ~MappedFile() {
+            if (mapping != NULL) munmap(mapping, mapping_size);
+        }
+};
 
-    
-    vector<string> file_fields;
+/**
+ * Parses a CSV cell holding a number, skipping whitespace around it and a '+'
+ * sign.  Unlike stod, a cell with anything else after the number (e.g., a date
+ * like 2013-01-07) is not a number.
+ *
+ * \return true if the whole cell was a number
+ */
+static bool parse_csv_value(const char *start, const char *end, double &value) {
+    while (start < end && (*start == ' ' || *start == '\t')) start++;
+    if (start < end && *start == '+') start++;
+
+    auto result = from_chars(start, end, value);
+    if (result.ec != errc() || result.ptr == start) return false;
+
+    const char *rest = result.ptr;
+    while (rest < end && (*rest == ' ' || *rest == '\t')) rest++;
+    return rest == end;
+}
+
+/**
+ * Splits the first line of a CSV file into its field names.
+ *
+ * \return the position of the first row after the header
+ */
+static const char* parse_csv_header(const char *position, const char *file_end, vector<string> &file_fields) {
+    const char *line_end = (const char*)memchr(position, '\n', file_end - position);
+    if (line_end == NULL) line_end = file_end;
+    string line(position, line_end);
+
+    file_fields.clear();
     string_split(line, ',', file_fields);
-    for (int32_t i = 0; i < file_fields.size(); i++) {
+    for (int32_t i = 0; i < (int32_t)file_fields.size(); i++) {
         //get rid of carriage returns (sometimes windows messes this up)
         file_fields[i].erase( std::remove(file_fields[i].begin(), file_fields[i].end(), '\r'), file_fields[i].end() );
     }
 
+    return (line_end < file_end) ? line_end + 1 : file_end;
+}
+
+/**
+ * Counts the lines left in a CSV file, an upper bound on the number of rows.
+ */
+static int32_t count_csv_lines(const char *position, const char *file_end) {
+    int32_t lines = 0;
+    for (const char *c = position; c < file_end && (c = (const char*)memchr(c, '\n', file_end - c)) != NULL; c++) {
+        lines++;
+    }
+    if (file_end > position && *(file_end - 1) != '\n') lines++;
+
+    return lines;
+}
+
+/**
+ * Parses the rows of a CSV file (after its header), calling
+ * add_value(column, value) for each value in the used columns, and
+ * invalid_value(column, row, cell_start, cell_end) for each cell of them
+ * which is not a number.
+ */
+template <class ValueHandler, class InvalidValueHandler>
+static void parse_csv_rows(const char *position, const char *file_end, const string &filename, const vector<string> &file_fields, const vector<bool> &file_fields_used, ValueHandler add_value, InvalidValueHandler invalid_value) {
+    int row = 1;
+    while (position < file_end) {
+        const char *line_end = (const char*)memchr(position, '\n', file_end - position);
+        if (line_end == NULL) line_end = file_end;
+
+        const char *line_start = position;
+        position = (line_end < file_end) ? line_end + 1 : file_end;
+
+        //ignore the carriage return of windows line endings
+        const char *row_end = line_end;
+        if (row_end > line_start && *(row_end - 1) == '\r') row_end--;
+
+        if (row_end == line_start || *line_start == '#' || row < 0) {
+            row++;
+            continue;
+        }
+
+        int32_t column = 0;
+        const char *cell_start = line_start;
+        while (true) {
+            const char *cell_end = (const char*)memchr(cell_start, ',', row_end - cell_start);
+            if (cell_end == NULL) cell_end = row_end;
+
+            if (column < (int32_t)file_fields_used.size() && file_fields_used[column]) {
+                LOG_TRACE("parts[%d]: %.*s being added to '%s'\n", column, (int)(cell_end - cell_start), cell_start, file_fields[column].c_str());
+
+                double value;
+                if (parse_csv_value(cell_start, cell_end, value)) {
+                    add_value(column, value);
+                } else {
+                    invalid_value(column, row, cell_start, cell_end);
+                }
+            }
+
+            column++;
+            if (cell_end == row_end) break;
+            cell_start = cell_end + 1;
+        }
+
+        if (column != (int32_t)file_fields.size()) {
+            LOG_FATAL("ERROR! number of values in row %d was %d, but there were %d fields in the header.\n", row, column, file_fields.size());
+            exit(1);
+        }
+
+        row++;
+    }
+}
+
+#define TIME_SERIES_CACHE_MAGIC "EXAMMTSC"
+#define TIME_SERIES_CACHE_VERSION 3
+#define TIME_SERIES_CACHE_HASH_BLOCK 4096
+
+/**
+ * A time series cache file starts with this header, followed by a
+ * TimeSeriesCacheField for each column of the CSV file, the column names,
+ * and then each numeric column's values as contiguous doubles (aligned to 8
+ * bytes).  Columns with a value which is not a number (e.g., dates or names)
+ * are kept in the field table without any values, so they can be reported if
+ * they are used.  Everything is written in the byte order of the machine
+ * creating it.
+ */
+class TimeSeriesCacheHeader {
+    public:
+        char magic[8];
+        int32_t version;
+        int32_t number_fields;
+
+        int64_t csv_size; /**< the size of the CSV file the cache was made from. */
+        int64_t csv_modification_seconds;
+        int64_t csv_modification_nanoseconds;
+        uint64_t csv_hash; /**< a hash of the first and last blocks of the CSV file. */
+};
+
+class TimeSeriesCacheField {
+    public:
+        int64_t name_offset;
+        int64_t values_offset;
+        int32_t name_length;
+        int32_t number_values;
+
+        int32_t invalid_row; /**< the first row with a value which is not a number, or -1 if the column is numeric. */
+        int32_t padding;
+
+        double min;
+        double average;
+        double max;
+        double std_dev;
+        double variance;
+        double min_change;
+        double max_change;
+};
+
+static uint64_t fnv1a_hash(const char *data, size_t length, uint64_t hash) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Fills in the fields of the cache header which identify the version of the
+ * CSV file the cache was made from, without reading the whole file.
+ *
+ * \return false if the CSV file could not be read
+ */
+static bool get_csv_fingerprint(const string &filename, TimeSeriesCacheHeader &header) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    header.csv_size = file_stat.st_size;
+#ifdef __APPLE__
+    header.csv_modification_seconds = file_stat.st_mtimespec.tv_sec;
+    header.csv_modification_nanoseconds = file_stat.st_mtimespec.tv_nsec;
+#else
+    header.csv_modification_seconds = file_stat.st_mtim.tv_sec;
+    header.csv_modification_nanoseconds = file_stat.st_mtim.tv_nsec;
+#endif
+
+    char block[TIME_SERIES_CACHE_HASH_BLOCK];
+    uint64_t hash = 14695981039346656037ULL;
+
+    ssize_t bytes_read = pread(fd, block, TIME_SERIES_CACHE_HASH_BLOCK, 0);
+    if (bytes_read > 0) hash = fnv1a_hash(block, bytes_read, hash);
+
+    if (file_stat.st_size > TIME_SERIES_CACHE_HASH_BLOCK) {
+        bytes_read = pread(fd, block, TIME_SERIES_CACHE_HASH_BLOCK, file_stat.st_size - TIME_SERIES_CACHE_HASH_BLOCK);
+        if (bytes_read > 0) hash = fnv1a_hash(block, bytes_read, hash);
+    }
+    close(fd);
+
+    header.csv_hash = hash;
+    return true;
+}
+
+/**
+ * Checks that a mapped cache file was made from the current version of the
+ * CSV file and is intact, and reads its field table and field names.
+ *
+ * \return false if the cache cannot be used
+ */
+static bool read_cache_fields(const string &filename, const string &cache_filename, const MappedFile &cache_file, vector<TimeSeriesCacheField> &cache_fields, vector<string> &cache_field_names) {
+    TimeSeriesCacheHeader current;
+    if (!cache_file.opened || !get_csv_fingerprint(filename, current)) return false;
+
+    const char *data = cache_file.data;
+    size_t size = cache_file.size;
+
+    if (size < sizeof(TimeSeriesCacheHeader)) {
+        LOG_DEBUG("time series cache '%s' is truncated, ignoring it\n", cache_filename.c_str());
+        return false;
+    }
+
+    TimeSeriesCacheHeader header;
+    memcpy(&header, data, sizeof(TimeSeriesCacheHeader));
+
+    if (memcmp(header.magic, TIME_SERIES_CACHE_MAGIC, 8) != 0 || header.version != TIME_SERIES_CACHE_VERSION) {
+        LOG_DEBUG("'%s' is not a time series cache for this version, ignoring it\n", cache_filename.c_str());
+        return false;
+    }
+
+    if (header.csv_size != current.csv_size || header.csv_modification_seconds != current.csv_modification_seconds || header.csv_modification_nanoseconds != current.csv_modification_nanoseconds || header.csv_hash != current.csv_hash) {
+        LOG_INFO("time series file '%s' has changed since its cache was made, re-reading it\n", filename.c_str());
+        return false;
+    }
+
+    if (header.number_fields < 0 || sizeof(TimeSeriesCacheHeader) + (size_t)header.number_fields * sizeof(TimeSeriesCacheField) > size) {
+        LOG_DEBUG("time series cache '%s' is truncated, ignoring it\n", cache_filename.c_str());
+        return false;
+    }
+
+    cache_fields.resize(header.number_fields);
+    cache_field_names.resize(header.number_fields);
+    if (header.number_fields > 0) memcpy(&cache_fields[0], data + sizeof(TimeSeriesCacheHeader), header.number_fields * sizeof(TimeSeriesCacheField));
+
+    for (int32_t i = 0; i < header.number_fields; i++) {
+        const TimeSeriesCacheField &field = cache_fields[i];
+        if (field.name_offset < 0 || field.name_length < 0 || field.name_offset + field.name_length > (int64_t)size
+                || field.values_offset < 0 || field.values_offset % sizeof(double) != 0 || field.number_values < 0
+                || field.values_offset + (int64_t)field.number_values * (int64_t)sizeof(double) > (int64_t)size) {
+            LOG_DEBUG("time series cache '%s' is truncated, ignoring it\n", cache_filename.c_str());
+            return false;
+        }
+        cache_field_names[i].assign(data + field.name_offset, field.name_length);
+    }
+
+    return true;
+}
+
+/**
+ * A column being streamed into the cache, with its statistics calculated the
+ * same way (and in the same order) as when a TimeSeries is read from the CSV file.
+ */
+class CacheColumn {
+    public:
+        double *values;
+        int32_t number_values;
+
+        RunningStatistics statistics;
+};
+
+/**
+ * Creates the binary cache of a CSV file with every one of its numeric
+ * columns.  The values are parsed straight into the memory mapped cache file,
+ * so neither the CSV file nor its values ever need to fit in memory.  The
+ * statistics are calculated in the same pass.  Columns which turn out not to
+ * be numeric are marked as such without reporting their values, as they may
+ * never be used, and the numeric columns are then packed together.  The cache
+ * is written to a temporary file and renamed, so that other processes reading
+ * the same CSV file never see a partially written cache.
+ *
+ * \return false if the cache could not be created (e.g., the directory is not writable)
+ */
+static bool create_time_series_cache(const string &filename, const string &cache_filename) {
+    TimeSeriesCacheHeader header;
+    memset(&header, 0, sizeof(TimeSeriesCacheHeader));
+    memcpy(header.magic, TIME_SERIES_CACHE_MAGIC, 8);
+    header.version = TIME_SERIES_CACHE_VERSION;
+    if (!get_csv_fingerprint(filename, header)) return false;
+
+    MappedFile csv_file(filename);
+    if (!csv_file.opened || csv_file.size == 0) return false;
+    const char *file_end = csv_file.data + csv_file.size;
+
+    vector<string> file_fields;
+    const char *position = parse_csv_header(csv_file.data, file_end, file_fields);
+
+    //a column with the same name as an earlier one is not cached
+    vector<bool> file_fields_used(file_fields.size(), true);
+    for (int32_t i = 0; i < (int32_t)file_fields.size(); i++) {
+        for (int32_t j = 0; j < i; j++) {
+            if (file_fields_used[j] && file_fields[j] == file_fields[i]) {
+                LOG_WARNING("WARNING: time series file '%s' has more than one column named '%s', only the first will be cached\n", filename.c_str(), file_fields[i].c_str());
+                file_fields_used[i] = false;
+            }
+        }
+    }
+
+    vector<int32_t> column_fields(file_fields.size(), -1);
+    vector<string> names;
+    for (int32_t i = 0; i < (int32_t)file_fields.size(); i++) {
+        if (file_fields_used[i]) {
+            column_fields[i] = names.size();
+            names.push_back(file_fields[i]);
+        }
+    }
+    header.number_fields = names.size();
+
+    //every column gets room for as many values as there are lines
+    int64_t capacity = count_csv_lines(position, file_end);
+
+    vector<TimeSeriesCacheField> cache_fields(names.size());
+    int64_t offset = sizeof(TimeSeriesCacheHeader) + names.size() * sizeof(TimeSeriesCacheField);
+    for (int32_t i = 0; i < (int32_t)names.size(); i++) {
+        memset(&cache_fields[i], 0, sizeof(TimeSeriesCacheField));
+        cache_fields[i].name_offset = offset;
+        cache_fields[i].name_length = names[i].size();
+        offset += names[i].size();
+    }
+
+    //align the columns so they can be read straight out of the mapped file
+    offset += (8 - (offset % 8)) % 8;
+    for (int32_t i = 0; i < (int32_t)names.size(); i++) {
+        cache_fields[i].values_offset = offset;
+        offset += capacity * sizeof(double);
+    }
+    int64_t cache_size = offset;
+
+    string temporary_filename = cache_filename + ".tmp." + std::to_string(getpid());
+    int fd = open(temporary_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_DEBUG("could not create time series cache '%s', continuing without it\n", cache_filename.c_str());
+        return false;
+    }
+
+    void *mapping = MAP_FAILED;
+    if (ftruncate(fd, cache_size) == 0) {
+        mapping = mmap(NULL, cache_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        LOG_DEBUG("could not map time series cache '%s', continuing without it\n", cache_filename.c_str());
+        unlink(temporary_filename.c_str());
+        return false;
+    }
+    char *cache = (char*)mapping;
+
+    vector<CacheColumn> columns(names.size());
+    for (int32_t i = 0; i < (int32_t)names.size(); i++) {
+        columns[i].values = (double*)(cache + cache_fields[i].values_offset);
+        columns[i].number_values = 0;
+    }
+
+    vector<int32_t> invalid_rows(names.size(), -1);
+
+    parse_csv_rows(position, file_end, filename, file_fields, file_fields_used, [&](int32_t column, double value) {
+        if (invalid_rows[ column_fields[column] ] >= 0) return;
+        CacheColumn &cache_column = columns[ column_fields[column] ];
+
+        cache_column.statistics.add(value);
+        cache_column.values[cache_column.number_values++] = value;
+    }, [&](int32_t column, int32_t row, const char *cell_start, const char *cell_end) {
+        if (invalid_rows[ column_fields[column] ] < 0) invalid_rows[ column_fields[column] ] = row;
+    });
+
+    //pack the values of the numeric columns together, each is at or after
+    //where it is moved to
+    int64_t packed_size = names.size() > 0 ? cache_fields[0].values_offset : offset;
+    for (int32_t i = 0; i < (int32_t)names.size(); i++) {
+        TimeSeriesCacheField &field = cache_fields[i];
+        field.invalid_row = invalid_rows[i];
+
+        if (invalid_rows[i] >= 0) {
+            LOG_DEBUG("column '%s' of '%s' is not numeric (row %d), it will not be cached\n", names[i].c_str(), filename.c_str(), invalid_rows[i]);
+            columns[i].number_values = 0;
+            columns[i].statistics = RunningStatistics();
+            field.values_offset = 0;
+            continue;
+        }
+
+        if (columns[i].number_values > 0) memmove(cache + packed_size, columns[i].values, columns[i].number_values * sizeof(double));
+        field.values_offset = packed_size;
+        packed_size += columns[i].number_values * sizeof(double);
+    }
+
+    for (int32_t i = 0; i < (int32_t)names.size(); i++) {
+        CacheColumn &cache_column = columns[i];
+        TimeSeriesCacheField &field = cache_fields[i];
+
+        field.number_values = cache_column.number_values;
+        field.min = cache_column.statistics.get_min();
+        field.average = cache_column.statistics.get_mean();
+        field.max = cache_column.statistics.get_max();
+        field.variance = cache_column.statistics.get_variance();
+        field.std_dev = sqrt(field.variance);
+        field.min_change = cache_column.statistics.get_min_change();
+        field.max_change = cache_column.statistics.get_max_change();
+
+        memcpy(cache + field.name_offset, names[i].c_str(), names[i].size());
+    }
+
+    memcpy(cache, &header, sizeof(TimeSeriesCacheHeader));
+    if (names.size() > 0) memcpy(cache + sizeof(TimeSeriesCacheHeader), &cache_fields[0], names.size() * sizeof(TimeSeriesCacheField));
+
+    bool written = msync(mapping, cache_size, MS_SYNC) == 0;
+    munmap(mapping, cache_size);
+
+    if (written && packed_size < cache_size) written = truncate(temporary_filename.c_str(), packed_size) == 0;
+
+    if (!written || rename(temporary_filename.c_str(), cache_filename.c_str()) != 0) {
+        LOG_DEBUG("could not write time series cache '%s', continuing without it\n", cache_filename.c_str());
+        unlink(temporary_filename.c_str());
+        return false;
+    }
+
+    LOG_INFO("wrote time series cache '%s'\n", cache_filename.c_str());
+    return true;
+}
+
+bool TimeSeriesSet::read_cache(string cache_filename, bool &cache_current) {
+    MappedFile cache_file(cache_filename);
+
+    vector<TimeSeriesCacheField> cache_fields;
+    vector<string> cache_field_names;
+    cache_current = false;
+    if (!read_cache_fields(filename, cache_filename, cache_file, cache_fields, cache_field_names)) return false;
+    cache_current = true;
+
+    //the cache has every column of the CSV file, so it can be used for any selection of fields
+    vector<int32_t> field_indexes(fields.size(), -1);
+    for (int32_t i = 0; i < (int32_t)fields.size(); i++) {
+        for (int32_t j = 0; j < (int32_t)cache_field_names.size(); j++) {
+            if (cache_field_names[j] == fields[i]) {
+                field_indexes[i] = j;
+                break;
+            }
+        }
+
+        if (field_indexes[i] < 0) {
+            //let reading the CSV file report the missing field
+            LOG_DEBUG("field '%s' was not in time series cache '%s'\n", fields[i].c_str(), cache_filename.c_str());
+            return false;
+        }
+
+        if (cache_fields[field_indexes[i]].invalid_row >= 0) {
+            //let reading the CSV file report the invalid values
+            LOG_DEBUG("field '%s' is not numeric in time series cache '%s'\n", fields[i].c_str(), cache_filename.c_str());
+            return false;
+        }
+    }
+
+    for (int32_t i = 0; i < (int32_t)fields.size(); i++) {
+        if (time_series.count(fields[i]) > 0) continue;
+
+        const TimeSeriesCacheField &field = cache_fields[field_indexes[i]];
+
+        TimeSeries *series = new TimeSeries(fields[i]);
+        series->values.resize(field.number_values);
+        if (field.number_values > 0) memcpy(&series->values[0], cache_file.data + field.values_offset, field.number_values * sizeof(double));
+
+        series->set_statistics(RunningStatistics(field.number_values, field.min, field.average, field.max, field.variance, field.min_change, field.max_change));
+
+        time_series[fields[i]] = series;
+    }
+
+    LOG_DEBUG("read time series '%s' from cache '%s'\n", filename.c_str(), cache_filename.c_str());
+    return true;
+}
+
+MappedTimeSeriesSet::MappedTimeSeriesSet(string _filename) : filename(_filename), cache_file(NULL) {
+    string cache_filename = filename + ".cache";
+
+    vector<TimeSeriesCacheField> cache_fields;
+    for (int32_t attempt = 0; attempt < 2; attempt++) {
+        //windows are read from anywhere in the file, so don't read ahead
+        cache_file = new MappedFile(cache_filename, MADV_RANDOM);
+        if (read_cache_fields(filename, cache_filename, *cache_file, cache_fields, fields)) break;
+
+        delete cache_file;
+        cache_file = NULL;
+
+        if (attempt > 0 || !create_time_series_cache(filename, cache_filename)) {
+            LOG_FATAL("ERROR: could not create the time series cache '%s' needed to stream '%s', is its directory writable?\n", cache_filename.c_str(), filename.c_str());
+            exit(1);
+        }
+    }
+
+    for (int32_t i = 0; i < (int32_t)cache_fields.size(); i++) {
+        if (cache_fields[i].invalid_row >= 0) {
+            columns.push_back(NULL);
+        } else {
+            columns.push_back((const double*)(cache_file->data + cache_fields[i].values_offset));
+        }
+        column_lengths.push_back(cache_fields[i].number_values);
+        invalid_rows.push_back(cache_fields[i].invalid_row);
+
+        const TimeSeriesCacheField &field = cache_fields[i];
+        statistics.push_back(RunningStatistics(field.number_values, field.min, field.average, field.max, field.variance, field.min_change, field.max_change));
+    }
+}
+
+MappedTimeSeriesSet::~MappedTimeSeriesSet() {
+    delete cache_file;
+}
+
+string MappedTimeSeriesSet::get_filename() const {
+    return filename;
+}
+
+int32_t MappedTimeSeriesSet::get_field_index(string field) const {
+    for (int32_t i = 0; i < (int32_t)fields.size(); i++) {
+        if (fields[i] == field) return i;
+    }
+    return -1;
+}
+
+const double* MappedTimeSeriesSet::get_column(int32_t field) const {
+    return columns[field];
+}
+
+int32_t MappedTimeSeriesSet::get_number_values(int32_t field) const {
+    return column_lengths[field];
+}
+
+int32_t MappedTimeSeriesSet::get_invalid_row(int32_t field) const {
+    return invalid_rows[field];
+}
+
+const RunningStatistics& MappedTimeSeriesSet::get_statistics(int32_t field) const {
+    return statistics[field];
+}
+
+void TimeSeriesSet::read_csv() {
+    MappedFile csv_file(filename);
+    if (!csv_file.opened) {
+        LOG_FATAL("ERROR! Could not open time series file: '%s'\n", filename.c_str());
+        exit(1);
+    }
+
+    const char *file_end = csv_file.data + csv_file.size;
+
+    if (csv_file.size == 0) {
+        LOG_ERROR("ERROR! Could not get headers from the CSV file. File potentially empty!\n");
+        exit(1);
+    }
+
+    vector<string> file_fields;
+    const char *position = parse_csv_header(csv_file.data, file_end, file_fields);
+
 
     //check to see that all the specified fields are in the file
     for (int32_t i = 0; i < (int32_t)fields.size(); i++) {
         if (find(file_fields.begin(), file_fields.end(), fields[i]) == file_fields.end()) {
             //one of the given fields didn't exist in the time series file
-            LOG_FATAL("ERROR: could not find specified field '%s' in time series file: '%s'\n", fields[i].c_str(), _filename.c_str());
+            LOG_FATAL("ERROR: could not find specified field '%s' in time series file: '%s'\n", fields[i].c_str(), filename.c_str());
             LOG_FATAL("file's fields:\n");
             for (int32_t j = 0; j < (int32_t)file_fields.size(); j++) {
                 LOG_FATAL("'%s'\n", file_fields[j].c_str());
@@ -280,34 +965,45 @@ TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string> &_fields) {
         add_time_series(fields[i]);
     }
 
-    int row = 1;
-    while (getline(ts_file, line)) {
-        if (line.size() == 0 || line[0] == '#' || row < 0) {
-            row++;
-            continue;
-        }
+    //look up the series each column is added to once, rather than for every value
+    vector<TimeSeries*> column_series(file_fields.size(), NULL);
+    for (int32_t i = 0; i < (int32_t)file_fields.size(); i++) {
+        if (file_fields_used[i]) column_series[i] = time_series[ file_fields[i] ];
+    }
 
-        vector<string> parts;
-        string_split(line, ',', parts);
+    //count the lines so the series only need to allocate their values once
+    int32_t estimated_rows = count_csv_lines(position, file_end);
+    for (auto series = time_series.begin(); series != time_series.end(); series++) {
+        series->second->reserve(estimated_rows);
+    }
 
-        if (parts.size() != file_fields.size()) {
-            LOG_FATAL("ERROR! number of values in row %d was %d, but there were %d fields in the header.\n", row, parts.size(), file_fields.size());
-            exit(1);
-        }
+    parse_csv_rows(position, file_end, filename, file_fields, file_fields_used, [&](int32_t column, double value) {
+        column_series[column]->add_value(value);
+    }, [&](int32_t column, int32_t row, const char *cell_start, const char *cell_end) {
+        LOG_ERROR("file: '%s' -- invalid value on row %d and column %d: '%s', value: '%s'\n", filename.c_str(), row, column, file_fields[column].c_str(), string(cell_start, cell_end).c_str());
+    });
+}
 
-        for (uint32_t i = 0; i < parts.size(); i++) {
-            if (!file_fields_used[i]) continue;
+TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string> &_fields, bool use_cache) {
+    filename = _filename;
+    fields = _fields;
 
-            LOG_TRACE("parts[%d]: %s being added to '%s'\n", i, parts[i].c_str(), file_fields[i].c_str());
+    bool cached = false;
+    if (use_cache) {
+        string cache_filename = filename + ".cache";
+        bool cache_current = false;
+        cached = read_cache(cache_filename, cache_current);
 
-            try {
-                time_series[ file_fields[i] ]->add_value( stod(parts[i]) );
-            } catch (const invalid_argument& ia) {
-                LOG_ERROR("file: '%s' -- invalid argument: '%s' on row %d and column %d: '%s', value: '%s'\n", filename.c_str(), ia.what(), row, i, file_fields[i].c_str(), parts[i].c_str());
-            }
-        }
+        //a current cache without the fields would be made the same again
+        if (!cached && !cache_current && create_time_series_cache(filename, cache_filename)) cached = read_cache(cache_filename, cache_current);
+    }
 
-        row++;
+    if (!cached) {
+        read_csv();
+
+        for (auto series = time_series.begin(); series != time_series.end(); series++) {
+            series->second->calculate_statistics();
+        }
     }
 
     number_rows = time_series.begin()->second->get_number_values();
@@ -317,7 +1013,6 @@ TimeSeriesSet::TimeSeriesSet(string _filename, const vector<string> &_fields) {
     }
 
     for (auto series = time_series.begin(); series != time_series.end(); series++) {
-        series->second->calculate_statistics();
         if (series->second->get_min_change() == 0 && series->second->get_max_change() == 0) {
             LOG_WARNING("WARNING: unchanging series: '%s'\n", series->first.c_str());
             //LOG_WARNING("removing unchanging series: '%s'\n", series->first.c_str());
@@ -394,6 +1089,10 @@ double TimeSeriesSet::get_max_change(string field) {
     return time_series[field]->get_max_change();
 }
 
+const RunningStatistics& TimeSeriesSet::get_statistics(string field) {
+    return time_series[field]->get_statistics();
+}
+
 void TimeSeriesSet::normalize_min_max(string field, double min, double max) {
     time_series[field]->normalize_min_max(min, max);
 }
@@ -402,6 +1101,10 @@ void TimeSeriesSet::normalize_avg_std_dev(string field, double avg, double std_d
     time_series[field]->normalize_avg_std_dev(avg, std_dev, norm_max);
 }
 
+const TimeSeries* TimeSeriesSet::get_time_series(string field_name) const {
+    return time_series.at(field_name);
+}
+
 double TimeSeriesSet::get_correlation(string field1, string field2, int32_t lag) const {
     const TimeSeries *first_series = time_series.at(field1);
     const TimeSeries *second_series = time_series.at(field2);
@@ -468,6 +1171,28 @@ void TimeSeriesSet::export_time_series(vector< vector<double> > &data, const vec
     }
 }
 
+void TimeSeriesSet::export_time_series(SeriesView &data, const vector<string> &requested_fields, const vector<string> &shift_fields, int32_t time_offset) {
+    data = SeriesView();
+
+    int abs_time_offset = time_offset;
+    if (abs_time_offset < 0) abs_time_offset *= -1;
+    int length = number_rows - abs_time_offset;
+
+    for (int i = 0; i != (int)requested_fields.size(); i++) {
+        const vector<double> &values = time_series[ requested_fields[i] ]->values;
+
+        //output data starts after the first N values, as do inputs shifted to the outputs' time
+        int start = 0;
+        if (time_offset > 0) {
+            start = time_offset;
+        } else if (time_offset < 0 && find(shift_fields.begin(), shift_fields.end(), requested_fields[i]) != shift_fields.end()) {
+            start = -time_offset;
+        }
+
+        data.add_field(values.data() + start, length);
+    }
+}
+
 void TimeSeriesSet::export_time_series(vector< vector<double> > &data, const vector<string> &requested_fields) {
     vector<string> shift_fields; //no fields will be shifted as this is empty
     export_time_series(data, requested_fields, shift_fields, 0);
@@ -566,11 +1291,15 @@ void TimeSeriesSets::help_message() {
     LOG_INFO("\t\t\t\t'b' denoting the parameter as having user specified bounds, if this is specified the following two values should be the min and max bounds for the parameter.\n");
     LOG_INFO("\t\t\t\tThe settings string requires at one of 'i' or 'o'.\n");
 
+    LOG_INFO("\tLoading:\n");
+    LOG_INFO("\t\t--load_threads <int>: (optional) the number of threads used to parse the CSV files in parallel. Defaults to 0, which uses one thread per hardware thread (but never more than the number of files).\n");
+    LOG_INFO("\t\t--no_dataset_cache: (optional) always parse the CSV files. Otherwise the first time a CSV file is read, its columns and their statistics are written to a binary cache next to it (the CSV file's name with .cache appended, e.g., burner_0.csv.cache) which later runs memory map instead, as long as the CSV file has not changed.\n");
+    LOG_INFO("\n");
     LOG_INFO("\tNormalization:\n");
     LOG_INFO("\t\t--normalize <type>: (optional) normalize the data. Types can be 'min_max' or 'avg_std_dev'. 'min_max' will take each parameter and subtract the min, then divide by max-min. 'avg_std_dev' will subtract the average, divide by the standard deviation and then divide by the normalized max to ensure values are between -1 and 1.\n");
 }
 
-TimeSeriesSets::TimeSeriesSets() : normalize_type("none") {
+TimeSeriesSets::TimeSeriesSets() : normalize_type("none"), load_threads(0), use_dataset_cache(true) {
 }
 
 TimeSeriesSets::~TimeSeriesSets(){
@@ -669,11 +1398,45 @@ void TimeSeriesSets::load_time_series() {
 
     for (uint32_t i = 0; i < filenames.size(); i++) {
         LOG_DEBUG("\t%s\n", filenames[i].c_str());
+    }
+
+    int32_t number_threads = load_threads;
+    if (number_threads <= 0) number_threads = thread::hardware_concurrency();
+    if (number_threads > (int32_t)filenames.size()) number_threads = filenames.size();
+    if (number_threads < 1) number_threads = 1;
+
+    //each file is parsed independently, into its own slot so the order of the sets matches the filenames
+    time_series.assign(filenames.size(), NULL);
+    if (number_threads == 1) {
+        for (uint32_t i = 0; i < filenames.size(); i++) {
+            time_series[i] = new TimeSeriesSet(filenames[i], all_parameter_names, use_dataset_cache);
+        }
+    } else {
+        LOG_DEBUG("loading %d time series files with %d threads\n", filenames.size(), number_threads);
+
+        string log_id = Log::get_id();
+        atomic<int32_t> next_file(0);
 
-        TimeSeriesSet *ts = new TimeSeriesSet(filenames[i], all_parameter_names);
-        time_series.push_back( ts );
+        vector<thread> loaders;
+        for (int32_t i = 0; i < number_threads; i++) {
+            loaders.push_back(thread([&]() {
+                //write to the log of the thread loading the time series
+                Log::set_id(log_id);
 
-        rows += ts->get_number_rows();
+                int32_t file;
+                while ((file = next_file++) < (int32_t)filenames.size()) {
+                    time_series[file] = new TimeSeriesSet(filenames[file], all_parameter_names, use_dataset_cache);
+                }
+            }));
+        }
+
+        for (int32_t i = 0; i < number_threads; i++) {
+            loaders[i].join();
+        }
+    }
+
+    for (uint32_t i = 0; i < time_series.size(); i++) {
+        rows += time_series[i]->get_number_rows();
     }
     LOG_DEBUG("number of time series files: %d, total rows: %d\n", filenames.size(), rows);
 }
@@ -761,6 +1524,9 @@ TimeSeriesSets* TimeSeriesSets::generate_from_arguments(const vector<string> &ar
     }
 
 
+    get_argument(arguments, "--load_threads", false, tss->load_threads);
+    if (argument_exists(arguments, "--no_dataset_cache")) tss->use_dataset_cache = false;
+
     tss->load_time_series();
 
     tss->normalize_type = "";
@@ -812,16 +1578,17 @@ TimeSeriesSets* TimeSeriesSets::generate_test(const vector<string> &_test_filena
     return tss;
 }
 
-double TimeSeriesSets::denormalize(string field_name, double value) {
+void TimeSeriesSets::get_denormalize_coefficient(string field_name, double &scale, double &offset) {
     if (normalize_type.compare("none") == 0) {
-        return value;
+        scale = 1.0;
+        offset = 0.0;
+
     } else if (normalize_type.compare("min_max") == 0) {
         double min = normalize_mins[field_name];
         double max = normalize_maxs[field_name];
 
-        value = (value * (max-min)) + min;
-
-        return value;
+        scale = max - min;
+        offset = min;
 
     } else if (normalize_type.compare("avg_std_dev") == 0) {
         double min = normalize_mins[field_name];
@@ -834,16 +1601,31 @@ double TimeSeriesSets::denormalize(string field_name, double value) {
         
         norm_max = fmax(norm_min, norm_max);
 
-        value = (value * norm_max * std_dev) + avg;
-
-        return value;
+        scale = norm_max * std_dev;
+        offset = avg;
 
     } else {
-        LOG_FATAL("Unknown normalize type on denormalize for '%s' and '%lf', '%s', this should never happen.\n", field_name.c_str(), value, normalize_type.c_str());
+        LOG_FATAL("Unknown normalize type on denormalize for '%s', '%s', this should never happen.\n", field_name.c_str(), normalize_type.c_str());
         exit(1);
     }
 }
 
+double TimeSeriesSets::denormalize(string field_name, double value) {
+    double scale, offset;
+    get_denormalize_coefficient(field_name, scale, offset);
+
+    return (value * scale) + offset;
+}
+
+void TimeSeriesSets::get_denormalize_coefficients(const vector<string> &field_names, vector<double> &scales, vector<double> &offsets) {
+    scales.resize(field_names.size());
+    offsets.resize(field_names.size());
+
+    for (int32_t i = 0; i < (int32_t)field_names.size(); i++) {
+        get_denormalize_coefficient(field_names[i], scales[i], offsets[i]);
+    }
+}
+
 void TimeSeriesSets::normalize_min_max() {
     LOG_INFO("doing min/max normalization:\n");
 
@@ -863,13 +1645,12 @@ void TimeSeriesSets::normalize_min_max() {
             LOG_INFO("user specified bounds for ");
 
         }  else {
+            RunningStatistics combined;
             for (int j = 0; j < time_series.size(); j++) {
-                double current_min = time_series[j]->get_min(parameter_name);
-                double current_max = time_series[j]->get_max(parameter_name);
-
-                if (current_min < min) min = current_min;
-                if (current_max > max) max = current_max;
+                combined.merge(time_series[j]->get_statistics(parameter_name));
             }
+            min = combined.get_min();
+            max = combined.get_max();
 
             normalize_mins[parameter_name] = min;
             normalize_maxs[parameter_name] = max;
@@ -945,36 +1726,22 @@ void TimeSeriesSets::normalize_avg_std_dev() {
             LOG_INFO("user specified avg/std dev for ");
 
         }  else {
-            double numerator_average = 0.0;
-            long total_values = 0;
-
+            //merge the statistics of each file instead of going over their values again
+            RunningStatistics combined;
             for (int j = 0; j < time_series.size(); j++) {
-                int n_values = time_series[j]->get_number_rows();
-                numerator_average += time_series[j]->get_average(parameter_name) * n_values;
-                total_values += n_values;
-
-                double current_min = time_series[j]->get_min(parameter_name);
-                double current_max = time_series[j]->get_max(parameter_name);
-
-                if (current_min < min) min = current_min;
-                if (current_max > max) max = current_max;
+                combined.merge(time_series[j]->get_statistics(parameter_name));
             }
+            min = combined.get_min();
+            max = combined.get_max();
 
             normalize_mins[parameter_name] = min;
             normalize_maxs[parameter_name] = max;
 
-            avg = numerator_average / total_values;
-
-            double numerator_std_dev = 0.0;
-            //get the Bessel-corrected (n-1 denominator) combined standard deviation
-            for (int j = 0; j < time_series.size(); j++) {
-                int n_values = time_series[j]->get_number_rows();
-
-                double avg_diff = time_series[j]->get_average(parameter_name) - avg;
-                numerator_std_dev += ((n_values - 1) * time_series[j]->get_variance(parameter_name)) + (n_values * avg_diff * avg_diff);
-            }
+            avg = combined.get_mean();
 
-            std_dev = numerator_std_dev / (total_values - 1);
+            //this has always been the Bessel-corrected (n-1 denominator) combined variance,
+            //which genomes have been saved with, so it is kept that way
+            std_dev = combined.get_variance();
 
             normalize_avgs[parameter_name] = avg;
             normalize_std_devs[parameter_name] = std_dev;
@@ -1085,6 +1852,23 @@ void TimeSeriesSets::export_time_series(const vector<int> &series_indexes, int t
     }
 }
 
+void TimeSeriesSets::export_time_series(const vector<int> &series_indexes, int time_offset, DatasetView &inputs, DatasetView &outputs) {
+    inputs.clear();
+    outputs.clear();
+
+    for (uint32_t i = 0; i < series_indexes.size(); i++) {
+        int series_index = series_indexes[i];
+
+        SeriesView series_inputs;
+        SeriesView series_outputs;
+        time_series[series_index]->export_time_series(series_inputs, input_parameter_names, shift_parameter_names, -time_offset);
+        time_series[series_index]->export_time_series(series_outputs, output_parameter_names, shift_parameter_names, time_offset);
+
+        inputs.push_back(series_inputs);
+        outputs.push_back(series_outputs);
+    }
+}
+
 /**
  * This exports the time series marked as training series by the training_indexes vector.
  */
@@ -1110,6 +1894,24 @@ void TimeSeriesSets::export_test_series(int time_offset, vector< vector< vector<
 }
 
 
+void TimeSeriesSets::export_training_series(int time_offset, DatasetView &inputs, DatasetView &outputs) {
+    if (training_indexes.size() == 0) {
+        LOG_FATAL("ERROR: attempting to export training time series, however the training_indexes were not specified.\n");
+        exit(1);
+    }
+
+    export_time_series(training_indexes, time_offset, inputs, outputs);
+}
+
+void TimeSeriesSets::export_test_series(int time_offset, DatasetView &inputs, DatasetView &outputs) {
+    if (test_indexes.size() == 0) {
+        LOG_FATAL("ERROR: attempting to export test time series, however the test_indexes were not specified.\n");
+        exit(1);
+    }
+
+    export_time_series(test_indexes, time_offset, inputs, outputs);
+}
+
 /**
  * This exports from all the loaded time series a particular column
  */
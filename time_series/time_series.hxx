@@ -1,6 +1,8 @@
 #ifndef EXAMM_TIME_SERIES_HXX
 #define EXAMM_TIME_SERIES_HXX
 
+#include <cstdint>
+
 #include <iostream>
 using std::ostream;
 
@@ -13,6 +15,66 @@ using std::map;
 #include <vector>
 using std::vector;
 
+#include "series_view.hxx"
+
+/**
+ * The statistics of a series of values, calculated in a single pass as the
+ * values are added (using Welford's algorithm for the variance).  The
+ * statistics of separate series can be merged to get their combined
+ * statistics (as in Chan et al.'s parallel algorithm), without another pass
+ * over their values.
+ */
+class RunningStatistics {
+    private:
+        int64_t count;
+        double mean;
+        double m2; /**< the sum of the squared differences from the mean. */
+        double min;
+        double max;
+        double min_change;
+        double max_change;
+        double last;
+
+    public:
+        RunningStatistics();
+
+        /**
+         * Restores the statistics of count values, e.g., from a time series cache.
+         */
+        RunningStatistics(int64_t _count, double _min, double _mean, double _max, double _variance, double _min_change, double _max_change);
+
+        void add(double value) {
+            if (count > 0) {
+                double change = value - last;
+                if (change < min_change) min_change = change;
+                if (change > max_change) max_change = change;
+            }
+            last = value;
+
+            if (value < min) min = value;
+            if (value > max) max = value;
+
+            count++;
+            double delta = value - mean;
+            mean += delta / count;
+            m2 += delta * (value - mean);
+        }
+
+        /**
+         * Combines these statistics with those of a separate series, so the change
+         * between the last value of one and the first value of the other is not counted.
+         */
+        void merge(const RunningStatistics &other);
+
+        int64_t get_count() const;
+        double get_min() const;
+        double get_mean() const;
+        double get_max() const;
+        double get_variance() const; /**< the Bessel-corrected (n-1 denominator) variance. */
+        double get_min_change() const;
+        double get_max_change() const;
+};
+
 class TimeSeries {
     private:
         string name;
@@ -27,13 +89,26 @@ class TimeSeries {
 
         vector<double> values;
 
+        RunningStatistics statistics; /**< updated as values are added. */
+
         TimeSeries();
+
+        void set_statistics(const RunningStatistics &_statistics);
+
+        //time series sets read and write the values and statistics from their cache files
+        friend class TimeSeriesSet;
+        friend class CrossCorrelation;
     public:
         TimeSeries(string _name);
 
         void add_value(double value);
+        void reserve(int32_t number_values);
         double get_value(int i);
 
+        /**
+         * Sets the statistics from those calculated as the values were added,
+         * or recalculates them if the values were changed since (e.g., cut).
+         */
         void calculate_statistics();
         void print_statistics();
 
@@ -46,6 +121,7 @@ class TimeSeries {
         double get_variance() const;
         double get_min_change() const;
         double get_max_change() const;
+        const RunningStatistics& get_statistics() const;
 
 
         void normalize_min_max(double min, double max);
@@ -70,10 +146,35 @@ class TimeSeriesSet {
         map<string, TimeSeries*> time_series;
 
         TimeSeriesSet();
+
+        /**
+         * Parses the specified fields from the CSV file.
+         */
+        void read_csv();
+
+        /**
+         * Reads the specified fields and their statistics from a cache file made
+         * by write_cache.
+         *
+         * \param cache_current set to true if the cache was made from the
+         * current version of the CSV file, even if it could not be used
+         *
+         * \return false if there is no cache, it was made from a different version of
+         * the CSV file, or it does not have all the fields (as numbers)
+         */
+        bool read_cache(string cache_filename, bool &cache_current);
     public:
 
 
-        TimeSeriesSet(string _filename, const vector<string> &_fields);
+        /**
+         * Reads the specified fields from a CSV file.  If use_cache is true, they are
+         * read from a binary cache next to the CSV file (its filename + ".cache"),
+         * which is created the first time the file is read and recreated whenever the
+         * CSV file changes.  The cache has every column of the CSV file and their
+         * statistics, along with the size, modification time and a hash of the CSV
+         * file to validate it.
+         */
+        TimeSeriesSet(string _filename, const vector<string> &_fields, bool use_cache = false);
         ~TimeSeriesSet();
         void add_time_series(string name);
 
@@ -84,6 +185,7 @@ class TimeSeriesSet {
         vector<string> get_fields() const;
 
         void get_series(string field_name, vector<double> &series);
+        const TimeSeries* get_time_series(string field_name) const;
 
         double get_min(string field);
         double get_average(string field);
@@ -92,6 +194,7 @@ class TimeSeriesSet {
         double get_variance(string field);
         double get_min_change(string field);
         double get_max_change(string field);
+        const RunningStatistics& get_statistics(string field);
 
         double get_correlation(string field1, string field2, int32_t lag) const;
 
@@ -102,6 +205,13 @@ class TimeSeriesSet {
         void export_time_series(vector< vector<double> > &data, const vector<string> &requested_fields);
         void export_time_series(vector< vector<double> > &data, const vector<string> &requested_fields, const vector<string> &shift_fields, int32_t time_offset);
 
+        /**
+         * Exports views of the requested fields with the same offsets as
+         * export_time_series, which refer to the values in this set rather than
+         * copying them.
+         */
+        void export_time_series(SeriesView &data, const vector<string> &requested_fields, const vector<string> &shift_fields, int32_t time_offset);
+
         TimeSeriesSet* copy();
 
         void cut(int32_t start, int32_t stop);
@@ -111,6 +221,49 @@ class TimeSeriesSet {
         void select_parameters(const vector<string> &input_parameter_names, const vector<string> &output_parameter_names);
 };
 
+class MappedFile;
+
+/**
+ * The binary cache of a time series file (see TimeSeriesSet), memory mapped
+ * so that windows of its columns can be read without loading the file into
+ * memory.  The cache is created if it is missing or out of date, which only
+ * needs memory for the parts of the files being worked on.
+ */
+class MappedTimeSeriesSet {
+    private:
+        string filename;
+        MappedFile *cache_file;
+
+        vector<string> fields;
+        vector<const double*> columns;
+        vector<int32_t> column_lengths;
+        vector<int32_t> invalid_rows;
+
+        vector<RunningStatistics> statistics;
+
+    public:
+        MappedTimeSeriesSet(string _filename);
+        ~MappedTimeSeriesSet();
+
+        string get_filename() const;
+
+        /**
+         * \return the index of the field with this name, or -1 if the file does not have it
+         */
+        int32_t get_field_index(string field) const;
+
+        const double* get_column(int32_t field) const;
+        int32_t get_number_values(int32_t field) const;
+
+        /**
+         * \return the first row of the field with a value which is not a
+         * number (in which case it has no column), or -1 if it is numeric
+         */
+        int32_t get_invalid_row(int32_t field) const;
+
+        const RunningStatistics& get_statistics(int32_t field) const;
+};
+
 class TimeSeriesSets {
     private:
         string normalize_type;
@@ -127,6 +280,9 @@ class TimeSeriesSets {
 
         vector<TimeSeriesSet*> time_series;
 
+        int32_t load_threads; /**< the number of threads used to parse the time series files, 0 to use one per hardware thread. */
+        bool use_dataset_cache; /**< read the time series files from (and create) binary caches next to them. */
+
         map<string,double> normalize_mins;
         map<string,double> normalize_maxs;
 
@@ -136,6 +292,8 @@ class TimeSeriesSets {
         void parse_parameters_string(const vector<string> &p);
         void load_time_series();
 
+        void get_denormalize_coefficient(string field_name, double &scale, double &offset);
+
     public:
         static void help_message();
 
@@ -161,10 +319,26 @@ class TimeSeriesSets {
 
         void export_test_series(int time_offset, vector< vector< vector<double> > > &inputs, vector< vector< vector<double> > > &outputs);
 
+        /**
+         * These export views of the series instead of copies, so they are only
+         * valid while this TimeSeriesSets exists and is not normalized, cut or
+         * split again.
+         */
+        void export_time_series(const vector<int> &series_indexes, int time_offset, DatasetView &inputs, DatasetView &outputs);
+        void export_training_series(int time_offset, DatasetView &inputs, DatasetView &outputs);
+        void export_test_series(int time_offset, DatasetView &inputs, DatasetView &outputs);
+
         void export_series_by_name(string field_name, vector< vector<double> > &exported_series);
 
         double denormalize(string field_name, double value);
 
+        /**
+         * Resolves how each of the fields is denormalized (as value * scale + offset)
+         * up front, so denormalizing many values does not need to look up their
+         * normalization by name each time.
+         */
+        void get_denormalize_coefficients(const vector<string> &field_names, vector<double> &scales, vector<double> &offsets);
+
         string get_normalize_type() const;
         map<string,double> get_normalize_mins() const;
         map<string,double> get_normalize_maxs() const;
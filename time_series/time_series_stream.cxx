@@ -0,0 +1,417 @@
+#include <chrono>
+
+#include <cmath>
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <limits>
+using std::numeric_limits;
+
+#include <map>
+using std::map;
+
+#include <mutex>
+using std::lock_guard;
+using std::mutex;
+using std::unique_lock;
+
+#include <random>
+using std::mt19937;
+using std::uniform_int_distribution;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "common/arguments.hxx"
+#include "common/log.hxx"
+
+#include "time_series.hxx"
+#include "time_series_stream.hxx"
+
+void merge_parameter_names(const vector<string> &input_parameter_names, const vector<string> &output_parameter_names, vector<string> &all_parameter_names);
+
+void TimeSeriesStream::help_message() {
+    LOG_INFO("TimeSeriesStream initialization options from arguments:\n");
+    LOG_INFO("\tFile input:\n");
+    LOG_INFO("\t\t\t--training_filenames : list of input CSV files for training time series\n");
+    LOG_INFO("\t\t\t--test_filenames : list of input CSV files for test time series\n");
+
+    LOG_INFO("\tSpecifying parameters:\n");
+    LOG_INFO("\t\t\t--input_parameter_names <name>*: parameters to be used as inputs\n");
+    LOG_INFO("\t\t\t--output_parameter_names <name>*: parameters to be used as outputs\n");
+    LOG_INFO("\t\t\t--shift_parameter_names <name>*: parameters to shift to same timestep as output\n");
+
+    LOG_INFO("\tStreaming:\n");
+    LOG_INFO("\t\t--stream_window_length <int>: the number of time steps in each window. The time series are read through their binary caches (e.g., burner_0.csv.cache for burner_0.csv, which are created if needed) instead of being loaded into memory, and genomes are trained and validated on windows of them.\n");
+    LOG_INFO("\t\t--stream_windows <int>: (optional) the number of randomly placed windows of the training files each genome is trained on. Defaults to 10.\n");
+    LOG_INFO("\t\t--stream_validation_windows <int>: (optional) the number of windows of the test files every genome is validated on, these are chosen once at the start of the search. Defaults to 10.\n");
+    LOG_INFO("\t\t--stream_prefetch <int>: (optional) the number of sets of training windows read ahead of time by a background thread. Defaults to 2.\n");
+    LOG_INFO("\n");
+    LOG_INFO("\tNormalization:\n");
+    LOG_INFO("\t\t--normalize <type>: (optional) normalize the data. Types can be 'min_max' or 'avg_std_dev', these are calculated over all the files from the statistics stored in their caches.\n");
+}
+
+TimeSeriesStream::TimeSeriesStream() : time_offset(1), window_length(0), training_windows(10), validation_windows(10), prefetch_size(2), normalize_type("none"), validation(NULL), stopping(false), requests(0), queue_empty(0) {
+}
+
+TimeSeriesStream::~TimeSeriesStream() {
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_all();
+    prefetcher.join();
+
+    for (int32_t i = 0; i < (int32_t)queue.size(); i++) {
+        delete queue[i];
+    }
+    delete validation;
+
+    for (int32_t i = 0; i < (int32_t)training_sets.size(); i++) {
+        delete training_sets[i];
+    }
+
+    for (int32_t i = 0; i < (int32_t)test_sets.size(); i++) {
+        delete test_sets[i];
+    }
+}
+
+TimeSeriesStream* TimeSeriesStream::generate_from_arguments(const vector<string> &arguments) {
+    TimeSeriesStream *tss = new TimeSeriesStream();
+
+    get_argument(arguments, "--stream_window_length", true, tss->window_length);
+    get_argument(arguments, "--stream_windows", false, tss->training_windows);
+    get_argument(arguments, "--stream_validation_windows", false, tss->validation_windows);
+    get_argument(arguments, "--stream_prefetch", false, tss->prefetch_size);
+    get_argument(arguments, "--time_offset", false, tss->time_offset);
+
+    if (tss->window_length < 1 || tss->training_windows < 1 || tss->validation_windows < 1 || tss->prefetch_size < 1) {
+        LOG_FATAL("ERROR: the stream window length (%d), windows (%d), validation windows (%d) and prefetch (%d) must all be at least 1.\n", tss->window_length, tss->training_windows, tss->validation_windows, tss->prefetch_size);
+        help_message();
+        exit(1);
+    }
+
+    if (argument_exists(arguments, "--training_filenames") && argument_exists(arguments, "--test_filenames")) {
+        get_argument_vector(arguments, "--training_filenames", true, tss->training_filenames);
+        get_argument_vector(arguments, "--test_filenames", true, tss->test_filenames);
+    } else {
+        LOG_FATAL("Streaming time series requires the '--training_filenames' and '--test_filenames' command line arguments.  Usage instructions:\n");
+        help_message();
+        exit(1);
+    }
+
+    if (argument_exists(arguments, "--input_parameter_names") && argument_exists(arguments, "--output_parameter_names")) {
+        get_argument_vector(arguments, "--input_parameter_names", true, tss->input_parameter_names);
+        get_argument_vector(arguments, "--output_parameter_names", true, tss->output_parameter_names);
+        get_argument_vector(arguments, "--shift_parameter_names", false, tss->shift_parameter_names);
+
+        merge_parameter_names(tss->input_parameter_names, tss->output_parameter_names, tss->all_parameter_names);
+    } else {
+        LOG_FATAL("Streaming time series requires the '--input_parameter_names' and '--output_parameter_names' command line arguments.  Usage instructions:\n");
+        help_message();
+        exit(1);
+    }
+
+    for (int32_t i = 0; i < (int32_t)tss->training_filenames.size(); i++) {
+        tss->training_sets.push_back(new MappedTimeSeriesSet(tss->training_filenames[i]));
+    }
+
+    for (int32_t i = 0; i < (int32_t)tss->test_filenames.size(); i++) {
+        tss->test_sets.push_back(new MappedTimeSeriesSet(tss->test_filenames[i]));
+    }
+
+    get_argument(arguments, "--normalize", false, tss->normalize_type);
+    if (tss->normalize_type.compare("none") != 0 && tss->normalize_type.compare("min_max") != 0 && tss->normalize_type.compare("avg_std_dev") != 0) {
+        LOG_FATAL("Unknown normalize type: '%s'\n", tss->normalize_type.c_str());
+        help_message();
+        exit(1);
+    }
+    tss->calculate_normalization();
+
+    //the validation windows are the same for every run with the same arguments
+    mt19937 validation_generator(1337);
+    tss->validation = tss->read_windows(tss->test_sets, tss->validation_windows, validation_generator);
+
+    tss->generator = mt19937(std::chrono::system_clock::now().time_since_epoch().count());
+    tss->prefetcher = thread(&TimeSeriesStream::prefetch, tss);
+
+    return tss;
+}
+
+void TimeSeriesStream::calculate_normalization() {
+    if (normalize_type.compare("none") == 0) return;
+
+    vector<MappedTimeSeriesSet*> sets(training_sets);
+    sets.insert(sets.end(), test_sets.begin(), test_sets.end());
+
+    for (int32_t i = 0; i < (int32_t)all_parameter_names.size(); i++) {
+        string parameter_name = all_parameter_names[i];
+
+        RunningStatistics combined;
+        for (int32_t j = 0; j < (int32_t)sets.size(); j++) {
+            int32_t field = sets[j]->get_field_index(parameter_name);
+            if (field < 0) {
+                LOG_FATAL("ERROR: parameter '%s' was not found in '%s'\n", parameter_name.c_str(), sets[j]->get_filename().c_str());
+                exit(1);
+            }
+
+            if (sets[j]->get_invalid_row(field) >= 0) {
+                LOG_FATAL("ERROR: parameter '%s' has a value which is not a number on row %d of '%s'\n", parameter_name.c_str(), sets[j]->get_invalid_row(field), sets[j]->get_filename().c_str());
+                exit(1);
+            }
+
+            combined.merge(sets[j]->get_statistics(field));
+        }
+
+        double min = combined.get_min();
+        double max = combined.get_max();
+
+        normalize_mins[parameter_name] = min;
+        normalize_maxs[parameter_name] = max;
+
+        if (normalize_type.compare("min_max") == 0) {
+            LOG_INFO("calculated bounds for     %30s, min: %22.10lf, max: %22.10lf\n", parameter_name.c_str(), min, max);
+            continue;
+        }
+
+        //combined the same way as TimeSeriesSets::normalize_avg_std_dev
+        double avg = combined.get_mean();
+        double std_dev = combined.get_variance();
+
+        normalize_avgs[parameter_name] = avg;
+        normalize_std_devs[parameter_name] = std_dev;
+
+        double norm_min = (min - avg) / std_dev;
+        double norm_max = (max - avg) / std_dev;
+        norm_max = fmax(norm_min, norm_max);
+        normalize_norm_maxs[parameter_name] = norm_max;
+
+        LOG_INFO("calculated bounds for     %30s, min: %22.10lf, max: %22.10lf, norm_max; %22.10lf, combined average: %22.10lf, combined std_dev: %22.10lf\n", parameter_name.c_str(), min, max, norm_max, avg, std_dev);
+    }
+}
+
+void TimeSeriesStream::get_normalize_coefficients(const vector<string> &parameter_names, vector<double> &offsets, vector<double> &divisors, vector<double> &norm_maxs) const {
+    offsets.assign(parameter_names.size(), 0.0);
+    divisors.assign(parameter_names.size(), 1.0);
+    norm_maxs.assign(parameter_names.size(), 1.0);
+
+    for (int32_t i = 0; i < (int32_t)parameter_names.size(); i++) {
+        const string &parameter_name = parameter_names[i];
+
+        if (normalize_type.compare("min_max") == 0) {
+            double min = normalize_mins.at(parameter_name);
+            double max = normalize_maxs.at(parameter_name);
+
+            offsets[i] = min;
+            divisors[i] = max - min;
+
+        } else if (normalize_type.compare("avg_std_dev") == 0) {
+            offsets[i] = normalize_avgs.at(parameter_name);
+            divisors[i] = normalize_std_devs.at(parameter_name);
+            norm_maxs[i] = normalize_norm_maxs.at(parameter_name);
+        }
+    }
+}
+
+TimeSeriesWindows* TimeSeriesStream::read_windows(const vector<MappedTimeSeriesSet*> &sets, int32_t number_windows, mt19937 &window_generator) const {
+    int32_t abs_time_offset = time_offset;
+    if (abs_time_offset < 0) abs_time_offset *= -1;
+
+    //a window can start anywhere its inputs and (offset) outputs fit in the file,
+    //so files are picked proportionally to how many windows they have
+    vector<int64_t> cumulative_starts;
+    int64_t total_starts = 0;
+    for (int32_t i = 0; i < (int32_t)sets.size(); i++) {
+        int32_t number_rows = numeric_limits<int32_t>::max();
+        for (int32_t j = 0; j < (int32_t)all_parameter_names.size(); j++) {
+            int32_t field = sets[i]->get_field_index(all_parameter_names[j]);
+            if (field < 0) {
+                LOG_FATAL("ERROR: parameter '%s' was not found in '%s'\n", all_parameter_names[j].c_str(), sets[i]->get_filename().c_str());
+                exit(1);
+            }
+
+            if (sets[i]->get_invalid_row(field) >= 0) {
+                LOG_FATAL("ERROR: parameter '%s' has a value which is not a number on row %d of '%s'\n", all_parameter_names[j].c_str(), sets[i]->get_invalid_row(field), sets[i]->get_filename().c_str());
+                exit(1);
+            }
+            if (sets[i]->get_number_values(field) < number_rows) number_rows = sets[i]->get_number_values(field);
+        }
+
+        int32_t starts = number_rows - abs_time_offset - window_length + 1;
+        if (starts > 0) total_starts += starts;
+        cumulative_starts.push_back(total_starts);
+    }
+
+    if (total_starts == 0) {
+        LOG_FATAL("ERROR: none of the time series files have more than %d rows, so no windows of length %d (with a time offset of %d) could be read from them.\n", window_length + abs_time_offset - 1, window_length, time_offset);
+        exit(1);
+    }
+
+    int32_t number_inputs = input_parameter_names.size();
+    int32_t number_outputs = output_parameter_names.size();
+
+    TimeSeriesWindows *windows = new TimeSeriesWindows();
+    //allocate everything first so the views never point at moved values
+    windows->values.resize((size_t)number_windows * (number_inputs + number_outputs) * window_length);
+
+    uniform_int_distribution<int64_t> start_distribution(0, total_starts - 1);
+
+    //look up the columns, shifts and normalization of each parameter once
+    //rather than for every window or value
+    vector< vector<const double*> > input_columns(sets.size());
+    vector< vector<const double*> > output_columns(sets.size());
+    for (int32_t i = 0; i < (int32_t)sets.size(); i++) {
+        for (int32_t j = 0; j < number_inputs; j++) {
+            input_columns[i].push_back(sets[i]->get_column(sets[i]->get_field_index(input_parameter_names[j])));
+        }
+
+        for (int32_t j = 0; j < number_outputs; j++) {
+            output_columns[i].push_back(sets[i]->get_column(sets[i]->get_field_index(output_parameter_names[j])));
+        }
+    }
+
+    //inputs shifted to the outputs' time start at the same row as the outputs
+    vector<int32_t> input_shifts(number_inputs, 0);
+    for (int32_t j = 0; j < number_inputs; j++) {
+        if (time_offset < 0) {
+            input_shifts[j] = -time_offset;
+        } else {
+            for (int32_t k = 0; k < (int32_t)shift_parameter_names.size(); k++) {
+                if (shift_parameter_names[k] == input_parameter_names[j]) input_shifts[j] += time_offset;
+            }
+        }
+    }
+
+    vector<double> input_offsets, input_divisors, input_norm_maxs;
+    vector<double> output_offsets, output_divisors, output_norm_maxs;
+    get_normalize_coefficients(input_parameter_names, input_offsets, input_divisors, input_norm_maxs);
+    get_normalize_coefficients(output_parameter_names, output_offsets, output_divisors, output_norm_maxs);
+
+    double *current = windows->values.data();
+    for (int32_t i = 0; i < number_windows; i++) {
+        int64_t position = start_distribution(window_generator);
+
+        int32_t set = 0;
+        while (cumulative_starts[set] <= position) set++;
+        int32_t start = position - (set > 0 ? cumulative_starts[set - 1] : 0);
+
+        SeriesView inputs;
+        for (int32_t j = 0; j < number_inputs; j++) {
+            const double *column = input_columns[set][j] + start + input_shifts[j];
+            double offset = input_offsets[j];
+            double divisor = input_divisors[j];
+            double norm_max = input_norm_maxs[j];
+
+            for (int32_t k = 0; k < window_length; k++) {
+                current[k] = ((column[k] - offset) / divisor) / norm_max;
+            }
+            inputs.add_field(current, window_length);
+            current += window_length;
+        }
+
+        int32_t output_start = start;
+        if (time_offset > 0) output_start += time_offset;
+
+        SeriesView outputs;
+        for (int32_t j = 0; j < number_outputs; j++) {
+            const double *column = output_columns[set][j] + output_start;
+            double offset = output_offsets[j];
+            double divisor = output_divisors[j];
+            double norm_max = output_norm_maxs[j];
+
+            for (int32_t k = 0; k < window_length; k++) {
+                current[k] = ((column[k] - offset) / divisor) / norm_max;
+            }
+            outputs.add_field(current, window_length);
+            current += window_length;
+        }
+
+        windows->inputs.push_back(inputs);
+        windows->outputs.push_back(outputs);
+    }
+
+    return windows;
+}
+
+void TimeSeriesStream::prefetch() {
+    Log::set_id("time_series_stream");
+
+    while (true) {
+        unique_lock<mutex> lock(queue_mutex);
+        queue_cv.wait(lock, [this]{ return stopping || (int32_t)queue.size() < prefetch_size; });
+        if (stopping) break;
+        lock.unlock();
+
+        TimeSeriesWindows *windows = read_windows(training_sets, training_windows, generator);
+
+        lock.lock();
+        queue.push_back(windows);
+        lock.unlock();
+        queue_cv.notify_all();
+    }
+
+    Log::release_id("time_series_stream");
+}
+
+TimeSeriesWindows* TimeSeriesStream::next_training_windows() {
+    unique_lock<mutex> lock(queue_mutex);
+
+    requests++;
+    if (queue.size() == 0) queue_empty++;
+
+    queue_cv.wait(lock, [this]{ return queue.size() > 0; });
+    TimeSeriesWindows *windows = queue.front();
+    queue.pop_front();
+
+    lock.unlock();
+    queue_cv.notify_all();
+
+    return windows;
+}
+
+const TimeSeriesWindows* TimeSeriesStream::get_validation_windows() const {
+    return validation;
+}
+
+void TimeSeriesStream::print_statistics() {
+    lock_guard<mutex> lock(queue_mutex);
+    LOG_INFO("time series stream: %ld sets of %d training windows of length %d requested, queue empty %ld times\n", requests, training_windows, window_length, queue_empty);
+}
+
+vector<string> TimeSeriesStream::get_input_parameter_names() const {
+    return input_parameter_names;
+}
+
+vector<string> TimeSeriesStream::get_output_parameter_names() const {
+    return output_parameter_names;
+}
+
+string TimeSeriesStream::get_normalize_type() const {
+    return normalize_type;
+}
+
+map<string,double> TimeSeriesStream::get_normalize_mins() const {
+    return normalize_mins;
+}
+
+map<string,double> TimeSeriesStream::get_normalize_maxs() const {
+    return normalize_maxs;
+}
+
+map<string,double> TimeSeriesStream::get_normalize_avgs() const {
+    return normalize_avgs;
+}
+
+map<string,double> TimeSeriesStream::get_normalize_std_devs() const {
+    return normalize_std_devs;
+}
@@ -0,0 +1,144 @@
+#ifndef EXAMM_TIME_SERIES_STREAM_HXX
+#define EXAMM_TIME_SERIES_STREAM_HXX
+
+#include <condition_variable>
+using std::condition_variable;
+
+#include <deque>
+using std::deque;
+
+#include <map>
+using std::map;
+
+#include <mutex>
+using std::mutex;
+
+#include <random>
+using std::mt19937;
+
+#include <string>
+using std::string;
+
+#include <thread>
+using std::thread;
+
+#include <vector>
+using std::vector;
+
+#include "series_view.hxx"
+#include "time_series.hxx"
+
+/**
+ * A set of normalized windows of time series, with views of their inputs
+ * and expected outputs which can be used to train and evaluate genomes.
+ */
+class TimeSeriesWindows {
+    public:
+        vector<double> values; /**< the values of every window, which the views point into. */
+
+        DatasetView inputs;
+        DatasetView outputs;
+};
+
+/**
+ * Streams windows of time series which are too large to load into memory.
+ *
+ * The time series files are memory mapped through their binary caches (which
+ * are created first if needed), so only the windows being read need to be in
+ * memory.  A background thread keeps a queue of sets of randomly placed
+ * training windows ready, so training does not wait on the disk.  The
+ * validation windows are chosen once from the test files with a fixed seed,
+ * so every genome is evaluated on the same data.
+ *
+ * The normalization bounds are combined from the statistics stored in the
+ * caches in the same way as TimeSeriesSets::normalize_min_max and
+ * TimeSeriesSets::normalize_avg_std_dev, and each window is normalized as it
+ * is read.
+ */
+class TimeSeriesStream {
+    private:
+        vector<string> training_filenames;
+        vector<string> test_filenames;
+
+        vector<string> input_parameter_names;
+        vector<string> output_parameter_names;
+        vector<string> shift_parameter_names;
+        vector<string> all_parameter_names;
+
+        int32_t time_offset;
+        int32_t window_length; /**< the number of time steps in each window. */
+        int32_t training_windows; /**< the number of windows in each set of training windows. */
+        int32_t validation_windows;
+        int32_t prefetch_size; /**< how many sets of training windows are read ahead of time. */
+
+        vector<MappedTimeSeriesSet*> training_sets;
+        vector<MappedTimeSeriesSet*> test_sets;
+
+        string normalize_type;
+        map<string,double> normalize_mins;
+        map<string,double> normalize_maxs;
+        map<string,double> normalize_avgs;
+        map<string,double> normalize_std_devs;
+        map<string,double> normalize_norm_maxs;
+
+        TimeSeriesWindows *validation;
+
+        mt19937 generator; /**< only used by the prefetch thread. */
+
+        mutex queue_mutex;
+        condition_variable queue_cv;
+        deque<TimeSeriesWindows*> queue;
+        bool stopping;
+        int64_t requests;
+        int64_t queue_empty; /**< how many times a set of training windows was requested before one was ready. */
+
+        thread prefetcher;
+
+        TimeSeriesStream();
+
+        void calculate_normalization();
+
+        /**
+         * Resolves how each of the parameters is normalized, as
+         * ((value - offset) / divisor) / norm_max, up front so normalizing the
+         * values of a window does not need to look up their bounds.
+         */
+        void get_normalize_coefficients(const vector<string> &parameter_names, vector<double> &offsets, vector<double> &divisors, vector<double> &norm_maxs) const;
+
+        /**
+         * Reads number_windows randomly placed windows from the time series sets.
+         */
+        TimeSeriesWindows* read_windows(const vector<MappedTimeSeriesSet*> &sets, int32_t number_windows, mt19937 &window_generator) const;
+
+        void prefetch();
+
+    public:
+        static void help_message();
+        static TimeSeriesStream* generate_from_arguments(const vector<string> &arguments);
+
+        ~TimeSeriesStream();
+
+        /**
+         * Returns the next set of randomly placed training windows, waiting for the
+         * prefetch thread if none are ready.  The caller is responsible for deleting it.
+         */
+        TimeSeriesWindows* next_training_windows();
+
+        /**
+         * Returns the validation windows, which are owned by the stream.
+         */
+        const TimeSeriesWindows* get_validation_windows() const;
+
+        void print_statistics();
+
+        vector<string> get_input_parameter_names() const;
+        vector<string> get_output_parameter_names() const;
+
+        string get_normalize_type() const;
+        map<string,double> get_normalize_mins() const;
+        map<string,double> get_normalize_maxs() const;
+        map<string,double> get_normalize_avgs() const;
+        map<string,double> get_normalize_std_devs() const;
+};
+
+#endif
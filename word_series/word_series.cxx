@@ -2,10 +2,19 @@
 
 #include <algorithm>
 using std::find;
+using std::sort;
+using std::stable_sort;
+using std::unique;
+
+#include <atomic>
+using std::atomic;
 
 #include <fstream>
 using std::ifstream;
 
+#include <functional>
+using std::function;
+
 #include <iomanip>
 using std::setw;
 
@@ -25,16 +34,20 @@ using std::invalid_argument;
 
 #include <string>
 using std::string;
+using std::to_string;
 using std::getline;
 
-#include <vector>
-using std::vector;
+#include <thread>
+using std::thread;
+
+#include <unordered_map>
+using std::unordered_map;
 
-#include <set>
-using std::set;
+#include <utility>
+using std::move;
 
-#include<regex>
-using std::regex_replace;
+#include <vector>
+using std::vector;
 
 #include "../common/arguments.hxx"
 #include "../common/log.hxx"
@@ -205,100 +218,136 @@ void WordSeries::copy_values(vector<double> &series) {
 }
 
 
-void string_split_word(const string &s, char delim, vector<string> &result) {
-    stringstream ss;
-    ss.str(s);
-
-    string item;
-    while (getline(ss, item, delim)) {
-        result.push_back(item);
+/**
+ * Numbers the words of a file in the order they first occur, where the words
+ * of each line are separated by (any number of) spaces and followed by an
+ * "<eos>" word.  file_tokens gets the number of the word at each position.
+ */
+void read_file_words(const string &filename, unordered_map<string,int32_t> &file_words, vector<int32_t> &file_tokens) {
+    ifstream cs_file(filename.c_str());
+    if (!cs_file.is_open()) {
+        LOG_FATAL("ERROR: could not open word series file '%s'\n", filename.c_str());
+        exit(1);
     }
-}
 
-void SentenceSeries::add_word_series(string name) {
-    if (word_series.count(name) == 0) {
-        word_series[name] = new WordSeries(name);
-    } else {
-        LOG_ERROR("ERROR! Trying to add a time series to a time series set with name '%s' which already exists in the set!\n", name.c_str());
-    }
-}
+    auto add_word = [&](const string &word) {
+        auto found = file_words.find(word);
+        if (found == file_words.end()) found = file_words.emplace(word, (int32_t)file_words.size()).first;
+        file_tokens.push_back(found->second);
+    };
 
+    string word;
+    for (string line; getline(cs_file, line);) {
+        size_t end = 0;
+        while (true) {
+            size_t start = line.find_first_not_of(' ', end);
+            if (start == string::npos) break;
 
+            end = line.find(' ', start);
+            if (end == string::npos) end = line.size();
 
-SentenceSeries::SentenceSeries(const string _filename,const vector<string> & _word_index , const map<string,int> &_vocab){
-   filename = _filename;
-   word_index = _word_index;
-   vocab = _vocab;  
+            word.assign(line, start, end - start);
+            add_word(word);
+        }
+        add_word("<eos>");
+    }
+}
 
-    ifstream cs_file(filename.c_str());
+/**
+ * Calls process_file for each file (from 0 up to number_files), with each
+ * file taken by whichever of the number_threads threads is free next.
+ */
+void for_each_file(int32_t number_files, int32_t number_threads, const function<void (int32_t)> &process_file) {
+    if (number_threads <= 1) {
+        for (int32_t i = 0; i < number_files; i++) {
+            process_file(i);
+        }
+        return;
+    }
 
-    vector<string> file_words;
+    string log_id = Log::get_id();
+    atomic<int32_t> next_file(0);
 
-    for(string line;getline(cs_file,line);){
-        
-        line = regex_replace(line, std::regex("^ +| +$|( ) +"), "$1");
-        string_split_word(line,' ',file_words);
-        file_words.push_back("<eos>");
-    }
+    vector<thread> readers;
+    for (int32_t i = 0; i < number_threads; i++) {
+        readers.push_back(thread([&]() {
+            //write to the log of the thread reading the files
+            Log::set_id(log_id);
 
-    for(int i  = 0; i < word_index.size();i++){
-       add_word_series(word_index[i]);
+            int32_t file;
+            while ((file = next_file++) < number_files) {
+                process_file(file);
+            }
+        }));
     }
 
-    for (int i = 0; i < file_words.size(); ++i)
-    {
-        int  current_word = vocab[file_words[i]];
-        for (int i = 0; i < word_index.size(); ++i)
-        {
-            if(i != current_word){
-                word_series[word_index[i]]->add_value(0);
-            }
-            else{
-                word_series[word_index[i]]->add_value(1);
-            }
-        }
+    for (int32_t i = 0; i < number_threads; i++) {
+        readers[i].join();
     }
+}
 
+SentenceSeries::SentenceSeries(const string _filename, const vector<string> *_word_index, const unordered_map<string,int32_t> *_vocab, vector<int32_t> _tokens) {
+    filename = _filename;
+    word_index = _word_index;
+    vocab = _vocab;
+    tokens = move(_tokens);
 
-   
+    word_classes = NULL;
+    number_classes = 0;
 
+    calculate_statistics();
 
-   number_rows = file_words.size();
+    LOG_INFO("read time series '%s' with number rows: %d\n", filename.c_str(), number_rows);
+}
 
-    for (auto series = word_series.begin(); series != word_series.end(); series++) {
-        series->second->calculate_statistics();
-        if (series->second->get_min_change() == 0 && series->second->get_max_change() == 0) {
-            LOG_WARNING("WARNING: unchanging series: '%s'\n", series->first.c_str());
-            LOG_WARNING("removing unchanging series: '%s'\n", series->first.c_str());
-            series->second->print_statistics();
-            //word_series.erase(series);
-        } else {
-            series->second->print_statistics();
-        }
+SentenceSeries::~SentenceSeries(){
+}
 
-        int series_rows = series->second->get_number_values();
+void SentenceSeries::calculate_statistics() {
+    number_rows = tokens.size();
 
-        if (series_rows != number_rows) {
-            LOG_ERROR("ERROR! number of rows for field '%s' (%d) doesn't equal number of rows in first field '%s' (%d)\n", series->first.c_str(), series->second->get_number_values(), word_series.begin()->first.c_str(), word_series.begin()->second->get_number_values());
-        }
+    word_counts.assign(word_index->size(), 0);
+    word_increases.assign(word_index->size(), 0);
+    word_decreases.assign(word_index->size(), 0);
 
-    }
+    inactive_values.assign(word_index->size(), 0.0);
+    active_values.assign(word_index->size(), 1.0);
 
-    LOG_INFO("read time series '%s' with number rows: %d\n", filename.c_str(), number_rows);
+    for (int32_t i = 0; i < number_rows; i++) {
+        word_counts[tokens[i]]++;
 
+        if (i > 0 && tokens[i] != tokens[i - 1]) {
+            word_increases[tokens[i]]++;
+            word_decreases[tokens[i - 1]]++;
+        }
+    }
 
+    for (int32_t i = 0; i < (int32_t)word_index->size(); i++) {
+        if (get_min_change((*word_index)[i]) == 0 && get_max_change((*word_index)[i]) == 0) {
+            LOG_WARNING("WARNING: unchanging series: '%s'\n", (*word_index)[i].c_str());
+            LOG_WARNING("removing unchanging series: '%s'\n", (*word_index)[i].c_str());
+        }
+        print_statistics(i);
+    }
 }
 
-SentenceSeries::~SentenceSeries(){
-    for( std::map<string, WordSeries*>::iterator it=word_series.begin(); it!=word_series.end(); it=word_series.begin())
-    {
-        WordSeries* series = it->second;
-        word_series.erase (it);
-        delete series;
-    }
+void SentenceSeries::print_statistics(int32_t word) const {
+    if (!Log::at_level(LOG_LEVEL_INFO)) return;
+
+    string name = (*word_index)[word];
+    LOG_INFO("\t%25s stats, min: %lf, avg: %lf, max: %lf, min_change: %lf, max_change: %lf, std_dev: %lf, variance: %lf\n", name.c_str(), get_min(name), get_average(name), get_max(name), get_min_change(name), get_max_change(name), get_std_dev(name), get_variance(name));
 }
 
+int32_t SentenceSeries::get_word(string word) const {
+    auto index = vocab->find(word);
+
+    if (index == vocab->end()) {
+        LOG_FATAL("ERROR: word '%s' is not in the vocabulary of '%s'\n", word.c_str(), filename.c_str());
+        exit(1);
+    }
 
+    return index->second;
+}
 
 
 int SentenceSeries::get_number_rows() const {
@@ -306,7 +355,7 @@ int SentenceSeries::get_number_rows() const {
 }
 
 int SentenceSeries::get_number_columns() const {
-    return word_index.size();
+    return word_index->size();
 }
 
 string SentenceSeries::get_filename() const {
@@ -314,97 +363,162 @@ string SentenceSeries::get_filename() const {
 }
 
 vector<string> SentenceSeries::get_word_index() const {
-    return word_index;
+    return *word_index;
 }
 
-void SentenceSeries::get_series(string word_name, vector<double> &series) {
-    word_series[word_name]->copy_values(series);
+const vector<int32_t>& SentenceSeries::get_tokens() const {
+    return tokens;
 }
 
-double SentenceSeries::get_min(string word) {
-    return word_series[word]->get_min();
+void SentenceSeries::get_series(string word_name, vector<double> &series) const {
+    int32_t word = get_word(word_name);
+
+    series.resize(number_rows);
+    for (int32_t i = 0; i < number_rows; i++) {
+        series[i] = (tokens[i] == word) ? active_values[word] : inactive_values[word];
+    }
+}
+
+double SentenceSeries::get_min(string word) const {
+    int32_t index = get_word(word);
+    return (word_counts[index] < number_rows) ? 0.0 : 1.0;
 }
 
-double SentenceSeries::get_average(string word) {
-    return word_series[word]->get_average();
+double SentenceSeries::get_average(string word) const {
+    int32_t index = get_word(word);
+    return (double)word_counts[index] / number_rows;
 }
 
-double SentenceSeries::get_max(string word) {
-    return word_series[word]->get_max();
+double SentenceSeries::get_max(string word) const {
+    int32_t index = get_word(word);
+    return (word_counts[index] > 0) ? 1.0 : 0.0;
 }
 
-double SentenceSeries::get_std_dev(string word) {
-    return word_series[word]->get_std_dev();
+double SentenceSeries::get_std_dev(string word) const {
+    return sqrt(get_variance(word));
 }
 
-double SentenceSeries::get_variance(string word) {
-    return word_series[word]->get_variance();
+double SentenceSeries::get_variance(string word) const {
+    //the sum of squared differences from the average of count ones and (n - count) zeros is count - count^2 / n
+    double count = word_counts[get_word(word)];
+    return (count - (count * count / number_rows)) / (number_rows - 1);
 }
 
-double SentenceSeries::get_min_change(string word) {
-    return word_series[word]->get_min_change();
+double SentenceSeries::get_min_change(string word) const {
+    int32_t index = get_word(word);
+    int32_t unchanged = (number_rows - 1) - word_increases[index] - word_decreases[index];
+
+    if (word_decreases[index] > 0) return -1.0;
+    else if (unchanged > 0) return 0.0;
+    else if (word_increases[index] > 0) return 1.0;
+    else return numeric_limits<double>::max();
 }
 
-double SentenceSeries::get_max_change(string word) {
-    return word_series[word]->get_max_change();
+double SentenceSeries::get_max_change(string word) const {
+    int32_t index = get_word(word);
+    int32_t unchanged = (number_rows - 1) - word_increases[index] - word_decreases[index];
+
+    if (word_increases[index] > 0) return 1.0;
+    else if (unchanged > 0) return 0.0;
+    else if (word_decreases[index] > 0) return -1.0;
+    else return -numeric_limits<double>::max();
 }
 
 void SentenceSeries::normalize_min_max(string word, double min, double max) {
-    word_series[word]->normalize_min_max(min, max);
+    int32_t index = get_word(word);
+
+    LOG_DEBUG("normalizing time series '%s' with min: %lf and max: %lf, series min: %lf, series max: %lf\n", word.c_str(), min, max, get_min(word), get_max(word));
+
+    //the series only has two distinct values, so only they need to be normalized
+    int32_t counts[2] = {number_rows - word_counts[index], word_counts[index]};
+    double *values[2] = {&inactive_values[index], &active_values[index]};
+
+    for (int32_t i = 0; i < 2; i++) {
+        if (counts[i] > 0 && *values[i] < min) {
+            LOG_WARNING("normalizing series %s, %d values of %lf were less than min for normalization: %lf\n", word.c_str(), counts[i], *values[i], min);
+        }
+
+        if (counts[i] > 0 && *values[i] > max) {
+            LOG_WARNING("normalizing series %s, %d values of %lf were greater than max for normalization: %lf\n", word.c_str(), counts[i], *values[i], max);
+        }
+
+        *values[i] = (*values[i] - min) / (max - min);
+    }
 }
 
+//divide by the normalized max to make things between -1 and 1
 void SentenceSeries::normalize_avg_std_dev(string word, double avg, double std_dev, double norm_max) {
-    word_series[word]->normalize_avg_std_dev(avg, std_dev, norm_max);
+    int32_t index = get_word(word);
+
+    LOG_DEBUG("normalizing time series '%s' with avg: %lf, std_dev: %lf and normalized max: %lf, series avg: %lf, series std_dev: %lf\n", word.c_str(), avg, std_dev, norm_max, get_average(word), get_std_dev(word));
+
+    inactive_values[index] = ((inactive_values[index] - avg) / std_dev) / norm_max;
+    active_values[index] = ((active_values[index] - avg) / std_dev) / norm_max;
 }
 
 double SentenceSeries::get_correlation(string word1, string word2, int32_t lag) const {
-    const WordSeries *first_series = word_series.at(word1);
-    const WordSeries *second_series = word_series.at(word2);
+    WordSeries first_series(word1);
+    WordSeries second_series(word2);
 
-    return first_series->get_correlation(second_series, lag);
+    vector<double> values;
+    get_series(word1, values);
+    for (int32_t i = 0; i < (int32_t)values.size(); i++) first_series.add_value(values[i]);
+
+    get_series(word2, values);
+    for (int32_t i = 0; i < (int32_t)values.size(); i++) second_series.add_value(values[i]);
+
+    first_series.calculate_statistics();
+    second_series.calculate_statistics();
+
+    return first_series.get_correlation(&second_series, lag);
 }
 
 void SentenceSeries::export_word_series(vector< vector<double> > &data , int word_offset){
-    
-    cout<<"word_offset:: "<<word_offset<<endl;
+    int32_t start = (word_offset > 0) ? word_offset : 0;
+    int32_t length = number_rows - abs(word_offset);
+
     data.clear();
-    data.resize(word_index.size(),vector<double> (number_rows - fabs(word_offset),0.0));
+    data.resize(word_index->size());
+    for (int32_t i = 0; i < (int32_t)word_index->size(); i++) {
+        data[i].assign(length, inactive_values[i]);
+    }
 
+    for (int32_t j = 0; j < length; j++) {
+        int32_t word = tokens[start + j];
+        data[word][j] = active_values[word];
+    }
+}
 
-    if(word_offset > 0){
-        cout<<"testing"<<endl;
-        for (int i = 0; i < word_index.size(); ++i)
-        {
-            for (int j = word_offset; j < number_rows; ++j)
-            {
-                data[i][j - word_offset] = word_series[word_index[i]]->get_value(j);
-            }
-        }    
-    } else if (word_offset < 0){
-        cout<<"training"<<endl; 
-        for (int i = 0; i < word_index.size(); ++i)
-        {
-            for (int j = 0; j < number_rows + word_offset; ++j)
-            {
-                data[i][j] = word_series[word_index[i]]->get_value(j);
-            }
-        }
-    } else{
-        for (int i = 0; i < word_index.size(); ++i)
-        {
-            for (int j = 0; j < number_rows; ++j)
-            {
-                data[i][j] = word_series[word_index[i]]->get_value(j);
-            }
-        }
+void SentenceSeries::export_word_series(vector< vector<double> > &data ){
+    export_word_series(data , 0);
+}
 
-    }
+void SentenceSeries::export_word_series(int word_offset, int32_t chunk_length, DatasetView &inputs, DatasetView &outputs) const {
+    //the inputs are offset by -word_offset and the outputs by word_offset
+    int32_t input_start = (word_offset < 0) ? -word_offset : 0;
+    int32_t output_start = (word_offset > 0) ? word_offset : 0;
+    int32_t length = number_rows - abs(word_offset);
 
+    for (int32_t start = 0; start < length; start += chunk_length) {
+        int32_t number_tokens = fmin(chunk_length, length - start);
 
+        inputs.push_back(SeriesView(tokens.data() + input_start + start, number_tokens, chunk_length, word_index->size(), inactive_values.data(), active_values.data()));
+
+        if (word_classes == NULL) {
+            outputs.push_back(SeriesView(tokens.data() + output_start + start, number_tokens, chunk_length, word_index->size(), inactive_values.data(), active_values.data()));
+        } else {
+            outputs.push_back(SeriesView(tokens.data() + output_start + start, number_tokens, chunk_length, word_index->size(), inactive_values.data(), active_values.data(), word_classes, number_classes));
+        }
+    }
 }
 
-void SentenceSeries::export_word_series(vector< vector<double> > &data ){
-    export_word_series(data , 0);
+void SentenceSeries::set_word_classes(const int32_t *_word_classes, int32_t _number_classes) {
+    word_classes = _word_classes;
+    number_classes = _number_classes;
+
+    //the class fields' values follow the words' values
+    inactive_values.resize(word_index->size() + number_classes, 0.0);
+    active_values.resize(word_index->size() + number_classes, 1.0);
 }
 
 SentenceSeries::SentenceSeries(){
@@ -418,36 +532,24 @@ SentenceSeries* SentenceSeries::copy(){
     ss->word_index = word_index;
     ss->vocab= vocab;
 
-    for (auto series = word_series.begin(); series != word_series.end(); series++) {
-        ss->word_series[series->first] = series->second->copy();
-    }
+    ss->tokens = tokens;
+    ss->word_counts = word_counts;
+    ss->word_increases = word_increases;
+    ss->word_decreases = word_decreases;
+    ss->inactive_values = inactive_values;
+    ss->active_values = active_values;
+    ss->word_classes = word_classes;
+    ss->number_classes = number_classes;
 
     return ss;
 
 }
 
-void SentenceSeries::select_parameters(const vector<string> &parameter_names) {
-    for (auto series = word_series.begin(); series != word_series.end(); series++) {
-        if (std::find(parameter_names.begin(), parameter_names.end(), series->first) == parameter_names.end()) {
-            LOG_INFO("removing series: '%s'\n", series->first.c_str());
-            word_series.erase(series->first);
-        }
-    }
-}
-
-void SentenceSeries::select_parameters(const vector<string> &input_parameter_names, const vector<string> &output_parameter_names) {
-    vector<string> combined_parameters = input_parameter_names;
-    combined_parameters.insert(combined_parameters.end(), output_parameter_names.begin(), output_parameter_names.end());
-
-    select_parameters(combined_parameters);
-}
-
-
 
 
 
 
-Corpus::Corpus() : normalize_type("none") { 
+Corpus::Corpus() : normalize_type("none"), load_threads(0) {
 
 }
 
@@ -476,46 +578,64 @@ void merge_parameter_names_word(const vector<string> &input_parameter_names, con
 }
 
 
-void Corpus::load_word_library(){
-	
-    
-    for (int i = 0; i < training_indexes.size(); ++i)
-    {
-        vector<string> words;
-        string filename = filenames[training_indexes[i]];
-        ifstream cs_file(filename.c_str());
-
-        for(string line;getline(cs_file,line);){
-            line = regex_replace(line, std::regex("^ +| +$|( ) +"), "$1");
-            
-            string_split_word(line,' ',words);
-            words.push_back("<eos>");
-        }
+void Corpus::load_word_library() {
+    for (uint32_t i = 0; i < filenames.size(); i++) {
+        LOG_DEBUG("\t%s\n", filenames[i].c_str());
+    }
 
-        set<string> word_index_set(words.begin(), words.end());
+    int32_t number_threads = load_threads;
+    if (number_threads <= 0) number_threads = thread::hardware_concurrency();
+    if (number_threads > (int32_t)filenames.size()) number_threads = filenames.size();
+    if (number_threads < 1) number_threads = 1;
 
-        for (set<string>::iterator i = word_index_set.begin(); i != word_index_set.end(); ++i)
-        {
-            word_index.push_back(*i);
-            vocab[*i] = vocab.size();
+    LOG_DEBUG("reading %d word series files with %d threads\n", filenames.size(), number_threads);
 
-        }
+    vector< unordered_map<string,int32_t> > file_words(filenames.size());
+    vector< vector<int32_t> > file_tokens(filenames.size());
+
+    for_each_file(filenames.size(), number_threads, [&](int32_t file) {
+        read_file_words(filenames[file], file_words[file], file_tokens[file]);
+    });
 
+    //the vocabulary is sorted, so each word's index does not depend on which
+    //training file (or thread) it was read from first
+    word_index.clear();
+    for (uint32_t i = 0; i < training_indexes.size(); i++) {
+        const unordered_map<string,int32_t> &words = file_words[training_indexes[i]];
+        for (auto word = words.begin(); word != words.end(); word++) {
+            word_index.push_back(word->first);
+        }
     }
+    sort(word_index.begin(), word_index.end());
+    word_index.erase(unique(word_index.begin(), word_index.end()), word_index.end());
 
+    vocab.clear();
+    vocab.reserve(word_index.size());
+    for (int32_t i = 0; i < (int32_t)word_index.size(); i++) {
+        vocab[word_index[i]] = i;
+    }
 
     input_parameter_names = word_index;
     output_parameter_names = word_index;
     all_parameter_names = word_index;
 
+    sent_series.assign(filenames.size(), NULL);
+    for_each_file(filenames.size(), number_threads, [&](int32_t file) {
+        //words which are not in the vocabulary (only in the test files) get the first word's index
+        vector<int32_t> renumbered(file_words[file].size());
+        for (auto word = file_words[file].begin(); word != file_words[file].end(); word++) {
+            auto index = vocab.find(word->first);
+            renumbered[word->second] = (index == vocab.end()) ? 0 : index->second;
+        }
+        unordered_map<string,int32_t>().swap(file_words[file]);
 
-    for (uint32_t i = 0; i < filenames.size(); i++) {
-        LOG_DEBUG("\t%s\n", filenames[i].c_str());
-
-        SentenceSeries *ss = new SentenceSeries(filenames[i], word_index,vocab);
-        sent_series.push_back( ss );
+        vector<int32_t> &tokens = file_tokens[file];
+        for (uint32_t i = 0; i < tokens.size(); i++) {
+            tokens[i] = renumbered[tokens[i]];
+        }
 
-    }
+        sent_series[file] = new SentenceSeries(filenames[file], &word_index, &vocab, move(tokens));
+    });
 }
 
 
@@ -558,6 +678,8 @@ Corpus* Corpus::generate_from_arguments(const vector<string> &arguments){
     cs->input_parameter_names.clear();
     cs->output_parameter_names.clear();
 
+    get_argument(arguments, "--load_threads", false, cs->load_threads);
+
 	cs->load_word_library();
 
 
@@ -591,6 +713,34 @@ Corpus* Corpus::generate_test(const vector<string> &_test_filenames, const vecto
     return cs;
 }
 
+Corpus* Corpus::generate_from_tokens(const vector<string> &_word_index, const vector<string> &training_filenames, const vector< vector<int32_t> > &training_tokens, const vector<string> &test_filenames, const vector< vector<int32_t> > &test_tokens) {
+    Corpus *cs = new Corpus();
+
+    cs->word_index = _word_index;
+    cs->vocab.reserve(cs->word_index.size());
+    for (int32_t i = 0; i < (int32_t)cs->word_index.size(); i++) {
+        cs->vocab[cs->word_index[i]] = i;
+    }
+
+    cs->input_parameter_names = cs->word_index;
+    cs->output_parameter_names = cs->word_index;
+    cs->all_parameter_names = cs->word_index;
+
+    for (int32_t i = 0; i < (int32_t)training_filenames.size(); i++) {
+        cs->training_indexes.push_back(cs->filenames.size());
+        cs->filenames.push_back(training_filenames[i]);
+        cs->sent_series.push_back( new SentenceSeries(training_filenames[i], &cs->word_index, &cs->vocab, training_tokens[i]) );
+    }
+
+    for (int32_t i = 0; i < (int32_t)test_filenames.size(); i++) {
+        cs->test_indexes.push_back(cs->filenames.size());
+        cs->filenames.push_back(test_filenames[i]);
+        cs->sent_series.push_back( new SentenceSeries(test_filenames[i], &cs->word_index, &cs->vocab, test_tokens[i]) );
+    }
+
+    return cs;
+}
+
 double Corpus::denormalize(string field_name, double value) {
     if (normalize_type.compare("none") == 0) {
         return value;
@@ -943,6 +1093,105 @@ void Corpus::export_test_series(int word_offset, vector< vector< vector<double>
     export_sent_series(test_indexes, word_offset, inputs, outputs);
 }
 
+void Corpus::export_sent_series(const vector<int> &series_indexes, int word_offset, DatasetView &inputs, DatasetView &outputs) {
+    inputs.clear();
+    outputs.clear();
+
+    //split the same as batchify, so the views match the exported vectors
+    for (uint32_t i = 0; i < series_indexes.size(); i++) {
+        sent_series[series_indexes[i]]->export_word_series(word_offset, 64, inputs, outputs);
+    }
+}
+
+void Corpus::export_training_series(int word_offset, DatasetView &inputs, DatasetView &outputs) {
+    if (training_indexes.size() == 0) {
+        LOG_FATAL("ERROR: attempting to export training time series, however the training_indexes were not specified.\n");
+        exit(1);
+    }
+
+    export_sent_series(training_indexes, word_offset, inputs, outputs);
+}
+
+void Corpus::export_test_series(int word_offset, DatasetView &inputs, DatasetView &outputs) {
+    if (test_indexes.size() == 0) {
+        LOG_FATAL("ERROR: attempting to export test time series, however the test_indexes were not specified.\n");
+        exit(1);
+    }
+
+    export_sent_series(test_indexes, word_offset, inputs, outputs);
+}
+
+void Corpus::set_word_classes(int32_t number_classes) {
+    if (word_classes.size() > 0) {
+        LOG_FATAL("ERROR: the word classes of the corpus were already set.\n");
+        exit(1);
+    }
+
+    if (number_classes <= 0 || number_classes > (int32_t)word_index.size()) {
+        LOG_FATAL("ERROR: cannot split %d words into %d classes.\n", word_index.size(), number_classes);
+        exit(1);
+    }
+
+    vector<int64_t> word_counts(word_index.size(), 0);
+    int64_t total_count = 0;
+    for (uint32_t i = 0; i < training_indexes.size(); i++) {
+        const vector<int32_t> &tokens = sent_series[training_indexes[i]]->get_tokens();
+        for (uint32_t j = 0; j < tokens.size(); j++) {
+            word_counts[tokens[j]]++;
+        }
+        total_count += tokens.size();
+    }
+
+    vector<int32_t> words(word_index.size());
+    for (int32_t i = 0; i < (int32_t)words.size(); i++) {
+        words[i] = i;
+    }
+    stable_sort(words.begin(), words.end(), [&word_counts](int32_t a, int32_t b) { return word_counts[a] > word_counts[b]; });
+
+    word_classes.assign(word_index.size(), 0);
+    int64_t cumulative_count = 0;
+    for (int32_t i = 0; i < (int32_t)words.size(); i++) {
+        int32_t word_class = (total_count == 0) ? ((int64_t)i * number_classes) / words.size() : (cumulative_count * number_classes) / total_count;
+        word_classes[words[i]] = fmin(word_class, number_classes - 1);
+
+        cumulative_count += word_counts[words[i]];
+    }
+
+    for (int32_t i = 0; i < number_classes; i++) {
+        output_parameter_names.push_back("<class_" + to_string(i) + ">");
+    }
+
+    for (uint32_t i = 0; i < sent_series.size(); i++) {
+        sent_series[i]->set_word_classes(word_classes.data(), number_classes);
+    }
+
+    LOG_INFO("split %d words into %d classes by frequency.\n", word_index.size(), number_classes);
+}
+
+const vector<int32_t>& Corpus::get_word_classes() const {
+    return word_classes;
+}
+
+void Corpus::get_training_tokens(vector<string> &training_filenames, vector< vector<int32_t> > &training_tokens) const {
+    training_filenames.clear();
+    training_tokens.clear();
+
+    for (uint32_t i = 0; i < training_indexes.size(); i++) {
+        training_filenames.push_back(sent_series[training_indexes[i]]->get_filename());
+        training_tokens.push_back(sent_series[training_indexes[i]]->get_tokens());
+    }
+}
+
+void Corpus::get_test_tokens(vector<string> &test_filenames, vector< vector<int32_t> > &test_tokens) const {
+    test_filenames.clear();
+    test_tokens.clear();
+
+    for (uint32_t i = 0; i < test_indexes.size(); i++) {
+        test_filenames.push_back(sent_series[test_indexes[i]]->get_filename());
+        test_tokens.push_back(sent_series[test_indexes[i]]->get_tokens());
+    }
+}
+
 void Corpus::export_series_by_name(string field_name, vector< vector<double> > &exported_series) {
     exported_series.clear();
 
@@ -10,9 +10,13 @@ using std::string;
 #include <map>
 using std::map;
 
+#include <unordered_map>
+using std::unordered_map;
+
 #include <vector>
 using std::vector;
 
+#include "../time_series/series_view.hxx"
 
  class WordSeries{
  	private:
@@ -67,17 +71,46 @@ using std::vector;
 	private:
         int number_rows;
         string filename;
-      	map<string,int> vocab;
-      	vector<string> word_index;
-        map <string,WordSeries*> word_series;
+
+        /**
+         * The vocabulary is built once by the corpus and shared by all of its
+         * files (and their copies), so these are only valid as long as the
+         * corpus exists.
+         */
+        const vector<string> *word_index;
+        const unordered_map<string,int32_t> *vocab;
+
+        vector<int32_t> tokens; /**< the index (in word_index) of the word at each position of the file. */
+
+        /**
+         * Each word's series is one hot (1 where it is the word, 0 everywhere
+         * else), so its statistics only depend on how many times the word
+         * occurs and how many times its series goes up or down.
+         */
+        vector<int32_t> word_counts;
+        vector<int32_t> word_increases;
+        vector<int32_t> word_decreases;
+
+        vector<double> inactive_values; /**< the (normalized) value of each word's series where it is not the word. */
+        vector<double> active_values; /**< the (normalized) value of each word's series where it is the word. */
+
+        const int32_t *word_classes; /**< NULL, or the class of each word (owned by the Corpus) for the class fields of the exported outputs. */
+        int32_t number_classes;
 
 
         SentenceSeries();
-    public:
 
+        int32_t get_word(string word) const;
+        void calculate_statistics();
+        void print_statistics(int32_t word) const;
 
-SentenceSeries(const string _filename,const vector<string> & _word_index , const map<string,int> &_vocab);        ~SentenceSeries();
-        void add_word_series(string name);
+    public:
+        /**
+         * Creates the series of a file from the index (in word_index) of the
+         * word at each of its positions.
+         */
+        SentenceSeries(const string _filename, const vector<string> *_word_index, const unordered_map<string,int32_t> *_vocab, vector<int32_t> _tokens);
+        ~SentenceSeries();
 
         int get_number_rows() const;
         int get_number_columns() const;
@@ -85,17 +118,18 @@ SentenceSeries(const string _filename,const vector<string> & _word_index , const
         string get_filename() const;
         
         vector<string> get_word_index() const;
+        const vector<int32_t>& get_tokens() const;
 		
 
-        void get_series(string word_name, vector<double> &series);
+        void get_series(string word_name, vector<double> &series) const;
 
-        double get_min(string word);
-        double get_average(string word);
-        double get_max(string word);
-        double get_std_dev(string word);
-        double get_variance(string word);
-        double get_min_change(string word);
-        double get_max_change(string word);
+        double get_min(string word) const;
+        double get_average(string word) const;
+        double get_max(string word) const;
+        double get_std_dev(string word) const;
+        double get_variance(string word) const;
+        double get_min_change(string word) const;
+        double get_max_change(string word) const;
 
         double get_correlation(string word1, string word2, int32_t lag) const;
 
@@ -104,15 +138,26 @@ SentenceSeries(const string _filename,const vector<string> & _word_index , const
 
         void export_word_series(vector< vector<double> > &data , int word_offset);
         void export_word_series(vector< vector<double> > &data );
+
+        /**
+         * Appends one hot views of this file's words to inputs and outputs
+         * (offset the same as export_word_series), split into chunks of
+         * chunk_length positions, the last of which is padded with positions
+         * that have no word.
+         */
+        void export_word_series(int word_offset, int32_t chunk_length, DatasetView &inputs, DatasetView &outputs) const;
+
+        /**
+         * Adds a class field (with values 0 and 1) after the words to the
+         * exported outputs for each class, where word_classes[word] is the
+         * class of each word.
+         */
+        void set_word_classes(const int32_t *_word_classes, int32_t _number_classes);
        
         SentenceSeries* copy();
 
-        void select_parameters(const vector<string> &input_parameter_names, const vector<string> &output_parameter_names);
-        void select_parameters(const vector<string> &parameter_names);
-
 };
 
-
 class Corpus {
 
 	private:
@@ -136,9 +181,19 @@ class Corpus {
         map<string,double> normalize_avgs;
         map<string,double> normalize_std_devs;
 
-		vector<string> word_index;
-		map<string,int> vocab;
+        int32_t load_threads; /**< the number of threads used to read the files, 0 to use one per hardware thread. */
 
+		vector<string> word_index; /**< every word in the training files, sorted. */
+		unordered_map<string,int32_t> vocab; /**< the index of each word in word_index. */
+
+        vector<int32_t> word_classes; /**< the class of each word, empty unless set_word_classes was called. */
+
+        /**
+         * Reads the files in parallel, numbering the words of each file
+         * within that file.  The vocabulary is then merged from the training
+         * files' words, and each file's tokens are renumbered with it (in
+         * parallel as well).
+         */
 		void load_word_library();
 
 
@@ -150,6 +205,12 @@ class Corpus {
 		static Corpus* generate_from_arguments(const vector<string> &arguments);
 		static Corpus* generate_test(const vector<string> &_test_filenames, const vector<string> &_input_parameter_names, const vector<string> &_output_parameter_names);
 
+        /**
+         * Creates a corpus from the tokens of files which were already read,
+         * e.g., by another process.
+         */
+        static Corpus* generate_from_tokens(const vector<string> &_word_index, const vector<string> &training_filenames, const vector< vector<int32_t> > &training_tokens, const vector<string> &test_filenames, const vector< vector<int32_t> > &test_tokens);
+
         void normalize_min_max();
         void normalize_min_max(const map<string,double> &_normalize_mins, const map<string,double> &_normalize_maxs);
 
@@ -164,6 +225,28 @@ class Corpus {
 
         void export_test_series(int word_offset, vector< vector< vector<double> > > &inputs, vector< vector< vector<double> > > &outputs);
 
+        /**
+         * These export one hot views of the words instead of copies of every
+         * word's series, they are valid as long as the corpus exists.
+         */
+        void export_sent_series(const vector<int> &series_indexes, int word_offset, DatasetView &inputs, DatasetView &outputs);
+        void export_training_series(int word_offset, DatasetView &inputs, DatasetView &outputs);
+        void export_test_series(int word_offset, DatasetView &inputs, DatasetView &outputs);
+
+        /**
+         * Assigns each word to one of number_classes classes for a class based
+         * hierarchical softmax by frequency binning: with the words sorted by
+         * how often they occur in the training files, each class gets about
+         * the same share of the total word count.  An output parameter is
+         * added after the words for each class ("<class_0>", ...), and the
+         * exported outputs have a field for each class.
+         */
+        void set_word_classes(int32_t number_classes);
+        const vector<int32_t>& get_word_classes() const;
+
+        void get_training_tokens(vector<string> &training_filenames, vector< vector<int32_t> > &training_tokens) const;
+        void get_test_tokens(vector<string> &test_filenames, vector< vector<int32_t> > &test_tokens) const;
+
         void export_series_by_name(string field_name, vector< vector<double> > &exported_series);
 
         double denormalize(string field_name, double value);